@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_allocation.h for all platforms.
+ */
+
+#include "kaizen_allocation.h"
+
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_event.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_thread_state.h"
+
+
+
+static int kaizen_internal_allocation_record(kaizen_event_type_t type,
+                                             size_t size);
+int kaizen_internal_allocation_record(kaizen_event_type_t type,
+                                      size_t size)
+{
+    /* Skip the clock query for threads recording nothing. */
+    if (NULL == kaizen_event_buffer_of_current_thread()) {
+        return ESRCH;
+    }
+
+    struct kaizen_raw_frame_time_s time = KAIZEN_RAW_FRAME_TIME_ZERO;
+    struct kaizen_raw_frame_time_s const duration = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int const errc = kaizen_frame_time_query(&time);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    return kaizen_event_record(type,
+                               kaizen_allocation_zone_id_of_current_thread(),
+                               &time,
+                               &duration,
+                               (uint64_t)size);
+}
+
+
+
+int kaizen_allocation_record(size_t size)
+{
+    return kaizen_internal_allocation_record(kaizen_allocation_event_type, size);
+}
+
+
+
+int kaizen_deallocation_record(size_t size)
+{
+    return kaizen_internal_allocation_record(kaizen_deallocation_event_type, size);
+}
+
+
+
+uint32_t kaizen_allocation_zone_id_of_current_thread(void)
+{
+    struct kaizen_thread_state_s const* const state = kaizen_thread_state_of_current_thread();
+
+    if (NULL == state || 0u == kaizen_thread_state_depth(state)) {
+        return KAIZEN_ALLOCATION_NO_ZONE_ID;
+    }
+
+    return kaizen_thread_state_top_zone_id(state);
+}
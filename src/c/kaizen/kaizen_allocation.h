@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Allocation tracking: records allocations and deallocations as events of
+ * the calling thread, attributed to its innermost open zone, so allocation
+ * churn shows up in the same capture as the zone timings.
+ *
+ * Call kaizen_allocation_record and kaizen_deallocation_record from the
+ * allocator of the application, or use the allocator and global operator
+ * new and delete hooks of kaizen_allocation_tracking.hpp.
+ *
+ * Zones are only known if a thread state is attached to the calling thread
+ * (see kaizen_thread_state.h). Allocations count towards the innermost open
+ * zone, whether its execution is sampled or not.
+ *
+ * Recording does not allocate, so it is safe to call from within an
+ * allocator.
+ */
+
+#ifndef KAIZEN_kaizen_allocation_H
+#define KAIZEN_kaizen_allocation_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Zone id of allocations made outside of any tracked zone.
+     */
+#define KAIZEN_ALLOCATION_NO_ZONE_ID 0xFFFFFFFFu
+
+
+
+    /**
+     * Records the allocation of @a size bytes as a kaizen_allocation_event_type
+     * event (see kaizen_event.h).
+     *
+     * Returns ESRCH if the calling thread has no event buffer attached and
+     * ENOMEM if it is full.
+     */
+    int kaizen_allocation_record(size_t size);
+
+    /**
+     * Records the deallocation of @a size bytes as a
+     * kaizen_deallocation_event_type event, see kaizen_allocation_record.
+     */
+    int kaizen_deallocation_record(size_t size);
+
+    /**
+     * Returns the id of the innermost zone tracked by the thread state of the
+     * calling thread or KAIZEN_ALLOCATION_NO_ZONE_ID.
+     */
+    uint32_t kaizen_allocation_zone_id_of_current_thread(void);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_allocation_H */
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_arena.h for all platforms.
+ */
+
+#include "kaizen_arena.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+
+
+
+int kaizen_arena_init(struct kaizen_arena_s* arena,
+                      void* memory,
+                      size_t size)
+{
+    assert(NULL != arena);
+    assert(NULL != memory);
+    assert(0 < size);
+
+    arena->begin = (char*)memory;
+    arena->end = (char*)memory + size;
+    kaizen_atomic_pointer_store_release(&(arena->persistent_top), arena->begin);
+    kaizen_atomic_pointer_store_release(&(arena->frame_bottom), arena->end);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_arena_finalize(struct kaizen_arena_s* arena)
+{
+    assert(NULL != arena);
+
+    arena->begin = NULL;
+    arena->end = NULL;
+    kaizen_atomic_pointer_store_release(&(arena->persistent_top), NULL);
+    kaizen_atomic_pointer_store_release(&(arena->frame_bottom), NULL);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_arena_allocate_persistent(struct kaizen_arena_s* arena,
+                                     size_t size,
+                                     size_t alignment,
+                                     void** result)
+{
+    assert(NULL != arena);
+    assert(0 < alignment);
+    assert(0 == (alignment & (alignment - 1)));
+    assert(NULL != result);
+
+    char* const top = (char*)kaizen_atomic_pointer_load_acquire(&(arena->persistent_top));
+    char* const frame_bottom = (char*)kaizen_atomic_pointer_load_acquire(&(arena->frame_bottom));
+
+    size_t const padding = (alignment - ((size_t)top & (alignment - 1))) & (alignment - 1);
+
+    if ((size_t)(frame_bottom - top) < padding
+        || (size_t)(frame_bottom - top) - padding < size) {
+
+        return ENOMEM;
+    }
+
+    char* const allocation = top + padding;
+    kaizen_atomic_pointer_store_release(&(arena->persistent_top), allocation + size);
+
+    *result = allocation;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_arena_allocate_frame(struct kaizen_arena_s* arena,
+                                size_t size,
+                                size_t alignment,
+                                void** result)
+{
+    assert(NULL != arena);
+    assert(0 < alignment);
+    assert(0 == (alignment & (alignment - 1)));
+    assert(NULL != result);
+
+    char* const persistent_top = (char*)kaizen_atomic_pointer_load_acquire(&(arena->persistent_top));
+
+    for (;;) {
+
+        char* const bottom = (char*)kaizen_atomic_pointer_load_acquire(&(arena->frame_bottom));
+
+        if ((size_t)(bottom - persistent_top) < size) {
+            return ENOMEM;
+        }
+
+        /* Grows downwards so aligning rounds the address down. */
+        char* const allocation = (char*)((size_t)(bottom - size) & ~(alignment - 1));
+
+        if (allocation < persistent_top) {
+            return ENOMEM;
+        }
+
+        if (KAIZEN_TRUE == kaizen_atomic_pointer_compare_and_swap(&(arena->frame_bottom),
+                                                                  bottom,
+                                                                  allocation)) {
+            *result = allocation;
+
+            return KAIZEN_SUCCESS;
+        }
+
+        kaizen_atomic_cpu_relax();
+    }
+}
+
+
+
+int kaizen_arena_reset_frame(struct kaizen_arena_s* arena)
+{
+    assert(NULL != arena);
+
+    kaizen_atomic_pointer_store_release(&(arena->frame_bottom), arena->end);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+size_t kaizen_arena_capacity(struct kaizen_arena_s const* arena)
+{
+    assert(NULL != arena);
+
+    return (size_t)(arena->end - arena->begin);
+}
+
+
+
+size_t kaizen_arena_persistent_size(struct kaizen_arena_s const* arena)
+{
+    assert(NULL != arena);
+
+    char* const top = (char*)kaizen_atomic_pointer_load_acquire(&(arena->persistent_top));
+
+    return (size_t)(top - arena->begin);
+}
+
+
+
+size_t kaizen_arena_frame_size(struct kaizen_arena_s const* arena)
+{
+    assert(NULL != arena);
+
+    char* const bottom = (char*)kaizen_atomic_pointer_load_acquire(&(arena->frame_bottom));
+
+    return (size_t)(arena->end - bottom);
+}
+
+
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Fixed capacity arena backing all profiler storage so profiling never
+ * calls malloc (and never waits on allocator locks) while a frame runs.
+ *
+ * The arena is double-ended:
+ *
+ *  - Persistent allocations grow from the bottom, e.g. event buffers,
+ *    zone tables and sampler storage created at startup.
+ *  - Frame allocations grow from the top, e.g. aggregation trees and
+ *    scratch data only needed until the next frame mark. They are lock-free
+ *    and can be made by all threads concurrently.
+ *
+ * kaizen_arena_reset_frame releases all frame allocations at once in O(1).
+ * Nothing is ever freed individually.
+ *
+ * The arena does not own its memory - pass a static array or a region
+ * allocated up front via kaizen_memory_region_init (see kaizen_raw_memory.h)
+ * to use huge pages.
+ */
+
+#ifndef KAIZEN_kaizen_arena_H
+#define KAIZEN_kaizen_arena_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_atomic.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Alignment suitable for all profiler types.
+     */
+#define KAIZEN_ARENA_DEFAULT_ALIGNMENT 16
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_arena_s {
+        struct kaizen_atomic_pointer_s persistent_top;
+        struct kaizen_atomic_pointer_s frame_bottom;
+        char* begin;
+        char* end;
+    };
+    typedef struct kaizen_arena_s kaizen_arena_t;
+
+
+
+    /**
+     * Initializes @a arena to hand out the @a size bytes of @a memory, which
+     * must outlive the arena.
+     */
+    int kaizen_arena_init(struct kaizen_arena_s* arena,
+                          void* memory,
+                          size_t size);
+
+    int kaizen_arena_finalize(struct kaizen_arena_s* arena);
+
+    /**
+     * Allocates @a size bytes aligned to @a alignment, a power of two, that
+     * stay allocated until the arena is finalized.
+     *
+     * Must not be called concurrently with other arena functions - allocate
+     * persistent storage during setup.
+     *
+     * Returns ENOMEM and leaves @a result untouched if the arena is full.
+     */
+    int kaizen_arena_allocate_persistent(struct kaizen_arena_s* arena,
+                                         size_t size,
+                                         size_t alignment,
+                                         void** result);
+
+    /**
+     * Allocates @a size bytes aligned to @a alignment, a power of two, that
+     * stay allocated until the next call of kaizen_arena_reset_frame.
+     *
+     * Lock-free, can be called by multiple threads concurrently.
+     *
+     * Returns ENOMEM and leaves @a result untouched if the arena is full.
+     */
+    int kaizen_arena_allocate_frame(struct kaizen_arena_s* arena,
+                                    size_t size,
+                                    size_t alignment,
+                                    void** result);
+
+    /**
+     * Releases all frame allocations in O(1).
+     *
+     * Must not be called concurrently with frame allocations, e.g. call it
+     * at the frame mark after all threads finished the frame.
+     */
+    int kaizen_arena_reset_frame(struct kaizen_arena_s* arena);
+
+    size_t kaizen_arena_capacity(struct kaizen_arena_s const* arena);
+
+    size_t kaizen_arena_persistent_size(struct kaizen_arena_s const* arena);
+
+    size_t kaizen_arena_frame_size(struct kaizen_arena_s const* arena);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_arena_H */
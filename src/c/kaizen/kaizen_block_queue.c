@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_block_queue.h for all platforms.
+ *
+ * Each slot carries a sequence number: equal to the enqueue position when
+ * the slot is free for that position, one higher when its block is
+ * published and block_count higher once the consumer released it for the
+ * next round.
+ */
+
+#include "kaizen_block_queue.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_arena.h"
+#include "kaizen_thread_state.h"
+
+
+
+int kaizen_block_queue_init_from_arena(struct kaizen_block_queue_s* queue,
+                                       struct kaizen_arena_s* arena,
+                                       uint32_t block_count,
+                                       size_t block_size)
+{
+    assert(NULL != queue);
+    assert(NULL != arena);
+    assert(0 < block_count);
+    assert(0 == (block_count & (block_count - 1)));
+    assert(0 < block_size);
+
+    void* slots = NULL;
+    int errc = kaizen_arena_allocate_persistent(arena,
+                                                block_count * sizeof(struct kaizen_block_queue_slot_s),
+                                                KAIZEN_CACHE_LINE_SIZE,
+                                                &slots);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    void* blocks = NULL;
+    errc = kaizen_arena_allocate_persistent(arena,
+                                            block_count * block_size,
+                                            KAIZEN_CACHE_LINE_SIZE,
+                                            &blocks);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    queue->slots = (struct kaizen_block_queue_slot_s*)slots;
+    queue->blocks = (uint8_t*)blocks;
+    queue->block_size = block_size;
+    queue->block_count = block_count;
+    queue->dequeue_position = 0;
+
+    uint32_t i = 0;
+    for (i = 0; i < block_count; ++i) {
+        queue->slots[i].size = 0;
+        kaizen_atomic_uint32_store_release(&(queue->slots[i].sequence), i);
+    }
+
+    kaizen_atomic_uint32_store_release(&(queue->enqueue_position), 0);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_block_queue_finalize(struct kaizen_block_queue_s* queue)
+{
+    assert(NULL != queue);
+
+    queue->slots = NULL;
+    queue->blocks = NULL;
+    queue->block_size = 0;
+    queue->block_count = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+size_t kaizen_block_queue_block_size(struct kaizen_block_queue_s const* queue)
+{
+    assert(NULL != queue);
+
+    return queue->block_size;
+}
+
+
+
+int kaizen_block_queue_try_push_begin(struct kaizen_block_queue_s* queue,
+                                      uint8_t** block,
+                                      uint32_t* ticket)
+{
+    assert(NULL != queue);
+    assert(NULL != block);
+    assert(NULL != ticket);
+
+    uint32_t const mask = queue->block_count - 1;
+    uint32_t position = kaizen_atomic_uint32_load_acquire(&(queue->enqueue_position));
+
+    for (;;) {
+
+        struct kaizen_block_queue_slot_s* const slot = &(queue->slots[position & mask]);
+        uint32_t const sequence = kaizen_atomic_uint32_load_acquire(&(slot->sequence));
+        int32_t const difference = (int32_t)(sequence - position);
+
+        if (0 == difference) {
+
+            if (KAIZEN_TRUE == kaizen_atomic_uint32_compare_and_swap(&(queue->enqueue_position),
+                                                                     position,
+                                                                     position + 1)) {
+
+                *block = queue->blocks + (size_t)(position & mask) * queue->block_size;
+                *ticket = position;
+
+                return KAIZEN_SUCCESS;
+            }
+
+        } else if (0 > difference) {
+
+            return EAGAIN;
+        }
+
+        position = kaizen_atomic_uint32_load_acquire(&(queue->enqueue_position));
+    }
+}
+
+
+
+void kaizen_block_queue_push_end(struct kaizen_block_queue_s* queue,
+                                 uint32_t ticket,
+                                 size_t size)
+{
+    assert(NULL != queue);
+    assert(size <= queue->block_size);
+
+    struct kaizen_block_queue_slot_s* const slot = &(queue->slots[ticket & (queue->block_count - 1)]);
+
+    slot->size = (uint32_t)size;
+    kaizen_atomic_uint32_store_release(&(slot->sequence), ticket + 1);
+}
+
+
+
+int kaizen_block_queue_try_pop_begin(struct kaizen_block_queue_s* queue,
+                                     uint8_t const** block,
+                                     size_t* size)
+{
+    assert(NULL != queue);
+    assert(NULL != block);
+    assert(NULL != size);
+
+    uint32_t const position = queue->dequeue_position;
+    uint32_t const index = position & (queue->block_count - 1);
+    struct kaizen_block_queue_slot_s const* const slot = &(queue->slots[index]);
+
+    if (position + 1 != kaizen_atomic_uint32_load_acquire(&(slot->sequence))) {
+        return EAGAIN;
+    }
+
+    *block = queue->blocks + (size_t)index * queue->block_size;
+    *size = slot->size;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+void kaizen_block_queue_pop_end(struct kaizen_block_queue_s* queue)
+{
+    assert(NULL != queue);
+
+    uint32_t const position = queue->dequeue_position;
+    struct kaizen_block_queue_slot_s* const slot = &(queue->slots[position & (queue->block_count - 1)]);
+
+    kaizen_atomic_uint32_store_release(&(slot->sequence), position + queue->block_count);
+    queue->dequeue_position = position + 1;
+}
+
+
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Bounded lock-free queue of fixed size byte blocks with any number of
+ * producers and a single consumer.
+ *
+ * Producers never block: if all blocks are in use pushing fails with
+ * EAGAIN and the producer decides what to drop. Blocks are written and read
+ * in place, no data is copied by the queue.
+ *
+ * <code>
+ * uint8_t* block = NULL;
+ * uint32_t ticket = 0;
+ * if (KAIZEN_SUCCESS == kaizen_block_queue_try_push_begin(&queue, &block, &ticket)) {
+ *     // write up to kaizen_block_queue_block_size(&queue) bytes to block
+ *     kaizen_block_queue_push_end(&queue, ticket, written_size);
+ * }
+ * </code>
+ *
+ * Based on Dmitry Vyukov's bounded MPMC queue.
+ * See http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ */
+
+#ifndef KAIZEN_kaizen_block_queue_H
+#define KAIZEN_kaizen_block_queue_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_atomic.h>
+#include <kaizen/kaizen_arena.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_block_queue_slot_s {
+        struct kaizen_atomic_uint32_s sequence;
+        uint32_t size;
+    };
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_block_queue_s {
+        struct kaizen_atomic_uint32_s enqueue_position;
+        uint32_t dequeue_position;
+        uint32_t block_count;
+        struct kaizen_block_queue_slot_s* slots;
+        uint8_t* blocks;
+        size_t block_size;
+    };
+    typedef struct kaizen_block_queue_s kaizen_block_queue_t;
+
+
+
+    /**
+     * Allocates @a block_count blocks of @a block_size bytes each from the
+     * persistent part of @a arena.
+     *
+     * @a block_count must be a power of two.
+     *
+     * Returns ENOMEM if the arena is full.
+     */
+    int kaizen_block_queue_init_from_arena(struct kaizen_block_queue_s* queue,
+                                           struct kaizen_arena_s* arena,
+                                           uint32_t block_count,
+                                           size_t block_size);
+
+    int kaizen_block_queue_finalize(struct kaizen_block_queue_s* queue);
+
+    size_t kaizen_block_queue_block_size(struct kaizen_block_queue_s const* queue);
+
+    /**
+     * Reserves the next free block for writing.
+     *
+     * Returns EAGAIN if all blocks are in use.
+     */
+    int kaizen_block_queue_try_push_begin(struct kaizen_block_queue_s* queue,
+                                          uint8_t** block,
+                                          uint32_t* ticket);
+
+    /**
+     * Publishes the block reserved with @a ticket containing @a size bytes
+     * to the consumer.
+     */
+    void kaizen_block_queue_push_end(struct kaizen_block_queue_s* queue,
+                                     uint32_t ticket,
+                                     size_t size);
+
+    /**
+     * Returns the oldest published block. Only call from the consumer.
+     *
+     * Returns EAGAIN if no block is published.
+     */
+    int kaizen_block_queue_try_pop_begin(struct kaizen_block_queue_s* queue,
+                                         uint8_t const** block,
+                                         size_t* size);
+
+    /**
+     * Returns the block returned by the last kaizen_block_queue_try_pop_begin
+     * to the producers.
+     */
+    void kaizen_block_queue_pop_end(struct kaizen_block_queue_s* queue);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_block_queue_H */
@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_callstack.h for all platforms.
+ *
+ * The table uses open addressing with linear probing. A thread claims an
+ * empty entry with a compare and swap, fills it and publishes it with a
+ * release store, lookups skip entries not published yet. Entries are never
+ * removed, so the id of a stack, its entry index plus one, stays valid for
+ * the lifetime of the table.
+ *
+ * Frame pointers are read with __builtin_frame_address of GCC and Clang,
+ * other compilers report ENOSYS.
+ */
+
+#include "kaizen_callstack.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_raw_thread.h"
+#include "kaizen_arena.h"
+#include "kaizen_event.h"
+#include "kaizen_internal_frame_pointer_walk.h"
+#include "kaizen_internal_thread_local.h"
+
+
+
+enum {
+    kaizen_internal_callstack_empty_entry = 0,
+    kaizen_internal_callstack_writing_entry,
+    kaizen_internal_callstack_ready_entry
+};
+
+/* Bounds lookups in crowded tables, the stack is dropped instead. */
+#define KAIZEN_INTERNAL_CALLSTACK_MAX_PROBE_COUNT 64u
+
+
+
+static KAIZEN_THREAD_LOCAL struct kaizen_callstack_table_s* kaizen_internal_current_thread_callstack_table = NULL;
+
+static KAIZEN_THREAD_LOCAL kaizen_bool kaizen_internal_callstack_has_stack_bounds = KAIZEN_FALSE;
+
+static KAIZEN_THREAD_LOCAL int kaizen_internal_callstack_stack_bounds_errc = KAIZEN_SUCCESS;
+
+static KAIZEN_THREAD_LOCAL size_t kaizen_internal_callstack_stack_low = 0;
+
+static KAIZEN_THREAD_LOCAL size_t kaizen_internal_callstack_stack_high = 0;
+
+
+
+static uint64_t kaizen_internal_callstack_hash(uint64_t const* frames,
+                                               uint32_t depth);
+uint64_t kaizen_internal_callstack_hash(uint64_t const* frames,
+                                        uint32_t depth)
+{
+    uint64_t hash = (uint64_t)0x9e3779b97f4a7c15ull ^ depth;
+
+    uint32_t i = 0;
+    for (i = 0; i < depth; ++i) {
+        hash ^= frames[i];
+        hash *= (uint64_t)0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+    }
+
+    return hash;
+}
+
+
+
+static kaizen_bool kaizen_internal_callstack_entry_equals(struct kaizen_callstack_entry_s const* entry,
+                                                          uint64_t hash,
+                                                          uint64_t const* frames,
+                                                          uint32_t depth);
+kaizen_bool kaizen_internal_callstack_entry_equals(struct kaizen_callstack_entry_s const* entry,
+                                                   uint64_t hash,
+                                                   uint64_t const* frames,
+                                                   uint32_t depth)
+{
+    if (entry->hash != hash || entry->depth != depth) {
+        return KAIZEN_FALSE;
+    }
+
+    uint32_t i = 0;
+    for (i = 0; i < depth; ++i) {
+        if (entry->frames[i] != frames[i]) {
+            return KAIZEN_FALSE;
+        }
+    }
+
+    return KAIZEN_TRUE;
+}
+
+
+
+/**
+ * Records the kaizen_callstack_event_type event of @a stack_id followed by
+ * one kaizen_stack_frame_event_type event per return address.
+ */
+static int kaizen_internal_callstack_record_definition(uint32_t stack_id,
+                                                       struct kaizen_raw_frame_time_s const* time,
+                                                       uint64_t const* frames,
+                                                       uint32_t depth);
+int kaizen_internal_callstack_record_definition(uint32_t stack_id,
+                                                struct kaizen_raw_frame_time_s const* time,
+                                                uint64_t const* frames,
+                                                uint32_t depth)
+{
+    struct kaizen_raw_frame_time_s const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+    int errc = kaizen_event_record_with_flags(kaizen_callstack_event_type,
+                                              stack_id,
+                                              time,
+                                              &zero,
+                                              0u,
+                                              (uint16_t)depth);
+
+    uint32_t i = 0;
+    for (i = 0; i < depth && KAIZEN_SUCCESS == errc; ++i) {
+        errc = kaizen_event_record_with_flags(kaizen_stack_frame_event_type,
+                                              stack_id,
+                                              time,
+                                              &zero,
+                                              frames[i],
+                                              (uint16_t)i);
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_callstack_table_init_from_arena(struct kaizen_callstack_table_s* table,
+                                           struct kaizen_arena_s* arena,
+                                           uint32_t capacity)
+{
+    assert(NULL != table);
+    assert(NULL != arena);
+
+    if (0u == capacity || 0u != (capacity & (capacity - 1u))) {
+        return EINVAL;
+    }
+
+    void* entries = NULL;
+    int const errc = kaizen_arena_allocate_persistent(arena,
+                                                      (size_t)capacity * sizeof(struct kaizen_callstack_entry_s),
+                                                      sizeof(uint64_t),
+                                                      &entries);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    table->entries = (struct kaizen_callstack_entry_s*)entries;
+    table->capacity = capacity;
+
+    uint32_t i = 0;
+    for (i = 0; i < capacity; ++i) {
+        kaizen_atomic_uint32_store_release(&(table->entries[i].state), kaizen_internal_callstack_empty_entry);
+        table->entries[i].depth = 0u;
+        table->entries[i].hash = 0u;
+    }
+
+    kaizen_atomic_uint32_store_release(&(table->count), 0u);
+    kaizen_atomic_uint32_store_release(&(table->dropped_count), 0u);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_callstack_table_finalize(struct kaizen_callstack_table_s* table)
+{
+    assert(NULL != table);
+    assert(kaizen_internal_current_thread_callstack_table != table);
+
+    table->entries = NULL;
+    table->capacity = 0u;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_callstack_table_intern(struct kaizen_callstack_table_s* table,
+                                  uint64_t const* frames,
+                                  uint32_t depth,
+                                  uint32_t* stack_id,
+                                  kaizen_bool* is_new)
+{
+    assert(NULL != table);
+    assert(NULL != frames);
+    assert(NULL != stack_id);
+    assert(NULL != is_new);
+
+    if (0u == depth || KAIZEN_CALLSTACK_MAX_DEPTH < depth) {
+        return EINVAL;
+    }
+
+    uint64_t const hash = kaizen_internal_callstack_hash(frames, depth);
+    uint32_t const mask = table->capacity - 1u;
+    uint32_t index = (uint32_t)(hash ^ (hash >> 32)) & mask;
+
+    uint32_t probe = 0;
+    for (probe = 0; probe < table->capacity && probe < KAIZEN_INTERNAL_CALLSTACK_MAX_PROBE_COUNT; ++probe) {
+        struct kaizen_callstack_entry_s* const entry = &(table->entries[index]);
+        uint32_t state = kaizen_atomic_uint32_load_acquire(&(entry->state));
+
+        if (kaizen_internal_callstack_empty_entry == state
+            && KAIZEN_TRUE == kaizen_atomic_uint32_compare_and_swap(&(entry->state),
+                                                                    kaizen_internal_callstack_empty_entry,
+                                                                    kaizen_internal_callstack_writing_entry)) {
+
+            entry->hash = hash;
+            entry->depth = depth;
+
+            uint32_t i = 0;
+            for (i = 0; i < depth; ++i) {
+                entry->frames[i] = frames[i];
+            }
+
+            kaizen_atomic_uint32_store_release(&(entry->state), kaizen_internal_callstack_ready_entry);
+            (void)kaizen_atomic_uint32_fetch_add(&(table->count), 1u);
+
+            *stack_id = index + 1u;
+            *is_new = KAIZEN_TRUE;
+
+            return KAIZEN_SUCCESS;
+        }
+
+        /* The entry is taken. Wait until its writer is done with it so a
+         * stack added concurrently by another thread gets one id instead of
+         * probing past it and adding a duplicate.
+         */
+        state = kaizen_atomic_uint32_load_acquire(&(entry->state));
+        while (kaizen_internal_callstack_writing_entry == state) {
+            kaizen_atomic_cpu_relax();
+            state = kaizen_atomic_uint32_load_acquire(&(entry->state));
+        }
+        assert(kaizen_internal_callstack_ready_entry == state);
+
+        if (KAIZEN_TRUE == kaizen_internal_callstack_entry_equals(entry, hash, frames, depth)) {
+
+            *stack_id = index + 1u;
+            *is_new = KAIZEN_FALSE;
+
+            return KAIZEN_SUCCESS;
+        }
+
+        index = (index + 1u) & mask;
+    }
+
+    (void)kaizen_atomic_uint32_fetch_add(&(table->dropped_count), 1u);
+
+    return ENOMEM;
+}
+
+
+
+int kaizen_callstack_table_frames(struct kaizen_callstack_table_s const* table,
+                                  uint32_t stack_id,
+                                  uint64_t* frames,
+                                  uint32_t* depth)
+{
+    assert(NULL != table);
+    assert(NULL != frames);
+    assert(NULL != depth);
+
+    if (KAIZEN_CALLSTACK_NO_ID == stack_id || table->capacity < stack_id) {
+        return ESRCH;
+    }
+
+    struct kaizen_callstack_entry_s const* const entry = &(table->entries[stack_id - 1u]);
+
+    if (kaizen_internal_callstack_ready_entry != kaizen_atomic_uint32_load_acquire(&(entry->state))) {
+        return ESRCH;
+    }
+
+    uint32_t i = 0;
+    for (i = 0; i < entry->depth; ++i) {
+        frames[i] = entry->frames[i];
+    }
+
+    *depth = entry->depth;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+uint32_t kaizen_callstack_table_count(struct kaizen_callstack_table_s const* table)
+{
+    assert(NULL != table);
+
+    return kaizen_atomic_uint32_load_acquire(&(table->count));
+}
+
+
+
+uint32_t kaizen_callstack_table_dropped_count(struct kaizen_callstack_table_s const* table)
+{
+    assert(NULL != table);
+
+    return kaizen_atomic_uint32_load_acquire(&(table->dropped_count));
+}
+
+
+
+int kaizen_callstack_table_record_definitions(struct kaizen_callstack_table_s const* table,
+                                              struct kaizen_raw_frame_time_s const* time)
+{
+    assert(NULL != table);
+    assert(NULL != time);
+
+    int errc = KAIZEN_SUCCESS;
+
+    uint32_t i = 0;
+    for (i = 0; i < table->capacity && KAIZEN_SUCCESS == errc; ++i) {
+        struct kaizen_callstack_entry_s const* const entry = &(table->entries[i]);
+
+        if (kaizen_internal_callstack_ready_entry == kaizen_atomic_uint32_load_acquire(&(entry->state))) {
+            errc = kaizen_internal_callstack_record_definition(i + 1u, time, entry->frames, entry->depth);
+        }
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_callstack_table_attach_to_current_thread(struct kaizen_callstack_table_s* table)
+{
+    kaizen_internal_current_thread_callstack_table = table;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+struct kaizen_callstack_table_s* kaizen_callstack_table_of_current_thread(void)
+{
+    return kaizen_internal_current_thread_callstack_table;
+}
+
+
+
+int kaizen_callstack_capture(uint32_t skip_count,
+                             uint32_t max_depth,
+                             uint64_t* frames,
+                             uint32_t* depth)
+{
+    assert(NULL != frames);
+    assert(NULL != depth);
+    assert(KAIZEN_CALLSTACK_MAX_DEPTH >= max_depth);
+
+    *depth = 0u;
+
+#if defined(__GNUC__)
+    if (KAIZEN_FALSE == kaizen_internal_callstack_has_stack_bounds) {
+        kaizen_internal_callstack_stack_bounds_errc = kaizen_thread_stack_bounds(&kaizen_internal_callstack_stack_low,
+                                                                                 &kaizen_internal_callstack_stack_high);
+        kaizen_internal_callstack_has_stack_bounds = KAIZEN_TRUE;
+    }
+
+    if (KAIZEN_SUCCESS != kaizen_internal_callstack_stack_bounds_errc) {
+        return kaizen_internal_callstack_stack_bounds_errc;
+    }
+
+    uint64_t addresses[2 * KAIZEN_CALLSTACK_MAX_DEPTH];
+    uint32_t const skipped = (KAIZEN_CALLSTACK_MAX_DEPTH < skip_count) ? KAIZEN_CALLSTACK_MAX_DEPTH : skip_count;
+    uint32_t const count = kaizen_internal_frame_pointer_walk((size_t)__builtin_frame_address(0),
+                                                              kaizen_internal_callstack_stack_low,
+                                                              kaizen_internal_callstack_stack_high,
+                                                              addresses,
+                                                              skipped + max_depth);
+
+    uint32_t i = 0;
+    for (i = skipped; i < count; ++i) {
+        frames[i - skipped] = addresses[i];
+    }
+
+    *depth = (count > skipped) ? count - skipped : 0u;
+
+    return KAIZEN_SUCCESS;
+#else
+    (void)skip_count;
+    (void)max_depth;
+
+    return ENOSYS;
+#endif
+}
+
+
+
+int kaizen_callstack_record(uint32_t zone_id,
+                            struct kaizen_raw_frame_time_s const* time,
+                            struct kaizen_raw_frame_time_s const* duration,
+                            uint64_t const* frames,
+                            uint32_t depth)
+{
+    assert(NULL != time);
+    assert(NULL != duration);
+    assert(NULL != frames);
+
+    struct kaizen_callstack_table_s* const table = kaizen_internal_current_thread_callstack_table;
+
+    if (NULL == table) {
+        return ESRCH;
+    }
+
+    uint32_t stack_id = KAIZEN_CALLSTACK_NO_ID;
+    kaizen_bool is_new = KAIZEN_FALSE;
+    int errc = kaizen_callstack_table_intern(table, frames, depth, &stack_id, &is_new);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    if (KAIZEN_TRUE == is_new) {
+        errc = kaizen_internal_callstack_record_definition(stack_id, time, frames, depth);
+
+        if (KAIZEN_SUCCESS != errc) {
+            return errc;
+        }
+    }
+
+    return kaizen_event_record(kaizen_zone_callstack_event_type,
+                               zone_id,
+                               time,
+                               duration,
+                               stack_id);
+}
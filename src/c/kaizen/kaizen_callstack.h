@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Short call stacks of selected zones, e.g. to find which caller made a hot
+ * generic zone like "allocate" or "lock" slow.
+ *
+ * Stacks are captured by walking the frame pointers of the calling thread
+ * (compile with frame pointers, e.g. -fno-omit-frame-pointer) and interned
+ * in a lock-free table shared by all threads, so each distinct stack gets
+ * one id and repeated stacks only cost the walk and a lookup.
+ *
+ * Attach a table to each thread recording stacks and enable stacks per
+ * zone with kaizen_zone_set_callstack_depth (see kaizen_zone.h). Every
+ * recorded execution of such a zone is followed by a
+ * kaizen_zone_callstack_event_type event with the stack id. The thread that
+ * interns a new stack records its definition, a kaizen_callstack_event_type
+ * event followed by its kaizen_stack_frame_event_type events, once (see
+ * kaizen_event.h).
+ *
+ * Stacks are only walked inside the stack bounds of the thread (see
+ * kaizen_thread_stack_bounds of kaizen_raw_thread.h), zones of fibers
+ * running on their own stacks record no stacks. Platforms without frame
+ * pointer access or stack bounds report ENOSYS.
+ */
+
+#ifndef KAIZEN_kaizen_callstack_H
+#define KAIZEN_kaizen_callstack_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_atomic.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_arena.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Return addresses stored per stack.
+     */
+#define KAIZEN_CALLSTACK_MAX_DEPTH 16
+
+    /**
+     * Stack id never handed out.
+     */
+#define KAIZEN_CALLSTACK_NO_ID 0u
+
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_callstack_entry_s {
+        struct kaizen_atomic_uint32_s state;
+        uint32_t depth;
+        uint64_t hash;
+        uint64_t frames[KAIZEN_CALLSTACK_MAX_DEPTH];
+    };
+    typedef struct kaizen_callstack_entry_s kaizen_callstack_entry_t;
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_callstack_table_s {
+        struct kaizen_callstack_entry_s* entries;
+        uint32_t capacity;
+        struct kaizen_atomic_uint32_s count;
+        struct kaizen_atomic_uint32_s dropped_count;
+    };
+    typedef struct kaizen_callstack_table_s kaizen_callstack_table_t;
+
+
+
+    /**
+     * Initializes @a table to hold @a capacity distinct stacks, a power of
+     * two, allocated from the persistent part of @a arena. Keep the table
+     * at most three quarters full to keep lookups short.
+     *
+     * Returns ENOMEM if the arena is full.
+     */
+    int kaizen_callstack_table_init_from_arena(struct kaizen_callstack_table_s* table,
+                                               struct kaizen_arena_s* arena,
+                                               uint32_t capacity);
+
+    /**
+     * Must not be attached to any thread.
+     */
+    int kaizen_callstack_table_finalize(struct kaizen_callstack_table_s* table);
+
+    /**
+     * Stores the id of the stack of @a depth return addresses in @a frames,
+     * innermost first, in @a stack_id. Adds the stack if it is new and sets
+     * @a is_new then. Can be called by many threads concurrently, a thread
+     * meeting a stack another thread is adding waits until it is added, so
+     * each stack gets exactly one id. Do not call it from signal handlers.
+     *
+     * Returns EINVAL if depth is 0 or greater than
+     * KAIZEN_CALLSTACK_MAX_DEPTH and ENOMEM if the table is too full to add
+     * the stack, which is counted as dropped.
+     */
+    int kaizen_callstack_table_intern(struct kaizen_callstack_table_s* table,
+                                      uint64_t const* frames,
+                                      uint32_t depth,
+                                      uint32_t* stack_id,
+                                      kaizen_bool* is_new);
+
+    /**
+     * Copies the return addresses of @a stack_id into @a frames, which must
+     * hold KAIZEN_CALLSTACK_MAX_DEPTH addresses, and the depth into
+     * @a depth.
+     *
+     * Returns ESRCH if the table has no stack with this id.
+     */
+    int kaizen_callstack_table_frames(struct kaizen_callstack_table_s const* table,
+                                      uint32_t stack_id,
+                                      uint64_t* frames,
+                                      uint32_t* depth);
+
+    /**
+     * Returns the number of distinct stacks.
+     */
+    uint32_t kaizen_callstack_table_count(struct kaizen_callstack_table_s const* table);
+
+    /**
+     * Returns the number of stacks not added because the table was full.
+     */
+    uint32_t kaizen_callstack_table_dropped_count(struct kaizen_callstack_table_s const* table);
+
+    /**
+     * Records the definitions of all stacks at @a time into the event
+     * buffer of the calling thread, e.g. for a viewer connecting to the
+     * stream server after the stacks were first recorded, or after a full
+     * event buffer dropped a definition.
+     *
+     * Returns ESRCH if the calling thread has no event buffer attached and
+     * ENOMEM if it is full.
+     */
+    int kaizen_callstack_table_record_definitions(struct kaizen_callstack_table_s const* table,
+                                                  struct kaizen_raw_frame_time_s const* time);
+
+    /**
+     * Attaches @a table to the calling thread so its zones with stacks
+     * enabled record them. Pass NULL to detach the current table.
+     */
+    int kaizen_callstack_table_attach_to_current_thread(struct kaizen_callstack_table_s* table);
+
+    /**
+     * Returns the table attached to the calling thread or NULL.
+     */
+    struct kaizen_callstack_table_s* kaizen_callstack_table_of_current_thread(void);
+
+
+
+    /**
+     * Walks the stack of the calling thread from the call of this function
+     * outwards, skips the innermost @a skip_count return addresses and
+     * stores at most @a max_depth of the following ones in @a frames and
+     * their number in @a depth. max_depth must not exceed
+     * KAIZEN_CALLSTACK_MAX_DEPTH.
+     *
+     * Returns ENOSYS if the platform offers no frame pointers or stack
+     * bounds.
+     */
+    int kaizen_callstack_capture(uint32_t skip_count,
+                                 uint32_t max_depth,
+                                 uint64_t* frames,
+                                 uint32_t* depth);
+
+    /**
+     * Interns the stack of @a depth return addresses in @a frames in the
+     * table attached to the calling thread and records a
+     * kaizen_zone_callstack_event_type event for the zone execution with
+     * @a zone_id, @a time and @a duration, preceded by the stack
+     * definition if it is new. Called by kaizen_zone_end.
+     *
+     * Returns ESRCH if the calling thread has no table or event buffer
+     * attached, ENOMEM if the table or event buffer is full.
+     */
+    int kaizen_callstack_record(uint32_t zone_id,
+                                struct kaizen_raw_frame_time_s const* time,
+                                struct kaizen_raw_frame_time_s const* duration,
+                                uint64_t const* frames,
+                                uint32_t depth);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_callstack_H */
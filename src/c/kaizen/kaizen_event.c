@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_event.h for all platforms.
+ */
+
+#include "kaizen_event.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_internal_thread_local.h"
+#include "kaizen_arena.h"
+#include "kaizen_event_channel.h"
+
+
+
+static KAIZEN_THREAD_LOCAL struct kaizen_event_buffer_s* kaizen_internal_current_thread_event_buffer = NULL;
+
+
+
+int kaizen_event_buffer_init(struct kaizen_event_buffer_s* buffer,
+                             struct kaizen_event_s* storage,
+                             size_t capacity)
+{
+    assert(NULL != buffer);
+    assert(NULL != storage);
+    assert(0 < capacity);
+
+    buffer->events = storage;
+    buffer->capacity = capacity;
+    buffer->count = 0;
+    buffer->dropped_count = 0;
+    buffer->channel = NULL;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_buffer_init_from_arena(struct kaizen_event_buffer_s* buffer,
+                                        struct kaizen_arena_s* arena,
+                                        size_t capacity)
+{
+    assert(NULL != buffer);
+    assert(NULL != arena);
+    assert(0 < capacity);
+
+    void* storage = NULL;
+    int const errc = kaizen_arena_allocate_persistent(arena,
+                                                      capacity * sizeof(struct kaizen_event_s),
+                                                      KAIZEN_ARENA_DEFAULT_ALIGNMENT,
+                                                      &storage);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    return kaizen_event_buffer_init(buffer,
+                                    (struct kaizen_event_s*)storage,
+                                    capacity);
+}
+
+
+
+int kaizen_event_buffer_finalize(struct kaizen_event_buffer_s* buffer)
+{
+    assert(NULL != buffer);
+    assert(kaizen_internal_current_thread_event_buffer != buffer);
+
+    buffer->events = NULL;
+    buffer->capacity = 0;
+    buffer->count = 0;
+    buffer->dropped_count = 0;
+    buffer->channel = NULL;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_buffer_clear(struct kaizen_event_buffer_s* buffer)
+{
+    assert(NULL != buffer);
+
+    buffer->count = 0;
+    buffer->dropped_count = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_buffer_push(struct kaizen_event_buffer_s* buffer,
+                             struct kaizen_event_s const* event)
+{
+    assert(NULL != buffer);
+    assert(NULL != event);
+
+    size_t const count = buffer->count;
+
+    if (count < buffer->capacity) {
+
+        buffer->events[count] = *event;
+        buffer->count = count + 1;
+
+        return KAIZEN_SUCCESS;
+    }
+
+    ++(buffer->dropped_count);
+
+    return ENOMEM;
+}
+
+
+
+size_t kaizen_event_buffer_count(struct kaizen_event_buffer_s const* buffer)
+{
+    assert(NULL != buffer);
+
+    return buffer->count;
+}
+
+
+
+size_t kaizen_event_buffer_dropped_count(struct kaizen_event_buffer_s const* buffer)
+{
+    assert(NULL != buffer);
+
+    return buffer->dropped_count;
+}
+
+
+
+struct kaizen_event_s const* kaizen_event_buffer_at(struct kaizen_event_buffer_s const* buffer,
+                                                    size_t index)
+{
+    assert(NULL != buffer);
+    assert(index < buffer->count);
+
+    return &(buffer->events[index]);
+}
+
+
+
+int kaizen_event_buffer_attach_to_current_thread(struct kaizen_event_buffer_s* buffer)
+{
+    kaizen_internal_current_thread_event_buffer = buffer;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+struct kaizen_event_buffer_s* kaizen_event_buffer_of_current_thread(void)
+{
+    return kaizen_internal_current_thread_event_buffer;
+}
+
+
+
+int kaizen_event_record(kaizen_event_type_t type,
+                        uint32_t id,
+                        struct kaizen_raw_frame_time_s const* time,
+                        struct kaizen_raw_frame_time_s const* duration,
+                        uint64_t value)
+{
+    assert(NULL != time);
+    assert(NULL != duration);
+
+    return kaizen_event_record_with_flags(type, id, time, duration, value, 0);
+}
+
+
+
+int kaizen_event_record_with_flags(kaizen_event_type_t type,
+                                   uint32_t id,
+                                   struct kaizen_raw_frame_time_s const* time,
+                                   struct kaizen_raw_frame_time_s const* duration,
+                                   uint64_t value,
+                                   uint16_t flags)
+{
+    assert(NULL != time);
+    assert(NULL != duration);
+
+    struct kaizen_event_buffer_s* buffer = kaizen_internal_current_thread_event_buffer;
+
+    if (NULL == buffer) {
+        return ESRCH;
+    }
+
+    struct kaizen_event_s event;
+    event.time = *time;
+    event.duration = *duration;
+    event.value = value;
+    event.id = id;
+    event.type = (uint16_t)type;
+    event.flags = flags;
+
+    /* Channels publish once per block, not per event. */
+    if (NULL != buffer->channel && buffer->count == buffer->capacity) {
+        (void)kaizen_event_channel_flush(buffer->channel);
+    }
+
+    int const errc = kaizen_event_buffer_push(buffer, &event);
+
+    if (NULL != buffer->channel && kaizen_frame_event_type == type) {
+        (void)kaizen_event_channel_flush(buffer->channel);
+    }
+
+    return errc;
+}
+
+
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Profiling events and per thread event buffers.
+ *
+ * An event stores when something happened (time), how long it took
+ * (duration, zero for instant events), an id identifying the source (e.g. a
+ * lock id) and a type specific value.
+ *
+ * Instrumentation records events into the event buffer attached to the
+ * calling thread. Threads without an attached buffer drop events silently,
+ * therefore instrumented code runs unchanged in threads nobody profiles.
+ *
+ * An event buffer must only be written to by the thread it is attached to
+ * and must only be read or cleared while it is not written to, e.g. by the
+ * owning thread at the end of a frame.
+ */
+
+#ifndef KAIZEN_kaizen_event_H
+#define KAIZEN_kaizen_event_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_arena.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * kaizen_lock_wait_event_type: time is the wait start, duration the
+     *     wait until the lock was acquired, id the lock id.
+     * kaizen_lock_hold_event_type: time is the acquisition, duration the
+     *     time the lock was held, id the lock id.
+     * kaizen_zone_event_type: time is the zone begin, duration the zone
+     *     runtime, id the zone id and value the sample interval N the zone
+     *     was recorded with (the event represents N executions). flags
+     *     combine the KAIZEN_ZONE_EVENT_*_FLAG values.
+     * kaizen_frame_event_type: time is the frame begin, duration the frame
+     *     time, value the frame number. Analysis tools attribute events to
+     *     the frame they begin in.
+     * kaizen_hardware_counter_event_type: follows the zone event it was
+     *     measured in with the same time, duration and id, value is the
+     *     counter delta and flags the kaizen_hardware_counter (see
+     *     kaizen_raw_hardware_counters.h).
+     * kaizen_allocation_event_type, kaizen_deallocation_event_type: time is
+     *     the (de)allocation, duration zero, id the innermost open zone id
+     *     and value the size in bytes (see kaizen_allocation.h).
+     * kaizen_sample_event_type: time is the sample, duration zero, id the
+     *     innermost zone id or KAIZEN_SAMPLE_NO_ZONE_ID, value the marked
+     *     frame number and flags the stack depth (see kaizen_raw_sampler.h).
+     * kaizen_stack_frame_event_type: follows the sample event it belongs to
+     *     with the same time and id, value is the stack address and flags
+     *     the index of the frame, innermost first. Also follows the
+     *     kaizen_callstack_event_type event it belongs to.
+     * kaizen_callstack_event_type: defines the stack with the id, flags is
+     *     the number of kaizen_stack_frame_event_type events following it
+     *     (see kaizen_callstack.h).
+     * kaizen_zone_callstack_event_type: follows the zone event it was
+     *     captured in with the same time, duration and id, value is the
+     *     stack id.
+     * kaizen_zone_name_event_type: names the zone with the id, value holds
+     *     eight bytes of the name, the first in the lowest byte, and flags
+     *     the index of the eight bytes in the name. The events of a name
+     *     follow each other and end with a zero byte (see
+     *     kaizen_zone_record_name of kaizen_zone.h).
+     */
+    enum kaizen_event_type {
+        kaizen_unknown_event_type = 0,
+        kaizen_lock_wait_event_type,
+        kaizen_lock_hold_event_type,
+        kaizen_zone_event_type,
+        kaizen_frame_event_type,
+        kaizen_hardware_counter_event_type,
+        kaizen_allocation_event_type,
+        kaizen_deallocation_event_type,
+        kaizen_sample_event_type,
+        kaizen_stack_frame_event_type,
+        kaizen_callstack_event_type,
+        kaizen_zone_callstack_event_type,
+        kaizen_zone_name_event_type
+    };
+    typedef enum kaizen_event_type kaizen_event_type_t;
+
+
+    /**
+     * Flags of zone events recorded while a scheduling monitor was attached
+     * (see kaizen_raw_scheduling_monitor.h): the scheduler preempted the
+     * thread during the zone, the thread moved to another processor, or it
+     * blocked (switched out voluntarily, e.g. waiting on a lock).
+     */
+#define KAIZEN_ZONE_EVENT_DESCHEDULED_FLAG 0x1u
+#define KAIZEN_ZONE_EVENT_MIGRATED_FLAG 0x2u
+#define KAIZEN_ZONE_EVENT_BLOCKED_FLAG 0x4u
+
+    /**
+     * Flag of zone events recorded by threads with a thread state (see
+     * kaizen_thread_state.h) if no zone of the thread state enclosed the
+     * zone, so analysis tools know no later event of the stream encloses it.
+     */
+#define KAIZEN_ZONE_EVENT_OUTERMOST_FLAG 0x8u
+
+
+
+    struct kaizen_event_s {
+        struct kaizen_raw_frame_time_s time;
+        struct kaizen_raw_frame_time_s duration;
+        uint64_t value;
+        uint32_t id;
+        uint16_t type;
+        uint16_t flags;
+    };
+    typedef struct kaizen_event_s kaizen_event_t;
+
+
+
+    struct kaizen_event_channel_s;
+
+
+    /**
+     * Fixed capacity event storage. Events pushed into a full buffer are
+     * dropped and counted.
+     *
+     * The buffer of an event channel (see kaizen_event_channel.h) publishes
+     * its events when it fills instead, and on frame events.
+     *
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_event_buffer_s {
+        struct kaizen_event_s* events;
+        size_t capacity;
+        size_t count;
+        size_t dropped_count;
+        struct kaizen_event_channel_s* channel;
+    };
+    typedef struct kaizen_event_buffer_s kaizen_event_buffer_t;
+
+
+
+    /**
+     * Initializes @a buffer to store at most @a capacity events in the
+     * caller owned @a storage which must stay valid until the buffer is
+     * finalized.
+     *
+     * buffer and storage must not be NULL, capacity must be greater than 0.
+     */
+    int kaizen_event_buffer_init(struct kaizen_event_buffer_s* buffer,
+                                 struct kaizen_event_s* storage,
+                                 size_t capacity);
+
+    /**
+     * Initializes @a buffer with storage for @a capacity events allocated
+     * from the persistent part of @a arena.
+     *
+     * Returns ENOMEM if the arena is full.
+     */
+    int kaizen_event_buffer_init_from_arena(struct kaizen_event_buffer_s* buffer,
+                                            struct kaizen_arena_s* arena,
+                                            size_t capacity);
+
+    /**
+     * @attention Detach the buffer from its thread before finalizing it.
+     */
+    int kaizen_event_buffer_finalize(struct kaizen_event_buffer_s* buffer);
+
+    /**
+     * Removes all events and resets the dropped counter.
+     */
+    int kaizen_event_buffer_clear(struct kaizen_event_buffer_s* buffer);
+
+    /**
+     * Copies @a event into @a buffer. Returns ENOMEM and counts the event as
+     * dropped if the buffer is full.
+     */
+    int kaizen_event_buffer_push(struct kaizen_event_buffer_s* buffer,
+                                 struct kaizen_event_s const* event);
+
+    size_t kaizen_event_buffer_count(struct kaizen_event_buffer_s const* buffer);
+
+    size_t kaizen_event_buffer_dropped_count(struct kaizen_event_buffer_s const* buffer);
+
+    /**
+     * Returns the event at @a index which must be lesser than the buffer
+     * count.
+     */
+    struct kaizen_event_s const* kaizen_event_buffer_at(struct kaizen_event_buffer_s const* buffer,
+                                                        size_t index);
+
+
+
+    /**
+     * Attaches @a buffer to the calling thread so events recorded by this
+     * thread are stored in it. Pass NULL to detach the current buffer.
+     */
+    int kaizen_event_buffer_attach_to_current_thread(struct kaizen_event_buffer_s* buffer);
+
+    /**
+     * Returns the event buffer attached to the calling thread or NULL.
+     */
+    struct kaizen_event_buffer_s* kaizen_event_buffer_of_current_thread(void);
+
+
+
+    /**
+     * Records an event into the buffer attached to the calling thread.
+     *
+     * Returns ESRCH if no buffer is attached and ENOMEM if the attached
+     * buffer is full.
+     *
+     * time and duration must not be NULL.
+     */
+    int kaizen_event_record(kaizen_event_type_t type,
+                            uint32_t id,
+                            struct kaizen_raw_frame_time_s const* time,
+                            struct kaizen_raw_frame_time_s const* duration,
+                            uint64_t value);
+
+    /**
+     * Records an event with type specific @a flags, see
+     * kaizen_event_record.
+     */
+    int kaizen_event_record_with_flags(kaizen_event_type_t type,
+                                       uint32_t id,
+                                       struct kaizen_raw_frame_time_s const* time,
+                                       struct kaizen_raw_frame_time_s const* duration,
+                                       uint64_t value,
+                                       uint16_t flags);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_event_H */
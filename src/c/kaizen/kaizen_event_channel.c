@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_event_channel.h for all platforms.
+ *
+ * Blocks form a ring. The producer owns published_block_count and the
+ * consumer released_block_count, block n lives at index n & (block_count -
+ * 1) and is free for the producer while fewer than block_count blocks are
+ * published but not released. The event buffer of the producer points into
+ * the block currently written, or has a capacity of 0 while no block is
+ * free so recording drops and counts events.
+ */
+
+#include "kaizen_event_channel.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_event.h"
+#include "kaizen_arena.h"
+#include "kaizen_thread_state.h"
+
+
+
+static void kaizen_internal_event_channel_acquire_block(struct kaizen_event_channel_s* channel);
+void kaizen_internal_event_channel_acquire_block(struct kaizen_event_channel_s* channel)
+{
+    struct kaizen_event_buffer_s* const buffer = &(channel->producer.event_buffer);
+    uint32_t const published = kaizen_atomic_uint32_load_acquire(&(channel->producer.published_block_count));
+    uint32_t const released = kaizen_atomic_uint32_load_acquire(&(channel->consumer.released_block_count));
+
+    buffer->count = 0;
+
+    if (published - released < channel->block_count) {
+        buffer->events = channel->blocks + (size_t)(published & (channel->block_count - 1)) * KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT;
+        buffer->capacity = KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT;
+        channel->producer.has_block = KAIZEN_TRUE;
+    } else {
+        buffer->capacity = 0;
+        channel->producer.has_block = KAIZEN_FALSE;
+    }
+}
+
+
+
+int kaizen_event_channel_init_from_arena(struct kaizen_event_channel_s* channel,
+                                         struct kaizen_arena_s* arena,
+                                         uint32_t block_count)
+{
+    assert(NULL != channel);
+    assert(NULL != arena);
+    assert(0 < block_count);
+    assert(0 == (block_count & (block_count - 1)));
+
+    void* blocks = NULL;
+    int errc = kaizen_arena_allocate_persistent(arena,
+                                                (size_t)block_count * KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT * sizeof(struct kaizen_event_s),
+                                                KAIZEN_CACHE_LINE_SIZE,
+                                                &blocks);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    void* block_event_counts = NULL;
+    errc = kaizen_arena_allocate_persistent(arena,
+                                            block_count * sizeof(uint32_t),
+                                            KAIZEN_CACHE_LINE_SIZE,
+                                            &block_event_counts);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    channel->blocks = (struct kaizen_event_s*)blocks;
+    channel->block_event_counts = (uint32_t*)block_event_counts;
+    channel->block_count = block_count;
+
+    errc = kaizen_event_buffer_init(&(channel->producer.event_buffer),
+                                    channel->blocks,
+                                    KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT);
+    assert(KAIZEN_SUCCESS == errc);
+    channel->producer.event_buffer.channel = channel;
+    channel->producer.has_block = KAIZEN_TRUE;
+
+    kaizen_atomic_uint32_store_release(&(channel->consumer.released_block_count), 0u);
+    kaizen_atomic_uint32_store_release(&(channel->producer.published_block_count), 0u);
+
+    return errc;
+}
+
+
+
+int kaizen_event_channel_finalize(struct kaizen_event_channel_s* channel)
+{
+    assert(NULL != channel);
+
+    int const errc = kaizen_event_buffer_finalize(&(channel->producer.event_buffer));
+
+    channel->blocks = NULL;
+    channel->block_event_counts = NULL;
+    channel->block_count = 0;
+
+    return errc;
+}
+
+
+
+int kaizen_event_channel_attach_to_current_thread(struct kaizen_event_channel_s* channel)
+{
+    return kaizen_event_buffer_attach_to_current_thread((NULL == channel) ? NULL : &(channel->producer.event_buffer));
+}
+
+
+
+struct kaizen_event_buffer_s* kaizen_event_channel_event_buffer(struct kaizen_event_channel_s* channel)
+{
+    assert(NULL != channel);
+
+    return &(channel->producer.event_buffer);
+}
+
+
+
+int kaizen_event_channel_flush(struct kaizen_event_channel_s* channel)
+{
+    assert(NULL != channel);
+
+    struct kaizen_event_buffer_s const* const buffer = &(channel->producer.event_buffer);
+
+    if (KAIZEN_TRUE == channel->producer.has_block) {
+
+        if (0 == buffer->count) {
+            return KAIZEN_SUCCESS;
+        }
+
+        uint32_t const published = kaizen_atomic_uint32_load_acquire(&(channel->producer.published_block_count));
+        channel->block_event_counts[published & (channel->block_count - 1)] = (uint32_t)buffer->count;
+
+        /* Publishes the events and their count to the consumer. */
+        kaizen_atomic_uint32_store_release(&(channel->producer.published_block_count), published + 1);
+    }
+
+    kaizen_internal_event_channel_acquire_block(channel);
+
+    return (KAIZEN_TRUE == channel->producer.has_block) ? KAIZEN_SUCCESS : EAGAIN;
+}
+
+
+
+size_t kaizen_event_channel_dropped_count(struct kaizen_event_channel_s const* channel)
+{
+    assert(NULL != channel);
+
+    return kaizen_event_buffer_dropped_count(&(channel->producer.event_buffer));
+}
+
+
+
+int kaizen_event_channel_try_pop_begin(struct kaizen_event_channel_s* channel,
+                                       struct kaizen_event_s const** events,
+                                       size_t* event_count)
+{
+    assert(NULL != channel);
+    assert(NULL != events);
+    assert(NULL != event_count);
+
+    uint32_t const released = kaizen_atomic_uint32_load_acquire(&(channel->consumer.released_block_count));
+
+    if (released == kaizen_atomic_uint32_load_acquire(&(channel->producer.published_block_count))) {
+        return EAGAIN;
+    }
+
+    uint32_t const index = released & (channel->block_count - 1);
+    *events = channel->blocks + (size_t)index * KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT;
+    *event_count = channel->block_event_counts[index];
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+void kaizen_event_channel_pop_end(struct kaizen_event_channel_s* channel)
+{
+    assert(NULL != channel);
+
+    uint32_t const released = kaizen_atomic_uint32_load_acquire(&(channel->consumer.released_block_count));
+
+    kaizen_atomic_uint32_store_release(&(channel->consumer.released_block_count), released + 1);
+}
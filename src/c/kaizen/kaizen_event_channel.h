@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Single producer single consumer channel publishing the events of one
+ * thread in blocks of KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT events.
+ *
+ * The producing thread attaches the channel, which attaches the event
+ * buffer of the channel (see kaizen_event.h). Recording stays a plain store
+ * into the current block, no atomic operation and no shared cache line is
+ * touched per event. The block is published to the consumer with a single
+ * release store when it is full, when a kaizen_frame_event_type event is
+ * recorded, or on kaizen_event_channel_flush.
+ *
+ * If the consumer falls behind and all blocks are published, events are
+ * dropped and counted until the consumer releases a block, recording never
+ * waits.
+ *
+ * <code>
+ * // Producer
+ * kaizen_event_channel_attach_to_current_thread(&channel);
+ *
+ * // Consumer, e.g. a drain thread
+ * struct kaizen_event_s const* events = NULL;
+ * size_t count = 0;
+ * while (KAIZEN_SUCCESS == kaizen_event_channel_try_pop_begin(&channel, &events, &count)) {
+ *     kaizen_stream_server_submit(&server, stream_id, events, count);
+ *     kaizen_event_channel_pop_end(&channel);
+ * }
+ * </code>
+ *
+ * Allocate channels as static or automatic variables - heap allocations via
+ * malloc are not guaranteed to be cache line aligned.
+ */
+
+#ifndef KAIZEN_kaizen_event_channel_H
+#define KAIZEN_kaizen_event_channel_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_atomic.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_thread_state.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+#define KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT 64
+
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct KAIZEN_CACHE_LINE_ALIGNED kaizen_event_channel_producer_s {
+        struct kaizen_event_buffer_s event_buffer;
+        struct kaizen_atomic_uint32_s published_block_count;
+        kaizen_bool has_block;
+    };
+
+    struct KAIZEN_CACHE_LINE_ALIGNED kaizen_event_channel_consumer_s {
+        struct kaizen_atomic_uint32_s released_block_count;
+    };
+
+    struct KAIZEN_CACHE_LINE_ALIGNED kaizen_event_channel_s {
+        struct kaizen_event_channel_producer_s producer;
+        struct kaizen_event_channel_consumer_s consumer;
+        struct kaizen_event_s* blocks;
+        uint32_t* block_event_counts;
+        uint32_t block_count;
+    };
+    typedef struct kaizen_event_channel_s kaizen_event_channel_t;
+
+
+
+    /**
+     * Allocates @a block_count blocks from the persistent part of @a arena.
+     *
+     * @a block_count must be a power of two.
+     *
+     * Returns ENOMEM if the arena is full.
+     */
+    int kaizen_event_channel_init_from_arena(struct kaizen_event_channel_s* channel,
+                                             struct kaizen_arena_s* arena,
+                                             uint32_t block_count);
+
+    /**
+     * Must not be attached to any thread.
+     */
+    int kaizen_event_channel_finalize(struct kaizen_event_channel_s* channel);
+
+    /**
+     * Attaches the event buffer of @a channel to the calling thread, replacing
+     * the buffer of an attached thread state. Pass NULL to detach.
+     *
+     * Only one thread may produce into a channel.
+     */
+    int kaizen_event_channel_attach_to_current_thread(struct kaizen_event_channel_s* channel);
+
+    struct kaizen_event_buffer_s* kaizen_event_channel_event_buffer(struct kaizen_event_channel_s* channel);
+
+    /**
+     * Publishes the events recorded into the current block, if any. Only
+     * call from the producing thread.
+     *
+     * Returns EAGAIN if all blocks are published afterwards, so events
+     * recorded next are dropped until the consumer releases a block.
+     */
+    int kaizen_event_channel_flush(struct kaizen_event_channel_s* channel);
+
+    /**
+     * Returns the number of events dropped because all blocks were
+     * published. Only call from the producing thread.
+     */
+    size_t kaizen_event_channel_dropped_count(struct kaizen_event_channel_s const* channel);
+
+    /**
+     * Returns the oldest published block. Only call from the consumer.
+     *
+     * Returns EAGAIN if no block is published.
+     */
+    int kaizen_event_channel_try_pop_begin(struct kaizen_event_channel_s* channel,
+                                           struct kaizen_event_s const** events,
+                                           size_t* event_count);
+
+    /**
+     * Returns the block returned by the last
+     * kaizen_event_channel_try_pop_begin to the producer.
+     */
+    void kaizen_event_channel_pop_end(struct kaizen_event_channel_s* channel);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_event_channel_H */
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_event_drain.h for all platforms.
+ *
+ * The drain thread polls its channels round robin and sleeps for a
+ * millisecond whenever a round found nothing, blocks of 64 events make a
+ * millisecond of latency affordable.
+ */
+
+#include "kaizen_event_drain.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_raw_memory.h"
+#include "kaizen_raw_thread.h"
+#include "kaizen_event.h"
+#include "kaizen_event_channel.h"
+#include "kaizen_event_encoding.h"
+#include "kaizen_arena.h"
+
+
+
+#define KAIZEN_INTERNAL_EVENT_DRAIN_IDLE_MILLISECONDS 1u
+
+
+
+static void kaizen_internal_event_drain_append(struct kaizen_event_drain_s* drain,
+                                               uint32_t stream_id,
+                                               struct kaizen_event_s const* events,
+                                               size_t event_count);
+void kaizen_internal_event_drain_append(struct kaizen_event_drain_s* drain,
+                                        uint32_t stream_id,
+                                        struct kaizen_event_s const* events,
+                                        size_t event_count)
+{
+    while (0 < event_count) {
+        size_t encoded_event_count = 0;
+        size_t encoded_size = 0;
+        int errc = KAIZEN_SUCCESS;
+
+        if (KAIZEN_TRUE == drain->is_compressed) {
+            errc = kaizen_event_block_encode_compressed(stream_id,
+                                                        events,
+                                                        event_count,
+                                                        drain->capture + drain->capture_size,
+                                                        drain->capture_capacity - drain->capture_size,
+                                                        &encoded_event_count,
+                                                        &encoded_size);
+        } else {
+            errc = kaizen_event_block_encode(stream_id,
+                                             events,
+                                             event_count,
+                                             drain->capture + drain->capture_size,
+                                             drain->capture_capacity - drain->capture_size,
+                                             &encoded_event_count,
+                                             &encoded_size);
+        }
+
+        if (KAIZEN_SUCCESS != errc) {
+            drain->dropped_event_count += event_count;
+
+            return;
+        }
+
+        drain->capture_size += encoded_size;
+        events += encoded_event_count;
+        event_count -= encoded_event_count;
+    }
+}
+
+
+
+static size_t kaizen_internal_event_drain_poll(struct kaizen_event_drain_s* drain);
+size_t kaizen_internal_event_drain_poll(struct kaizen_event_drain_s* drain)
+{
+    size_t block_count = 0;
+    size_t i = 0;
+
+    for (i = 0; i < drain->channel_count; ++i) {
+        struct kaizen_event_s const* events = NULL;
+        size_t event_count = 0;
+
+        while (KAIZEN_SUCCESS == kaizen_event_channel_try_pop_begin(drain->channels[i], &events, &event_count)) {
+            kaizen_internal_event_drain_append(drain, drain->stream_ids[i], events, event_count);
+            kaizen_event_channel_pop_end(drain->channels[i]);
+            ++block_count;
+        }
+    }
+
+    return block_count;
+}
+
+
+
+static void kaizen_internal_event_drain_run(void* context);
+void kaizen_internal_event_drain_run(void* context)
+{
+    struct kaizen_event_drain_s* const drain = (struct kaizen_event_drain_s*)context;
+
+    if (KAIZEN_MEMORY_ANY_NUMA_NODE != drain->numa_node) {
+        drain->bind_error = kaizen_memory_numa_bind_current_thread(drain->numa_node);
+    }
+
+    for (;;) {
+        /* Read before polling so the last poll sees all blocks published before stop. */
+        uint32_t const is_stopping = kaizen_atomic_uint32_load_acquire(&(drain->is_stopping));
+
+        if (0u < kaizen_internal_event_drain_poll(drain)) {
+            continue;
+        }
+
+        if (0u != is_stopping) {
+            return;
+        }
+
+        (void)kaizen_thread_sleep_milliseconds(KAIZEN_INTERNAL_EVENT_DRAIN_IDLE_MILLISECONDS);
+    }
+}
+
+
+
+int kaizen_event_drain_init_from_arena(struct kaizen_event_drain_s* drain,
+                                       struct kaizen_arena_s* arena,
+                                       uint32_t numa_node,
+                                       size_t channel_capacity,
+                                       size_t capture_capacity,
+                                       uint64_t ticks_per_second)
+{
+    assert(NULL != drain);
+    assert(NULL != arena);
+    assert(0 < channel_capacity);
+    assert(KAIZEN_EVENT_STREAM_HEADER_SIZE + KAIZEN_EVENT_BLOCK_HEADER_SIZE + KAIZEN_EVENT_ENCODED_MAX_SIZE <= capture_capacity);
+
+    void* channels = NULL;
+    int errc = kaizen_arena_allocate_persistent(arena,
+                                                channel_capacity * sizeof(struct kaizen_event_channel_s*),
+                                                KAIZEN_ARENA_DEFAULT_ALIGNMENT,
+                                                &channels);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    void* stream_ids = NULL;
+    errc = kaizen_arena_allocate_persistent(arena,
+                                            channel_capacity * sizeof(uint32_t),
+                                            KAIZEN_ARENA_DEFAULT_ALIGNMENT,
+                                            &stream_ids);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    void* capture = NULL;
+    errc = kaizen_arena_allocate_persistent(arena,
+                                            capture_capacity,
+                                            KAIZEN_ARENA_DEFAULT_ALIGNMENT,
+                                            &capture);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    drain->channels = (struct kaizen_event_channel_s**)channels;
+    drain->stream_ids = (uint32_t*)stream_ids;
+    drain->channel_count = 0;
+    drain->channel_capacity = channel_capacity;
+    drain->capture = (uint8_t*)capture;
+    drain->capture_capacity = capture_capacity;
+    drain->dropped_event_count = 0;
+    drain->numa_node = numa_node;
+    drain->bind_error = KAIZEN_SUCCESS;
+    drain->is_running = KAIZEN_FALSE;
+    drain->is_compressed = KAIZEN_FALSE;
+    kaizen_atomic_uint32_store_release(&(drain->is_stopping), 0u);
+
+    errc = kaizen_event_stream_header_encode(ticks_per_second, drain->capture, capture_capacity);
+    drain->capture_size = KAIZEN_EVENT_STREAM_HEADER_SIZE;
+
+    return errc;
+}
+
+
+
+int kaizen_event_drain_finalize(struct kaizen_event_drain_s* drain)
+{
+    assert(NULL != drain);
+    assert(KAIZEN_FALSE == drain->is_running);
+
+    drain->channels = NULL;
+    drain->stream_ids = NULL;
+    drain->channel_count = 0;
+    drain->channel_capacity = 0;
+    drain->capture = NULL;
+    drain->capture_size = 0;
+    drain->capture_capacity = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_drain_add_channel(struct kaizen_event_drain_s* drain,
+                                   struct kaizen_event_channel_s* channel,
+                                   uint32_t stream_id)
+{
+    assert(NULL != drain);
+    assert(NULL != channel);
+    assert(KAIZEN_FALSE == drain->is_running);
+
+    if (drain->channel_count == drain->channel_capacity) {
+        return ENOMEM;
+    }
+
+    drain->channels[drain->channel_count] = channel;
+    drain->stream_ids[drain->channel_count] = stream_id;
+    ++(drain->channel_count);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_drain_set_compressed(struct kaizen_event_drain_s* drain,
+                                      kaizen_bool is_compressed)
+{
+    assert(NULL != drain);
+    assert(KAIZEN_FALSE == drain->is_running);
+
+    drain->is_compressed = is_compressed;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_drain_start(struct kaizen_event_drain_s* drain)
+{
+    assert(NULL != drain);
+    assert(KAIZEN_FALSE == drain->is_running);
+
+    kaizen_atomic_uint32_store_release(&(drain->is_stopping), 0u);
+
+    int const errc = kaizen_thread_launch(&(drain->thread),
+                                          kaizen_internal_event_drain_run,
+                                          drain);
+
+    if (KAIZEN_SUCCESS == errc) {
+        drain->is_running = KAIZEN_TRUE;
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_event_drain_stop(struct kaizen_event_drain_s* drain)
+{
+    assert(NULL != drain);
+    assert(KAIZEN_TRUE == drain->is_running);
+
+    kaizen_atomic_uint32_store_release(&(drain->is_stopping), 1u);
+
+    int const errc = kaizen_thread_join(&(drain->thread));
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    drain->is_running = KAIZEN_FALSE;
+
+    return drain->bind_error;
+}
+
+
+
+uint8_t const* kaizen_event_drain_capture(struct kaizen_event_drain_s const* drain,
+                                          size_t* size)
+{
+    assert(NULL != drain);
+    assert(NULL != size);
+    assert(KAIZEN_FALSE == drain->is_running);
+
+    *size = drain->capture_size;
+
+    return drain->capture;
+}
+
+
+
+size_t kaizen_event_drain_dropped_count(struct kaizen_event_drain_s const* drain)
+{
+    assert(NULL != drain);
+
+    return drain->dropped_event_count;
+}
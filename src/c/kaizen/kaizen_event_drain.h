@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Background thread draining the event channels (see
+ * kaizen_event_channel.h) of the workers of one NUMA node into an encoded
+ * capture (see kaizen_event_encoding.h) in memory of that node.
+ *
+ * Run one drain per node and allocate the channels of a node's workers and
+ * the drain itself from an arena backed by a region on that node (see
+ * kaizen_raw_memory.h), so recording, draining and storing events never
+ * move cache lines across the socket interconnect. Merge the captures of
+ * all drains by time when profiling ends, e.g. with
+ * kaizen::merge_captures of kaizen_capture_analysis.hpp.
+ *
+ * <code>
+ * kaizen_memory_region_init_on_numa_node(&region, size, kaizen_memory_default_page_size, node);
+ * kaizen_arena_init(&arena, kaizen_memory_region_memory(&region), kaizen_memory_region_size(&region));
+ * kaizen_event_drain_init_from_arena(&drain, &arena, node, worker_count, capture_capacity, ticks_per_second);
+ * // per worker of the node
+ * kaizen_event_channel_init_from_arena(&channels[i], &arena, 16);
+ * kaizen_event_drain_add_channel(&drain, &channels[i], worker_index);
+ * kaizen_event_drain_start(&drain);
+ * // ... workers flush their channels when done
+ * kaizen_event_drain_stop(&drain);
+ * capture = kaizen_event_drain_capture(&drain, &capture_size);
+ * </code>
+ *
+ * Enable block compression with kaizen_event_drain_set_compressed to fit
+ * about twice as many events into the capture, the drain thread then spends
+ * a few nanoseconds more per event.
+ *
+ * Needs the threading backend (see kaizen_raw_thread.h).
+ */
+
+#ifndef KAIZEN_kaizen_event_drain_H
+#define KAIZEN_kaizen_event_drain_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_atomic.h>
+#include <kaizen/kaizen_raw_thread.h>
+#include <kaizen/kaizen_event_channel.h>
+#include <kaizen/kaizen_arena.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_event_drain_s {
+        struct kaizen_raw_thread_s thread;
+        struct kaizen_atomic_uint32_s is_stopping;
+        struct kaizen_event_channel_s** channels;
+        uint32_t* stream_ids;
+        size_t channel_count;
+        size_t channel_capacity;
+        uint8_t* capture;
+        size_t capture_size;
+        size_t capture_capacity;
+        size_t dropped_event_count;
+        uint32_t numa_node;
+        int bind_error;
+        kaizen_bool is_running;
+        kaizen_bool is_compressed;
+    };
+    typedef struct kaizen_event_drain_s kaizen_event_drain_t;
+
+
+
+    /**
+     * Allocates room for @a channel_capacity channels and a capture of
+     * @a capture_capacity bytes from the persistent part of @a arena and
+     * writes the stream header for @a ticks_per_second.
+     *
+     * The drain thread binds to the processors of @a numa_node, pass
+     * KAIZEN_MEMORY_ANY_NUMA_NODE to leave it unbound.
+     *
+     * Returns ENOMEM if the arena is full.
+     */
+    int kaizen_event_drain_init_from_arena(struct kaizen_event_drain_s* drain,
+                                           struct kaizen_arena_s* arena,
+                                           uint32_t numa_node,
+                                           size_t channel_capacity,
+                                           size_t capture_capacity,
+                                           uint64_t ticks_per_second);
+
+    /**
+     * Must not be running.
+     */
+    int kaizen_event_drain_finalize(struct kaizen_event_drain_s* drain);
+
+    /**
+     * Drains @a channel, tagging its events with @a stream_id. Only call
+     * while the drain is not running.
+     *
+     * Returns ENOMEM if channel_capacity channels are added already.
+     */
+    int kaizen_event_drain_add_channel(struct kaizen_event_drain_s* drain,
+                                       struct kaizen_event_channel_s* channel,
+                                       uint32_t stream_id);
+
+    /**
+     * Encodes the drained events as compressed blocks (see
+     * kaizen_event_block_encode_compressed) if @a is_compressed is
+     * KAIZEN_TRUE. Blocks are not compressed by default. Only call while
+     * the drain is not running.
+     */
+    int kaizen_event_drain_set_compressed(struct kaizen_event_drain_s* drain,
+                                          kaizen_bool is_compressed);
+
+    /**
+     * Launches the drain thread.
+     *
+     * Returns EAGAIN if the platform lacks resources to create the thread.
+     */
+    int kaizen_event_drain_start(struct kaizen_event_drain_s* drain);
+
+    /**
+     * Drains all published blocks and stops the drain thread. Flush the
+     * channels before to include their last events.
+     *
+     * Returns the error of binding the thread to its NUMA node, if any -
+     * events are drained regardless.
+     */
+    int kaizen_event_drain_stop(struct kaizen_event_drain_s* drain);
+
+    /**
+     * Returns the encoded capture and stores its size in @a size. Only call
+     * while the drain is not running.
+     */
+    uint8_t const* kaizen_event_drain_capture(struct kaizen_event_drain_s const* drain,
+                                              size_t* size);
+
+    /**
+     * Returns the number of events dropped because the capture was full.
+     */
+    size_t kaizen_event_drain_dropped_count(struct kaizen_event_drain_s const* drain);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_event_drain_H */
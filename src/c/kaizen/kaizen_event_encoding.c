@@ -0,0 +1,791 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_event_encoding.h for all platforms.
+ *
+ * Compressed columns are packed and unpacked through a 64 bit accumulator
+ * flushed and refilled a whole word at a time, so each value costs a few
+ * shifts and no per bit loops.
+ */
+
+#include "kaizen_event_encoding.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_event.h"
+
+
+
+static void kaizen_internal_encoding_write_uint32(uint8_t* buffer,
+                                                  uint32_t value);
+void kaizen_internal_encoding_write_uint32(uint8_t* buffer,
+                                           uint32_t value)
+{
+    buffer[0] = (uint8_t)value;
+    buffer[1] = (uint8_t)(value >> 8);
+    buffer[2] = (uint8_t)(value >> 16);
+    buffer[3] = (uint8_t)(value >> 24);
+}
+
+
+
+static uint32_t kaizen_internal_encoding_read_uint32(uint8_t const* buffer);
+uint32_t kaizen_internal_encoding_read_uint32(uint8_t const* buffer)
+{
+    return (uint32_t)buffer[0]
+        | ((uint32_t)buffer[1] << 8)
+        | ((uint32_t)buffer[2] << 16)
+        | ((uint32_t)buffer[3] << 24);
+}
+
+
+
+/* Returns the number of bytes written, buffer must have room for 10. */
+static size_t kaizen_internal_encoding_write_varint(uint8_t* buffer,
+                                                    uint64_t value);
+size_t kaizen_internal_encoding_write_varint(uint8_t* buffer,
+                                             uint64_t value)
+{
+    size_t size = 0;
+
+    while (0x80 <= value) {
+        buffer[size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    buffer[size++] = (uint8_t)value;
+
+    return size;
+}
+
+
+
+/* Returns the number of bytes read or 0 if the varint is malformed or not
+ * complete.
+ */
+static size_t kaizen_internal_encoding_read_varint(uint8_t const* buffer,
+                                                   size_t size,
+                                                   uint64_t* value);
+size_t kaizen_internal_encoding_read_varint(uint8_t const* buffer,
+                                            size_t size,
+                                            uint64_t* value)
+{
+    uint64_t result = 0;
+    unsigned int shift = 0;
+    size_t i = 0;
+
+    for (i = 0; i < size && shift < 64; ++i, shift += 7) {
+
+        uint8_t const byte = buffer[i];
+        result |= (uint64_t)(byte & 0x7f) << shift;
+
+        if (0 == (byte & 0x80)) {
+            *value = result;
+
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+
+
+/* Returns the number of bytes the varint of value needs. */
+static size_t kaizen_internal_encoding_varint_size(uint64_t value);
+size_t kaizen_internal_encoding_varint_size(uint64_t value)
+{
+    size_t size = 1;
+
+    while (0x80 <= value) {
+        value >>= 7;
+        ++size;
+    }
+
+    return size;
+}
+
+
+
+static unsigned int kaizen_internal_encoding_bit_width(uint64_t value);
+unsigned int kaizen_internal_encoding_bit_width(uint64_t value)
+{
+    unsigned int width = 0;
+
+    while (0 != value) {
+        value >>= 1;
+        ++width;
+    }
+
+    return width;
+}
+
+
+
+static void kaizen_internal_encoding_write_uint64(uint8_t* buffer,
+                                                  uint64_t value);
+void kaizen_internal_encoding_write_uint64(uint8_t* buffer,
+                                           uint64_t value)
+{
+    kaizen_internal_encoding_write_uint32(buffer, (uint32_t)value);
+    kaizen_internal_encoding_write_uint32(buffer + 4, (uint32_t)(value >> 32));
+}
+
+
+
+/* Reads at most 8 bytes, missing high bytes are 0. */
+static uint64_t kaizen_internal_encoding_read_uint64(uint8_t const* buffer,
+                                                     size_t size);
+uint64_t kaizen_internal_encoding_read_uint64(uint8_t const* buffer,
+                                              size_t size)
+{
+    if (8 <= size) {
+        return (uint64_t)kaizen_internal_encoding_read_uint32(buffer)
+            | ((uint64_t)kaizen_internal_encoding_read_uint32(buffer + 4) << 32);
+    }
+
+    uint64_t value = 0;
+    size_t i = 0;
+
+    for (i = 0; i < size; ++i) {
+        value |= (uint64_t)buffer[i] << (8 * i);
+    }
+
+    return value;
+}
+
+
+
+/* Returns the number of bytes of count values packed with width bits. */
+static size_t kaizen_internal_encoding_packed_size(size_t count,
+                                                   unsigned int width);
+size_t kaizen_internal_encoding_packed_size(size_t count,
+                                            unsigned int width)
+{
+    return (count * width + 7) / 8;
+}
+
+
+
+/* Packs the width low bits of each value minus minimum, least significant
+ * bit first, and returns the number of bytes written.
+ */
+static size_t kaizen_internal_encoding_pack_bits(uint64_t const* values,
+                                                 size_t count,
+                                                 uint64_t minimum,
+                                                 unsigned int width,
+                                                 uint8_t* buffer);
+size_t kaizen_internal_encoding_pack_bits(uint64_t const* values,
+                                          size_t count,
+                                          uint64_t minimum,
+                                          unsigned int width,
+                                          uint8_t* buffer)
+{
+    uint64_t bits = 0;
+    unsigned int bit_count = 0;
+    size_t size = 0;
+    size_t i = 0;
+
+    if (0 == width) {
+        return 0;
+    }
+
+    for (i = 0; i < count; ++i) {
+
+        uint64_t const value = values[i] - minimum;
+        bits |= value << bit_count;
+        bit_count += width;
+
+        if (64 <= bit_count) {
+            kaizen_internal_encoding_write_uint64(buffer + size, bits);
+            size += 8;
+
+            /* Keeps the high bits of the value that did not fit. */
+            bit_count -= 64;
+            bits = (0 == bit_count) ? 0 : value >> (width - bit_count);
+        }
+    }
+
+    while (0 < bit_count) {
+        buffer[size++] = (uint8_t)bits;
+        bits >>= 8;
+        bit_count = (8 < bit_count) ? bit_count - 8 : 0;
+    }
+
+    return size;
+}
+
+
+
+/* Reverses kaizen_internal_encoding_pack_bits, buffer must hold the packed
+ * size of count values.
+ */
+static void kaizen_internal_encoding_unpack_bits(uint8_t const* buffer,
+                                                 size_t count,
+                                                 uint64_t minimum,
+                                                 unsigned int width,
+                                                 uint64_t* values);
+void kaizen_internal_encoding_unpack_bits(uint8_t const* buffer,
+                                          size_t count,
+                                          uint64_t minimum,
+                                          unsigned int width,
+                                          uint64_t* values)
+{
+    size_t const size = kaizen_internal_encoding_packed_size(count, width);
+    uint64_t const mask = (64 == width) ? ~(uint64_t)0 : (((uint64_t)1 << width) - 1);
+    uint64_t bits = 0;
+    unsigned int bit_count = 0;
+    size_t offset = 0;
+    size_t i = 0;
+
+    for (i = 0; i < count; ++i) {
+
+        uint64_t value = 0;
+
+        if (width <= bit_count) {
+            value = bits & mask;
+            bits = (64 == width) ? 0 : bits >> width;
+            bit_count -= width;
+        } else {
+            size_t const loaded = (8 < size - offset) ? 8 : size - offset;
+            uint64_t const word = kaizen_internal_encoding_read_uint64(buffer + offset, loaded);
+            unsigned int const used = width - bit_count;
+            offset += loaded;
+
+            value = (bits | (word << bit_count)) & mask;
+            bits = (64 == used) ? 0 : word >> used;
+            bit_count = (unsigned int)(8 * loaded) - used;
+        }
+
+        values[i] = minimum + value;
+    }
+}
+
+
+
+/* Columns of a compressed group, in the order of the encoding. */
+enum {
+    kaizen_internal_encoding_time_column = 0,
+    kaizen_internal_encoding_duration_column,
+    kaizen_internal_encoding_value_column,
+    kaizen_internal_encoding_id_column,
+    kaizen_internal_encoding_type_column,
+    kaizen_internal_encoding_flags_column,
+    kaizen_internal_encoding_column_count
+};
+
+
+
+/* Splits count events into columns, time differences start at
+ * previous_time. Stores the time of each event in times.
+ */
+static void kaizen_internal_encoding_gather_group(struct kaizen_event_s const* events,
+                                                  size_t count,
+                                                  uint64_t previous_time,
+                                                  uint64_t columns[][KAIZEN_EVENT_COMPRESSED_GROUP_SIZE],
+                                                  uint64_t* times);
+void kaizen_internal_encoding_gather_group(struct kaizen_event_s const* events,
+                                           size_t count,
+                                           uint64_t previous_time,
+                                           uint64_t columns[][KAIZEN_EVENT_COMPRESSED_GROUP_SIZE],
+                                           uint64_t* times)
+{
+    size_t i = 0;
+
+    for (i = 0; i < count; ++i) {
+
+        struct kaizen_event_s const* event = &(events[i]);
+
+        uint64_t time = 0;
+        uint64_t duration = 0;
+        (void)kaizen_frame_time_convert_to_ticks(&(event->time), &time);
+        (void)kaizen_frame_time_convert_to_ticks(&(event->duration), &duration);
+
+        int64_t const delta = (int64_t)(time - previous_time);
+        previous_time = time;
+        times[i] = time;
+
+        columns[kaizen_internal_encoding_time_column][i] = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+        columns[kaizen_internal_encoding_duration_column][i] = duration;
+        columns[kaizen_internal_encoding_value_column][i] = event->value;
+        columns[kaizen_internal_encoding_id_column][i] = event->id;
+        columns[kaizen_internal_encoding_type_column][i] = event->type;
+        columns[kaizen_internal_encoding_flags_column][i] = event->flags;
+    }
+}
+
+
+
+/* Returns the encoded size of the first count events of the columns and
+ * stores the minimum and bit width of each column.
+ */
+static size_t kaizen_internal_encoding_measure_group(uint64_t columns[][KAIZEN_EVENT_COMPRESSED_GROUP_SIZE],
+                                                     size_t count,
+                                                     uint64_t* minima,
+                                                     unsigned int* widths);
+size_t kaizen_internal_encoding_measure_group(uint64_t columns[][KAIZEN_EVENT_COMPRESSED_GROUP_SIZE],
+                                              size_t count,
+                                              uint64_t* minima,
+                                              unsigned int* widths)
+{
+    size_t size = 0;
+    int column = 0;
+
+    for (column = 0; column < kaizen_internal_encoding_column_count; ++column) {
+
+        uint64_t const* const values = columns[column];
+        uint64_t minimum = values[0];
+        uint64_t maximum = values[0];
+        size_t i = 0;
+
+        for (i = 1; i < count; ++i) {
+            minimum = (values[i] < minimum) ? values[i] : minimum;
+            maximum = (values[i] > maximum) ? values[i] : maximum;
+        }
+
+        minima[column] = minimum;
+        widths[column] = kaizen_internal_encoding_bit_width(maximum - minimum);
+        size += kaizen_internal_encoding_varint_size(minimum) + 1
+            + kaizen_internal_encoding_packed_size(count, widths[column]);
+    }
+
+    return size;
+}
+
+
+
+/* Decodes the payload of a compressed block of block_size bytes holding
+ * event_count events.
+ */
+static int kaizen_internal_encoding_decode_compressed(uint8_t const* buffer,
+                                                      size_t block_size,
+                                                      struct kaizen_event_s* events,
+                                                      size_t event_count);
+int kaizen_internal_encoding_decode_compressed(uint8_t const* buffer,
+                                               size_t block_size,
+                                               struct kaizen_event_s* events,
+                                               size_t event_count)
+{
+    size_t offset = KAIZEN_EVENT_BLOCK_HEADER_SIZE;
+    uint64_t time = 0;
+
+    if (0 < event_count) {
+        size_t const read = kaizen_internal_encoding_read_varint(buffer + offset,
+                                                                 block_size - offset,
+                                                                 &time);
+        if (0 == read) {
+            return EINVAL;
+        }
+
+        offset += read;
+    }
+
+    size_t first = 0;
+
+    while (first < event_count) {
+
+        uint64_t columns[kaizen_internal_encoding_column_count][KAIZEN_EVENT_COMPRESSED_GROUP_SIZE];
+        size_t const count = (KAIZEN_EVENT_COMPRESSED_GROUP_SIZE < event_count - first) ? KAIZEN_EVENT_COMPRESSED_GROUP_SIZE : event_count - first;
+        int column = 0;
+
+        for (column = 0; column < kaizen_internal_encoding_column_count; ++column) {
+
+            uint64_t minimum = 0;
+            size_t const read = kaizen_internal_encoding_read_varint(buffer + offset,
+                                                                     block_size - offset,
+                                                                     &minimum);
+            if (0 == read || block_size - offset == read) {
+                return EINVAL;
+            }
+
+            offset += read;
+
+            unsigned int const width = buffer[offset++];
+            size_t const packed_size = kaizen_internal_encoding_packed_size(count, width);
+
+            if (64 < width || block_size - offset < packed_size) {
+                return EINVAL;
+            }
+
+            if (0 == width) {
+                size_t i = 0;
+                for (i = 0; i < count; ++i) {
+                    columns[column][i] = minimum;
+                }
+            } else {
+                kaizen_internal_encoding_unpack_bits(buffer + offset, count, minimum, width, columns[column]);
+            }
+
+            offset += packed_size;
+        }
+
+        size_t i = 0;
+
+        for (i = 0; i < count; ++i) {
+
+            uint64_t const zig_zag_delta = columns[kaizen_internal_encoding_time_column][i];
+            int64_t const delta = (int64_t)(zig_zag_delta >> 1) ^ -(int64_t)(zig_zag_delta & 1);
+            time += (uint64_t)delta;
+
+            struct kaizen_event_s* event = &(events[first + i]);
+            (void)kaizen_frame_time_convert_from_ticks(&(event->time), time);
+            (void)kaizen_frame_time_convert_from_ticks(&(event->duration), columns[kaizen_internal_encoding_duration_column][i]);
+            event->value = columns[kaizen_internal_encoding_value_column][i];
+            event->id = (uint32_t)columns[kaizen_internal_encoding_id_column][i];
+            event->type = (uint16_t)columns[kaizen_internal_encoding_type_column][i];
+            event->flags = (uint16_t)columns[kaizen_internal_encoding_flags_column][i];
+        }
+
+        first += count;
+    }
+
+    if (offset != block_size) {
+        return EINVAL;
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_stream_header_encode(uint64_t ticks_per_second,
+                                      uint8_t* buffer,
+                                      size_t capacity)
+{
+    assert(NULL != buffer);
+
+    if (KAIZEN_EVENT_STREAM_HEADER_SIZE > capacity) {
+        return ENOMEM;
+    }
+
+    buffer[0] = 'K';
+    buffer[1] = 'Z';
+    buffer[2] = 'S';
+    buffer[3] = '1';
+    kaizen_internal_encoding_write_uint32(buffer + 4, KAIZEN_EVENT_ENCODING_VERSION);
+    kaizen_internal_encoding_write_uint32(buffer + 8, (uint32_t)ticks_per_second);
+    kaizen_internal_encoding_write_uint32(buffer + 12, (uint32_t)(ticks_per_second >> 32));
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_stream_header_decode(uint8_t const* buffer,
+                                      size_t size,
+                                      uint64_t* ticks_per_second)
+{
+    assert(NULL != buffer);
+    assert(NULL != ticks_per_second);
+
+    if (KAIZEN_EVENT_STREAM_HEADER_SIZE > size) {
+        return EAGAIN;
+    }
+
+    if ('K' != buffer[0] || 'Z' != buffer[1] || 'S' != buffer[2] || '1' != buffer[3]
+        || KAIZEN_EVENT_ENCODING_VERSION != kaizen_internal_encoding_read_uint32(buffer + 4)) {
+
+        return EINVAL;
+    }
+
+    *ticks_per_second = (uint64_t)kaizen_internal_encoding_read_uint32(buffer + 8)
+        | ((uint64_t)kaizen_internal_encoding_read_uint32(buffer + 12) << 32);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_block_encode(uint32_t stream_id,
+                              struct kaizen_event_s const* events,
+                              size_t event_count,
+                              uint8_t* buffer,
+                              size_t capacity,
+                              size_t* encoded_event_count,
+                              size_t* encoded_size)
+{
+    assert(NULL != events || 0 == event_count);
+    assert(NULL != buffer);
+    assert(NULL != encoded_event_count);
+    assert(NULL != encoded_size);
+
+    if (KAIZEN_EVENT_BLOCK_HEADER_SIZE + KAIZEN_EVENT_ENCODED_MAX_SIZE > capacity) {
+        return ENOMEM;
+    }
+
+    size_t size = KAIZEN_EVENT_BLOCK_HEADER_SIZE;
+    uint64_t previous_time = 0;
+    size_t i = 0;
+
+    for (i = 0; i < event_count && size + KAIZEN_EVENT_ENCODED_MAX_SIZE <= capacity; ++i) {
+
+        struct kaizen_event_s const* event = &(events[i]);
+
+        uint64_t time = 0;
+        uint64_t duration = 0;
+        (void)kaizen_frame_time_convert_to_ticks(&(event->time), &time);
+        (void)kaizen_frame_time_convert_to_ticks(&(event->duration), &duration);
+
+        /* Zig-zag keeps small negative deltas of unordered events small. */
+        int64_t const delta = (int64_t)(time - previous_time);
+        uint64_t const zig_zag_delta = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+        previous_time = time;
+
+        size += kaizen_internal_encoding_write_varint(buffer + size, zig_zag_delta);
+        size += kaizen_internal_encoding_write_varint(buffer + size, duration);
+        size += kaizen_internal_encoding_write_varint(buffer + size, event->value);
+        size += kaizen_internal_encoding_write_varint(buffer + size, event->id);
+        size += kaizen_internal_encoding_write_varint(buffer + size, event->type);
+        size += kaizen_internal_encoding_write_varint(buffer + size, event->flags);
+    }
+
+    buffer[0] = 'K';
+    buffer[1] = 'Z';
+    buffer[2] = 'B';
+    buffer[3] = '1';
+    kaizen_internal_encoding_write_uint32(buffer + 4, (uint32_t)(size - KAIZEN_EVENT_BLOCK_HEADER_SIZE));
+    kaizen_internal_encoding_write_uint32(buffer + 8, (uint32_t)i);
+    kaizen_internal_encoding_write_uint32(buffer + 12, stream_id);
+
+    *encoded_event_count = i;
+    *encoded_size = size;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_block_encode_compressed(uint32_t stream_id,
+                                         struct kaizen_event_s const* events,
+                                         size_t event_count,
+                                         uint8_t* buffer,
+                                         size_t capacity,
+                                         size_t* encoded_event_count,
+                                         size_t* encoded_size)
+{
+    assert(NULL != events || 0 == event_count);
+    assert(NULL != buffer);
+    assert(NULL != encoded_event_count);
+    assert(NULL != encoded_size);
+
+    if (KAIZEN_EVENT_BLOCK_HEADER_SIZE + KAIZEN_EVENT_ENCODED_MAX_SIZE > capacity) {
+        return ENOMEM;
+    }
+
+    size_t size = KAIZEN_EVENT_BLOCK_HEADER_SIZE;
+    uint64_t previous_time = 0;
+    size_t i = 0;
+
+    if (0 < event_count) {
+        (void)kaizen_frame_time_convert_to_ticks(&(events[0].time), &previous_time);
+        size += kaizen_internal_encoding_write_varint(buffer + size, previous_time);
+    }
+
+    while (i < event_count) {
+
+        uint64_t columns[kaizen_internal_encoding_column_count][KAIZEN_EVENT_COMPRESSED_GROUP_SIZE];
+        uint64_t times[KAIZEN_EVENT_COMPRESSED_GROUP_SIZE];
+        uint64_t minima[kaizen_internal_encoding_column_count];
+        unsigned int widths[kaizen_internal_encoding_column_count];
+        size_t const full_count = (KAIZEN_EVENT_COMPRESSED_GROUP_SIZE < event_count - i) ? KAIZEN_EVENT_COMPRESSED_GROUP_SIZE : event_count - i;
+        size_t count = full_count;
+
+        kaizen_internal_encoding_gather_group(events + i, count, previous_time, columns, times);
+
+        /* Halves the group until it fits, it then ends the block as only the
+         * last group may be partial.
+         */
+        size_t group_size = kaizen_internal_encoding_measure_group(columns, count, minima, widths);
+
+        while (size + group_size > capacity && 1 < count) {
+            count /= 2;
+            group_size = kaizen_internal_encoding_measure_group(columns, count, minima, widths);
+        }
+
+        if (size + group_size > capacity) {
+            break;
+        }
+
+        int column = 0;
+        for (column = 0; column < kaizen_internal_encoding_column_count; ++column) {
+            size += kaizen_internal_encoding_write_varint(buffer + size, minima[column]);
+            buffer[size++] = (uint8_t)widths[column];
+            size += kaizen_internal_encoding_pack_bits(columns[column], count, minima[column], widths[column], buffer + size);
+        }
+
+        previous_time = times[count - 1];
+        i += count;
+
+        if (count < full_count) {
+            break;
+        }
+    }
+
+    if (0 == i && 0 < event_count) {
+        return ENOMEM;
+    }
+
+    buffer[0] = 'K';
+    buffer[1] = 'Z';
+    buffer[2] = 'C';
+    buffer[3] = '1';
+    kaizen_internal_encoding_write_uint32(buffer + 4, (uint32_t)(size - KAIZEN_EVENT_BLOCK_HEADER_SIZE));
+    kaizen_internal_encoding_write_uint32(buffer + 8, (uint32_t)i);
+    kaizen_internal_encoding_write_uint32(buffer + 12, stream_id);
+
+    *encoded_event_count = i;
+    *encoded_size = size;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_block_peek(uint8_t const* buffer,
+                            size_t size,
+                            size_t* block_size,
+                            uint32_t* event_count,
+                            uint32_t* stream_id)
+{
+    assert(NULL != buffer);
+    assert(NULL != block_size);
+    assert(NULL != event_count);
+    assert(NULL != stream_id);
+
+    if (KAIZEN_EVENT_BLOCK_HEADER_SIZE > size) {
+        return EAGAIN;
+    }
+
+    if ('K' != buffer[0] || 'Z' != buffer[1] || ('B' != buffer[2] && 'C' != buffer[2]) || '1' != buffer[3]) {
+        return EINVAL;
+    }
+
+    *block_size = KAIZEN_EVENT_BLOCK_HEADER_SIZE + (size_t)kaizen_internal_encoding_read_uint32(buffer + 4);
+    *event_count = kaizen_internal_encoding_read_uint32(buffer + 8);
+    *stream_id = kaizen_internal_encoding_read_uint32(buffer + 12);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_block_decode(uint8_t const* buffer,
+                              size_t size,
+                              struct kaizen_event_s* events,
+                              size_t capacity,
+                              size_t* decoded_event_count)
+{
+    assert(NULL != buffer);
+    assert(NULL != events || 0 == capacity);
+    assert(NULL != decoded_event_count);
+
+    size_t block_size = 0;
+    uint32_t event_count = 0;
+    uint32_t stream_id = 0;
+    int const errc = kaizen_event_block_peek(buffer,
+                                             size,
+                                             &block_size,
+                                             &event_count,
+                                             &stream_id);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    if (block_size > size) {
+        return EAGAIN;
+    }
+
+    if (event_count > capacity) {
+        return ENOMEM;
+    }
+
+    if ('C' == buffer[2]) {
+        int const decode_errc = kaizen_internal_encoding_decode_compressed(buffer, block_size, events, event_count);
+
+        if (KAIZEN_SUCCESS == decode_errc) {
+            *decoded_event_count = event_count;
+        }
+
+        return decode_errc;
+    }
+
+    size_t offset = KAIZEN_EVENT_BLOCK_HEADER_SIZE;
+    uint64_t time = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < event_count; ++i) {
+
+        uint64_t fields[6] = {0, 0, 0, 0, 0, 0};
+        int field = 0;
+
+        for (field = 0; field < 6; ++field) {
+
+            size_t const read = kaizen_internal_encoding_read_varint(buffer + offset,
+                                                                     block_size - offset,
+                                                                     &(fields[field]));
+            if (0 == read) {
+                return EINVAL;
+            }
+
+            offset += read;
+        }
+
+        int64_t const delta = (int64_t)(fields[0] >> 1) ^ -(int64_t)(fields[0] & 1);
+        time += (uint64_t)delta;
+
+        struct kaizen_event_s* event = &(events[i]);
+        (void)kaizen_frame_time_convert_from_ticks(&(event->time), time);
+        (void)kaizen_frame_time_convert_from_ticks(&(event->duration), fields[1]);
+        event->value = fields[2];
+        event->id = (uint32_t)fields[3];
+        event->type = (uint16_t)fields[4];
+        event->flags = (uint16_t)fields[5];
+    }
+
+    if (offset != block_size) {
+        return EINVAL;
+    }
+
+    *decoded_event_count = event_count;
+
+    return KAIZEN_SUCCESS;
+}
+
+
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Compact, platform independent binary encoding of kaizen events used to
+ * stream events to viewers and to store captures.
+ *
+ * A stream starts with a stream header followed by any number of blocks:
+ *
+ *  - Stream header (KAIZEN_EVENT_STREAM_HEADER_SIZE bytes): magic "KZS1",
+ *    uint32 format version, uint64 frame time ticks per second.
+ *  - Block header (KAIZEN_EVENT_BLOCK_HEADER_SIZE bytes): magic "KZB1",
+ *    uint32 payload size in bytes, uint32 event count, uint32 stream id
+ *    (e.g. the producing thread).
+ *  - Block payload: per event the zig-zag encoded difference of its time
+ *    to the time of the previous event of the block (to 0 for the first
+ *    one), its duration, value, id, type and flags, each as unsigned LEB128
+ *    variable length integer.
+ *
+ * Compressed blocks (see kaizen_event_block_encode_compressed) use the same
+ * header with magic "KZC1" and store the events column by column instead:
+ *
+ *  - Compressed payload: the time of the first event as unsigned LEB128
+ *    followed by groups of KAIZEN_EVENT_COMPRESSED_GROUP_SIZE events, the
+ *    last group holding the rest. Each group stores six columns: the
+ *    zig-zag encoded time differences to the previous event (0 for the
+ *    first event of the block), durations, values, ids, types and flags.
+ *    A column is its minimum as unsigned LEB128, a byte with the bit width
+ *    of its largest difference to the minimum and these differences of all
+ *    events of the group, packed with the bit width, least significant bit
+ *    first, into whole bytes.
+ *
+ * Times are stored as frame time ticks (see
+ * kaizen_frame_time_convert_to_ticks). Fixed size fields are little endian.
+ *
+ * Events close in time with short durations and small ids typically need
+ * 8 to 12 bytes instead of the size of kaizen_event_s, compressed ones 4 to
+ * 6 bytes as columns of constant types, flags and values need no bits at
+ * all. Compressing costs a few nanoseconds per event, e.g. on the drain
+ * thread (see kaizen_event_drain.h).
+ */
+
+#ifndef KAIZEN_kaizen_event_encoding_H
+#define KAIZEN_kaizen_event_encoding_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_event.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+#define KAIZEN_EVENT_ENCODING_VERSION 1
+
+#define KAIZEN_EVENT_STREAM_HEADER_SIZE 16
+
+#define KAIZEN_EVENT_BLOCK_HEADER_SIZE 16
+
+    /**
+     * Largest number of payload bytes a single encoded event needs.
+     */
+#define KAIZEN_EVENT_ENCODED_MAX_SIZE 41
+
+    /**
+     * Number of events whose columns compressed blocks pack together.
+     */
+#define KAIZEN_EVENT_COMPRESSED_GROUP_SIZE 64
+
+
+
+    /**
+     * Writes a stream header for a stream of events measured with a frame
+     * time of @a ticks_per_second into @a buffer.
+     *
+     * Returns ENOMEM if @a capacity is smaller than
+     * KAIZEN_EVENT_STREAM_HEADER_SIZE.
+     */
+    int kaizen_event_stream_header_encode(uint64_t ticks_per_second,
+                                          uint8_t* buffer,
+                                          size_t capacity);
+
+    /**
+     * Reads the stream header at the beginning of @a buffer.
+     *
+     * Returns EAGAIN if @a size is too small to contain the header, EINVAL
+     * if the buffer does not start with a stream header of a supported
+     * version.
+     */
+    int kaizen_event_stream_header_decode(uint8_t const* buffer,
+                                          size_t size,
+                                          uint64_t* ticks_per_second);
+
+    /**
+     * Encodes as many events as fit into @a capacity bytes of @a buffer
+     * starting with the first of the @a event_count @a events.
+     *
+     * Stores the number of encoded events in @a encoded_event_count and the
+     * number of bytes written, header included, in @a encoded_size.
+     *
+     * Returns ENOMEM if not even one event fits.
+     */
+    int kaizen_event_block_encode(uint32_t stream_id,
+                                  struct kaizen_event_s const* events,
+                                  size_t event_count,
+                                  uint8_t* buffer,
+                                  size_t capacity,
+                                  size_t* encoded_event_count,
+                                  size_t* encoded_size);
+
+    /**
+     * Like kaizen_event_block_encode but writes a compressed block. Fills
+     * @a capacity less tightly as it encodes whole groups of events that
+     * fit.
+     *
+     * Returns ENOMEM if not even one event fits.
+     */
+    int kaizen_event_block_encode_compressed(uint32_t stream_id,
+                                             struct kaizen_event_s const* events,
+                                             size_t event_count,
+                                             uint8_t* buffer,
+                                             size_t capacity,
+                                             size_t* encoded_event_count,
+                                             size_t* encoded_size);
+
+    /**
+     * Reads the header of the block, compressed or not, at the beginning of
+     * @a buffer.
+     *
+     * Stores the size of the whole block, header included, in
+     * @a block_size.
+     *
+     * Returns EAGAIN if @a size is too small to contain the block header,
+     * EINVAL if the buffer does not start with a block.
+     */
+    int kaizen_event_block_peek(uint8_t const* buffer,
+                                size_t size,
+                                size_t* block_size,
+                                uint32_t* event_count,
+                                uint32_t* stream_id);
+
+    /**
+     * Decodes all events of the block, compressed or not, at the beginning
+     * of @a buffer into @a events.
+     *
+     * Returns EAGAIN if @a size is too small to contain the whole block,
+     * EINVAL if the block is malformed and ENOMEM if @a capacity is smaller
+     * than the number of events in the block.
+     */
+    int kaizen_event_block_decode(uint8_t const* buffer,
+                                  size_t size,
+                                  struct kaizen_event_s* events,
+                                  size_t capacity,
+                                  size_t* decoded_event_count);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_event_encoding_H */
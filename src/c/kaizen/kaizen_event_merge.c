@@ -0,0 +1,497 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_event_merge.h for all platforms.
+ *
+ * The loser tree has a power of two leaf_count of leaves, leaf i is stream i
+ * or a finished padding stream for i >= stream_count. Internal node n, with
+ * the root at 1 and children at 2n and 2n + 1, stores the stream which lost
+ * the comparison at n, the overall winner is kept separately. Streams
+ * waiting for events rank before all streams with events so the winner
+ * tells when the merge needs events, finished streams rank last. Only the
+ * winner ever changes, so replaying its path restores the tree.
+ *
+ * The reorder window of each stream is a binary min-heap of its next
+ * events ordered by end time and recording sequence, its root is the head
+ * of the stream. A stream is ready while its window is full or, once
+ * finished, not empty.
+ */
+
+#include "kaizen_event_merge.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_event.h"
+#include "kaizen_arena.h"
+#include "kaizen_raw_frame_time.h"
+
+
+
+enum kaizen_internal_event_merge_rank {
+    kaizen_internal_event_merge_waiting_rank = 0,
+    kaizen_internal_event_merge_ready_rank,
+    kaizen_internal_event_merge_finished_rank
+};
+
+
+
+static int kaizen_internal_event_merge_rank_of(struct kaizen_event_merge_s const* merge,
+                                               size_t stream_index);
+int kaizen_internal_event_merge_rank_of(struct kaizen_event_merge_s const* merge,
+                                        size_t stream_index)
+{
+    struct kaizen_event_merge_stream_s const* stream = NULL;
+
+    if (stream_index >= merge->stream_count) {
+        return kaizen_internal_event_merge_finished_rank;
+    }
+
+    stream = &(merge->streams[stream_index]);
+
+    if (KAIZEN_TRUE == stream->is_finished) {
+        return (0 == stream->window_count) ? kaizen_internal_event_merge_finished_rank : kaizen_internal_event_merge_ready_rank;
+    }
+
+    if (stream->window_count < merge->reorder_window) {
+        return kaizen_internal_event_merge_waiting_rank;
+    }
+
+    return kaizen_internal_event_merge_ready_rank;
+}
+
+
+
+static kaizen_bool kaizen_internal_event_merge_precedes(struct kaizen_event_merge_s const* merge,
+                                                        size_t lhs,
+                                                        size_t rhs);
+kaizen_bool kaizen_internal_event_merge_precedes(struct kaizen_event_merge_s const* merge,
+                                                 size_t lhs,
+                                                 size_t rhs)
+{
+    int const lhs_rank = kaizen_internal_event_merge_rank_of(merge, lhs);
+    int const rhs_rank = kaizen_internal_event_merge_rank_of(merge, rhs);
+
+    if (lhs_rank != rhs_rank) {
+        return (lhs_rank < rhs_rank) ? KAIZEN_TRUE : KAIZEN_FALSE;
+    }
+
+    if (kaizen_internal_event_merge_ready_rank == lhs_rank) {
+        struct kaizen_raw_frame_time_s const* lhs_time = &(merge->streams[lhs].window[0].end_time);
+        struct kaizen_raw_frame_time_s const* rhs_time = &(merge->streams[rhs].window[0].end_time);
+
+        if (KAIZEN_TRUE == kaizen_frame_time_lesser(lhs_time, rhs_time)) {
+            return KAIZEN_TRUE;
+        }
+
+        if (KAIZEN_TRUE == kaizen_frame_time_lesser(rhs_time, lhs_time)) {
+            return KAIZEN_FALSE;
+        }
+    }
+
+    return (lhs < rhs) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+/**
+ * Replays the matches on the path from the leaf of @a stream_index to the
+ * root after the stream changed.
+ */
+static void kaizen_internal_event_merge_replay(struct kaizen_event_merge_s* merge,
+                                               size_t stream_index);
+void kaizen_internal_event_merge_replay(struct kaizen_event_merge_s* merge,
+                                        size_t stream_index)
+{
+    size_t winner = stream_index;
+    size_t node = (merge->leaf_count + stream_index) / 2;
+
+    while (0 < node) {
+        if (KAIZEN_TRUE == kaizen_internal_event_merge_precedes(merge, merge->losers[node], winner)) {
+            size_t const loser = winner;
+            winner = merge->losers[node];
+            merge->losers[node] = loser;
+        }
+
+        node /= 2;
+    }
+
+    merge->winner = winner;
+}
+
+
+
+static kaizen_bool kaizen_internal_event_merge_entry_precedes(struct kaizen_event_merge_entry_s const* lhs,
+                                                              struct kaizen_event_merge_entry_s const* rhs);
+kaizen_bool kaizen_internal_event_merge_entry_precedes(struct kaizen_event_merge_entry_s const* lhs,
+                                                       struct kaizen_event_merge_entry_s const* rhs)
+{
+    if (KAIZEN_TRUE == kaizen_frame_time_lesser(&(lhs->end_time), &(rhs->end_time))) {
+        return KAIZEN_TRUE;
+    }
+
+    if (KAIZEN_TRUE == kaizen_frame_time_lesser(&(rhs->end_time), &(lhs->end_time))) {
+        return KAIZEN_FALSE;
+    }
+
+    return (lhs->sequence < rhs->sequence) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+static void kaizen_internal_event_merge_swap_entries(struct kaizen_event_merge_entry_s* lhs,
+                                                     struct kaizen_event_merge_entry_s* rhs);
+void kaizen_internal_event_merge_swap_entries(struct kaizen_event_merge_entry_s* lhs,
+                                              struct kaizen_event_merge_entry_s* rhs)
+{
+    struct kaizen_event_merge_entry_s const tmp = *lhs;
+    *lhs = *rhs;
+    *rhs = tmp;
+}
+
+
+
+/**
+ * Moves the next supplied event of @a stream into its reorder window with
+ * skew corrected time.
+ */
+static void kaizen_internal_event_merge_push_next(struct kaizen_event_merge_stream_s* stream);
+void kaizen_internal_event_merge_push_next(struct kaizen_event_merge_stream_s* stream)
+{
+    struct kaizen_event_s const* const event = &(stream->events[stream->position]);
+    struct kaizen_event_merge_entry_s* const entry = &(stream->window[stream->window_count]);
+    int errc = KAIZEN_SUCCESS;
+
+    entry->event = *event;
+    entry->sequence = stream->sequence;
+
+    if (KAIZEN_FALSE == stream->has_skew) {
+        entry->event.time = event->time;
+    } else if (KAIZEN_FALSE == stream->is_skew_ahead) {
+        errc = kaizen_frame_time_aggregate(&(event->time), &(stream->skew), &(entry->event.time));
+    } else if (KAIZEN_TRUE == kaizen_frame_time_lesser(&(event->time), &(stream->skew))) {
+        struct kaizen_raw_frame_time_s const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+        entry->event.time = zero;
+    } else {
+        errc = kaizen_frame_time_subtract(&(event->time), &(stream->skew), &(entry->event.time));
+    }
+
+    assert(KAIZEN_SUCCESS == errc);
+
+    errc = kaizen_frame_time_aggregate(&(entry->event.time), &(entry->event.duration), &(entry->end_time));
+    assert(KAIZEN_SUCCESS == errc);
+    (void)errc;
+
+    ++(stream->position);
+    ++(stream->sequence);
+
+    size_t child = stream->window_count;
+    ++(stream->window_count);
+
+    while (0 < child) {
+        size_t const parent = (child - 1) / 2;
+
+        if (KAIZEN_FALSE == kaizen_internal_event_merge_entry_precedes(&(stream->window[child]), &(stream->window[parent]))) {
+            break;
+        }
+
+        kaizen_internal_event_merge_swap_entries(&(stream->window[child]), &(stream->window[parent]));
+        child = parent;
+    }
+}
+
+
+
+/**
+ * Removes the head of the reorder window of @a stream.
+ */
+static void kaizen_internal_event_merge_pop_head(struct kaizen_event_merge_stream_s* stream);
+void kaizen_internal_event_merge_pop_head(struct kaizen_event_merge_stream_s* stream)
+{
+    assert(0 < stream->window_count);
+
+    --(stream->window_count);
+    stream->window[0] = stream->window[stream->window_count];
+
+    size_t const count = stream->window_count;
+    size_t parent = 0;
+
+    for (;;) {
+        size_t const left = 2 * parent + 1;
+        size_t const right = left + 1;
+        size_t smallest = parent;
+
+        if (left < count && KAIZEN_TRUE == kaizen_internal_event_merge_entry_precedes(&(stream->window[left]), &(stream->window[smallest]))) {
+            smallest = left;
+        }
+
+        if (right < count && KAIZEN_TRUE == kaizen_internal_event_merge_entry_precedes(&(stream->window[right]), &(stream->window[smallest]))) {
+            smallest = right;
+        }
+
+        if (smallest == parent) {
+            break;
+        }
+
+        kaizen_internal_event_merge_swap_entries(&(stream->window[parent]), &(stream->window[smallest]));
+        parent = smallest;
+    }
+}
+
+
+
+/**
+ * Fills the reorder window of @a stream from its supplied events.
+ */
+static void kaizen_internal_event_merge_fill_window(struct kaizen_event_merge_s const* merge,
+                                                    struct kaizen_event_merge_stream_s* stream);
+void kaizen_internal_event_merge_fill_window(struct kaizen_event_merge_s const* merge,
+                                             struct kaizen_event_merge_stream_s* stream)
+{
+    while (stream->window_count < merge->reorder_window && stream->position < stream->event_count) {
+        kaizen_internal_event_merge_push_next(stream);
+    }
+}
+
+
+
+int kaizen_event_merge_init_from_arena(struct kaizen_event_merge_s* merge,
+                                       struct kaizen_arena_s* arena,
+                                       size_t stream_count,
+                                       size_t reorder_window)
+{
+    assert(NULL != merge);
+    assert(NULL != arena);
+    assert(0 < stream_count);
+    assert(0 < reorder_window);
+
+    size_t leaf_count = 1;
+
+    while (leaf_count < stream_count) {
+        leaf_count *= 2;
+    }
+
+    void* streams = NULL;
+    int errc = kaizen_arena_allocate_persistent(arena,
+                                                stream_count * sizeof(struct kaizen_event_merge_stream_s),
+                                                KAIZEN_ARENA_DEFAULT_ALIGNMENT,
+                                                &streams);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    void* losers = NULL;
+    errc = kaizen_arena_allocate_persistent(arena,
+                                            leaf_count * sizeof(size_t),
+                                            KAIZEN_ARENA_DEFAULT_ALIGNMENT,
+                                            &losers);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    void* windows = NULL;
+    errc = kaizen_arena_allocate_persistent(arena,
+                                            stream_count * reorder_window * sizeof(struct kaizen_event_merge_entry_s),
+                                            KAIZEN_ARENA_DEFAULT_ALIGNMENT,
+                                            &windows);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    merge->streams = (struct kaizen_event_merge_stream_s*)streams;
+    merge->losers = (size_t*)losers;
+    merge->stream_count = stream_count;
+    merge->leaf_count = leaf_count;
+    merge->reorder_window = reorder_window;
+
+    struct kaizen_raw_frame_time_s const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+    size_t i = 0;
+
+    for (i = 0; i < stream_count; ++i) {
+        struct kaizen_event_merge_stream_s* const stream = &(merge->streams[i]);
+
+        stream->events = NULL;
+        stream->window = (struct kaizen_event_merge_entry_s*)windows + i * reorder_window;
+        stream->event_count = 0;
+        stream->position = 0;
+        stream->window_count = 0;
+        stream->sequence = 0;
+        stream->skew = zero;
+        stream->has_skew = KAIZEN_FALSE;
+        stream->is_skew_ahead = KAIZEN_FALSE;
+        stream->is_finished = KAIZEN_FALSE;
+    }
+
+    /*
+     * All streams wait for events, so ties make the leftmost leaf of every
+     * subtree its winner and the leftmost leaf of the right subtree the
+     * loser of a node.
+     */
+    merge->losers[0] = 0;
+
+    for (i = 1; i < leaf_count; ++i) {
+        size_t node = 2 * i + 1;
+
+        while (node < leaf_count) {
+            node *= 2;
+        }
+
+        merge->losers[i] = node - leaf_count;
+    }
+
+    merge->winner = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_merge_finalize(struct kaizen_event_merge_s* merge)
+{
+    assert(NULL != merge);
+
+    merge->streams = NULL;
+    merge->losers = NULL;
+    merge->stream_count = 0;
+    merge->leaf_count = 0;
+    merge->reorder_window = 0;
+    merge->winner = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_merge_set_stream_skew(struct kaizen_event_merge_s* merge,
+                                       size_t stream_index,
+                                       struct kaizen_raw_frame_time_s const* skew,
+                                       kaizen_bool is_ahead)
+{
+    assert(NULL != merge);
+    assert(NULL != skew);
+    assert(stream_index < merge->stream_count);
+    assert(0 == merge->streams[stream_index].sequence);
+
+    struct kaizen_event_merge_stream_s* const stream = &(merge->streams[stream_index]);
+
+    stream->skew = *skew;
+    stream->has_skew = KAIZEN_TRUE;
+    stream->is_skew_ahead = is_ahead;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_merge_supply(struct kaizen_event_merge_s* merge,
+                              size_t stream_index,
+                              struct kaizen_event_s const* events,
+                              size_t event_count)
+{
+    assert(NULL != merge);
+    assert(NULL != events);
+    assert(0 < event_count);
+    assert(stream_index < merge->stream_count);
+    assert(kaizen_internal_event_merge_waiting_rank == kaizen_internal_event_merge_rank_of(merge, stream_index));
+    assert(stream_index == merge->winner);
+
+    struct kaizen_event_merge_stream_s* const stream = &(merge->streams[stream_index]);
+
+    stream->events = events;
+    stream->event_count = event_count;
+    stream->position = 0;
+    kaizen_internal_event_merge_fill_window(merge, stream);
+
+    kaizen_internal_event_merge_replay(merge, stream_index);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_merge_finish_stream(struct kaizen_event_merge_s* merge,
+                                     size_t stream_index)
+{
+    assert(NULL != merge);
+    assert(stream_index < merge->stream_count);
+    assert(kaizen_internal_event_merge_waiting_rank == kaizen_internal_event_merge_rank_of(merge, stream_index));
+    assert(stream_index == merge->winner);
+
+    merge->streams[stream_index].is_finished = KAIZEN_TRUE;
+
+    kaizen_internal_event_merge_replay(merge, stream_index);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_event_merge_pop(struct kaizen_event_merge_s* merge,
+                           struct kaizen_event_s* event,
+                           size_t* stream_index)
+{
+    assert(NULL != merge);
+    assert(NULL != event);
+    assert(NULL != stream_index);
+
+    size_t const winner = merge->winner;
+
+    switch (kaizen_internal_event_merge_rank_of(merge, winner)) {
+        case kaizen_internal_event_merge_waiting_rank:
+            *stream_index = winner;
+            return EAGAIN;
+        case kaizen_internal_event_merge_finished_rank:
+            return ENOENT;
+        default:
+            break;
+    }
+
+    struct kaizen_event_merge_stream_s* const stream = &(merge->streams[winner]);
+
+    *event = stream->window[0].event;
+    *stream_index = winner;
+
+    kaizen_internal_event_merge_pop_head(stream);
+    kaizen_internal_event_merge_fill_window(merge, stream);
+
+    kaizen_internal_event_merge_replay(merge, winner);
+
+    return KAIZEN_SUCCESS;
+}
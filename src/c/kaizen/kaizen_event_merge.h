@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Streaming merge of the event streams of several threads, e.g. popped
+ * from their event channels (see kaizen_event_channel.h), into one stream
+ * ordered by event end time, i.e. time plus duration, e.g. for a live view
+ * or a file writer which need a global order.
+ *
+ * Streams are ordered by end time because zones are recorded when they end
+ * but carry their start time, so nested zones of a thread arrive inner
+ * first. Events recorded in batches after the fact, e.g. samples of
+ * kaizen_sampler_record_events or call stack definitions, arrive later
+ * than events ending after them. Each stream sorts its next
+ * reorder_window events by end time, so events arriving up to
+ * reorder_window - 1 events late are emitted in order. Events with equal
+ * end times keep their order within a stream, e.g. stack frame events stay
+ * behind their sample.
+ *
+ * The merge copies up to reorder_window events of each stream into a
+ * per-stream heap and selects the next stream with a loser tree, i.e. with
+ * log2(stream count) time comparisons per event and no allocations after
+ * initialization.
+ *
+ * An event can only be emitted once the reorder window of every stream is
+ * full or its stream finished. When the events supplied for a stream ran out
+ * kaizen_event_merge_pop asks for the stream's next events, or for it to be
+ * finished, before emitting anything else.
+ *
+ * <code>
+ * for (;;) {
+ *     int const errc = kaizen_event_merge_pop(&merge, &event, &stream_index);
+ *     if (KAIZEN_SUCCESS == errc) {
+ *         write_event(&event, stream_index);
+ *     } else if (EAGAIN == errc) {
+ *         // Release the consumed block, then wait for the next one.
+ *         if (has_block[stream_index]) {
+ *             kaizen_event_channel_pop_end(&channels[stream_index]);
+ *         }
+ *         has_block[stream_index] = wait_for_block(&channels[stream_index], &events, &count);
+ *         kaizen_event_merge_supply(&merge, stream_index, events, count);
+ *     } else {
+ *         break; // ENOENT, all streams finished.
+ *     }
+ * }
+ * </code>
+ *
+ * A merge must only be used by one thread at a time.
+ */
+
+#ifndef KAIZEN_kaizen_event_merge_H
+#define KAIZEN_kaizen_event_merge_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_event_merge_entry_s {
+        struct kaizen_event_s event;
+        struct kaizen_raw_frame_time_s end_time;
+        uint64_t sequence;
+    };
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_event_merge_stream_s {
+        struct kaizen_event_s const* events;
+        struct kaizen_event_merge_entry_s* window;
+        size_t event_count;
+        size_t position;
+        size_t window_count;
+        uint64_t sequence;
+        struct kaizen_raw_frame_time_s skew;
+        kaizen_bool has_skew;
+        kaizen_bool is_skew_ahead;
+        kaizen_bool is_finished;
+    };
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_event_merge_s {
+        struct kaizen_event_merge_stream_s* streams;
+        size_t* losers;
+        size_t stream_count;
+        size_t leaf_count;
+        size_t reorder_window;
+        size_t winner;
+    };
+    typedef struct kaizen_event_merge_s kaizen_event_merge_t;
+
+
+
+    /**
+     * Allocates the state for merging @a stream_count streams with a
+     * @a reorder_window of at least one event per stream from the persistent
+     * part of @a arena. All streams start out waiting for their first events,
+     * kaizen_event_merge_pop asks for them in stream index order.
+     *
+     * Pick a reorder window larger than the most events a stream records
+     * after an event that ends earlier, e.g. the sampler capacity times the
+     * stack depth plus one for threads recording samples. A window of one
+     * only merges streams already ordered by end time.
+     *
+     * Returns ENOMEM if the arena is full.
+     */
+    int kaizen_event_merge_init_from_arena(struct kaizen_event_merge_s* merge,
+                                           struct kaizen_arena_s* arena,
+                                           size_t stream_count,
+                                           size_t reorder_window);
+
+    int kaizen_event_merge_finalize(struct kaizen_event_merge_s* merge);
+
+    /**
+     * Corrects the times of the events of stream @a stream_index by @a skew,
+     * i.e. the offset of the clock the stream was recorded with, e.g. of
+     * the processor core its thread is pinned to. Pass KAIZEN_TRUE for
+     * @a is_ahead if the clock runs ahead. Times earlier than a subtracted
+     * skew become zero.
+     *
+     * Set the skew before supplying the first events of the stream.
+     */
+    int kaizen_event_merge_set_stream_skew(struct kaizen_event_merge_s* merge,
+                                           size_t stream_index,
+                                           struct kaizen_raw_frame_time_s const* skew,
+                                           kaizen_bool is_ahead);
+
+    /**
+     * Supplies the next @a event_count events of stream @a stream_index in
+     * recording order. The events must stay valid until
+     * kaizen_event_merge_pop asks for the next events of the stream.
+     *
+     * Only call for the stream kaizen_event_merge_pop asked events for.
+     */
+    int kaizen_event_merge_supply(struct kaizen_event_merge_s* merge,
+                                  size_t stream_index,
+                                  struct kaizen_event_s const* events,
+                                  size_t event_count);
+
+    /**
+     * Marks stream @a stream_index as ended, e.g. because its thread
+     * finished, so events of the other streams do not wait for it.
+     *
+     * Only call for the stream kaizen_event_merge_pop asked events for.
+     */
+    int kaizen_event_merge_finish_stream(struct kaizen_event_merge_s* merge,
+                                         size_t stream_index);
+
+    /**
+     * Copies the event with the earliest end time of all streams with skew
+     * corrected time into @a event and stores the index of its stream in
+     * @a stream_index. Events with equal end times are emitted in stream
+     * index order.
+     *
+     * Returns EAGAIN and stores the index of the stream whose next events are
+     * needed in @a stream_index if the supplied events of a stream ran out,
+     * and ENOENT once all streams are finished.
+     */
+    int kaizen_event_merge_pop(struct kaizen_event_merge_s* merge,
+                               struct kaizen_event_s* event,
+                               size_t* stream_index);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_event_merge_H */
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_frame_limiter.h for all platforms based on
+ * kaizen_raw_frame_time.h and kaizen_thread_sleep_nanoseconds of
+ * kaizen_raw_thread.h.
+ *
+ * The margin tracks a decaying maximum of the observed oversleep plus a
+ * quarter of headroom: a larger oversleep replaces it immediately, smaller
+ * ones pull it down by 1/16 of the difference per sleep.
+ */
+
+#include "kaizen_frame_limiter.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_raw_thread.h"
+#include "kaizen_frame_time_converter.h"
+
+
+
+#define KAIZEN_INTERNAL_FRAME_LIMITER_INITIAL_MARGIN_NANOSECONDS 2000000u
+#define KAIZEN_INTERNAL_FRAME_LIMITER_MINIMUM_MARGIN_NANOSECONDS 50000u
+#define KAIZEN_INTERNAL_FRAME_LIMITER_MARGIN_DECAY_SHIFT 4u
+
+
+
+/**
+ * Adapts the margin of @a limiter to a sleep which took @a oversleep_ticks
+ * longer than requested.
+ */
+static void kaizen_internal_frame_limiter_adapt_margin(struct kaizen_frame_limiter_s* limiter,
+                                                       uint64_t oversleep_ticks);
+
+static void kaizen_internal_frame_limiter_adapt_margin(struct kaizen_frame_limiter_s* limiter,
+                                                       uint64_t oversleep_ticks)
+{
+    assert(NULL != limiter);
+
+    uint64_t target_ticks = oversleep_ticks + (oversleep_ticks / 4u);
+
+    if (target_ticks < limiter->minimum_margin_ticks) {
+        target_ticks = limiter->minimum_margin_ticks;
+    }
+
+    if (target_ticks >= limiter->margin_ticks) {
+        limiter->margin_ticks = target_ticks;
+    } else {
+        limiter->margin_ticks -= (limiter->margin_ticks - target_ticks) >> KAIZEN_INTERNAL_FRAME_LIMITER_MARGIN_DECAY_SHIFT;
+    }
+}
+
+
+
+int kaizen_frame_limiter_init(struct kaizen_frame_limiter_s* limiter)
+{
+    assert(NULL != limiter);
+
+    int const errc = kaizen_frame_time_converter_init(&(limiter->converter));
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    limiter->margin_ticks = kaizen_frame_time_converter_nanoseconds_to_ticks(&(limiter->converter),
+                                                                             KAIZEN_INTERNAL_FRAME_LIMITER_INITIAL_MARGIN_NANOSECONDS);
+    limiter->minimum_margin_ticks = kaizen_frame_time_converter_nanoseconds_to_ticks(&(limiter->converter),
+                                                                                     KAIZEN_INTERNAL_FRAME_LIMITER_MINIMUM_MARGIN_NANOSECONDS);
+    limiter->overslept_count = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_limiter_finalize(struct kaizen_frame_limiter_s* limiter)
+{
+    assert(NULL != limiter);
+
+    return kaizen_frame_time_converter_finalize(&(limiter->converter));
+}
+
+
+
+int kaizen_frame_wait_until(struct kaizen_frame_limiter_s* limiter,
+                            struct kaizen_raw_frame_time_s const* deadline)
+{
+    assert(NULL != limiter);
+    assert(NULL != deadline);
+
+    struct kaizen_raw_frame_time_s now = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int errc = kaizen_frame_time_query(&now);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    if (KAIZEN_TRUE == kaizen_frame_time_greater_or_equal(&now, deadline)) {
+        return KAIZEN_SUCCESS;
+    }
+
+    struct kaizen_raw_frame_time_s remaining = KAIZEN_RAW_FRAME_TIME_ZERO;
+    uint64_t remaining_ticks = 0;
+    errc = kaizen_frame_time_subtract(deadline, &now, &remaining);
+
+    if (KAIZEN_SUCCESS == errc) {
+        errc = kaizen_frame_time_convert_to_ticks(&remaining, &remaining_ticks);
+    }
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    if (remaining_ticks > limiter->margin_ticks) {
+        uint64_t const sleep_ticks = remaining_ticks - limiter->margin_ticks;
+        struct kaizen_raw_frame_time_s const sleep_start = now;
+
+        errc = kaizen_thread_sleep_nanoseconds(kaizen_frame_time_converter_ticks_to_nanoseconds_uint64(&(limiter->converter),
+                                                                                                     sleep_ticks));
+
+        if (KAIZEN_SUCCESS != errc) {
+            return errc;
+        }
+
+        errc = kaizen_frame_time_query(&now);
+
+        if (KAIZEN_SUCCESS != errc) {
+            return errc;
+        }
+
+        struct kaizen_raw_frame_time_s slept = KAIZEN_RAW_FRAME_TIME_ZERO;
+        uint64_t slept_ticks = 0;
+
+        if (KAIZEN_TRUE == kaizen_frame_time_greater_or_equal(&now, &sleep_start)) {
+            errc = kaizen_frame_time_subtract(&now, &sleep_start, &slept);
+
+            if (KAIZEN_SUCCESS == errc) {
+                errc = kaizen_frame_time_convert_to_ticks(&slept, &slept_ticks);
+            }
+
+            if (KAIZEN_SUCCESS != errc) {
+                return errc;
+            }
+        }
+
+        kaizen_internal_frame_limiter_adapt_margin(limiter,
+                                                   (slept_ticks > sleep_ticks) ? (slept_ticks - sleep_ticks) : 0u);
+
+        if (KAIZEN_TRUE == kaizen_frame_time_greater(&now, deadline)) {
+            ++(limiter->overslept_count);
+
+            return KAIZEN_SUCCESS;
+        }
+    }
+
+    while (KAIZEN_TRUE == kaizen_frame_time_lesser(&now, deadline)) {
+        kaizen_atomic_cpu_relax();
+
+        errc = kaizen_frame_time_query(&now);
+
+        if (KAIZEN_SUCCESS != errc) {
+            return errc;
+        }
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_limiter_margin(struct kaizen_frame_limiter_s const* limiter,
+                                struct kaizen_raw_frame_time_s* margin)
+{
+    assert(NULL != limiter);
+    assert(NULL != margin);
+
+    return kaizen_frame_time_convert_from_ticks(margin, limiter->margin_ticks);
+}
+
+
+
+uint64_t kaizen_frame_limiter_overslept_count(struct kaizen_frame_limiter_s const* limiter)
+{
+    assert(NULL != limiter);
+
+    return limiter->overslept_count;
+}
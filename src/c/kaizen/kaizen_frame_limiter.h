@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Frame limiter waiting for precise deadlines, e.g. the next tick of a
+ * dedicated server running at a fixed rate, without burning a core.
+ *
+ * kaizen_frame_wait_until sleeps until a margin before the deadline and
+ * spins on kaizen_frame_time_query for the rest. Sleeping alone wakes up
+ * late by the scheduling latency (often 1-2 ms), spinning alone keeps a
+ * core busy. The margin adapts to the oversleep observed: it grows at once
+ * when a sleep overshoots it and shrinks slowly while sleeps are punctual.
+ *
+ * <code>
+ * kaizen_frame_time_query(&deadline);
+ * while (running) {
+ *     kaizen_frame_time_aggregate(&deadline, &tick_period, &next_deadline);
+ *     deadline = next_deadline;
+ *     tick();
+ *     kaizen_frame_wait_until(&limiter, &deadline);
+ * }
+ * </code>
+ *
+ * Each thread waiting needs its own limiter.
+ */
+
+#ifndef KAIZEN_kaizen_frame_limiter_H
+#define KAIZEN_kaizen_frame_limiter_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_frame_time_converter.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_frame_limiter_s {
+        struct kaizen_frame_time_converter_s converter;
+        uint64_t margin_ticks;
+        uint64_t minimum_margin_ticks;
+        uint64_t overslept_count;
+    };
+    typedef struct kaizen_frame_limiter_s kaizen_frame_limiter_t;
+
+
+
+    /**
+     * Initializes @a limiter with a margin of 2 ms.
+     */
+    int kaizen_frame_limiter_init(struct kaizen_frame_limiter_s* limiter);
+
+    int kaizen_frame_limiter_finalize(struct kaizen_frame_limiter_s* limiter);
+
+    /**
+     * Returns when the frame time reaches @a deadline, a frame time queried
+     * with kaizen_frame_time_query, or at once if it already passed.
+     *
+     * Sleeps until the margin of @a limiter before @a deadline and spins
+     * afterwards.
+     */
+    int kaizen_frame_wait_until(struct kaizen_frame_limiter_s* limiter,
+                                struct kaizen_raw_frame_time_s const* deadline);
+
+    /**
+     * Stores the current margin before deadlines which is spent spinning.
+     */
+    int kaizen_frame_limiter_margin(struct kaizen_frame_limiter_s const* limiter,
+                                    struct kaizen_raw_frame_time_s* margin);
+
+    /**
+     * Returns how often sleeping overshot a deadline, e.g. because the
+     * margin had been too small or the thread had been preempted.
+     */
+    uint64_t kaizen_frame_limiter_overslept_count(struct kaizen_frame_limiter_s const* limiter);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_frame_limiter_H */
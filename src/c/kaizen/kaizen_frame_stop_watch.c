@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_frame_stop_watch.h for all platforms based on
+ * kaizen_raw_frame_time.h.
+ */
+
+#include "kaizen_frame_stop_watch.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_raw_reliable_frame_time_scope.h"
+#include "kaizen_frame_time_accumulator.h"
+
+
+
+static struct kaizen_raw_frame_time_s const kaizen_internal_zero_frame_time = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+
+
+/**
+ * Adds the time since the segment start to the elapsed time and the lap
+ * and starts the next segment now.
+ *
+ * Counters leaping backwards (see kaizen_raw_frame_time.h) add nothing.
+ */
+static int kaizen_internal_frame_stop_watch_close_segment(struct kaizen_frame_stop_watch_s* watch);
+
+static int kaizen_internal_frame_stop_watch_close_segment(struct kaizen_frame_stop_watch_s* watch)
+{
+    assert(NULL != watch);
+    assert(kaizen_running_frame_stop_watch_state == watch->state);
+
+    struct kaizen_raw_frame_time_s now = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int errc = kaizen_frame_time_query(&now);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    if (KAIZEN_TRUE == kaizen_frame_time_lesser(&now, &(watch->segment_start))) {
+        watch->segment_start = now;
+
+        return KAIZEN_SUCCESS;
+    }
+
+    struct kaizen_raw_frame_time_s segment = KAIZEN_RAW_FRAME_TIME_ZERO;
+    errc = kaizen_frame_time_subtract(&now, &(watch->segment_start), &segment);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    struct kaizen_raw_frame_time_s const elapsed = watch->elapsed;
+    struct kaizen_raw_frame_time_s const lap_elapsed = watch->lap_elapsed;
+
+    errc = kaizen_frame_time_aggregate(&elapsed, &segment, &(watch->elapsed));
+
+    if (KAIZEN_SUCCESS == errc) {
+        errc = kaizen_frame_time_aggregate(&lap_elapsed, &segment, &(watch->lap_elapsed));
+    }
+
+    watch->segment_start = now;
+
+    return errc;
+}
+
+
+
+/**
+ * Zeroes the elapsed time and the laps of @a watch.
+ */
+static void kaizen_internal_frame_stop_watch_reset(struct kaizen_frame_stop_watch_s* watch);
+
+static void kaizen_internal_frame_stop_watch_reset(struct kaizen_frame_stop_watch_s* watch)
+{
+    assert(NULL != watch);
+
+    watch->segment_start = kaizen_internal_zero_frame_time;
+    watch->elapsed = kaizen_internal_zero_frame_time;
+    watch->lap_elapsed = kaizen_internal_zero_frame_time;
+    watch->last_lap = kaizen_internal_zero_frame_time;
+    watch->shortest_lap = kaizen_internal_zero_frame_time;
+    watch->longest_lap = kaizen_internal_zero_frame_time;
+    watch->lap_count = 0;
+    (void)kaizen_frame_time_accumulator_init(&(watch->lap_sum));
+}
+
+
+
+int kaizen_frame_stop_watch_init(struct kaizen_frame_stop_watch_s* watch)
+{
+    assert(NULL != watch);
+
+    kaizen_internal_frame_stop_watch_reset(watch);
+    watch->state = kaizen_stopped_frame_stop_watch_state;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_stop_watch_finalize(struct kaizen_frame_stop_watch_s* watch)
+{
+    assert(NULL != watch);
+    assert(kaizen_stopped_frame_stop_watch_state == watch->state);
+
+    return kaizen_frame_time_accumulator_finalize(&(watch->lap_sum));
+}
+
+
+
+int kaizen_frame_stop_watch_start(struct kaizen_frame_stop_watch_s* watch)
+{
+    assert(NULL != watch);
+    assert(kaizen_stopped_frame_stop_watch_state == watch->state);
+
+    kaizen_internal_frame_stop_watch_reset(watch);
+
+    int errc = kaizen_reliable_frame_time_scope_init(&(watch->scope));
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    errc = kaizen_frame_time_query(&(watch->segment_start));
+
+    if (KAIZEN_SUCCESS != errc) {
+        (void)kaizen_reliable_frame_time_scope_finalize(&(watch->scope));
+
+        return errc;
+    }
+
+    watch->state = kaizen_running_frame_stop_watch_state;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_stop_watch_stop(struct kaizen_frame_stop_watch_s* watch)
+{
+    assert(NULL != watch);
+    assert(kaizen_stopped_frame_stop_watch_state != watch->state);
+
+    int errc = KAIZEN_SUCCESS;
+
+    if (kaizen_running_frame_stop_watch_state == watch->state) {
+        errc = kaizen_internal_frame_stop_watch_close_segment(watch);
+    }
+
+    int const scope_errc = kaizen_reliable_frame_time_scope_finalize(&(watch->scope));
+    watch->state = kaizen_stopped_frame_stop_watch_state;
+
+    return (KAIZEN_SUCCESS != errc) ? errc : scope_errc;
+}
+
+
+
+int kaizen_frame_stop_watch_pause(struct kaizen_frame_stop_watch_s* watch)
+{
+    assert(NULL != watch);
+    assert(kaizen_running_frame_stop_watch_state == watch->state);
+
+    int const errc = kaizen_internal_frame_stop_watch_close_segment(watch);
+    watch->state = kaizen_paused_frame_stop_watch_state;
+
+    return errc;
+}
+
+
+
+int kaizen_frame_stop_watch_resume(struct kaizen_frame_stop_watch_s* watch)
+{
+    assert(NULL != watch);
+    assert(kaizen_paused_frame_stop_watch_state == watch->state);
+
+    int const errc = kaizen_frame_time_query(&(watch->segment_start));
+
+    if (KAIZEN_SUCCESS == errc) {
+        watch->state = kaizen_running_frame_stop_watch_state;
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_frame_stop_watch_lap(struct kaizen_frame_stop_watch_s* watch,
+                                struct kaizen_raw_frame_time_s* lap)
+{
+    assert(NULL != watch);
+    assert(NULL != lap);
+    assert(kaizen_stopped_frame_stop_watch_state != watch->state);
+
+    if (kaizen_running_frame_stop_watch_state == watch->state) {
+        int const errc = kaizen_internal_frame_stop_watch_close_segment(watch);
+
+        if (KAIZEN_SUCCESS != errc) {
+            return errc;
+        }
+    }
+
+    uint64_t lap_ticks = 0;
+    int const errc = kaizen_frame_time_convert_to_ticks(&(watch->lap_elapsed), &lap_ticks);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    struct kaizen_raw_frame_time_s const current_lap = watch->lap_elapsed;
+
+    if ((0 == watch->lap_count)
+        || (KAIZEN_TRUE == kaizen_frame_time_lesser(&current_lap, &(watch->shortest_lap)))) {
+
+        watch->shortest_lap = current_lap;
+    }
+
+    if (KAIZEN_TRUE == kaizen_frame_time_greater(&current_lap, &(watch->longest_lap))) {
+        watch->longest_lap = current_lap;
+    }
+
+    kaizen_frame_time_accumulator_add_ticks(&(watch->lap_sum), lap_ticks);
+    watch->last_lap = current_lap;
+    watch->lap_elapsed = kaizen_internal_zero_frame_time;
+    ++(watch->lap_count);
+
+    *lap = current_lap;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_stop_watch_query_elapsed(struct kaizen_frame_stop_watch_s const* watch,
+                                          struct kaizen_raw_frame_time_s* elapsed)
+{
+    assert(NULL != watch);
+    assert(NULL != elapsed);
+
+    if (kaizen_running_frame_stop_watch_state != watch->state) {
+        *elapsed = watch->elapsed;
+
+        return KAIZEN_SUCCESS;
+    }
+
+    struct kaizen_raw_frame_time_s now = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int errc = kaizen_frame_time_query(&now);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    if (KAIZEN_TRUE == kaizen_frame_time_lesser(&now, &(watch->segment_start))) {
+        *elapsed = watch->elapsed;
+
+        return KAIZEN_SUCCESS;
+    }
+
+    struct kaizen_raw_frame_time_s segment = KAIZEN_RAW_FRAME_TIME_ZERO;
+    errc = kaizen_frame_time_subtract(&now, &(watch->segment_start), &segment);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    return kaizen_frame_time_aggregate(&(watch->elapsed), &segment, elapsed);
+}
+
+
+
+int kaizen_frame_stop_watch_query_lap_statistics(struct kaizen_frame_stop_watch_s const* watch,
+                                                  struct kaizen_frame_lap_statistics_s* statistics)
+{
+    assert(NULL != watch);
+    assert(NULL != statistics);
+
+    statistics->lap_count = watch->lap_count;
+    statistics->last_lap = watch->last_lap;
+    statistics->shortest_lap = watch->shortest_lap;
+    statistics->longest_lap = watch->longest_lap;
+    statistics->mean_lap = kaizen_internal_zero_frame_time;
+
+    if (0 == watch->lap_count) {
+        return KAIZEN_SUCCESS;
+    }
+
+    return kaizen_frame_time_accumulator_mean(&(watch->lap_sum),
+                                              watch->lap_count,
+                                              &(statistics->mean_lap));
+}
+
+
+
+kaizen_frame_stop_watch_state_t kaizen_frame_stop_watch_state(struct kaizen_frame_stop_watch_s const* watch)
+{
+    assert(NULL != watch);
+
+    return watch->state;
+}
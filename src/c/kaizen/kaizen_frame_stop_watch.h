@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Stop watch accumulating the time it runs, e.g. the time spent in a
+ * subsystem across several calls of a frame, with pause and resume and
+ * laps, e.g. one lap per processed job.
+ *
+ * A running stop watch keeps a reliable frame time scope (see
+ * kaizen_raw_reliable_frame_time_scope.h) open from start to stop, so
+ * start, pause, resume, lap and stop must be called from the same thread.
+ * It does not allocate memory.
+ *
+ * <code>
+ * kaizen_frame_stop_watch_start(&watch);
+ * for each job {
+ *     process(job);
+ *     kaizen_frame_stop_watch_lap(&watch, &job_time);
+ * }
+ * kaizen_frame_stop_watch_stop(&watch);
+ * kaizen_frame_stop_watch_query_lap_statistics(&watch, &statistics);
+ * </code>
+ */
+
+#ifndef KAIZEN_kaizen_frame_stop_watch_H
+#define KAIZEN_kaizen_frame_stop_watch_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_raw_reliable_frame_time_scope.h>
+#include <kaizen/kaizen_frame_time_accumulator.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    enum kaizen_frame_stop_watch_state {
+        kaizen_stopped_frame_stop_watch_state = 0,
+        kaizen_running_frame_stop_watch_state,
+        kaizen_paused_frame_stop_watch_state
+    };
+    typedef enum kaizen_frame_stop_watch_state kaizen_frame_stop_watch_state_t;
+
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_frame_stop_watch_s {
+        struct kaizen_raw_reliable_frame_time_scope_s scope;
+        struct kaizen_raw_frame_time_s segment_start;
+        struct kaizen_raw_frame_time_s elapsed;
+        struct kaizen_raw_frame_time_s lap_elapsed;
+        struct kaizen_raw_frame_time_s last_lap;
+        struct kaizen_raw_frame_time_s shortest_lap;
+        struct kaizen_raw_frame_time_s longest_lap;
+        struct kaizen_frame_time_accumulator_s lap_sum;
+        uint64_t lap_count;
+        kaizen_frame_stop_watch_state_t state;
+    };
+    typedef struct kaizen_frame_stop_watch_s kaizen_frame_stop_watch_t;
+
+
+
+    /**
+     * Statistics of the laps measured since the stop watch was started.
+     * All durations are zero if no lap has been measured.
+     */
+    struct kaizen_frame_lap_statistics_s {
+        uint64_t lap_count;
+        struct kaizen_raw_frame_time_s last_lap;
+        struct kaizen_raw_frame_time_s shortest_lap;
+        struct kaizen_raw_frame_time_s longest_lap;
+        struct kaizen_raw_frame_time_s mean_lap;
+    };
+    typedef struct kaizen_frame_lap_statistics_s kaizen_frame_lap_statistics_t;
+
+
+
+    /**
+     * Initializes a stopped @a watch.
+     */
+    int kaizen_frame_stop_watch_init(struct kaizen_frame_stop_watch_s* watch);
+
+    /**
+     * @a watch must be stopped.
+     */
+    int kaizen_frame_stop_watch_finalize(struct kaizen_frame_stop_watch_s* watch);
+
+    /**
+     * Resets the elapsed time and laps of the stopped @a watch, opens a
+     * reliable frame time scope and starts measuring.
+     */
+    int kaizen_frame_stop_watch_start(struct kaizen_frame_stop_watch_s* watch);
+
+    /**
+     * Stops the running or paused @a watch and closes its reliable frame
+     * time scope. The elapsed time and laps stay queryable until the next
+     * start.
+     */
+    int kaizen_frame_stop_watch_stop(struct kaizen_frame_stop_watch_s* watch);
+
+    /**
+     * Stops adding time to the running @a watch until it is resumed.
+     */
+    int kaizen_frame_stop_watch_pause(struct kaizen_frame_stop_watch_s* watch);
+
+    int kaizen_frame_stop_watch_resume(struct kaizen_frame_stop_watch_s* watch);
+
+    /**
+     * Ends the current lap of the running or paused @a watch, stores its
+     * time without pauses into @a lap and starts the next lap.
+     */
+    int kaizen_frame_stop_watch_lap(struct kaizen_frame_stop_watch_s* watch,
+                                    struct kaizen_raw_frame_time_s* lap);
+
+    /**
+     * Stores the time @a watch ran since it was started, without pauses.
+     *
+     * Returns ERANGE if the frame time can not represent it, use a
+     * kaizen_frame_time_accumulator for times longer than frames.
+     */
+    int kaizen_frame_stop_watch_query_elapsed(struct kaizen_frame_stop_watch_s const* watch,
+                                              struct kaizen_raw_frame_time_s* elapsed);
+
+    int kaizen_frame_stop_watch_query_lap_statistics(struct kaizen_frame_stop_watch_s const* watch,
+                                                      struct kaizen_frame_lap_statistics_s* statistics);
+
+    kaizen_frame_stop_watch_state_t kaizen_frame_stop_watch_state(struct kaizen_frame_stop_watch_s const* watch);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_frame_stop_watch_H */
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_frame_time_accumulator.h for all platforms based
+ * on the tick functions of kaizen_raw_frame_time.h.
+ */
+
+#include "kaizen_frame_time_accumulator.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_internal_fixed_point.h"
+
+
+
+int kaizen_frame_time_accumulator_init(struct kaizen_frame_time_accumulator_s* accumulator)
+{
+    assert(NULL != accumulator);
+
+    accumulator->high_ticks = 0;
+    accumulator->low_ticks = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_accumulator_finalize(struct kaizen_frame_time_accumulator_s* accumulator)
+{
+    assert(NULL != accumulator);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_accumulator_add(struct kaizen_frame_time_accumulator_s* accumulator,
+                                      struct kaizen_raw_frame_time_s const* duration)
+{
+    assert(NULL != accumulator);
+    assert(NULL != duration);
+
+    uint64_t ticks = 0;
+    int const errc = kaizen_frame_time_convert_to_ticks(duration, &ticks);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    kaizen_frame_time_accumulator_add_ticks(accumulator, ticks);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+void kaizen_frame_time_accumulator_add_ticks(struct kaizen_frame_time_accumulator_s* accumulator,
+                                             uint64_t ticks)
+{
+    assert(NULL != accumulator);
+
+    uint64_t const low_ticks = accumulator->low_ticks + ticks;
+
+    accumulator->high_ticks += (low_ticks < ticks) ? 1u : 0u;
+    accumulator->low_ticks = low_ticks;
+}
+
+
+
+void kaizen_frame_time_accumulator_merge(struct kaizen_frame_time_accumulator_s* accumulator,
+                                         struct kaizen_frame_time_accumulator_s const* other)
+{
+    assert(NULL != accumulator);
+    assert(NULL != other);
+
+    kaizen_frame_time_accumulator_add_ticks(accumulator, other->low_ticks);
+    accumulator->high_ticks += other->high_ticks;
+}
+
+
+
+void kaizen_frame_time_accumulator_ticks(struct kaizen_frame_time_accumulator_s const* accumulator,
+                                         uint64_t* high_ticks,
+                                         uint64_t* low_ticks)
+{
+    assert(NULL != accumulator);
+    assert(NULL != high_ticks);
+    assert(NULL != low_ticks);
+
+    *high_ticks = accumulator->high_ticks;
+    *low_ticks = accumulator->low_ticks;
+}
+
+
+
+int kaizen_frame_time_accumulator_mean(struct kaizen_frame_time_accumulator_s const* accumulator,
+                                       uint64_t count,
+                                       struct kaizen_raw_frame_time_s* mean)
+{
+    assert(NULL != accumulator);
+    assert(NULL != mean);
+
+    if (0 == count) {
+        return EINVAL;
+    }
+
+    uint64_t mean_high = 0;
+    uint64_t mean_low = 0;
+    (void)kaizen_internal_fixed_point_divide(accumulator->high_ticks,
+                                             accumulator->low_ticks,
+                                             count,
+                                             &mean_high,
+                                             &mean_low);
+
+    if (0 != mean_high) {
+        return ERANGE;
+    }
+
+    return kaizen_frame_time_convert_from_ticks(mean, mean_low);
+}
+
+
+
+int kaizen_frame_time_accumulator_convert_to_seconds(struct kaizen_frame_time_accumulator_s const* accumulator,
+                                                     uint64_t ticks_per_second,
+                                                     uint64_t* seconds,
+                                                     uint32_t* nanoseconds)
+{
+    assert(NULL != accumulator);
+    assert(NULL != seconds);
+    assert(NULL != nanoseconds);
+
+    if (0 == ticks_per_second) {
+        return EINVAL;
+    }
+
+    uint64_t seconds_high = 0;
+    uint64_t seconds_low = 0;
+    uint64_t const remaining_ticks = kaizen_internal_fixed_point_divide(accumulator->high_ticks,
+                                                                        accumulator->low_ticks,
+                                                                        ticks_per_second,
+                                                                        &seconds_high,
+                                                                        &seconds_low);
+
+    if (0 != seconds_high) {
+        return ERANGE;
+    }
+
+    uint64_t product_high = 0;
+    uint64_t product_low = 0;
+    kaizen_internal_fixed_point_multiply(remaining_ticks, (uint64_t)1000000000, &product_high, &product_low);
+
+    uint64_t nanoseconds_high = 0;
+    uint64_t nanoseconds_low = 0;
+    (void)kaizen_internal_fixed_point_divide(product_high,
+                                             product_low,
+                                             ticks_per_second,
+                                             &nanoseconds_high,
+                                             &nanoseconds_low);
+
+    *seconds = seconds_low;
+    *nanoseconds = (uint32_t)nanoseconds_low;
+
+    return KAIZEN_SUCCESS;
+}
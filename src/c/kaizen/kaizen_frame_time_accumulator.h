@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Overflow safe sum of frame times or ticks, e.g. the total time of a zone
+ * over days of server uptime. Frame times (see kaizen_raw_frame_time.h)
+ * only cover short spans and 64 bit ticks of a GHz counter overflow after
+ * about 584 years of summed durations - billions of zone executions reach
+ * that far sooner than it sounds when durations are summed across threads.
+ *
+ * The accumulator keeps 128 bit ticks as two 64 bit halves. Adding costs an
+ * addition with carry, converting is exact and only meant for reporting.
+ *
+ * <code>
+ * kaizen_frame_time_accumulator_add(&zone_total, &duration);
+ * // when reporting
+ * kaizen_frame_time_accumulator_convert_to_seconds(&zone_total, ticks_per_second, &seconds, &nanoseconds);
+ * </code>
+ */
+
+#ifndef KAIZEN_kaizen_frame_time_accumulator_H
+#define KAIZEN_kaizen_frame_time_accumulator_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_frame_time_accumulator_s {
+        uint64_t high_ticks;
+        uint64_t low_ticks;
+    };
+    typedef struct kaizen_frame_time_accumulator_s kaizen_frame_time_accumulator_t;
+
+
+
+    /**
+     * Initializes @a accumulator to zero.
+     */
+    int kaizen_frame_time_accumulator_init(struct kaizen_frame_time_accumulator_s* accumulator);
+
+    int kaizen_frame_time_accumulator_finalize(struct kaizen_frame_time_accumulator_s* accumulator);
+
+    /**
+     * Adds the ticks of the frame time @a duration.
+     */
+    int kaizen_frame_time_accumulator_add(struct kaizen_frame_time_accumulator_s* accumulator,
+                                          struct kaizen_raw_frame_time_s const* duration);
+
+    void kaizen_frame_time_accumulator_add_ticks(struct kaizen_frame_time_accumulator_s* accumulator,
+                                                 uint64_t ticks);
+
+    /**
+     * Adds the sum of @a other, e.g. to combine per thread accumulators.
+     */
+    void kaizen_frame_time_accumulator_merge(struct kaizen_frame_time_accumulator_s* accumulator,
+                                             struct kaizen_frame_time_accumulator_s const* other);
+
+    /**
+     * Stores the summed ticks as high and low 64 bits.
+     */
+    void kaizen_frame_time_accumulator_ticks(struct kaizen_frame_time_accumulator_s const* accumulator,
+                                             uint64_t* high_ticks,
+                                             uint64_t* low_ticks);
+
+    /**
+     * Stores the sum divided by @a count into @a mean, rounded down, e.g. the
+     * mean duration of @a count summed zone executions or frames.
+     *
+     * Returns EINVAL if @a count is 0 and ERANGE if the frame time can not
+     * represent the mean.
+     */
+    int kaizen_frame_time_accumulator_mean(struct kaizen_frame_time_accumulator_s const* accumulator,
+                                           uint64_t count,
+                                           struct kaizen_raw_frame_time_s* mean);
+
+    /**
+     * Converts the sum of ticks of @a ticks_per_second exactly into whole
+     * seconds and the remaining nanoseconds, rounded down.
+     *
+     * Returns EINVAL if @a ticks_per_second is 0 and ERANGE if the seconds
+     * exceed 64 bits.
+     */
+    int kaizen_frame_time_accumulator_convert_to_seconds(struct kaizen_frame_time_accumulator_s const* accumulator,
+                                                         uint64_t ticks_per_second,
+                                                         uint64_t* seconds,
+                                                         uint32_t* nanoseconds);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_frame_time_accumulator_H */
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_frame_time_converter.h for all platforms based on
+ * the tick functions of kaizen_raw_frame_time.h.
+ */
+
+#include "kaizen_frame_time_converter.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_internal_fixed_point.h"
+
+
+
+#define KAIZEN_INTERNAL_NANOSECONDS_PER_MICROSECOND ((uint64_t)1000)
+#define KAIZEN_INTERNAL_NANOSECONDS_PER_MILLISECOND ((uint64_t)1000000)
+#define KAIZEN_INTERNAL_NANOSECONDS_PER_SECOND ((uint64_t)1000000000)
+
+
+
+int kaizen_frame_time_converter_init(struct kaizen_frame_time_converter_s* converter)
+{
+    assert(NULL != converter);
+
+    uint64_t ticks_per_second = 0;
+    int const errc = kaizen_frame_time_query_ticks_per_second(&ticks_per_second);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    return kaizen_frame_time_converter_init_with_ticks_per_second(converter, ticks_per_second);
+}
+
+
+
+int kaizen_frame_time_converter_init_with_ticks_per_second(struct kaizen_frame_time_converter_s* converter,
+                                                           uint64_t ticks_per_second)
+{
+    assert(NULL != converter);
+
+    if (0 == ticks_per_second) {
+        return EINVAL;
+    }
+
+    converter->ticks_per_second = ticks_per_second;
+    converter->seconds_per_tick = 1.0 / (double)ticks_per_second;
+    converter->milliseconds_per_tick = 1000.0 / (double)ticks_per_second;
+    converter->microseconds_per_tick = 1000000.0 / (double)ticks_per_second;
+    converter->nanoseconds_per_tick = 1000000000.0 / (double)ticks_per_second;
+    kaizen_internal_fixed_point_factor(KAIZEN_INTERNAL_NANOSECONDS_PER_SECOND,
+                                       ticks_per_second,
+                                       &(converter->nanoseconds_per_tick_mult),
+                                       &(converter->nanoseconds_per_tick_shift));
+    kaizen_internal_fixed_point_factor(ticks_per_second,
+                                       KAIZEN_INTERNAL_NANOSECONDS_PER_SECOND,
+                                       &(converter->ticks_per_nanosecond_mult),
+                                       &(converter->ticks_per_nanosecond_shift));
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_converter_finalize(struct kaizen_frame_time_converter_s* converter)
+{
+    assert(NULL != converter);
+
+    converter->ticks_per_second = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+uint64_t kaizen_frame_time_converter_ticks_per_second(struct kaizen_frame_time_converter_s const* converter)
+{
+    assert(NULL != converter);
+
+    return converter->ticks_per_second;
+}
+
+
+
+double kaizen_frame_time_converter_ticks_to_nanoseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                        uint64_t ticks)
+{
+    assert(NULL != converter);
+
+    return (double)ticks * converter->nanoseconds_per_tick;
+}
+
+
+
+double kaizen_frame_time_converter_ticks_to_microseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                         uint64_t ticks)
+{
+    assert(NULL != converter);
+
+    return (double)ticks * converter->microseconds_per_tick;
+}
+
+
+
+double kaizen_frame_time_converter_ticks_to_milliseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                         uint64_t ticks)
+{
+    assert(NULL != converter);
+
+    return (double)ticks * converter->milliseconds_per_tick;
+}
+
+
+
+double kaizen_frame_time_converter_ticks_to_seconds(struct kaizen_frame_time_converter_s const* converter,
+                                                    uint64_t ticks)
+{
+    assert(NULL != converter);
+
+    return (double)ticks * converter->seconds_per_tick;
+}
+
+
+
+uint64_t kaizen_frame_time_converter_nanoseconds_to_ticks(struct kaizen_frame_time_converter_s const* converter,
+                                                          uint64_t nanoseconds)
+{
+    assert(NULL != converter);
+
+    uint64_t result = 0;
+    (void)kaizen_internal_fixed_point_scale(nanoseconds,
+                                            converter->ticks_per_nanosecond_mult,
+                                            converter->ticks_per_nanosecond_shift,
+                                            &result);
+
+    return result;
+}
+
+
+
+uint64_t kaizen_frame_time_converter_ticks_to_nanoseconds_uint64(struct kaizen_frame_time_converter_s const* converter,
+                                                                 uint64_t ticks)
+{
+    assert(NULL != converter);
+
+    uint64_t result = 0;
+    (void)kaizen_internal_fixed_point_scale(ticks,
+                                            converter->nanoseconds_per_tick_mult,
+                                            converter->nanoseconds_per_tick_shift,
+                                            &result);
+
+    return result;
+}
+
+
+
+static int kaizen_internal_frame_time_converter_convert(struct kaizen_raw_frame_time_s const* time,
+                                                        double factor,
+                                                        double* result);
+int kaizen_internal_frame_time_converter_convert(struct kaizen_raw_frame_time_s const* time,
+                                                 double factor,
+                                                 double* result)
+{
+    assert(NULL != time);
+    assert(NULL != result);
+
+    uint64_t ticks = 0;
+    int const errc = kaizen_frame_time_convert_to_ticks(time, &ticks);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    *result = (double)ticks * factor;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_converter_convert_to_nanoseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                       struct kaizen_raw_frame_time_s const* time,
+                                                       double* result)
+{
+    assert(NULL != converter);
+
+    return kaizen_internal_frame_time_converter_convert(time, converter->nanoseconds_per_tick, result);
+}
+
+
+
+int kaizen_frame_time_converter_convert_to_microseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                        struct kaizen_raw_frame_time_s const* time,
+                                                        double* result)
+{
+    assert(NULL != converter);
+
+    return kaizen_internal_frame_time_converter_convert(time, converter->microseconds_per_tick, result);
+}
+
+
+
+int kaizen_frame_time_converter_convert_to_milliseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                        struct kaizen_raw_frame_time_s const* time,
+                                                        double* result)
+{
+    assert(NULL != converter);
+
+    return kaizen_internal_frame_time_converter_convert(time, converter->milliseconds_per_tick, result);
+}
+
+
+
+int kaizen_frame_time_converter_convert_to_seconds(struct kaizen_frame_time_converter_s const* converter,
+                                                   struct kaizen_raw_frame_time_s const* time,
+                                                   double* result)
+{
+    assert(NULL != converter);
+
+    return kaizen_internal_frame_time_converter_convert(time, converter->seconds_per_tick, result);
+}
+
+
+
+int kaizen_frame_time_converter_convert_from_nanoseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                         uint64_t nanoseconds,
+                                                         struct kaizen_raw_frame_time_s* result)
+{
+    assert(NULL != converter);
+    assert(NULL != result);
+
+    uint64_t ticks = 0;
+    int const errc = kaizen_internal_fixed_point_scale(nanoseconds,
+                                                       converter->ticks_per_nanosecond_mult,
+                                                       converter->ticks_per_nanosecond_shift,
+                                                       &ticks);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    return kaizen_frame_time_convert_from_ticks(result, ticks);
+}
+
+
+
+int kaizen_frame_time_converter_convert_from_microseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                          uint64_t microseconds,
+                                                          struct kaizen_raw_frame_time_s* result)
+{
+    if (microseconds > (uint64_t)0xFFFFFFFFFFFFFFFFull / KAIZEN_INTERNAL_NANOSECONDS_PER_MICROSECOND) {
+        return ERANGE;
+    }
+
+    return kaizen_frame_time_converter_convert_from_nanoseconds(converter, microseconds * KAIZEN_INTERNAL_NANOSECONDS_PER_MICROSECOND, result);
+}
+
+
+
+int kaizen_frame_time_converter_convert_from_milliseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                          uint64_t milliseconds,
+                                                          struct kaizen_raw_frame_time_s* result)
+{
+    if (milliseconds > (uint64_t)0xFFFFFFFFFFFFFFFFull / KAIZEN_INTERNAL_NANOSECONDS_PER_MILLISECOND) {
+        return ERANGE;
+    }
+
+    return kaizen_frame_time_converter_convert_from_nanoseconds(converter, milliseconds * KAIZEN_INTERNAL_NANOSECONDS_PER_MILLISECOND, result);
+}
+
+
+
+int kaizen_frame_time_converter_convert_from_seconds(struct kaizen_frame_time_converter_s const* converter,
+                                                     uint64_t seconds,
+                                                     struct kaizen_raw_frame_time_s* result)
+{
+    if (seconds > (uint64_t)0xFFFFFFFFFFFFFFFFull / KAIZEN_INTERNAL_NANOSECONDS_PER_SECOND) {
+        return ERANGE;
+    }
+
+    return kaizen_frame_time_converter_convert_from_nanoseconds(converter, seconds * KAIZEN_INTERNAL_NANOSECONDS_PER_SECOND, result);
+}
+
+
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Converter caching the conversion factors of a tick frequency, so that
+ * converting many frame times or ticks (e.g. when exporting captures) costs
+ * one multiplication instead of a platform query each.
+ *
+ * Conversions between whole nanoseconds and ticks use fixed point factors
+ * and need neither division nor floating point, e.g. to convert frame
+ * budgets into ticks in hot loops comparing them against measurements:
+ *
+ * <code>
+ * kaizen_frame_time_converter_convert_from_microseconds(&converter, 16667, &budget);
+ * if (KAIZEN_TRUE == kaizen_frame_time_greater(&elapsed, &budget)) { ... }
+ * </code>
+ *
+ * Initialize it for the running platform to convert frame times, or with
+ * the ticks per second stored in a capture to convert its ticks on any
+ * platform.
+ */
+
+#ifndef KAIZEN_kaizen_frame_time_converter_H
+#define KAIZEN_kaizen_frame_time_converter_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_frame_time_converter_s {
+        uint64_t ticks_per_second;
+        double nanoseconds_per_tick;
+        double microseconds_per_tick;
+        double milliseconds_per_tick;
+        double seconds_per_tick;
+        uint64_t nanoseconds_per_tick_mult;
+        uint64_t ticks_per_nanosecond_mult;
+        uint32_t nanoseconds_per_tick_shift;
+        uint32_t ticks_per_nanosecond_shift;
+    };
+    typedef struct kaizen_frame_time_converter_s kaizen_frame_time_converter_t;
+
+
+
+    /**
+     * Initializes @a converter for the frame time of the running platform.
+     */
+    int kaizen_frame_time_converter_init(struct kaizen_frame_time_converter_s* converter);
+
+    /**
+     * Initializes @a converter for ticks of @a ticks_per_second, e.g. read
+     * from a capture.
+     *
+     * Returns EINVAL if @a ticks_per_second is 0.
+     */
+    int kaizen_frame_time_converter_init_with_ticks_per_second(struct kaizen_frame_time_converter_s* converter,
+                                                               uint64_t ticks_per_second);
+
+    int kaizen_frame_time_converter_finalize(struct kaizen_frame_time_converter_s* converter);
+
+    uint64_t kaizen_frame_time_converter_ticks_per_second(struct kaizen_frame_time_converter_s const* converter);
+
+    double kaizen_frame_time_converter_ticks_to_nanoseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                            uint64_t ticks);
+
+    double kaizen_frame_time_converter_ticks_to_microseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                             uint64_t ticks);
+
+    double kaizen_frame_time_converter_ticks_to_milliseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                             uint64_t ticks);
+
+    double kaizen_frame_time_converter_ticks_to_seconds(struct kaizen_frame_time_converter_s const* converter,
+                                                        uint64_t ticks);
+
+    /**
+     * Converts whole nanoseconds to ticks and back with a fixed point
+     * multiplication and shift. Results are rounded down and may be off by
+     * one tick or nanosecond.
+     *
+     * Results which do not fit into 64 bits saturate at UINT64_MAX. This
+     * happens for nanoseconds above UINT64_MAX / ticks per nanosecond on
+     * platforms counting more than 10^9 ticks per second, and for ticks
+     * above UINT64_MAX / nanoseconds per tick on platforms counting fewer.
+     */
+    uint64_t kaizen_frame_time_converter_nanoseconds_to_ticks(struct kaizen_frame_time_converter_s const* converter,
+                                                              uint64_t nanoseconds);
+
+    uint64_t kaizen_frame_time_converter_ticks_to_nanoseconds_uint64(struct kaizen_frame_time_converter_s const* converter,
+                                                                     uint64_t ticks);
+
+    /**
+     * Converts a frame time of the running platform. Only meaningful if
+     * @a converter was initialized by kaizen_frame_time_converter_init.
+     *
+     * All parameters must not be NULL.
+     */
+    int kaizen_frame_time_converter_convert_to_nanoseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                           struct kaizen_raw_frame_time_s const* time,
+                                                           double* result);
+
+    int kaizen_frame_time_converter_convert_to_microseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                            struct kaizen_raw_frame_time_s const* time,
+                                                            double* result);
+
+    int kaizen_frame_time_converter_convert_to_milliseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                            struct kaizen_raw_frame_time_s const* time,
+                                                            double* result);
+
+    int kaizen_frame_time_converter_convert_to_seconds(struct kaizen_frame_time_converter_s const* converter,
+                                                       struct kaizen_raw_frame_time_s const* time,
+                                                       double* result);
+
+    /**
+     * Converts a time span into a frame time of the running platform with
+     * kaizen_frame_time_converter_nanoseconds_to_ticks. Only meaningful if
+     * @a converter was initialized by kaizen_frame_time_converter_init.
+     *
+     * Returns ERANGE if the span in nanoseconds or its ticks do not fit into
+     * 64 bits, or the frame time can not represent the ticks.
+     *
+     * All pointer parameters must not be NULL.
+     */
+    int kaizen_frame_time_converter_convert_from_nanoseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                             uint64_t nanoseconds,
+                                                             struct kaizen_raw_frame_time_s* result);
+
+    int kaizen_frame_time_converter_convert_from_microseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                              uint64_t microseconds,
+                                                              struct kaizen_raw_frame_time_s* result);
+
+    int kaizen_frame_time_converter_convert_from_milliseconds(struct kaizen_frame_time_converter_s const* converter,
+                                                              uint64_t milliseconds,
+                                                              struct kaizen_raw_frame_time_s* result);
+
+    int kaizen_frame_time_converter_convert_from_seconds(struct kaizen_frame_time_converter_s const* converter,
+                                                         uint64_t seconds,
+                                                         struct kaizen_raw_frame_time_s* result);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_frame_time_converter_H */
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_frame_timer.h for all platforms based on
+ * kaizen_raw_frame_time.h.
+ */
+
+#include "kaizen_frame_timer.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_raw_reliable_frame_time_scope.h"
+#include "kaizen_frame_time_accumulator.h"
+
+
+
+static struct kaizen_raw_frame_time_s const kaizen_internal_zero_frame_time = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+
+
+int kaizen_frame_timer_init(struct kaizen_frame_timer_s* timer)
+{
+    assert(NULL != timer);
+
+    timer->last_delta = kaizen_internal_zero_frame_time;
+    timer->shortest_delta = kaizen_internal_zero_frame_time;
+    timer->longest_delta = kaizen_internal_zero_frame_time;
+    timer->frame_count = 0;
+
+    int errc = kaizen_frame_time_accumulator_init(&(timer->elapsed));
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    errc = kaizen_reliable_frame_time_scope_init(&(timer->scope));
+
+    if (KAIZEN_SUCCESS != errc) {
+        (void)kaizen_frame_time_accumulator_finalize(&(timer->elapsed));
+
+        return errc;
+    }
+
+    errc = kaizen_frame_time_query(&(timer->frame_start));
+
+    if (KAIZEN_SUCCESS != errc) {
+        (void)kaizen_reliable_frame_time_scope_finalize(&(timer->scope));
+        (void)kaizen_frame_time_accumulator_finalize(&(timer->elapsed));
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_frame_timer_finalize(struct kaizen_frame_timer_s* timer)
+{
+    assert(NULL != timer);
+
+    int const errc = kaizen_reliable_frame_time_scope_finalize(&(timer->scope));
+    (void)kaizen_frame_time_accumulator_finalize(&(timer->elapsed));
+
+    return errc;
+}
+
+
+
+int kaizen_frame_timer_advance(struct kaizen_frame_timer_s* timer,
+                               struct kaizen_raw_frame_time_s* delta)
+{
+    assert(NULL != timer);
+    assert(NULL != delta);
+
+    struct kaizen_raw_frame_time_s now = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int errc = kaizen_frame_time_query(&now);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    struct kaizen_raw_frame_time_s frame_time = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+    if (KAIZEN_FALSE == kaizen_frame_time_lesser(&now, &(timer->frame_start))) {
+        errc = kaizen_frame_time_subtract(&now, &(timer->frame_start), &frame_time);
+
+        if (KAIZEN_SUCCESS != errc) {
+            return errc;
+        }
+    }
+
+    uint64_t ticks = 0;
+    errc = kaizen_frame_time_convert_to_ticks(&frame_time, &ticks);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    if ((0 == timer->frame_count)
+        || (KAIZEN_TRUE == kaizen_frame_time_lesser(&frame_time, &(timer->shortest_delta)))) {
+
+        timer->shortest_delta = frame_time;
+    }
+
+    if (KAIZEN_TRUE == kaizen_frame_time_greater(&frame_time, &(timer->longest_delta))) {
+        timer->longest_delta = frame_time;
+    }
+
+    kaizen_frame_time_accumulator_add_ticks(&(timer->elapsed), ticks);
+    timer->last_delta = frame_time;
+    timer->frame_start = now;
+    ++(timer->frame_count);
+
+    *delta = frame_time;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_timer_restart(struct kaizen_frame_timer_s* timer)
+{
+    assert(NULL != timer);
+
+    return kaizen_frame_time_query(&(timer->frame_start));
+}
+
+
+
+uint64_t kaizen_frame_timer_frame_count(struct kaizen_frame_timer_s const* timer)
+{
+    assert(NULL != timer);
+
+    return timer->frame_count;
+}
+
+
+
+void kaizen_frame_timer_last_delta(struct kaizen_frame_timer_s const* timer,
+                                   struct kaizen_raw_frame_time_s* delta)
+{
+    assert(NULL != timer);
+    assert(NULL != delta);
+
+    *delta = timer->last_delta;
+}
+
+
+
+void kaizen_frame_timer_shortest_delta(struct kaizen_frame_timer_s const* timer,
+                                       struct kaizen_raw_frame_time_s* delta)
+{
+    assert(NULL != timer);
+    assert(NULL != delta);
+
+    *delta = timer->shortest_delta;
+}
+
+
+
+void kaizen_frame_timer_longest_delta(struct kaizen_frame_timer_s const* timer,
+                                      struct kaizen_raw_frame_time_s* delta)
+{
+    assert(NULL != timer);
+    assert(NULL != delta);
+
+    *delta = timer->longest_delta;
+}
+
+
+
+int kaizen_frame_timer_mean_delta(struct kaizen_frame_timer_s const* timer,
+                                  struct kaizen_raw_frame_time_s* delta)
+{
+    assert(NULL != timer);
+    assert(NULL != delta);
+
+    return kaizen_frame_time_accumulator_mean(&(timer->elapsed),
+                                              timer->frame_count,
+                                              delta);
+}
+
+
+
+void kaizen_frame_timer_elapsed(struct kaizen_frame_timer_s const* timer,
+                                struct kaizen_frame_time_accumulator_s* elapsed)
+{
+    assert(NULL != timer);
+    assert(NULL != elapsed);
+
+    *elapsed = timer->elapsed;
+}
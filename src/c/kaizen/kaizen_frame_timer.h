@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Frame timer measuring the time between consecutive frames of a main loop,
+ * e.g. to advance the simulation by the last frame time or to watch the
+ * frame rate.
+ *
+ * The timer keeps a reliable frame time scope (see
+ * kaizen_raw_reliable_frame_time_scope.h) open from init to finalize, so it
+ * must only be used by the thread running the main loop. The total time of
+ * all frames is summed without overflow (see
+ * kaizen_frame_time_accumulator.h) so the timer can run for days.
+ *
+ * <code>
+ * kaizen_frame_timer_init(&timer);
+ * while (running) {
+ *     kaizen_frame_timer_advance(&timer, &frame_time);
+ *     update(frame_time);
+ *     render();
+ * }
+ * kaizen_frame_timer_finalize(&timer);
+ * </code>
+ */
+
+#ifndef KAIZEN_kaizen_frame_timer_H
+#define KAIZEN_kaizen_frame_timer_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_raw_reliable_frame_time_scope.h>
+#include <kaizen/kaizen_frame_time_accumulator.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_frame_timer_s {
+        struct kaizen_raw_reliable_frame_time_scope_s scope;
+        struct kaizen_raw_frame_time_s frame_start;
+        struct kaizen_raw_frame_time_s last_delta;
+        struct kaizen_raw_frame_time_s shortest_delta;
+        struct kaizen_raw_frame_time_s longest_delta;
+        struct kaizen_frame_time_accumulator_s elapsed;
+        uint64_t frame_count;
+    };
+    typedef struct kaizen_frame_timer_s kaizen_frame_timer_t;
+
+
+
+    /**
+     * Opens a reliable frame time scope and starts the first frame now.
+     */
+    int kaizen_frame_timer_init(struct kaizen_frame_timer_s* timer);
+
+    /**
+     * Closes the reliable frame time scope opened by
+     * kaizen_frame_timer_init.
+     */
+    int kaizen_frame_timer_finalize(struct kaizen_frame_timer_s* timer);
+
+    /**
+     * Ends the current frame, stores its time into @a delta and starts the
+     * next frame now.
+     *
+     * Counters leaping backwards (see kaizen_raw_frame_time.h) result in a
+     * zero @a delta.
+     */
+    int kaizen_frame_timer_advance(struct kaizen_frame_timer_s* timer,
+                                   struct kaizen_raw_frame_time_s* delta);
+
+    /**
+     * Starts the current frame again now without ending it, e.g. after a
+     * loading screen or a breakpoint that should not count as a frame.
+     */
+    int kaizen_frame_timer_restart(struct kaizen_frame_timer_s* timer);
+
+    /**
+     * Returns the number of frames ended by kaizen_frame_timer_advance.
+     */
+    uint64_t kaizen_frame_timer_frame_count(struct kaizen_frame_timer_s const* timer);
+
+    /**
+     * Store the time of the last, the shortest and the longest frame. All
+     * are zero before the first frame ended.
+     */
+    void kaizen_frame_timer_last_delta(struct kaizen_frame_timer_s const* timer,
+                                       struct kaizen_raw_frame_time_s* delta);
+
+    void kaizen_frame_timer_shortest_delta(struct kaizen_frame_timer_s const* timer,
+                                           struct kaizen_raw_frame_time_s* delta);
+
+    void kaizen_frame_timer_longest_delta(struct kaizen_frame_timer_s const* timer,
+                                          struct kaizen_raw_frame_time_s* delta);
+
+    /**
+     * Stores the mean frame time. Returns EINVAL before the first frame
+     * ended.
+     */
+    int kaizen_frame_timer_mean_delta(struct kaizen_frame_timer_s const* timer,
+                                      struct kaizen_raw_frame_time_s* delta);
+
+    /**
+     * Stores the summed time of all ended frames.
+     */
+    void kaizen_frame_timer_elapsed(struct kaizen_frame_timer_s const* timer,
+                                    struct kaizen_frame_time_accumulator_s* elapsed);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_frame_timer_H */
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_instrumented_spinlock.h for all platforms.
+ */
+
+#include "kaizen_instrumented_spinlock.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_lock_profile.h"
+
+
+enum {
+    kaizen_internal_spinlock_unlocked = 0,
+    kaizen_internal_spinlock_locked = 1
+};
+
+
+
+int kaizen_instrumented_spinlock_init(struct kaizen_instrumented_spinlock_s* spinlock,
+                                      uint32_t lock_id,
+                                      struct kaizen_raw_frame_time_s const* wait_threshold)
+{
+    assert(NULL != spinlock);
+    assert(NULL != wait_threshold);
+
+    kaizen_atomic_uint32_store_release(&(spinlock->state),
+                                       kaizen_internal_spinlock_unlocked);
+
+    return kaizen_lock_profile_init(&(spinlock->profile),
+                                    lock_id,
+                                    wait_threshold);
+}
+
+
+
+int kaizen_instrumented_spinlock_finalize(struct kaizen_instrumented_spinlock_s* spinlock)
+{
+    assert(NULL != spinlock);
+
+    if (kaizen_internal_spinlock_unlocked != kaizen_atomic_uint32_load_acquire(&(spinlock->state))) {
+        return EBUSY;
+    }
+
+    return kaizen_lock_profile_finalize(&(spinlock->profile));
+}
+
+
+
+int kaizen_instrumented_spinlock_lock(struct kaizen_instrumented_spinlock_s* spinlock)
+{
+    assert(NULL != spinlock);
+
+    if (kaizen_internal_spinlock_unlocked == kaizen_atomic_uint32_exchange(&(spinlock->state),
+                                                                           kaizen_internal_spinlock_locked)) {
+        return KAIZEN_SUCCESS;
+    }
+
+    struct kaizen_raw_frame_time_s wait_start = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int const errc = kaizen_lock_profile_wait_begin(&(spinlock->profile),
+                                                    &wait_start);
+
+    /* Spin on a plain load to keep the cache line shared while locked. */
+    do {
+        while (kaizen_internal_spinlock_unlocked != kaizen_atomic_uint32_load_acquire(&(spinlock->state))) {
+            kaizen_atomic_cpu_relax();
+        }
+    } while (kaizen_internal_spinlock_unlocked != kaizen_atomic_uint32_exchange(&(spinlock->state),
+                                                                                kaizen_internal_spinlock_locked));
+
+    if (KAIZEN_SUCCESS == errc) {
+        (void)kaizen_lock_profile_wait_end(&(spinlock->profile),
+                                           &wait_start);
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_instrumented_spinlock_trylock(struct kaizen_instrumented_spinlock_s* spinlock)
+{
+    assert(NULL != spinlock);
+
+    if (kaizen_internal_spinlock_unlocked == kaizen_atomic_uint32_exchange(&(spinlock->state),
+                                                                           kaizen_internal_spinlock_locked)) {
+        return KAIZEN_SUCCESS;
+    }
+
+    return EBUSY;
+}
+
+
+
+int kaizen_instrumented_spinlock_unlock(struct kaizen_instrumented_spinlock_s* spinlock)
+{
+    assert(NULL != spinlock);
+    assert(kaizen_internal_spinlock_locked == kaizen_atomic_uint32_load_acquire(&(spinlock->state)));
+
+    (void)kaizen_lock_profile_release(&(spinlock->profile));
+
+    kaizen_atomic_uint32_store_release(&(spinlock->state),
+                                       kaizen_internal_spinlock_unlocked);
+
+    return KAIZEN_SUCCESS;
+}
+
+
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Test-and-test-and-set spinlock recording contended acquire wait times and
+ * hold times as kaizen events (see kaizen_lock_profile.h).
+ *
+ * Only use spinlocks for very short critical sections.
+ */
+
+#ifndef KAIZEN_kaizen_instrumented_spinlock_H
+#define KAIZEN_kaizen_instrumented_spinlock_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_atomic.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_lock_profile.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_instrumented_spinlock_s {
+        struct kaizen_atomic_uint32_s state;
+        struct kaizen_lock_profile_s profile;
+    };
+    typedef struct kaizen_instrumented_spinlock_s kaizen_instrumented_spinlock_t;
+
+
+
+    /**
+     * See kaizen_lock_profile_init for the meaning of @a wait_threshold.
+     */
+    int kaizen_instrumented_spinlock_init(struct kaizen_instrumented_spinlock_s* spinlock,
+                                          uint32_t lock_id,
+                                          struct kaizen_raw_frame_time_s const* wait_threshold);
+
+    /**
+     * @attention The spinlock must not be locked.
+     */
+    int kaizen_instrumented_spinlock_finalize(struct kaizen_instrumented_spinlock_s* spinlock);
+
+    int kaizen_instrumented_spinlock_lock(struct kaizen_instrumented_spinlock_s* spinlock);
+
+    /**
+     * Returns EBUSY without recording anything if the spinlock is locked.
+     */
+    int kaizen_instrumented_spinlock_trylock(struct kaizen_instrumented_spinlock_s* spinlock);
+
+    int kaizen_instrumented_spinlock_unlock(struct kaizen_instrumented_spinlock_s* spinlock);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_instrumented_spinlock_H */
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Scaling of 64 bit integers by a rational factor without division or
+ * floating point, like the mult/shift pairs of clock sources in operating
+ * system kernels: value * factor is computed as (value * mult) >> shift.
+ *
+ * mult has 64 bits and the product 128 bits, so the full 64 bit range
+ * converts without intermediate overflow and results are exact up to one
+ * unit plus the relative error of mult, below 2^-63. The product is one
+ * multiplication on compilers with a 128 bit integer type and four 32 bit
+ * multiplications elsewhere.
+ *
+ * The 128 bit multiplication and division are also used to convert wide
+ * sums (see kaizen_frame_time_accumulator.h) exactly.
+ *
+ * Only include in kaizen source files.
+ */
+
+#ifndef KAIZEN_kaizen_internal_fixed_point_H
+#define KAIZEN_kaizen_internal_fixed_point_H
+
+
+#include <assert.h>
+#include <errno.h>
+
+#include "kaizen_stddef.h"
+
+
+
+#define KAIZEN_INTERNAL_FIXED_POINT_MAX_SHIFT 127u
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 kaizen_internal_uint128_t;
+#endif
+
+
+
+/**
+ * Calculates mult and shift for multiplying by @a numerator / @a
+ * denominator, choosing the largest shift which keeps mult below 2^64.
+ *
+ * @a denominator must be below 2^63.
+ */
+inline static void kaizen_internal_fixed_point_factor(uint64_t numerator,
+                                                      uint64_t denominator,
+                                                      uint64_t* mult,
+                                                      uint32_t* shift);
+inline static void kaizen_internal_fixed_point_factor(uint64_t numerator,
+                                                      uint64_t denominator,
+                                                      uint64_t* mult,
+                                                      uint32_t* shift)
+{
+    assert(0 != denominator);
+    assert(denominator < ((uint64_t)1 << 63));
+    assert(NULL != mult);
+    assert(NULL != shift);
+
+    uint64_t quotient = numerator / denominator;
+    uint64_t remainder = numerator % denominator;
+    uint32_t bit_count = 0;
+
+    /* Long division producing one more fraction bit per step. */
+    while (bit_count < KAIZEN_INTERNAL_FIXED_POINT_MAX_SHIFT
+           && quotient < ((uint64_t)1 << 63)) {
+
+        quotient *= 2;
+        remainder *= 2;
+
+        if (remainder >= denominator) {
+            quotient += 1;
+            remainder -= denominator;
+        }
+
+        ++bit_count;
+    }
+
+    if (remainder >= denominator - remainder
+        && quotient < (uint64_t)0xFFFFFFFFFFFFFFFFull) {
+
+        ++quotient;
+    }
+
+    *mult = quotient;
+    *shift = bit_count;
+}
+
+
+
+/**
+ * Stores the 128 bit product of @a lhs and @a rhs in @a high and @a low.
+ */
+inline static void kaizen_internal_fixed_point_multiply(uint64_t lhs,
+                                                        uint64_t rhs,
+                                                        uint64_t* high,
+                                                        uint64_t* low);
+inline static void kaizen_internal_fixed_point_multiply(uint64_t lhs,
+                                                        uint64_t rhs,
+                                                        uint64_t* high,
+                                                        uint64_t* low)
+{
+    assert(NULL != high);
+    assert(NULL != low);
+
+#if defined(__SIZEOF_INT128__)
+    kaizen_internal_uint128_t const product = (kaizen_internal_uint128_t)lhs * rhs;
+
+    *high = (uint64_t)(product >> 64);
+    *low = (uint64_t)product;
+#else
+    uint64_t const mask = (uint64_t)0xFFFFFFFFu;
+    uint64_t const low_low = (lhs & mask) * (rhs & mask);
+    uint64_t const low_high = (lhs & mask) * (rhs >> 32);
+    uint64_t const high_low = (lhs >> 32) * (rhs & mask);
+    uint64_t const high_high = (lhs >> 32) * (rhs >> 32);
+    uint64_t const middle = (low_low >> 32) + (low_high & mask) + (high_low & mask);
+
+    *high = high_high + (low_high >> 32) + (high_low >> 32) + (middle >> 32);
+    *low = (middle << 32) | (low_low & mask);
+#endif
+}
+
+
+
+/**
+ * Divides the 128 bit value @a high, @a low by @a divisor, stores the
+ * quotient in @a quotient_high, @a quotient_low and returns the remainder.
+ *
+ * Bitwise long division, only meant for rare conversions, e.g. of totals
+ * when reporting.
+ */
+inline static uint64_t kaizen_internal_fixed_point_divide(uint64_t high,
+                                                          uint64_t low,
+                                                          uint64_t divisor,
+                                                          uint64_t* quotient_high,
+                                                          uint64_t* quotient_low);
+inline static uint64_t kaizen_internal_fixed_point_divide(uint64_t high,
+                                                          uint64_t low,
+                                                          uint64_t divisor,
+                                                          uint64_t* quotient_high,
+                                                          uint64_t* quotient_low)
+{
+    assert(0 != divisor);
+    assert(NULL != quotient_high);
+    assert(NULL != quotient_low);
+
+    uint64_t remainder = 0;
+    int bit = 0;
+
+    *quotient_high = 0;
+    *quotient_low = 0;
+
+    for (bit = 127; bit >= 0; --bit) {
+        uint64_t const next_bit = (64 <= bit) ? ((high >> (bit - 64)) & 1u) : ((low >> bit) & 1u);
+        uint64_t const carry = remainder >> 63;
+
+        remainder = (remainder << 1) | next_bit;
+
+        /* With a carry the true remainder exceeds the divisor, the
+         * subtraction wraps to the correct value. */
+        if (0 != carry || remainder >= divisor) {
+            remainder -= divisor;
+
+            if (64 <= bit) {
+                *quotient_high |= (uint64_t)1 << (bit - 64);
+            } else {
+                *quotient_low |= (uint64_t)1 << bit;
+            }
+        }
+    }
+
+    return remainder;
+}
+
+
+
+/**
+ * Stores (@a value * @a mult) >> @a shift computed with a 128 bit product
+ * in @a result.
+ *
+ * Returns ERANGE and stores UINT64_MAX if the result does not fit into 64
+ * bits, e.g. for values above UINT64_MAX / factor when scaling by a factor
+ * above one.
+ */
+inline static int kaizen_internal_fixed_point_scale(uint64_t value,
+                                                    uint64_t mult,
+                                                    uint32_t shift,
+                                                    uint64_t* result);
+inline static int kaizen_internal_fixed_point_scale(uint64_t value,
+                                                    uint64_t mult,
+                                                    uint32_t shift,
+                                                    uint64_t* result)
+{
+    assert(shift <= KAIZEN_INTERNAL_FIXED_POINT_MAX_SHIFT);
+    assert(NULL != result);
+
+    uint64_t high = 0;
+    uint64_t low = 0;
+    kaizen_internal_fixed_point_multiply(value, mult, &high, &low);
+
+    if (64 <= shift) {
+        *result = high >> (shift - 64);
+        return KAIZEN_SUCCESS;
+    }
+
+    if (0 != (high >> shift)) {
+        *result = (uint64_t)0xFFFFFFFFFFFFFFFFull;
+        return ERANGE;
+    }
+
+    if (0 == shift) {
+        *result = low;
+    } else {
+        *result = (high << (64 - shift)) | (low >> shift);
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+#endif /* KAIZEN_kaizen_internal_fixed_point_H */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Walks the frame pointer chain of a stack, for code compiled with frame
+ * pointers (e.g. -fno-omit-frame-pointer). Each frame starts with the saved
+ * frame pointer of the caller followed by the return address into the
+ * caller, on x86, x86-64 and AArch64 alike.
+ *
+ * The walk only reads inside the given stack bounds and stops at frames
+ * not moving towards the stack base, so frames of code without frame
+ * pointers end the walk instead of crashing it. Safe to call from signal
+ * handlers.
+ */
+
+#ifndef KAIZEN_kaizen_internal_frame_pointer_walk_H
+#define KAIZEN_kaizen_internal_frame_pointer_walk_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Stores at most @a capacity return addresses, innermost first, of the
+     * frames starting at @a frame_pointer inside the stack from
+     * @a stack_low to @a stack_high into @a addresses. Returns the number
+     * of addresses stored.
+     */
+    inline static uint32_t kaizen_internal_frame_pointer_walk(size_t frame_pointer,
+                                                              size_t stack_low,
+                                                              size_t stack_high,
+                                                              uint64_t* addresses,
+                                                              uint32_t capacity)
+    {
+        uint32_t count = 0;
+
+        while (count < capacity
+               && frame_pointer >= stack_low
+               && frame_pointer <= stack_high - 2 * sizeof(void*)
+               && 0 == (frame_pointer % sizeof(void*))) {
+
+            void* const* const frame = (void* const*)frame_pointer;
+            size_t const caller_frame_pointer = (size_t)frame[0];
+            size_t const return_address = (size_t)frame[1];
+
+            if (0 == return_address) {
+                break;
+            }
+
+            addresses[count] = (uint64_t)return_address;
+            ++count;
+
+            /* Stacks grow down, callers' frames lie at higher addresses. */
+            if (caller_frame_pointer <= frame_pointer) {
+                break;
+            }
+
+            frame_pointer = caller_frame_pointer;
+        }
+
+        return count;
+    }
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_internal_frame_pointer_walk_H */
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Compiler specific storage class specifier for thread local variables.
+ *
+ * Only use KAIZEN_THREAD_LOCAL for variables with static storage duration
+ * and constant initializers inside of kaizen source files.
+ *
+ * Define KAIZEN_THREAD_LOCAL before including this header to use a different
+ * specifier, e.g. _Thread_local or thread_local.
+ */
+
+#ifndef KAIZEN_kaizen_internal_thread_local_H
+#define KAIZEN_kaizen_internal_thread_local_H
+
+
+#if !defined(KAIZEN_THREAD_LOCAL)
+#   if defined(_MSC_VER)
+#       define KAIZEN_THREAD_LOCAL __declspec(thread)
+#   elif defined(__GNUC__)
+#       define KAIZEN_THREAD_LOCAL __thread
+#   else
+#       error Unsupported compiler, define KAIZEN_THREAD_LOCAL.
+#   endif
+#endif
+
+
+#endif /* KAIZEN_kaizen_internal_thread_local_H */
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_lock_profile.h for all platforms.
+ */
+
+#include "kaizen_lock_profile.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_event.h"
+
+
+
+int kaizen_lock_profile_init(struct kaizen_lock_profile_s* profile,
+                             uint32_t lock_id,
+                             struct kaizen_raw_frame_time_s const* wait_threshold)
+{
+    assert(NULL != profile);
+    assert(NULL != wait_threshold);
+
+    struct kaizen_raw_frame_time_s const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+    profile->wait_threshold = *wait_threshold;
+    profile->acquired = zero;
+    profile->lock_id = lock_id;
+    profile->hold_is_measured = KAIZEN_FALSE;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_lock_profile_finalize(struct kaizen_lock_profile_s* profile)
+{
+    assert(NULL != profile);
+    assert(KAIZEN_FALSE == profile->hold_is_measured);
+    (void)profile;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+uint32_t kaizen_lock_profile_lock_id(struct kaizen_lock_profile_s const* profile)
+{
+    assert(NULL != profile);
+
+    return profile->lock_id;
+}
+
+
+
+int kaizen_lock_profile_wait_begin(struct kaizen_lock_profile_s const* profile,
+                                   struct kaizen_raw_frame_time_s* wait_start)
+{
+    assert(NULL != profile);
+    assert(NULL != wait_start);
+    (void)profile;
+
+    return kaizen_frame_time_query(wait_start);
+}
+
+
+
+int kaizen_lock_profile_wait_end(struct kaizen_lock_profile_s* profile,
+                                 struct kaizen_raw_frame_time_s const* wait_start)
+{
+    assert(NULL != profile);
+    assert(NULL != wait_start);
+
+    struct kaizen_raw_frame_time_s now = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int errc = kaizen_frame_time_query(&now);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    struct kaizen_raw_frame_time_s wait = KAIZEN_RAW_FRAME_TIME_ZERO;
+    errc = kaizen_frame_time_subtract(&now, wait_start, &wait);
+
+    if (KAIZEN_SUCCESS == errc
+        && KAIZEN_TRUE == kaizen_frame_time_greater_or_equal(&wait, &(profile->wait_threshold))) {
+
+        profile->acquired = now;
+        profile->hold_is_measured = KAIZEN_TRUE;
+
+        /* Threads without an event buffer are not profiled - not an error. */
+        (void)kaizen_event_record(kaizen_lock_wait_event_type,
+                                  profile->lock_id,
+                                  wait_start,
+                                  &wait,
+                                  0);
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_lock_profile_release(struct kaizen_lock_profile_s* profile)
+{
+    assert(NULL != profile);
+
+    if (KAIZEN_FALSE == profile->hold_is_measured) {
+        return KAIZEN_SUCCESS;
+    }
+
+    profile->hold_is_measured = KAIZEN_FALSE;
+
+    struct kaizen_raw_frame_time_s now = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int errc = kaizen_frame_time_query(&now);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    struct kaizen_raw_frame_time_s hold = KAIZEN_RAW_FRAME_TIME_ZERO;
+    errc = kaizen_frame_time_subtract(&now, &(profile->acquired), &hold);
+
+    if (KAIZEN_SUCCESS == errc) {
+        (void)kaizen_event_record(kaizen_lock_hold_event_type,
+                                  profile->lock_id,
+                                  &(profile->acquired),
+                                  &hold,
+                                  0);
+    }
+
+    return errc;
+}
+
+
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Lock contention measurement shared by the instrumented locks (see
+ * kaizen_raw_instrumented_mutex.h and kaizen_instrumented_spinlock.h) and
+ * usable to instrument other lock types.
+ *
+ * A lock only measures time after an acquire attempt failed, therefore
+ * uncontended acquires only pay for the try-lock. If a contended acquire
+ * waited at least as long as the wait threshold of the lock a
+ * kaizen_lock_wait_event_type event is recorded and the following release
+ * records a kaizen_lock_hold_event_type event. Both events carry the lock id
+ * and are recorded into the event buffer of the calling thread (see
+ * kaizen_event.h).
+ *
+ * Usage to instrument a lock:
+ * <code>
+ * if (!try_lock(lock)) {
+ *     kaizen_raw_frame_time_t start;
+ *     kaizen_lock_profile_wait_begin(&profile, &start);
+ *     lock(lock);
+ *     kaizen_lock_profile_wait_end(&profile, &start);
+ * }
+ * // ...
+ * kaizen_lock_profile_release(&profile);
+ * unlock(lock);
+ * </code>
+ *
+ * The profile state changed by wait_end and release must be protected by the
+ * instrumented lock itself.
+ */
+
+#ifndef KAIZEN_kaizen_lock_profile_H
+#define KAIZEN_kaizen_lock_profile_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_lock_profile_s {
+        struct kaizen_raw_frame_time_s wait_threshold;
+        struct kaizen_raw_frame_time_s acquired;
+        uint32_t lock_id;
+        kaizen_bool hold_is_measured;
+    };
+    typedef struct kaizen_lock_profile_s kaizen_lock_profile_t;
+
+
+
+    /**
+     * Contended acquires waiting less than @a wait_threshold are not
+     * recorded. Pass a zero time (KAIZEN_RAW_FRAME_TIME_ZERO) to record all
+     * contended acquires.
+     *
+     * All pointer parameters must not be NULL.
+     */
+    int kaizen_lock_profile_init(struct kaizen_lock_profile_s* profile,
+                                 uint32_t lock_id,
+                                 struct kaizen_raw_frame_time_s const* wait_threshold);
+
+    int kaizen_lock_profile_finalize(struct kaizen_lock_profile_s* profile);
+
+    uint32_t kaizen_lock_profile_lock_id(struct kaizen_lock_profile_s const* profile);
+
+    /**
+     * Call after a try-lock failed and before blocking. Stores the wait start
+     * time in @a wait_start.
+     */
+    int kaizen_lock_profile_wait_begin(struct kaizen_lock_profile_s const* profile,
+                                       struct kaizen_raw_frame_time_s* wait_start);
+
+    /**
+     * Call after the contended lock has been acquired with the time stored
+     * by kaizen_lock_profile_wait_begin.
+     */
+    int kaizen_lock_profile_wait_end(struct kaizen_lock_profile_s* profile,
+                                     struct kaizen_raw_frame_time_s const* wait_start);
+
+    /**
+     * Call while still holding the lock directly before releasing it.
+     */
+    int kaizen_lock_profile_release(struct kaizen_lock_profile_s* profile);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_lock_profile_H */
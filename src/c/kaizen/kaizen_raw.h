@@ -37,6 +37,14 @@
 #include <kaizen/kaizen_stddef.h>
 #include <kaizen/kaizen_raw_reliable_frame_time_scope.h>
 #include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_raw_atomic.h>
+#include <kaizen/kaizen_raw_instrumented_mutex.h>
+#include <kaizen/kaizen_raw_memory.h>
+#include <kaizen/kaizen_raw_hardware_counters.h>
+#include <kaizen/kaizen_raw_scheduling_monitor.h>
+#include <kaizen/kaizen_raw_sampler.h>
+#include <kaizen/kaizen_raw_thread.h>
+#include <kaizen/kaizen_raw_stream_server.h>
 
 
 #endif /* KAIZEN_kaizen_raw_H */
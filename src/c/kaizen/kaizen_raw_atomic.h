@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Minimal set of atomic operations needed by kaizen to publish profiling
+ * data between threads without locks.
+ *
+ * Only the memory orders named by the functions are guaranteed. Functions
+ * without a memory order in their name are full barriers.
+ *
+ * Treat the atomic types as opaque and only access them via the functions
+ * declared here.
+ *
+ * Usage: define exactly one of KAIZEN_USE_GCC_ATOMIC_BUILTINS (GCC and Clang)
+ * or KAIZEN_USE_WIN32_INTERLOCKED (MSVC) and compile the matching source
+ * file ending in _gcc_atomic_builtins.c or _win32_interlocked.c.
+ *
+ * See http://gcc.gnu.org/onlinedocs/gcc/_005f_005fatomic-Builtins.html
+ * See http://msdn.microsoft.com/en-us/library/ms684122(VS.85).aspx
+ */
+
+#ifndef KAIZEN_kaizen_raw_atomic_H
+#define KAIZEN_kaizen_raw_atomic_H
+
+
+#include <kaizen/kaizen_stddef.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    struct kaizen_atomic_uint32_s {
+        uint32_t volatile value;
+    };
+    typedef struct kaizen_atomic_uint32_s kaizen_atomic_uint32_t;
+
+
+    /**
+     * @attention Must be 8 byte aligned on 32bit platforms. Embed it as the
+     *            first member or behind other 8 byte members.
+     */
+    struct kaizen_atomic_uint64_s {
+        uint64_t volatile value;
+    };
+    typedef struct kaizen_atomic_uint64_s kaizen_atomic_uint64_t;
+
+
+    struct kaizen_atomic_pointer_s {
+        void* volatile pointer;
+    };
+    typedef struct kaizen_atomic_pointer_s kaizen_atomic_pointer_t;
+
+
+
+    uint32_t kaizen_atomic_uint32_load_acquire(struct kaizen_atomic_uint32_s const* atomic);
+
+    void kaizen_atomic_uint32_store_release(struct kaizen_atomic_uint32_s* atomic,
+                                            uint32_t value);
+
+    /**
+     * Adds @a value and returns the value stored before the addition.
+     */
+    uint32_t kaizen_atomic_uint32_fetch_add(struct kaizen_atomic_uint32_s* atomic,
+                                            uint32_t value);
+
+    /**
+     * Stores @a value and returns the value stored before.
+     */
+    uint32_t kaizen_atomic_uint32_exchange(struct kaizen_atomic_uint32_s* atomic,
+                                           uint32_t value);
+
+    /**
+     * Stores @a desired if the atomic contains @a expected and returns
+     * KAIZEN_TRUE, otherwise leaves the atomic unchanged and returns
+     * KAIZEN_FALSE.
+     */
+    kaizen_bool kaizen_atomic_uint32_compare_and_swap(struct kaizen_atomic_uint32_s* atomic,
+                                                      uint32_t expected,
+                                                      uint32_t desired);
+
+
+
+    uint64_t kaizen_atomic_uint64_load_acquire(struct kaizen_atomic_uint64_s const* atomic);
+
+    void kaizen_atomic_uint64_store_release(struct kaizen_atomic_uint64_s* atomic,
+                                            uint64_t value);
+
+    uint64_t kaizen_atomic_uint64_fetch_add(struct kaizen_atomic_uint64_s* atomic,
+                                            uint64_t value);
+
+    kaizen_bool kaizen_atomic_uint64_compare_and_swap(struct kaizen_atomic_uint64_s* atomic,
+                                                      uint64_t expected,
+                                                      uint64_t desired);
+
+
+
+    void* kaizen_atomic_pointer_load_acquire(struct kaizen_atomic_pointer_s const* atomic);
+
+    void kaizen_atomic_pointer_store_release(struct kaizen_atomic_pointer_s* atomic,
+                                             void* pointer);
+
+    kaizen_bool kaizen_atomic_pointer_compare_and_swap(struct kaizen_atomic_pointer_s* atomic,
+                                                       void* expected,
+                                                       void* desired);
+
+
+
+    /**
+     * Hints the processor that the calling thread is spin-waiting (pause
+     * instruction on x86).
+     */
+    void kaizen_atomic_cpu_relax(void);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_raw_atomic_H */
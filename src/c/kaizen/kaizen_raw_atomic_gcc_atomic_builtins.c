@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_atomic.h with the GCC (and Clang) __atomic
+ * builtins.
+ *
+ * See http://gcc.gnu.org/onlinedocs/gcc/_005f_005fatomic-Builtins.html
+ */
+
+#include "kaizen_raw_atomic.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+
+
+
+uint32_t kaizen_atomic_uint32_load_acquire(struct kaizen_atomic_uint32_s const* atomic)
+{
+    assert(NULL != atomic);
+
+    return __atomic_load_n(&atomic->value, __ATOMIC_ACQUIRE);
+}
+
+
+
+void kaizen_atomic_uint32_store_release(struct kaizen_atomic_uint32_s* atomic,
+                                        uint32_t value)
+{
+    assert(NULL != atomic);
+
+    __atomic_store_n(&atomic->value, value, __ATOMIC_RELEASE);
+}
+
+
+
+uint32_t kaizen_atomic_uint32_fetch_add(struct kaizen_atomic_uint32_s* atomic,
+                                        uint32_t value)
+{
+    assert(NULL != atomic);
+
+    return __atomic_fetch_add(&atomic->value, value, __ATOMIC_SEQ_CST);
+}
+
+
+
+uint32_t kaizen_atomic_uint32_exchange(struct kaizen_atomic_uint32_s* atomic,
+                                       uint32_t value)
+{
+    assert(NULL != atomic);
+
+    return __atomic_exchange_n(&atomic->value, value, __ATOMIC_SEQ_CST);
+}
+
+
+
+kaizen_bool kaizen_atomic_uint32_compare_and_swap(struct kaizen_atomic_uint32_s* atomic,
+                                                  uint32_t expected,
+                                                  uint32_t desired)
+{
+    assert(NULL != atomic);
+
+    return __atomic_compare_exchange_n(&atomic->value,
+                                       &expected,
+                                       desired,
+                                       0,
+                                       __ATOMIC_SEQ_CST,
+                                       __ATOMIC_SEQ_CST) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+uint64_t kaizen_atomic_uint64_load_acquire(struct kaizen_atomic_uint64_s const* atomic)
+{
+    assert(NULL != atomic);
+
+    return __atomic_load_n(&atomic->value, __ATOMIC_ACQUIRE);
+}
+
+
+
+void kaizen_atomic_uint64_store_release(struct kaizen_atomic_uint64_s* atomic,
+                                        uint64_t value)
+{
+    assert(NULL != atomic);
+
+    __atomic_store_n(&atomic->value, value, __ATOMIC_RELEASE);
+}
+
+
+
+uint64_t kaizen_atomic_uint64_fetch_add(struct kaizen_atomic_uint64_s* atomic,
+                                        uint64_t value)
+{
+    assert(NULL != atomic);
+
+    return __atomic_fetch_add(&atomic->value, value, __ATOMIC_SEQ_CST);
+}
+
+
+
+kaizen_bool kaizen_atomic_uint64_compare_and_swap(struct kaizen_atomic_uint64_s* atomic,
+                                                  uint64_t expected,
+                                                  uint64_t desired)
+{
+    assert(NULL != atomic);
+
+    return __atomic_compare_exchange_n(&atomic->value,
+                                       &expected,
+                                       desired,
+                                       0,
+                                       __ATOMIC_SEQ_CST,
+                                       __ATOMIC_SEQ_CST) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+void* kaizen_atomic_pointer_load_acquire(struct kaizen_atomic_pointer_s const* atomic)
+{
+    assert(NULL != atomic);
+
+    return __atomic_load_n(&atomic->pointer, __ATOMIC_ACQUIRE);
+}
+
+
+
+void kaizen_atomic_pointer_store_release(struct kaizen_atomic_pointer_s* atomic,
+                                         void* pointer)
+{
+    assert(NULL != atomic);
+
+    __atomic_store_n(&atomic->pointer, pointer, __ATOMIC_RELEASE);
+}
+
+
+
+kaizen_bool kaizen_atomic_pointer_compare_and_swap(struct kaizen_atomic_pointer_s* atomic,
+                                                   void* expected,
+                                                   void* desired)
+{
+    assert(NULL != atomic);
+
+    return __atomic_compare_exchange_n(&atomic->pointer,
+                                       &expected,
+                                       desired,
+                                       0,
+                                       __ATOMIC_SEQ_CST,
+                                       __ATOMIC_SEQ_CST) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+void kaizen_atomic_cpu_relax(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__ ("pause" ::: "memory");
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__ ("yield" ::: "memory");
+#else
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+
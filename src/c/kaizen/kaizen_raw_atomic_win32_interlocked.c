@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_atomic.h with the Win32 Interlocked
+ * functions.
+ *
+ * Volatile reads and writes have acquire respectively release semantics
+ * with MSVC (since Visual Studio 2005) on x86 and x64, the compiler barrier
+ * prevents reordering by the compiler.
+ *
+ * See http://msdn.microsoft.com/en-us/library/ms684122(VS.85).aspx
+ * See http://msdn.microsoft.com/en-us/library/12a04hfd(VS.80).aspx
+ */
+
+#include "kaizen_raw_atomic.h"
+
+#include <windows.h>
+#include <intrin.h>
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+
+
+#pragma intrinsic(_ReadWriteBarrier)
+
+
+
+uint32_t kaizen_atomic_uint32_load_acquire(struct kaizen_atomic_uint32_s const* atomic)
+{
+    assert(NULL != atomic);
+
+    uint32_t const value = atomic->value;
+    _ReadWriteBarrier();
+
+    return value;
+}
+
+
+
+void kaizen_atomic_uint32_store_release(struct kaizen_atomic_uint32_s* atomic,
+                                        uint32_t value)
+{
+    assert(NULL != atomic);
+
+    _ReadWriteBarrier();
+    atomic->value = value;
+}
+
+
+
+uint32_t kaizen_atomic_uint32_fetch_add(struct kaizen_atomic_uint32_s* atomic,
+                                        uint32_t value)
+{
+    assert(NULL != atomic);
+
+    return (uint32_t)InterlockedExchangeAdd((LONG volatile*)&atomic->value,
+                                            (LONG)value);
+}
+
+
+
+uint32_t kaizen_atomic_uint32_exchange(struct kaizen_atomic_uint32_s* atomic,
+                                       uint32_t value)
+{
+    assert(NULL != atomic);
+
+    return (uint32_t)InterlockedExchange((LONG volatile*)&atomic->value,
+                                         (LONG)value);
+}
+
+
+
+kaizen_bool kaizen_atomic_uint32_compare_and_swap(struct kaizen_atomic_uint32_s* atomic,
+                                                  uint32_t expected,
+                                                  uint32_t desired)
+{
+    assert(NULL != atomic);
+
+    LONG const previous = InterlockedCompareExchange((LONG volatile*)&atomic->value,
+                                                     (LONG)desired,
+                                                     (LONG)expected);
+
+    return ((LONG)expected == previous) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+uint64_t kaizen_atomic_uint64_load_acquire(struct kaizen_atomic_uint64_s const* atomic)
+{
+    assert(NULL != atomic);
+
+#if defined(_WIN64)
+    uint64_t const value = atomic->value;
+    _ReadWriteBarrier();
+
+    return value;
+#else
+    /* 64bit reads are not atomic on 32bit x86, a no-op compare exchange is. */
+    return (uint64_t)InterlockedCompareExchange64((LONGLONG volatile*)&atomic->value,
+                                                  (LONGLONG)0,
+                                                  (LONGLONG)0);
+#endif
+}
+
+
+
+void kaizen_atomic_uint64_store_release(struct kaizen_atomic_uint64_s* atomic,
+                                        uint64_t value)
+{
+    assert(NULL != atomic);
+
+#if defined(_WIN64)
+    _ReadWriteBarrier();
+    atomic->value = value;
+#else
+    LONGLONG previous = 0;
+    do {
+        previous = (LONGLONG)atomic->value;
+    } while (previous != InterlockedCompareExchange64((LONGLONG volatile*)&atomic->value,
+                                                      (LONGLONG)value,
+                                                      previous));
+#endif
+}
+
+
+
+uint64_t kaizen_atomic_uint64_fetch_add(struct kaizen_atomic_uint64_s* atomic,
+                                        uint64_t value)
+{
+    assert(NULL != atomic);
+
+    LONGLONG previous = 0;
+    do {
+        previous = (LONGLONG)atomic->value;
+    } while (previous != InterlockedCompareExchange64((LONGLONG volatile*)&atomic->value,
+                                                      previous + (LONGLONG)value,
+                                                      previous));
+
+    return (uint64_t)previous;
+}
+
+
+
+kaizen_bool kaizen_atomic_uint64_compare_and_swap(struct kaizen_atomic_uint64_s* atomic,
+                                                  uint64_t expected,
+                                                  uint64_t desired)
+{
+    assert(NULL != atomic);
+
+    LONGLONG const previous = InterlockedCompareExchange64((LONGLONG volatile*)&atomic->value,
+                                                           (LONGLONG)desired,
+                                                           (LONGLONG)expected);
+
+    return ((LONGLONG)expected == previous) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+void* kaizen_atomic_pointer_load_acquire(struct kaizen_atomic_pointer_s const* atomic)
+{
+    assert(NULL != atomic);
+
+    void* const pointer = atomic->pointer;
+    _ReadWriteBarrier();
+
+    return pointer;
+}
+
+
+
+void kaizen_atomic_pointer_store_release(struct kaizen_atomic_pointer_s* atomic,
+                                         void* pointer)
+{
+    assert(NULL != atomic);
+
+    _ReadWriteBarrier();
+    atomic->pointer = pointer;
+}
+
+
+
+kaizen_bool kaizen_atomic_pointer_compare_and_swap(struct kaizen_atomic_pointer_s* atomic,
+                                                   void* expected,
+                                                   void* desired)
+{
+    assert(NULL != atomic);
+
+    void* const previous = InterlockedCompareExchangePointer((PVOID volatile*)&atomic->pointer,
+                                                             desired,
+                                                             expected);
+
+    return (expected == previous) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+void kaizen_atomic_cpu_relax(void)
+{
+    YieldProcessor();
+}
+
+
@@ -109,7 +109,9 @@ extern "C" {
      * 
      * Treat as opaque type and do not rely on implementation details.
      *
-     * @attention Only usable for short time spans below seconds.
+     * @attention Only usable for short time spans below seconds. Sum
+     *            durations over long sessions with
+     *            kaizen_frame_time_accumulator.
      */
     struct kaizen_raw_frame_time_s {
 #if defined(KAIZEN_USE_APPLE_MACH_ABSOLUTE_TIME)
@@ -117,7 +119,7 @@ extern "C" {
 #elif defined(KAIZEN_USE_POSIX_GETTIMEOFDAY)
 #   error Unsupported platform.
 #elif defined(KAIZEN_USE_POSIX_CLOCK_GETTIME)
-        timespec time; 
+        struct timespec time;
 #elif defined(KAIZEN_USE_WIN32_QUERY_PERFORMANCE_COUNTER)
         LARGE_INTEGER counter;
 #else
@@ -132,7 +134,7 @@ extern "C" {
 #elif defined(KAIZEN_USE_POSIX_GETTIMEOFDAY)
 #   error Unsupported platform.
 #elif defined(KAIZEN_USE_POSIX_CLOCK_GETTIME)
-#   define KAIZEN_RAW_FRAME_TIME_ZERO {(time_t)0, (long)0}
+#   define KAIZEN_RAW_FRAME_TIME_ZERO {{(time_t)0, (long)0}}
 #elif defined(KAIZEN_USE_WIN32_QUERY_PERFORMANCE_COUNTER)
 #   define KAIZEN_RAW_FRAME_TIME_ZERO {(DWORD)0, (LONG)0}
 #else
@@ -207,6 +209,9 @@ extern "C" {
     /**
      * Aggregates the time measured in lhs and rhs and stores it into result.
      *
+     * Returns ERANGE if the sum overflows the frame time. Sum many or long
+     * durations with kaizen_frame_time_accumulator instead.
+     *
      * All parameters must not be NULL.
      */
     int kaizen_frame_time_aggregate(struct kaizen_raw_frame_time_s const* lhs,
@@ -234,12 +239,16 @@ extern "C" {
                                              double* result);
     
     
-    /* TODO: @todo Implement
-     * Document that times must be positive or zero.
-     * Document that because of floating point precision some values might not
-     * result in expected internal time values.
-     * TODO: @todo Decide if to only offer conversion from nanoseconds.
-     * TODO: @todo Decide if to offer double and uint types to convert from.
+    /**
+     * Converts a time span into a frame time. Spans must be positive or zero,
+     * the result is rounded down to whole timer/counter ticks.
+     *
+     * Based on platform this can be an expensive operation. To convert many
+     * time spans, e.g. frame budgets, use kaizen_frame_time_converter.
+     *
+     * Returns EINVAL for negative spans and ERANGE if the frame time can not
+     * represent the span.
+     */
     int kaizen_frame_time_convert_from_nanoseconds(struct kaizen_raw_frame_time_s* result,
                                                    double nanoseconds);
     
@@ -251,7 +260,23 @@ extern "C" {
     
     int kaizen_frame_time_convert_from_seconds(struct kaizen_raw_frame_time_s* result,
                                                double seconds);
-    */
+    
+    /**
+     * Converts @a time into the number of timer/counter ticks of the
+     * platform, e.g. to store or transmit frame times in a platform
+     * independent binary encoding. Ticks are only meaningful together with
+     * the tick frequency reported by kaizen_frame_time_query_ticks_per_second.
+     *
+     * All parameters must not be NULL.
+     */
+    int kaizen_frame_time_convert_to_ticks(struct kaizen_raw_frame_time_s const* time,
+                                           uint64_t* ticks);
+    
+    int kaizen_frame_time_convert_from_ticks(struct kaizen_raw_frame_time_s* result,
+                                             uint64_t ticks);
+    
+    int kaizen_frame_time_query_ticks_per_second(uint64_t* ticks_per_second);
+    
     
     kaizen_bool kaizen_frame_time_equal(struct kaizen_raw_frame_time_s const* lhs,
                                         struct kaizen_raw_frame_time_s const* rhs);
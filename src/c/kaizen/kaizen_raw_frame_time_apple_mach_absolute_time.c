@@ -42,7 +42,9 @@
  * See http://www.wand.net.nz/~smr26/wordpress/2009/01/19/monotonic-time-in-mac-os-x/
  * See http://developer.apple.com/mac/library/documentation/Darwin/Conceptual/KernelProgramming/services/services.html#//apple_ref/doc/uid/TP30000905-CH219-CHDGFEFE
  *
- * TODO: @todo Only query mach_timebase_info once per app execution.
+ * The timebase is converted once into a fixed point factor (see
+ * kaizen_internal_fixed_point.h) so converting to nanoseconds neither
+ * queries nor divides by the timebase.
  */
 
 #include "kaizen_raw_frame_time.h"
@@ -57,6 +59,18 @@
 
 
 #include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_internal_fixed_point.h"
+
+
+
+/**
+ * Fixed point factor converting intervals to nanoseconds, published by
+ * storing the shift plus one last, 0 until first used. Racing threads
+ * store the same values.
+ */
+static struct kaizen_atomic_uint64_s kaizen_internal_nanoseconds_per_interval_mult = {0};
+static struct kaizen_atomic_uint32_s kaizen_internal_nanoseconds_per_interval_shift = {0};
 
 
 
@@ -70,14 +84,26 @@ int kaizen_internal_frame_time_convert_to_nanoseconds_uint64(struct kaizen_raw_f
     
     int return_code = EAGAIN;
     
-    mach_timebase_info_data_t timebase;
-    kern_return_t const errc = mach_timebase_info(&timebase);
+    uint32_t shift = kaizen_atomic_uint32_load_acquire(&kaizen_internal_nanoseconds_per_interval_shift);
+    uint64_t mult = kaizen_atomic_uint64_load_acquire(&kaizen_internal_nanoseconds_per_interval_mult);
+    kern_return_t errc = KERN_SUCCESS;
+    
+    if (0 == shift) {
+        mach_timebase_info_data_t timebase;
+        errc = mach_timebase_info(&timebase);
+        
+        if (KERN_SUCCESS == errc) {
+            kaizen_internal_fixed_point_factor(timebase.numer, timebase.denom, &mult, &shift);
+            ++shift;
+            
+            kaizen_atomic_uint64_store_release(&kaizen_internal_nanoseconds_per_interval_mult, mult);
+            kaizen_atomic_uint32_store_release(&kaizen_internal_nanoseconds_per_interval_shift, shift);
+        }
+    }
     
     if (KERN_SUCCESS == errc) {
         
-        uint64_t const elapsed = time->interval;
-        *result = elapsed * (uint64_t)timebase.numer / (uint64_t)timebase.denom;
-        return_code = KAIZEN_SUCCESS;
+        return_code = kaizen_internal_fixed_point_scale(time->interval, mult, shift - 1, result);
     } else {
         /**
          * Error code is not correct and only used to signal that an error
@@ -114,7 +140,7 @@ inline static int kaizen_internal_frame_time_convert_with_factor(struct kaizen_r
                                                                &intermediate_result);
     
     if (KAIZEN_SUCCESS == errc) {
-        assert(0 == (intermediate_result & ((uint64_t)(-1))<< DBL_MANT_DIG));
+        /* Rounds to the double mantissa beyond 2^53 ns, about 104 days. */
         *result = conversion_factor * (double)intermediate_result;
     }
     
@@ -228,9 +254,9 @@ int kaizen_frame_time_aggregate(struct kaizen_raw_frame_time_s const* lhs,
     
     uint64_t const aggregate = left_interval + right_interval;
     
-    assert(aggregate >= left_interval
-           && aggregate >= right_interval
-           && "Overflow");
+    if (aggregate < left_interval) {
+        return ERANGE;
+    }
     
     result->interval = aggregate;
     
@@ -271,6 +297,112 @@ int kaizen_frame_time_convert_to_seconds(struct kaizen_raw_frame_time_s const* t
 
 
 
+static int kaizen_internal_frame_time_convert_from_nanoseconds(struct kaizen_raw_frame_time_s* result,
+                                                              double nanoseconds);
+int kaizen_internal_frame_time_convert_from_nanoseconds(struct kaizen_raw_frame_time_s* result,
+                                                       double nanoseconds)
+{
+    assert(NULL != result);
+    
+    if (!(0.0 <= nanoseconds)) {
+        return EINVAL;
+    }
+    
+    mach_timebase_info_data_t timebase;
+    kern_return_t const errc = mach_timebase_info(&timebase);
+    
+    if (KERN_SUCCESS != errc) {
+        return EAGAIN;
+    }
+    
+    double const interval = nanoseconds * (double)timebase.denom / (double)timebase.numer;
+    
+    if (!(interval < 18446744073709551616.0)) {
+        return ERANGE;
+    }
+    
+    result->interval = (uint64_t)interval;
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_convert_from_nanoseconds(struct kaizen_raw_frame_time_s* result,
+                                               double nanoseconds)
+{
+    return kaizen_internal_frame_time_convert_from_nanoseconds(result, nanoseconds);
+}
+
+
+
+int kaizen_frame_time_convert_from_microseconds(struct kaizen_raw_frame_time_s* result,
+                                                double microseconds)
+{
+    return kaizen_internal_frame_time_convert_from_nanoseconds(result, microseconds * 1.0e3);
+}
+
+
+
+int kaizen_frame_time_convert_from_milliseconds(struct kaizen_raw_frame_time_s* result,
+                                                double milliseconds)
+{
+    return kaizen_internal_frame_time_convert_from_nanoseconds(result, milliseconds * 1.0e6);
+}
+
+
+
+int kaizen_frame_time_convert_from_seconds(struct kaizen_raw_frame_time_s* result,
+                                           double seconds)
+{
+    return kaizen_internal_frame_time_convert_from_nanoseconds(result, seconds * 1.0e9);
+}
+
+
+
+int kaizen_frame_time_convert_to_ticks(struct kaizen_raw_frame_time_s const* time,
+                                       uint64_t* ticks)
+{
+    assert(NULL != time);
+    assert(NULL != ticks);
+    
+    *ticks = time->interval;
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_convert_from_ticks(struct kaizen_raw_frame_time_s* result,
+                                         uint64_t ticks)
+{
+    assert(NULL != result);
+    
+    result->interval = ticks;
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_query_ticks_per_second(uint64_t* ticks_per_second)
+{
+    assert(NULL != ticks_per_second);
+    
+    mach_timebase_info_data_t timebase;
+    kern_return_t const errc = mach_timebase_info(&timebase);
+    
+    if (KERN_SUCCESS != errc) {
+        return EAGAIN;
+    }
+    
+    *ticks_per_second = (uint64_t)1000000000 * (uint64_t)timebase.denom / (uint64_t)timebase.numer;
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
 kaizen_bool kaizen_frame_time_equal(struct kaizen_raw_frame_time_s const* lhs,
                                     struct kaizen_raw_frame_time_s const* rhs)
 {
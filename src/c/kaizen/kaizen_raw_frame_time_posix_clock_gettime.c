@@ -47,6 +47,9 @@
  * See http://www.opengroup.org/onlinepubs/000095399/functions/clock_getres.html
  *
  * To use clock_gettime and clock_getres link against librt.
+ *
+ * Uses CLOCK_MONOTONIC where available and falls back to CLOCK_REALTIME,
+ * which jumps when the system time is set.
  */
 
 #include "kaizen_raw_frame_time.h"
@@ -58,14 +61,20 @@
 
 #include <time.h>
 
-#error Not tested yet.
-
-#if !defined(CLOCK_REALTIME)
+#if defined(CLOCK_MONOTONIC)
+#   define KAIZEN_INTERNAL_CLOCK_ID CLOCK_MONOTONIC
+#elif defined(CLOCK_REALTIME)
+#   define KAIZEN_INTERNAL_CLOCK_ID CLOCK_REALTIME
+#else
 #   error POSIX realtime clock not supported on platform.
 #endif
 
 
-#define KAIZEN_INTERNAL_ONE_SECOND_IN_NANOSECONDS 1000000000
+#define KAIZEN_INTERNAL_ONE_SECOND_IN_NANOSECONDS 1000000000L
+
+/* UINT64_MAX nanosecond ticks split into seconds and nanoseconds. */
+#define KAIZEN_INTERNAL_MAX_TICK_SECONDS ((uint64_t)18446744073ull)
+#define KAIZEN_INTERNAL_MAX_TICK_NANOSECONDS 709551615L
 
 
 inline static kaizen_bool kaizen_internal_timespec_is_valid(struct timespec const* time);
@@ -73,22 +82,21 @@ inline static kaizen_bool kaizen_internal_timespec_is_valid(struct timespec cons
 {
     return ((time->tv_sec >= 0)
             && (time->tv_nsec < KAIZEN_INTERNAL_ONE_SECOND_IN_NANOSECONDS)
-            && (time->tv_nsec > 0));
+            && (time->tv_nsec >= 0)) ? KAIZEN_TRUE : KAIZEN_FALSE;
 }
 
 
 
 kaizen_bool kaizen_frame_time_is_supported(void)
 {
-    kaizen_bool return_value = KAIZEN_TRUE;
+    kaizen_bool return_value = KAIZEN_FALSE;
     
     struct timespec time;
-    int const error_indicator = clock_getres(CLOCK_REALTIME, &time);
-    assert(kaizen_internal_timespec_is_valid(&time));
+    int const error_indicator = clock_getres(KAIZEN_INTERNAL_CLOCK_ID, &time);
     
-    if (0 != error_indicator) {
-        int const errc = errno;
-        return_value = KAIZEN_FALSE;
+    if (0 == error_indicator) {
+        assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&time));
+        return_value = KAIZEN_TRUE;
     }
     
     return return_value;
@@ -98,7 +106,11 @@ kaizen_bool kaizen_frame_time_is_supported(void)
 
 kaizen_bool kaizen_frame_time_is_monotonic(void)
 {
+#if defined(CLOCK_MONOTONIC)
+    return KAIZEN_TRUE;
+#else
     return KAIZEN_FALSE;
+#endif
 }
 
 
@@ -108,47 +120,30 @@ int kaizen_frame_time_query_resolution(kaizen_frame_time_resolution_t* resolutio
 {
     assert(NULL != resolution);
     
-    int return_code = ENOSYS;
-    
     struct timespec res;
-    int const error_indicator = clock_getres(CLOCK_REALTIME, &res);
+    int const error_indicator = clock_getres(KAIZEN_INTERNAL_CLOCK_ID, &res);
+    
+    if (0 != error_indicator) {
+        return ENOSYS;
+    }
+    
     assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&res));
     
-    /* TODO: @todo Unsure how to handle the opaque tv_sec value. Decide to
-     *             use gmtime or localtime or keep the current implementation.
-     */
-    long const sec_res = (long)res.tv_sec;
-    long const nanosec_res = res.tv_nsec;
+    kaizen_frame_time_resolution_t result = kaizen_unknown_frame_time_resolution;
     
-    if (0 == error_indicator) {
-        
-        kaizen_frame_time_resolution_t result = kaizen_unknown_frame_time_resolution;
-        
-#error Untested functionality.
-        /* TODO: @todo Check logic on linux computer. */
-        if (sec_res > 0 /* || nanosec_res >= 1000000000 */) {
-            result = kaizen_seconds_frame_time_resolution;
-        } else if (nanosec_res >= 1000000) {
-            result = kaizen_milliseconds_frame_time_resolution;
-        } else if (nanosec_res >= 1000) {
-            result = kaizen_microseconds_frame_time_resolution;
-        } else if (nanosec_res > 0) {
-            result = kaizen_nanoseconds_frame_time_resolution;
-        } else {
-            result = kaizen_unknown_frame_time_resolution;
-        }
-        
-        *resolution = result;
-        
-        return_code = KAIZEN_SUCCESS;
-    } else {
-        int const errc = errno;
-        assert(0);
-        return_code = ENOSYS;
+    if (res.tv_sec > 0) {
+        result = kaizen_seconds_frame_time_resolution;
+    } else if (res.tv_nsec >= 1000000) {
+        result = kaizen_milliseconds_frame_time_resolution;
+    } else if (res.tv_nsec >= 1000) {
+        result = kaizen_microseconds_frame_time_resolution;
+    } else if (res.tv_nsec > 0) {
+        result = kaizen_nanoseconds_frame_time_resolution;
     }
     
+    *resolution = result;
     
-    return return_code;
+    return KAIZEN_SUCCESS;
 }
 
 
@@ -157,24 +152,18 @@ int kaizen_frame_time_query(struct kaizen_raw_frame_time_s* now)
 {
     assert(NULL != now);
     
-    int return_code = ENOSYS;
-    
-    struct timespec time = KAIZEN_RAW_FRAME_TIME_ZERO;
-    int const error_indicator = clock_gettime(CLOCK_REALTIME, &time);
-    assert(kaizen_internal_timespec_is_valid(&time));
+    struct timespec time = {(time_t)0, 0L};
+    int const error_indicator = clock_gettime(KAIZEN_INTERNAL_CLOCK_ID, &time);
     
-    if (0 == error_indicator) {
-        
-        now->time = time;
-        
-        return_code = KAIZEN_SUCCESS;
-    } else {
-        int const errc = errno;
-        assert(0);
-        return_code = ENOSYS;
+    if (0 != error_indicator) {
+        return ENOSYS;
     }
     
-    return return_code;
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&time));
+    
+    now->time = time;
+    
+    return KAIZEN_SUCCESS;
 }
 
 
@@ -187,17 +176,20 @@ int kaizen_frame_time_subtract(struct kaizen_raw_frame_time_s const* later,
     assert(NULL != earlier);
     assert(NULL != result);
     assert(KAIZEN_TRUE == kaizen_frame_time_greater_or_equal(later, earlier));
-    assert(kaizen_internal_timespec_is_valid(&(later->time)));
-    assert(kaizen_internal_timespec_is_valid(&(earlier->time)));
     
     struct timespec const later_time = later->time;
     struct timespec const earlier_time = earlier->time;
     
-    time_t const difference_tv_sec = later_time.tv_sec - earlier_time.tv_sec; 
-    long const difference_tv_nsec = later_time.tv_nsec - earlier_time.tv_nsec;
-    struct timespec const difference = {difference_tv_sec, difference_tv_nsec};
+    time_t difference_tv_sec = later_time.tv_sec - earlier_time.tv_sec; 
+    long difference_tv_nsec = later_time.tv_nsec - earlier_time.tv_nsec;
     
-    result->time = difference;
+    if (difference_tv_nsec < 0) {
+        difference_tv_sec -= 1;
+        difference_tv_nsec += KAIZEN_INTERNAL_ONE_SECOND_IN_NANOSECONDS;
+    }
+    
+    result->time.tv_sec = difference_tv_sec;
+    result->time.tv_nsec = difference_tv_nsec;
     
     return KAIZEN_SUCCESS;
 }
@@ -211,8 +203,6 @@ int kaizen_frame_time_difference(struct kaizen_raw_frame_time_s const* one,
     assert(NULL != one);
     assert(NULL != two);
     assert(NULL != result);
-    assert(kaizen_internal_timespec_is_valid(&(one->time)));
-    assert(kaizen_internal_timespec_is_valid(&(two->time)));
     
     int return_code = ENOSYS;
     
@@ -236,27 +226,35 @@ int kaizen_frame_time_aggregate(struct kaizen_raw_frame_time_s const* lhs,
     assert(NULL != lhs);
     assert(NULL != rhs);
     assert(NULL != result);
-    assert(kaizen_internal_timespec_is_valid(&(lhs->time)));
-    assert(kaizen_internal_timespec_is_valid(&(rhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(lhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(rhs->time)));
     
     struct timespec const left_time = lhs->time;
     struct timespec const right_time = rhs->time;
     
-    long sec_aggregate = left_time.tv_sec + right_time.tv_sec;
-    long nssec_aggregate = left_time.tv_nsec + right_time.tv_nsec;
+    /* Add in uint64_t, the signed time_t overflow is undefined. */
+    uint64_t sec_aggregate = (uint64_t)left_time.tv_sec + (uint64_t)right_time.tv_sec;
+    long nsec_aggregate = left_time.tv_nsec + right_time.tv_nsec;
     
     if (nsec_aggregate >= KAIZEN_INTERNAL_ONE_SECOND_IN_NANOSECONDS) {
         sec_aggregate += 1;
         nsec_aggregate -= KAIZEN_INTERNAL_ONE_SECOND_IN_NANOSECONDS;
     }
     
-    struct timespec const aggregate = {sec_aggregate, nsec_aggregate};
+    /* Sums must stay convertible to uint64_t nanosecond ticks and time_t. */
+    if (sec_aggregate > KAIZEN_INTERNAL_MAX_TICK_SECONDS
+        || (KAIZEN_INTERNAL_MAX_TICK_SECONDS == sec_aggregate && nsec_aggregate > KAIZEN_INTERNAL_MAX_TICK_NANOSECONDS)) {
+        return ERANGE;
+    }
+    
+    time_t const aggregate_tv_sec = (time_t)sec_aggregate;
     
-    assert(kaizen_frame_time_greater_or_equal(&aggregate, &left_time)
-           && kaizen_frame_time_greater_or_equal(&aggregate, &right_time)
-           && "Overflow");
+    if (aggregate_tv_sec < 0 || (uint64_t)aggregate_tv_sec != sec_aggregate) {
+        return ERANGE;
+    }
     
-    result->time = aggregate;
+    result->time.tv_sec = aggregate_tv_sec;
+    result->time.tv_nsec = nsec_aggregate;
     
     return KAIZEN_SUCCESS;
 }
@@ -268,9 +266,9 @@ int kaizen_frame_time_convert_to_nanoseconds(struct kaizen_raw_frame_time_s cons
 {
     assert(NULL != time);
     assert(NULL != result);
-    assert(kaizen_internal_timespec_is_valid(&(time->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(time->time)));
     
-    *result = 1000000000.0 * (double)time->tv_sec + (double)time->tv_nsec;
+    *result = 1000000000.0 * (double)time->time.tv_sec + (double)time->time.tv_nsec;
 
     return KAIZEN_SUCCESS;
 }
@@ -282,9 +280,9 @@ int kaizen_frame_time_convert_to_microseconds(struct kaizen_raw_frame_time_s con
 {
     assert(NULL != time);
     assert(NULL != result);
-    assert(kaizen_internal_timespec_is_valid(&(time->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(time->time)));
     
-    *result = 1000000.0 * (double)time->tv_sec + (double)time->tv_nsec / 1000.0;
+    *result = 1000000.0 * (double)time->time.tv_sec + (double)time->time.tv_nsec / 1000.0;
     
     return KAIZEN_SUCCESS;
 }
@@ -296,9 +294,9 @@ int kaizen_frame_time_convert_to_milliseconds(struct kaizen_raw_frame_time_s con
 {
     assert(NULL != time);
     assert(NULL != result);
-    assert(kaizen_internal_timespec_is_valid(&(time->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(time->time)));
     
-    *result = 1000.0 * (double)time->tv_sec + (double)time->tv_nsec / 1000000.0;
+    *result = 1000.0 * (double)time->time.tv_sec + (double)time->time.tv_nsec / 1000000.0;
     
     return KAIZEN_SUCCESS;
 }
@@ -310,9 +308,111 @@ int kaizen_frame_time_convert_to_seconds(struct kaizen_raw_frame_time_s const* t
 {
     assert(NULL != time);
     assert(NULL != result);
-    assert(kaizen_internal_timespec_is_valid(&(time->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(time->time)));
+    
+    *result = (double)time->time.tv_sec + (double)time->time.tv_nsec / 1000000000.0;
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
+static int kaizen_internal_frame_time_convert_from_nanoseconds(struct kaizen_raw_frame_time_s* result,
+                                                              double nanoseconds);
+int kaizen_internal_frame_time_convert_from_nanoseconds(struct kaizen_raw_frame_time_s* result,
+                                                       double nanoseconds)
+{
+    assert(NULL != result);
+    
+    if (!(0.0 <= nanoseconds)) {
+        return EINVAL;
+    }
+    
+    double const seconds = nanoseconds / 1000000000.0;
+    
+    if (!(seconds < 9223372036854775808.0)) {
+        return ERANGE;
+    }
+    
+    result->time.tv_sec = (time_t)seconds;
+    result->time.tv_nsec = (long)(nanoseconds - 1000000000.0 * (double)result->time.tv_sec);
+    
+    /* Rounding of the division may leave the remainder just outside a second. */
+    if (result->time.tv_nsec < 0) {
+        result->time.tv_nsec = 0;
+    } else if (KAIZEN_INTERNAL_ONE_SECOND_IN_NANOSECONDS <= result->time.tv_nsec) {
+        result->time.tv_nsec = KAIZEN_INTERNAL_ONE_SECOND_IN_NANOSECONDS - 1;
+    }
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_convert_from_nanoseconds(struct kaizen_raw_frame_time_s* result,
+                                               double nanoseconds)
+{
+    return kaizen_internal_frame_time_convert_from_nanoseconds(result, nanoseconds);
+}
+
+
+
+int kaizen_frame_time_convert_from_microseconds(struct kaizen_raw_frame_time_s* result,
+                                                double microseconds)
+{
+    return kaizen_internal_frame_time_convert_from_nanoseconds(result, microseconds * 1.0e3);
+}
+
+
+
+int kaizen_frame_time_convert_from_milliseconds(struct kaizen_raw_frame_time_s* result,
+                                                double milliseconds)
+{
+    return kaizen_internal_frame_time_convert_from_nanoseconds(result, milliseconds * 1.0e6);
+}
+
+
+
+int kaizen_frame_time_convert_from_seconds(struct kaizen_raw_frame_time_s* result,
+                                           double seconds)
+{
+    return kaizen_internal_frame_time_convert_from_nanoseconds(result, seconds * 1.0e9);
+}
+
+
+
+int kaizen_frame_time_convert_to_ticks(struct kaizen_raw_frame_time_s const* time,
+                                       uint64_t* ticks)
+{
+    assert(NULL != time);
+    assert(NULL != ticks);
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(time->time)));
+    
+    *ticks = (uint64_t)time->time.tv_sec * (uint64_t)1000000000 + (uint64_t)time->time.tv_nsec;
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_convert_from_ticks(struct kaizen_raw_frame_time_s* result,
+                                         uint64_t ticks)
+{
+    assert(NULL != result);
+    
+    result->time.tv_sec = (time_t)(ticks / (uint64_t)1000000000);
+    result->time.tv_nsec = (long)(ticks % (uint64_t)1000000000);
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_query_ticks_per_second(uint64_t* ticks_per_second)
+{
+    assert(NULL != ticks_per_second);
     
-    *result = (double)time->tv_sec + (double)time->tv_nsec / 1000000000.0;
+    *ticks_per_second = (uint64_t)1000000000;
     
     return KAIZEN_SUCCESS;
 }
@@ -324,8 +424,8 @@ kaizen_bool kaizen_frame_time_equal(struct kaizen_raw_frame_time_s const* lhs,
 {
     assert(NULL != lhs);
     assert(NULL != rhs);
-    assert(kaizen_internal_timespec_is_valid(&(lhs->time)));
-    assert(kaizen_internal_timespec_is_valid(&(rhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(lhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(rhs->time)));
     
     return (rhs->time.tv_sec == lhs->time.tv_sec
             && rhs->time.tv_nsec == lhs->time.tv_nsec);
@@ -338,11 +438,11 @@ kaizen_bool kaizen_frame_time_unequal(struct kaizen_raw_frame_time_s const* lhs,
 {
     assert(NULL != lhs);
     assert(NULL != rhs);
-    assert(kaizen_internal_timespec_is_valid(&(lhs->time)));
-    assert(kaizen_internal_timespec_is_valid(&(rhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(lhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(rhs->time)));
     
     return (rhs->time.tv_sec != lhs->time.tv_sec
-            && rhs->time.tv_nsec != lhs->time.tv_nsec);
+            || rhs->time.tv_nsec != lhs->time.tv_nsec);
 }
 
 
@@ -353,12 +453,12 @@ kaizen_bool kaizen_frame_time_greater(struct kaizen_raw_frame_time_s const* lhs,
 {
     assert(NULL != lhs);
     assert(NULL != rhs);
-    assert(kaizen_internal_timespec_is_valid(&(lhs->time)));
-    assert(kaizen_internal_timespec_is_valid(&(rhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(lhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(rhs->time)));
     
-    return (rhs->time.tv_sec > lhs->time.tv_sec
-            || ((rhs->time.tv_sec == lhs->time.tv_sec)
-                && (rhs->time.tv_nsec > lhs->time.tv_nsec)));
+    return (lhs->time.tv_sec > rhs->time.tv_sec
+            || ((lhs->time.tv_sec == rhs->time.tv_sec)
+                && (lhs->time.tv_nsec > rhs->time.tv_nsec)));
 }
 
 
@@ -369,12 +469,12 @@ kaizen_bool kaizen_frame_time_greater_or_equal(struct kaizen_raw_frame_time_s co
 {
     assert(NULL != lhs);
     assert(NULL != rhs);
-    assert(kaizen_internal_timespec_is_valid(&(lhs->time)));
-    assert(kaizen_internal_timespec_is_valid(&(rhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(lhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(rhs->time)));
     
-    return (rhs->time.tv_sec >= lhs->time.tv_sec
-            || ((rhs->time.tv_sec == lhs->time.tv_sec)
-                && (rhs->time.tv_nsec >= lhs->time.tv_nsec)));
+    return (lhs->time.tv_sec > rhs->time.tv_sec
+            || ((lhs->time.tv_sec == rhs->time.tv_sec)
+                && (lhs->time.tv_nsec >= rhs->time.tv_nsec)));
 }
 
 
@@ -385,12 +485,12 @@ kaizen_bool kaizen_frame_time_lesser(struct kaizen_raw_frame_time_s const* lhs,
 {
     assert(NULL != lhs);
     assert(NULL != rhs);
-    assert(kaizen_internal_timespec_is_valid(&(lhs->time)));
-    assert(kaizen_internal_timespec_is_valid(&(rhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(lhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(rhs->time)));
     
-    return (rhs->time.tv_sec < lhs->time.tv_sec
-            || ((rhs->time.tv_sec == lhs->time.tv_sec)
-                && (rhs->time.tv_nsec < lhs->time.tv_nsec)));
+    return (lhs->time.tv_sec < rhs->time.tv_sec
+            || ((lhs->time.tv_sec == rhs->time.tv_sec)
+                && (lhs->time.tv_nsec < rhs->time.tv_nsec)));
 }
 
 
@@ -401,12 +501,12 @@ kaizen_bool kaizen_frame_time_lesser_or_equal(struct kaizen_raw_frame_time_s con
 {
     assert(NULL != lhs);
     assert(NULL != rhs);
-    assert(kaizen_internal_timespec_is_valid(&(lhs->time)));
-    assert(kaizen_internal_timespec_is_valid(&(rhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(lhs->time)));
+    assert(KAIZEN_TRUE == kaizen_internal_timespec_is_valid(&(rhs->time)));
     
-    return (rhs->time.tv_sec <= lhs->time.tv_sec
-            || ((rhs->time.tv_sec == lhs->time.tv_sec)
-                && (rhs->time.tv_nsec <= lhs->time.tv_nsec)));
+    return (lhs->time.tv_sec < rhs->time.tv_sec
+            || ((lhs->time.tv_sec == rhs->time.tv_sec)
+                && (lhs->time.tv_nsec <= rhs->time.tv_nsec)));
 }
 
 
@@ -248,13 +248,11 @@ int kaizen_frame_time_aggregate(struct kaizen_raw_frame_time_s const* lhs,
     LONGLONG const left_counter = lhs->counter.QuadPart;
     LONGLONG const right_counter = rhs->counter.QuadPart;
     
-    LONGLONG const aggregate = left_counter + right_counter;
-    
-    assert(aggregate >= left_counter
-           && aggregate >= right_counter
-           && "Overflow");
+    if (right_counter > (LONGLONG)0x7FFFFFFFFFFFFFFFll - left_counter) {
+        return ERANGE;
+    }
     
-    result->counter.QuadPart = aggregate;
+    result->counter.QuadPart = left_counter + right_counter;
     
     return KAIZEN_SUCCESS;
 }
@@ -301,6 +299,113 @@ int kaizen_frame_time_convert_to_seconds(struct kaizen_raw_frame_time_s const* t
 
 
 
+static int kaizen_internal_frame_time_convert_from_seconds(struct kaizen_raw_frame_time_s* result,
+                                                          double seconds);
+int kaizen_internal_frame_time_convert_from_seconds(struct kaizen_raw_frame_time_s* result,
+                                                   double seconds)
+{
+    assert(NULL != result);
+    
+    if (!(0.0 <= seconds)) {
+        return EINVAL;
+    }
+    
+    LARGE_INTEGER frequency = {(DWORD)0,(LONG)0};
+    BOOL const errc = QueryPerformanceFrequency(&frequency);
+    
+    if (FALSE == errc) {
+        return ENOSYS;
+    }
+    
+    double const counter = seconds * (double)frequency.QuadPart;
+    
+    if (!(counter < 9223372036854775808.0)) {
+        return ERANGE;
+    }
+    
+    result->counter.QuadPart = (LONGLONG)counter;
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_convert_from_nanoseconds(struct kaizen_raw_frame_time_s* result,
+                                               double nanoseconds)
+{
+    return kaizen_internal_frame_time_convert_from_seconds(result, nanoseconds * 1.0e-9);
+}
+
+
+
+int kaizen_frame_time_convert_from_microseconds(struct kaizen_raw_frame_time_s* result,
+                                                double microseconds)
+{
+    return kaizen_internal_frame_time_convert_from_seconds(result, microseconds * 1.0e-6);
+}
+
+
+
+int kaizen_frame_time_convert_from_milliseconds(struct kaizen_raw_frame_time_s* result,
+                                                double milliseconds)
+{
+    return kaizen_internal_frame_time_convert_from_seconds(result, milliseconds * 1.0e-3);
+}
+
+
+
+int kaizen_frame_time_convert_from_seconds(struct kaizen_raw_frame_time_s* result,
+                                           double seconds)
+{
+    return kaizen_internal_frame_time_convert_from_seconds(result, seconds);
+}
+
+
+
+int kaizen_frame_time_convert_to_ticks(struct kaizen_raw_frame_time_s const* time,
+                                       uint64_t* ticks)
+{
+    assert(NULL != time);
+    assert(NULL != ticks);
+    assert(time->counter.QuadPart >= 0);
+    
+    *ticks = (uint64_t)time->counter.QuadPart;
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_convert_from_ticks(struct kaizen_raw_frame_time_s* result,
+                                         uint64_t ticks)
+{
+    assert(NULL != result);
+    
+    result->counter.QuadPart = (LONGLONG)ticks;
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_frame_time_query_ticks_per_second(uint64_t* ticks_per_second)
+{
+    assert(NULL != ticks_per_second);
+    
+    LARGE_INTEGER frequency = {(DWORD)0,(LONG)0};
+    BOOL const errc = QueryPerformanceFrequency(&frequency);
+    
+    if (FALSE == errc) {
+        return ENOSYS;
+    }
+    
+    *ticks_per_second = (uint64_t)frequency.QuadPart;
+    
+    return KAIZEN_SUCCESS;
+}
+
+
+
 kaizen_bool kaizen_frame_time_equal(struct kaizen_raw_frame_time_s const* lhs,
                                     struct kaizen_raw_frame_time_s const* rhs)
 {
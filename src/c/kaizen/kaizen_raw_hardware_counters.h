@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Per thread hardware performance counters (cycles, instructions, cache
+ * misses, branch misses) to explain why a zone got slower, e.g. a dropping
+ * instructions per cycle ratio or rising cache misses.
+ *
+ * Counters count for the thread that initialized them. Attach them to that
+ * thread and every sampled zone (see kaizen_zone.h) it runs records the
+ * counter deltas as kaizen_hardware_counter_event_type events next to its
+ * zone event (see kaizen_event.h).
+ *
+ * Counters the processor or the process privileges do not allow are left
+ * disabled, e.g. in virtual machines or if perf_event_paranoid forbids
+ * them.
+ *
+ * Usage: define KAIZEN_USE_LINUX_PERF_EVENT and compile the source file
+ * ending in _linux_perf_event.c on Linux. On other platforms compile the
+ * file ending in _generic_unsupported.c which reports ENOSYS.
+ */
+
+#ifndef KAIZEN_kaizen_raw_hardware_counters_H
+#define KAIZEN_kaizen_raw_hardware_counters_H
+
+
+#include <kaizen/kaizen_stddef.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    enum kaizen_hardware_counter {
+        kaizen_cycles_hardware_counter = 0,
+        kaizen_instructions_hardware_counter,
+        kaizen_cache_misses_hardware_counter,
+        kaizen_branch_misses_hardware_counter
+    };
+    typedef enum kaizen_hardware_counter kaizen_hardware_counter_t;
+
+#define KAIZEN_HARDWARE_COUNTER_COUNT 4
+
+
+    struct kaizen_hardware_counter_values_s {
+        uint64_t values[KAIZEN_HARDWARE_COUNTER_COUNT];
+    };
+    typedef struct kaizen_hardware_counter_values_s kaizen_hardware_counter_values_t;
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_raw_hardware_counters_s {
+#if defined(KAIZEN_USE_LINUX_PERF_EVENT)
+        int file_descriptors[KAIZEN_HARDWARE_COUNTER_COUNT];
+        void* mapped_pages[KAIZEN_HARDWARE_COUNTER_COUNT];
+#endif
+        uint32_t enabled_mask;
+    };
+    typedef struct kaizen_raw_hardware_counters_s kaizen_raw_hardware_counters_t;
+
+
+
+    /**
+     * Opens the hardware counters of the calling thread.
+     *
+     * Returns ENOSYS if the platform offers no counters, or the error of the
+     * platform (e.g. EACCES) if no counter could be opened.
+     */
+    int kaizen_hardware_counters_init(struct kaizen_raw_hardware_counters_s* counters);
+
+    int kaizen_hardware_counters_finalize(struct kaizen_raw_hardware_counters_s* counters);
+
+    kaizen_bool kaizen_hardware_counters_is_enabled(struct kaizen_raw_hardware_counters_s const* counters,
+                                                    kaizen_hardware_counter_t counter);
+
+    /**
+     * Reads all enabled counters, disabled counters read as 0. Only call
+     * from the thread that initialized @a counters.
+     *
+     * Reads from user space without a system call (rdpmc) where the kernel
+     * allows it.
+     */
+    int kaizen_hardware_counters_read(struct kaizen_raw_hardware_counters_s const* counters,
+                                      struct kaizen_hardware_counter_values_s* result);
+
+    /**
+     * Attaches @a counters to the calling thread so sampled zones record
+     * their deltas. Pass NULL to detach the current counters.
+     */
+    int kaizen_hardware_counters_attach_to_current_thread(struct kaizen_raw_hardware_counters_s* counters);
+
+    /**
+     * Returns the counters attached to the calling thread or NULL.
+     */
+    struct kaizen_raw_hardware_counters_s* kaizen_hardware_counters_of_current_thread(void);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_raw_hardware_counters_H */
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_hardware_counters.h for platforms without
+ * supported hardware counters. Initialization reports ENOSYS, attaching
+ * counters is still possible so code runs unchanged.
+ */
+
+#include "kaizen_raw_hardware_counters.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_internal_thread_local.h"
+
+
+
+static KAIZEN_THREAD_LOCAL struct kaizen_raw_hardware_counters_s* kaizen_internal_current_thread_hardware_counters = NULL;
+
+
+
+int kaizen_hardware_counters_init(struct kaizen_raw_hardware_counters_s* counters)
+{
+    assert(NULL != counters);
+
+    counters->enabled_mask = 0u;
+
+    return ENOSYS;
+}
+
+
+
+int kaizen_hardware_counters_finalize(struct kaizen_raw_hardware_counters_s* counters)
+{
+    assert(NULL != counters);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+kaizen_bool kaizen_hardware_counters_is_enabled(struct kaizen_raw_hardware_counters_s const* counters,
+                                                kaizen_hardware_counter_t counter)
+{
+    assert(NULL != counters);
+
+    return KAIZEN_FALSE;
+}
+
+
+
+int kaizen_hardware_counters_read(struct kaizen_raw_hardware_counters_s const* counters,
+                                  struct kaizen_hardware_counter_values_s* result)
+{
+    assert(NULL != counters);
+    assert(NULL != result);
+
+    int i = 0;
+    for (i = 0; i < KAIZEN_HARDWARE_COUNTER_COUNT; ++i) {
+        result->values[i] = 0u;
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_hardware_counters_attach_to_current_thread(struct kaizen_raw_hardware_counters_s* counters)
+{
+    kaizen_internal_current_thread_hardware_counters = counters;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+struct kaizen_raw_hardware_counters_s* kaizen_hardware_counters_of_current_thread(void)
+{
+    return kaizen_internal_current_thread_hardware_counters;
+}
+
+
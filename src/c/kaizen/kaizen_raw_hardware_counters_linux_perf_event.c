@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_hardware_counters.h with Linux perf_event_open.
+ *
+ * Each counter is opened for the calling thread (user space only) and its
+ * metadata page is mapped. If the kernel sets cap_user_rdpmc the counter is
+ * read with the rdpmc instruction, guarded by the sequence lock of the
+ * metadata page, otherwise with a read system call.
+ *
+ * See http://man7.org/linux/man-pages/man2/perf_event_open.2.html
+ */
+
+#include "kaizen_raw_hardware_counters.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_internal_thread_local.h"
+
+
+
+static KAIZEN_THREAD_LOCAL struct kaizen_raw_hardware_counters_s* kaizen_internal_current_thread_hardware_counters = NULL;
+
+
+
+static uint64_t const kaizen_internal_hardware_counter_configs[KAIZEN_HARDWARE_COUNTER_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+
+
+static int kaizen_internal_perf_event_open(uint64_t config);
+int kaizen_internal_perf_event_open(uint64_t config)
+{
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = config;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    /* Calling thread on any CPU. */
+    return (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+}
+
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+static uint64_t kaizen_internal_rdpmc(uint32_t counter);
+uint64_t kaizen_internal_rdpmc(uint32_t counter)
+{
+    uint32_t low = 0;
+    uint32_t high = 0;
+
+    __asm__ __volatile__ ("rdpmc" : "=a" (low), "=d" (high) : "c" (counter));
+
+    return ((uint64_t)high << 32) | (uint64_t)low;
+}
+
+#endif
+
+
+
+static int kaizen_internal_hardware_counter_read(struct kaizen_raw_hardware_counters_s const* counters,
+                                                 int counter,
+                                                 uint64_t* result);
+int kaizen_internal_hardware_counter_read(struct kaizen_raw_hardware_counters_s const* counters,
+                                          int counter,
+                                          uint64_t* result)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    struct perf_event_mmap_page volatile* const page = (struct perf_event_mmap_page volatile*)counters->mapped_pages[counter];
+
+    if (NULL != page) {
+        uint32_t sequence = 0;
+        uint64_t count = 0;
+        kaizen_bool is_read = KAIZEN_FALSE;
+
+        do {
+            sequence = page->lock;
+            __asm__ __volatile__ ("" ::: "memory");
+
+            uint32_t const index = page->index;
+            is_read = (0 != page->cap_user_rdpmc && 0 != index) ? KAIZEN_TRUE : KAIZEN_FALSE;
+
+            if (KAIZEN_TRUE == is_read) {
+                uint32_t const shift = 64u - page->pmc_width;
+
+                /* Sign extend the counter width. */
+                int64_t const value = (int64_t)(kaizen_internal_rdpmc(index - 1) << shift) >> shift;
+
+                count = (uint64_t)(page->offset + value);
+            }
+
+            __asm__ __volatile__ ("" ::: "memory");
+        } while (page->lock != sequence);
+
+        if (KAIZEN_TRUE == is_read) {
+            *result = count;
+
+            return KAIZEN_SUCCESS;
+        }
+    }
+#endif
+
+    /* Counter not scheduled on a PMU or rdpmc forbidden. */
+    uint64_t count = 0;
+
+    if ((ssize_t)sizeof(count) != read(counters->file_descriptors[counter], &count, sizeof(count))) {
+        return errno;
+    }
+
+    *result = count;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_hardware_counters_init(struct kaizen_raw_hardware_counters_s* counters)
+{
+    assert(NULL != counters);
+
+    int errc = ENOSYS;
+    long const page_size = sysconf(_SC_PAGESIZE);
+    int i = 0;
+
+    counters->enabled_mask = 0u;
+
+    for (i = 0; i < KAIZEN_HARDWARE_COUNTER_COUNT; ++i) {
+        counters->mapped_pages[i] = NULL;
+        counters->file_descriptors[i] = kaizen_internal_perf_event_open(kaizen_internal_hardware_counter_configs[i]);
+
+        if (0 > counters->file_descriptors[i]) {
+            errc = errno;
+
+            continue;
+        }
+
+        counters->enabled_mask |= 1u << i;
+
+        void* const page = mmap(NULL, (size_t)page_size, PROT_READ, MAP_SHARED, counters->file_descriptors[i], 0);
+
+        if (MAP_FAILED != page) {
+            counters->mapped_pages[i] = page;
+        }
+    }
+
+    return (0u == counters->enabled_mask) ? errc : KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_hardware_counters_finalize(struct kaizen_raw_hardware_counters_s* counters)
+{
+    assert(NULL != counters);
+
+    long const page_size = sysconf(_SC_PAGESIZE);
+    int i = 0;
+
+    for (i = 0; i < KAIZEN_HARDWARE_COUNTER_COUNT; ++i) {
+        if (0u == (counters->enabled_mask & (1u << i))) {
+            continue;
+        }
+
+        if (NULL != counters->mapped_pages[i]) {
+            (void)munmap(counters->mapped_pages[i], (size_t)page_size);
+            counters->mapped_pages[i] = NULL;
+        }
+
+        (void)close(counters->file_descriptors[i]);
+        counters->file_descriptors[i] = -1;
+    }
+
+    counters->enabled_mask = 0u;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+kaizen_bool kaizen_hardware_counters_is_enabled(struct kaizen_raw_hardware_counters_s const* counters,
+                                                kaizen_hardware_counter_t counter)
+{
+    assert(NULL != counters);
+    assert(KAIZEN_HARDWARE_COUNTER_COUNT > (int)counter);
+
+    return (0u != (counters->enabled_mask & (1u << (int)counter))) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+int kaizen_hardware_counters_read(struct kaizen_raw_hardware_counters_s const* counters,
+                                  struct kaizen_hardware_counter_values_s* result)
+{
+    assert(NULL != counters);
+    assert(NULL != result);
+
+    int i = 0;
+
+    for (i = 0; i < KAIZEN_HARDWARE_COUNTER_COUNT; ++i) {
+        result->values[i] = 0u;
+
+        if (0u == (counters->enabled_mask & (1u << i))) {
+            continue;
+        }
+
+        int const errc = kaizen_internal_hardware_counter_read(counters, i, &(result->values[i]));
+
+        if (KAIZEN_SUCCESS != errc) {
+            return errc;
+        }
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_hardware_counters_attach_to_current_thread(struct kaizen_raw_hardware_counters_s* counters)
+{
+    kaizen_internal_current_thread_hardware_counters = counters;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+struct kaizen_raw_hardware_counters_s* kaizen_hardware_counters_of_current_thread(void)
+{
+    return kaizen_internal_current_thread_hardware_counters;
+}
+
+
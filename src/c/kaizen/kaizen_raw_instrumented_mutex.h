@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Shallow wrapper around the platform mutex recording contended acquire
+ * wait times and hold times as kaizen events (see kaizen_lock_profile.h).
+ *
+ * Uncontended lock calls only cost a try-lock of the platform mutex.
+ *
+ * Usage: define KAIZEN_USE_POSIX_THREADS and compile the source file ending
+ * in _posix_threads.c to build with a pthread mutex, or define
+ * KAIZEN_USE_WIN32_THREADS and compile the file ending in _win32.c to build
+ * with a Win32 critical section.
+ */
+
+#ifndef KAIZEN_kaizen_raw_instrumented_mutex_H
+#define KAIZEN_kaizen_raw_instrumented_mutex_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_lock_profile.h>
+
+
+#if defined(KAIZEN_USE_POSIX_THREADS)
+#   include <pthread.h>
+#elif defined(KAIZEN_USE_WIN32_THREADS)
+#   include <windows.h>
+#else
+#   error Unsupported platform.
+#endif
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_raw_instrumented_mutex_s {
+#if defined(KAIZEN_USE_POSIX_THREADS)
+        pthread_mutex_t mutex;
+#elif defined(KAIZEN_USE_WIN32_THREADS)
+        CRITICAL_SECTION critical_section;
+#else
+#   error Unsupported platform.
+#endif
+        struct kaizen_lock_profile_s profile;
+    };
+    typedef struct kaizen_raw_instrumented_mutex_s kaizen_raw_instrumented_mutex_t;
+
+
+
+    /**
+     * See kaizen_lock_profile_init for the meaning of @a wait_threshold.
+     *
+     * Returns EAGAIN or ENOMEM if the platform mutex can not be created.
+     */
+    int kaizen_instrumented_mutex_init(struct kaizen_raw_instrumented_mutex_s* mutex,
+                                       uint32_t lock_id,
+                                       struct kaizen_raw_frame_time_s const* wait_threshold);
+
+    /**
+     * Returns EBUSY if the mutex is locked.
+     */
+    int kaizen_instrumented_mutex_finalize(struct kaizen_raw_instrumented_mutex_s* mutex);
+
+    int kaizen_instrumented_mutex_lock(struct kaizen_raw_instrumented_mutex_s* mutex);
+
+    /**
+     * Returns EBUSY without recording anything if the mutex is locked.
+     */
+    int kaizen_instrumented_mutex_trylock(struct kaizen_raw_instrumented_mutex_s* mutex);
+
+    int kaizen_instrumented_mutex_unlock(struct kaizen_raw_instrumented_mutex_s* mutex);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_raw_instrumented_mutex_H */
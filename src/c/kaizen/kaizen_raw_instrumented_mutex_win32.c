@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_instrumented_mutex.h with a Win32 critical
+ * section.
+ *
+ * See http://msdn.microsoft.com/en-us/library/ms682530(VS.85).aspx
+ */
+
+#include "kaizen_raw_instrumented_mutex.h"
+
+#include <windows.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_lock_profile.h"
+
+
+/* Spin count used by the Windows heap manager for its critical sections. */
+#define KAIZEN_INTERNAL_CRITICAL_SECTION_SPIN_COUNT 4000
+
+
+
+int kaizen_instrumented_mutex_init(struct kaizen_raw_instrumented_mutex_s* mutex,
+                                   uint32_t lock_id,
+                                   struct kaizen_raw_frame_time_s const* wait_threshold)
+{
+    assert(NULL != mutex);
+    assert(NULL != wait_threshold);
+
+    BOOL const errc = InitializeCriticalSectionAndSpinCount(&(mutex->critical_section),
+                                                            KAIZEN_INTERNAL_CRITICAL_SECTION_SPIN_COUNT);
+
+    if (FALSE == errc) {
+        DWORD const last_error = GetLastError();
+        (void)last_error;
+
+        return ENOMEM;
+    }
+
+    return kaizen_lock_profile_init(&(mutex->profile),
+                                    lock_id,
+                                    wait_threshold);
+}
+
+
+
+int kaizen_instrumented_mutex_finalize(struct kaizen_raw_instrumented_mutex_s* mutex)
+{
+    assert(NULL != mutex);
+
+    DeleteCriticalSection(&(mutex->critical_section));
+
+    return kaizen_lock_profile_finalize(&(mutex->profile));
+}
+
+
+
+int kaizen_instrumented_mutex_lock(struct kaizen_raw_instrumented_mutex_s* mutex)
+{
+    assert(NULL != mutex);
+
+    if (FALSE != TryEnterCriticalSection(&(mutex->critical_section))) {
+        return KAIZEN_SUCCESS;
+    }
+
+    struct kaizen_raw_frame_time_s wait_start = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int const time_errc = kaizen_lock_profile_wait_begin(&(mutex->profile),
+                                                         &wait_start);
+
+    EnterCriticalSection(&(mutex->critical_section));
+
+    if (KAIZEN_SUCCESS == time_errc) {
+        (void)kaizen_lock_profile_wait_end(&(mutex->profile),
+                                           &wait_start);
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_instrumented_mutex_trylock(struct kaizen_raw_instrumented_mutex_s* mutex)
+{
+    assert(NULL != mutex);
+
+    if (FALSE != TryEnterCriticalSection(&(mutex->critical_section))) {
+        return KAIZEN_SUCCESS;
+    }
+
+    return EBUSY;
+}
+
+
+
+int kaizen_instrumented_mutex_unlock(struct kaizen_raw_instrumented_mutex_s* mutex)
+{
+    assert(NULL != mutex);
+
+    (void)kaizen_lock_profile_release(&(mutex->profile));
+
+    LeaveCriticalSection(&(mutex->critical_section));
+
+    return KAIZEN_SUCCESS;
+}
+
+
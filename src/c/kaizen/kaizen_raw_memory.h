@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Shallow wrapper around the platform virtual memory functions to allocate
+ * the memory region backing a kaizen_arena (see kaizen_arena.h) up front,
+ * once, outside of the frames to profile.
+ *
+ * The region is committed and touched on allocation so using it never
+ * page faults or calls into an allocator afterwards. Optionally requests
+ * huge (large) pages to reduce TLB misses, falling back to normal pages if
+ * the platform or the process privileges do not allow them.
+ *
+ * On NUMA machines regions can be placed on a given node, e.g. the node of
+ * the worker thread writing its events into the region, and threads can be
+ * bound to the processors of a node (see kaizen_event_drain.h).
+ *
+ * Usage: define KAIZEN_USE_POSIX_MMAP and compile the source file ending in
+ * _posix_mmap.c on POSIX platforms, or define KAIZEN_USE_WIN32_VIRTUAL_ALLOC
+ * and compile the file ending in _win32_virtual_alloc.c on Windows.
+ */
+
+#ifndef KAIZEN_kaizen_raw_memory_H
+#define KAIZEN_kaizen_raw_memory_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    enum kaizen_memory_page_size {
+        kaizen_memory_default_page_size = 0,
+        kaizen_memory_huge_page_size
+    };
+    typedef enum kaizen_memory_page_size kaizen_memory_page_size_t;
+
+
+    /**
+     * Places a region like the platform does by default, usually on the node
+     * of the thread touching it first.
+     */
+#define KAIZEN_MEMORY_ANY_NUMA_NODE 0xFFFFFFFFu
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_raw_memory_region_s {
+        void* memory;
+        size_t size;
+        kaizen_memory_page_size_t page_size;
+    };
+    typedef struct kaizen_raw_memory_region_s kaizen_raw_memory_region_t;
+
+
+
+    /**
+     * Allocates, commits and touches at least @a size bytes. The size is
+     * rounded up to a multiple of the used page size.
+     *
+     * If @a requested_page_size is kaizen_memory_huge_page_size and huge
+     * pages are not available normal pages are used instead. Query the used
+     * page size via kaizen_memory_region_page_size.
+     *
+     * Returns ENOMEM if the memory can not be allocated.
+     */
+    int kaizen_memory_region_init(struct kaizen_raw_memory_region_s* region,
+                                  size_t size,
+                                  kaizen_memory_page_size_t requested_page_size);
+
+    /**
+     * Like kaizen_memory_region_init but prefers memory of @a numa_node, or
+     * places it by default for KAIZEN_MEMORY_ANY_NUMA_NODE.
+     *
+     * Returns EINVAL if @a numa_node does not exist.
+     */
+    int kaizen_memory_region_init_on_numa_node(struct kaizen_raw_memory_region_s* region,
+                                               size_t size,
+                                               kaizen_memory_page_size_t requested_page_size,
+                                               uint32_t numa_node);
+
+    int kaizen_memory_region_finalize(struct kaizen_raw_memory_region_s* region);
+
+    void* kaizen_memory_region_memory(struct kaizen_raw_memory_region_s const* region);
+
+    size_t kaizen_memory_region_size(struct kaizen_raw_memory_region_s const* region);
+
+    kaizen_memory_page_size_t kaizen_memory_region_page_size(struct kaizen_raw_memory_region_s const* region);
+
+    /**
+     * Returns the number of NUMA nodes, 1 on machines or platforms without
+     * NUMA support.
+     */
+    uint32_t kaizen_memory_numa_node_count(void);
+
+    /**
+     * Returns the NUMA node of the processor the calling thread runs on,
+     * 0 on machines or platforms without NUMA support.
+     */
+    uint32_t kaizen_memory_numa_node_of_current_thread(void);
+
+    /**
+     * Restricts the calling thread to the processors of @a numa_node.
+     *
+     * Returns EINVAL if @a numa_node does not exist. Without NUMA support
+     * only node 0 exists and binding to it leaves the thread unchanged.
+     */
+    int kaizen_memory_numa_bind_current_thread(uint32_t numa_node);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_raw_memory_H */
@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_memory.h with mmap.
+ *
+ * Huge pages use MAP_HUGETLB where available (Linux, needs reserved huge
+ * pages) and fall back to normal pages with a transparent huge page hint.
+ *
+ * NUMA placement is only supported on Linux: regions get a preferred node
+ * via mbind before they are touched, the topology is read from sysfs and
+ * threads are bound with sched_setaffinity. Other POSIX platforms have a
+ * single node.
+ *
+ * See http://www.opengroup.org/onlinepubs/000095399/functions/mmap.html
+ * See http://www.kernel.org/doc/Documentation/vm/hugetlbpage.txt
+ * See http://man7.org/linux/man-pages/man2/mbind.2.html
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "kaizen_raw_memory.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#   include <sched.h>
+#   include <sys/syscall.h>
+#endif
+
+#include "kaizen_stddef.h"
+
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#   define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Most common huge page size on x86-64 and ARM64 Linux. */
+#define KAIZEN_INTERNAL_MEMORY_HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
+
+/* From linux/mempolicy.h, not every libc ships numaif.h. */
+#define KAIZEN_INTERNAL_MEMORY_MPOL_PREFERRED 1
+
+
+
+static size_t kaizen_internal_memory_round_up(size_t size,
+                                              size_t page_size);
+size_t kaizen_internal_memory_round_up(size_t size,
+                                       size_t page_size)
+{
+    return ((size + page_size - 1) / page_size) * page_size;
+}
+
+
+
+static void* kaizen_internal_memory_map(size_t size,
+                                        int additional_flags);
+void* kaizen_internal_memory_map(size_t size,
+                                 int additional_flags)
+{
+    void* const memory = mmap(NULL,
+                              size,
+                              PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | additional_flags,
+                              -1,
+                              0);
+
+    return (MAP_FAILED == memory) ? NULL : memory;
+}
+
+
+
+#if defined(__linux__)
+
+/**
+ * Reads a sysfs list like "0-3,8-11" and calls @a func for every number,
+ * returns the highest number or -1.
+ */
+static long kaizen_internal_memory_read_list(char const* path,
+                                             void (*func)(long number, void* context),
+                                             void* context);
+long kaizen_internal_memory_read_list(char const* path,
+                                      void (*func)(long number, void* context),
+                                      void* context)
+{
+    FILE* const file = fopen(path, "r");
+
+    if (NULL == file) {
+        return -1;
+    }
+
+    long highest = -1;
+    long first = 0;
+    long last = 0;
+    int separator = 0;
+
+    while (1 == fscanf(file, "%ld", &first)) {
+        last = first;
+        separator = fgetc(file);
+
+        if ('-' == separator) {
+            if (1 != fscanf(file, "%ld", &last)) {
+                break;
+            }
+            separator = fgetc(file);
+        }
+
+        long number = 0;
+        for (number = first; number <= last; ++number) {
+            if (NULL != func) {
+                func(number, context);
+            }
+        }
+
+        highest = (last > highest) ? last : highest;
+
+        if (',' != separator) {
+            break;
+        }
+    }
+
+    (void)fclose(file);
+
+    return highest;
+}
+
+
+
+static void kaizen_internal_memory_add_cpu(long cpu,
+                                           void* cpu_set);
+void kaizen_internal_memory_add_cpu(long cpu,
+                                    void* cpu_set)
+{
+    if (0 <= cpu && CPU_SETSIZE > cpu) {
+        CPU_SET((int)cpu, (cpu_set_t*)cpu_set);
+    }
+}
+
+#endif
+
+
+
+int kaizen_memory_region_init(struct kaizen_raw_memory_region_s* region,
+                              size_t size,
+                              kaizen_memory_page_size_t requested_page_size)
+{
+    return kaizen_memory_region_init_on_numa_node(region,
+                                                  size,
+                                                  requested_page_size,
+                                                  KAIZEN_MEMORY_ANY_NUMA_NODE);
+}
+
+
+
+int kaizen_memory_region_init_on_numa_node(struct kaizen_raw_memory_region_s* region,
+                                           size_t size,
+                                           kaizen_memory_page_size_t requested_page_size,
+                                           uint32_t numa_node)
+{
+    assert(NULL != region);
+    assert(0 < size);
+
+    if (KAIZEN_MEMORY_ANY_NUMA_NODE != numa_node
+        && numa_node >= kaizen_memory_numa_node_count()) {
+
+        return EINVAL;
+    }
+
+    void* memory = NULL;
+    size_t mapped_size = 0;
+    kaizen_memory_page_size_t page_size = kaizen_memory_default_page_size;
+
+#if defined(MAP_HUGETLB)
+    if (kaizen_memory_huge_page_size == requested_page_size) {
+
+        mapped_size = kaizen_internal_memory_round_up(size,
+                                                      KAIZEN_INTERNAL_MEMORY_HUGE_PAGE_SIZE);
+        memory = kaizen_internal_memory_map(mapped_size, MAP_HUGETLB);
+        page_size = kaizen_memory_huge_page_size;
+    }
+#endif
+
+    if (NULL == memory) {
+
+        long const system_page_size = sysconf(_SC_PAGESIZE);
+
+        mapped_size = kaizen_internal_memory_round_up(size,
+                                                      (0 < system_page_size) ? (size_t)system_page_size : 4096);
+        memory = kaizen_internal_memory_map(mapped_size, 0);
+        page_size = kaizen_memory_default_page_size;
+
+        if (NULL == memory) {
+            return ENOMEM;
+        }
+
+#if defined(MADV_HUGEPAGE)
+        if (kaizen_memory_huge_page_size == requested_page_size) {
+            /* Only a hint - failing leaves normal pages in place. */
+            (void)madvise(memory, mapped_size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+#if defined(__linux__)
+    if (KAIZEN_MEMORY_ANY_NUMA_NODE != numa_node) {
+        unsigned long node_mask[4] = {0ul, 0ul, 0ul, 0ul};
+        size_t const bits_per_mask = 8 * sizeof(node_mask[0]);
+
+        if (numa_node < 4 * bits_per_mask) {
+            node_mask[numa_node / bits_per_mask] = 1ul << (numa_node % bits_per_mask);
+
+            /* Only a preference - a full node falls back to other nodes. */
+            (void)syscall(SYS_mbind,
+                          memory,
+                          mapped_size,
+                          KAIZEN_INTERNAL_MEMORY_MPOL_PREFERRED,
+                          node_mask,
+                          (unsigned long)(4 * bits_per_mask),
+                          0u);
+        }
+    }
+#endif
+
+    /* Touch every page now instead of page faulting while profiling. */
+    memset(memory, 0, mapped_size);
+
+    region->memory = memory;
+    region->size = mapped_size;
+    region->page_size = page_size;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_memory_region_finalize(struct kaizen_raw_memory_region_s* region)
+{
+    assert(NULL != region);
+
+    int const errc = munmap(region->memory, region->size);
+    assert(0 == errc);
+    (void)errc;
+
+    region->memory = NULL;
+    region->size = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+void* kaizen_memory_region_memory(struct kaizen_raw_memory_region_s const* region)
+{
+    assert(NULL != region);
+
+    return region->memory;
+}
+
+
+
+size_t kaizen_memory_region_size(struct kaizen_raw_memory_region_s const* region)
+{
+    assert(NULL != region);
+
+    return region->size;
+}
+
+
+
+kaizen_memory_page_size_t kaizen_memory_region_page_size(struct kaizen_raw_memory_region_s const* region)
+{
+    assert(NULL != region);
+
+    return region->page_size;
+}
+
+
+
+
+
+uint32_t kaizen_memory_numa_node_count(void)
+{
+#if defined(__linux__)
+    long const highest_node = kaizen_internal_memory_read_list("/sys/devices/system/node/possible", NULL, NULL);
+
+    if (0 < highest_node) {
+        return (uint32_t)highest_node + 1u;
+    }
+#endif
+
+    return 1u;
+}
+
+
+
+uint32_t kaizen_memory_numa_node_of_current_thread(void)
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+
+    if (0 == syscall(SYS_getcpu, &cpu, &node, NULL)) {
+        return (uint32_t)node;
+    }
+#endif
+
+    return 0u;
+}
+
+
+
+int kaizen_memory_numa_bind_current_thread(uint32_t numa_node)
+{
+    if (numa_node >= kaizen_memory_numa_node_count()) {
+        return EINVAL;
+    }
+
+#if defined(__linux__)
+    char path[64];
+    (void)snprintf(path, sizeof(path), "/sys/devices/system/node/node%lu/cpulist", (unsigned long)numa_node);
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+
+    if (0 > kaizen_internal_memory_read_list(path, kaizen_internal_memory_add_cpu, &cpu_set)) {
+        /* Kernels without NUMA support have no node directories. */
+        return (0u == numa_node) ? KAIZEN_SUCCESS : EINVAL;
+    }
+
+    if (0 != sched_setaffinity(0, sizeof(cpu_set), &cpu_set)) {
+        return errno;
+    }
+#endif
+
+    return KAIZEN_SUCCESS;
+}
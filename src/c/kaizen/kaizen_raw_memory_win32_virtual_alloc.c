@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_memory.h with VirtualAlloc.
+ *
+ * Large pages need the SeLockMemoryPrivilege of the process, without it
+ * normal pages are used.
+ *
+ * NUMA placement uses VirtualAllocExNuma and the processor of the calling
+ * thread, both need Windows Vista or later (_WIN32_WINNT 0x0600). Older
+ * targets place regions by default and report node 0 for every thread.
+ *
+ * See http://msdn.microsoft.com/en-us/library/aa366891(VS.85).aspx
+ * See http://msdn.microsoft.com/en-us/library/aa366887(VS.85).aspx
+ * See http://msdn.microsoft.com/en-us/library/aa366720(VS.85).aspx
+ */
+
+#include "kaizen_raw_memory.h"
+
+#include <windows.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "kaizen_stddef.h"
+
+
+
+static size_t kaizen_internal_memory_round_up(size_t size,
+                                              size_t page_size);
+size_t kaizen_internal_memory_round_up(size_t size,
+                                       size_t page_size)
+{
+    return ((size + page_size - 1) / page_size) * page_size;
+}
+
+
+
+#if defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0600)
+#   define KAIZEN_INTERNAL_MEMORY_HAS_NUMA_API 1
+#endif
+
+
+
+static void* kaizen_internal_memory_allocate(size_t size,
+                                             DWORD additional_flags,
+                                             uint32_t numa_node);
+void* kaizen_internal_memory_allocate(size_t size,
+                                      DWORD additional_flags,
+                                      uint32_t numa_node)
+{
+#if defined(KAIZEN_INTERNAL_MEMORY_HAS_NUMA_API)
+    if (KAIZEN_MEMORY_ANY_NUMA_NODE != numa_node) {
+        return VirtualAllocExNuma(GetCurrentProcess(),
+                                  NULL,
+                                  size,
+                                  MEM_RESERVE | MEM_COMMIT | additional_flags,
+                                  PAGE_READWRITE,
+                                  (DWORD)numa_node);
+    }
+#else
+    (void)numa_node;
+#endif
+
+    return VirtualAlloc(NULL,
+                        size,
+                        MEM_RESERVE | MEM_COMMIT | additional_flags,
+                        PAGE_READWRITE);
+}
+
+
+
+int kaizen_memory_region_init(struct kaizen_raw_memory_region_s* region,
+                              size_t size,
+                              kaizen_memory_page_size_t requested_page_size)
+{
+    return kaizen_memory_region_init_on_numa_node(region,
+                                                  size,
+                                                  requested_page_size,
+                                                  KAIZEN_MEMORY_ANY_NUMA_NODE);
+}
+
+
+
+int kaizen_memory_region_init_on_numa_node(struct kaizen_raw_memory_region_s* region,
+                                           size_t size,
+                                           kaizen_memory_page_size_t requested_page_size,
+                                           uint32_t numa_node)
+{
+    assert(NULL != region);
+    assert(0 < size);
+
+    if (KAIZEN_MEMORY_ANY_NUMA_NODE != numa_node
+        && numa_node >= kaizen_memory_numa_node_count()) {
+
+        return EINVAL;
+    }
+
+    void* memory = NULL;
+    size_t allocated_size = 0;
+    kaizen_memory_page_size_t page_size = kaizen_memory_default_page_size;
+
+    if (kaizen_memory_huge_page_size == requested_page_size) {
+
+        SIZE_T const large_page_size = GetLargePageMinimum();
+
+        if (0 != large_page_size) {
+            allocated_size = kaizen_internal_memory_round_up(size, large_page_size);
+            memory = kaizen_internal_memory_allocate(allocated_size, MEM_LARGE_PAGES, numa_node);
+            page_size = kaizen_memory_huge_page_size;
+        }
+    }
+
+    if (NULL == memory) {
+
+        SYSTEM_INFO system_info;
+        GetSystemInfo(&system_info);
+
+        allocated_size = kaizen_internal_memory_round_up(size, system_info.dwPageSize);
+        memory = kaizen_internal_memory_allocate(allocated_size, 0, numa_node);
+        page_size = kaizen_memory_default_page_size;
+
+        if (NULL == memory) {
+            return ENOMEM;
+        }
+    }
+
+    /* Touch every page now instead of page faulting while profiling. */
+    memset(memory, 0, allocated_size);
+
+    region->memory = memory;
+    region->size = allocated_size;
+    region->page_size = page_size;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_memory_region_finalize(struct kaizen_raw_memory_region_s* region)
+{
+    assert(NULL != region);
+
+    BOOL const errc = VirtualFree(region->memory, 0, MEM_RELEASE);
+    assert(FALSE != errc);
+    (void)errc;
+
+    region->memory = NULL;
+    region->size = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+void* kaizen_memory_region_memory(struct kaizen_raw_memory_region_s const* region)
+{
+    assert(NULL != region);
+
+    return region->memory;
+}
+
+
+
+size_t kaizen_memory_region_size(struct kaizen_raw_memory_region_s const* region)
+{
+    assert(NULL != region);
+
+    return region->size;
+}
+
+
+
+kaizen_memory_page_size_t kaizen_memory_region_page_size(struct kaizen_raw_memory_region_s const* region)
+{
+    assert(NULL != region);
+
+    return region->page_size;
+}
+
+
+
+
+
+uint32_t kaizen_memory_numa_node_count(void)
+{
+    ULONG highest_node = 0;
+
+    if (FALSE == GetNumaHighestNodeNumber(&highest_node)) {
+        return 1u;
+    }
+
+    return (uint32_t)highest_node + 1u;
+}
+
+
+
+uint32_t kaizen_memory_numa_node_of_current_thread(void)
+{
+#if defined(KAIZEN_INTERNAL_MEMORY_HAS_NUMA_API)
+    UCHAR node = 0;
+
+    if (FALSE != GetNumaProcessorNode((UCHAR)GetCurrentProcessorNumber(), &node)) {
+        return (uint32_t)node;
+    }
+#endif
+
+    return 0u;
+}
+
+
+
+int kaizen_memory_numa_bind_current_thread(uint32_t numa_node)
+{
+    if (numa_node >= kaizen_memory_numa_node_count()) {
+        return EINVAL;
+    }
+
+    ULONGLONG processor_mask = 0;
+
+    if (FALSE == GetNumaNodeProcessorMask((UCHAR)numa_node, &processor_mask)
+        || 0 == processor_mask) {
+
+        return EINVAL;
+    }
+
+    if (0 == SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)processor_mask)) {
+        return EINVAL;
+    }
+
+    return KAIZEN_SUCCESS;
+}
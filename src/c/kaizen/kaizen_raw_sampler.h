@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Opt-in statistical sampling profiler covering code nobody instrumented.
+ * A per thread timer interrupts the thread after each interval of its CPU
+ * time and captures the interrupted instruction pointer and a frame pointer
+ * walk of its stack, tagged with the innermost zone of the thread state
+ * attached to the thread (see kaizen_thread_state.h) and the frame number
+ * last marked with kaizen_sampler_mark_frame.
+ *
+ * Samples go into a lock-free buffer of the sampler without locks or
+ * allocations. Read them from any one thread, or record them as
+ * kaizen_sample_event_type events into the event buffer of the calling
+ * thread to store them with a capture. The overhead is fixed by the
+ * interval and bounded by the buffer capacity - samples of a full buffer
+ * are dropped and counted.
+ *
+ * Stacks are only walked through code compiled with frame pointers (e.g.
+ * -fno-omit-frame-pointer), otherwise samples contain fewer frames.
+ *
+ * Usage: define KAIZEN_USE_LINUX_SIGPROF and compile the source file ending
+ * in _linux_sigprof.c on Linux and link with -lrt on older C libraries. The
+ * sampler takes over the SIGPROF signal of the process. On other platforms
+ * compile the file ending in _generic_unsupported.c which reports ENOSYS.
+ */
+
+#ifndef KAIZEN_kaizen_raw_sampler_H
+#define KAIZEN_kaizen_raw_sampler_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_atomic.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_arena.h>
+
+#if defined(KAIZEN_USE_LINUX_SIGPROF)
+#   include <time.h>
+#endif
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Stack frames captured per sample, the interrupted instruction
+     * included.
+     */
+#define KAIZEN_SAMPLE_MAX_STACK_DEPTH 16
+
+    /**
+     * Zone id of samples taken outside of any tracked zone.
+     */
+#define KAIZEN_SAMPLE_NO_ZONE_ID 0xffffffffu
+
+
+
+    struct kaizen_sample_s {
+        struct kaizen_raw_frame_time_s time;
+        uint64_t frame_number;
+        uint32_t zone_id;
+        uint32_t stack_depth;
+        uint64_t stack[KAIZEN_SAMPLE_MAX_STACK_DEPTH];
+    };
+    typedef struct kaizen_sample_s kaizen_sample_t;
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_raw_sampler_s {
+        struct kaizen_sample_s* samples;
+        uint32_t capacity;
+        struct kaizen_atomic_uint32_s write_index;
+        struct kaizen_atomic_uint32_s read_index;
+        struct kaizen_atomic_uint32_s dropped_count;
+#if defined(KAIZEN_USE_LINUX_SIGPROF)
+        timer_t timer;
+        size_t stack_low;
+        size_t stack_high;
+#endif
+        kaizen_bool is_running;
+    };
+    typedef struct kaizen_raw_sampler_s kaizen_raw_sampler_t;
+
+
+
+    /**
+     * Initializes @a sampler for the calling thread with a buffer of
+     * @a capacity samples, a power of two, allocated from the persistent
+     * part of @a arena.
+     *
+     * Returns ENOMEM if the arena is full, ENOSYS if the platform does not
+     * support sampling, or the error of the platform (e.g. EAGAIN).
+     */
+    int kaizen_sampler_init_from_arena(struct kaizen_raw_sampler_s* sampler,
+                                       struct kaizen_arena_s* arena,
+                                       uint32_t capacity);
+
+    /**
+     * @a sampler must be stopped.
+     */
+    int kaizen_sampler_finalize(struct kaizen_raw_sampler_s* sampler);
+
+    /**
+     * Samples the thread that initialized @a sampler after each
+     * @a interval_nanoseconds of its CPU time, e.g. 1000000 for 1000
+     * samples per second of busy thread.
+     */
+    int kaizen_sampler_start(struct kaizen_raw_sampler_s* sampler,
+                             uint64_t interval_nanoseconds);
+
+    int kaizen_sampler_stop(struct kaizen_raw_sampler_s* sampler);
+
+    /**
+     * Takes the oldest sample out of the buffer of @a sampler. Only one
+     * thread at a time may read samples.
+     *
+     * Returns EAGAIN if the buffer is empty.
+     */
+    int kaizen_sampler_read(struct kaizen_raw_sampler_s* sampler,
+                            struct kaizen_sample_s* sample);
+
+    /**
+     * Takes all samples out of the buffer of @a sampler and records each as
+     * a kaizen_sample_event_type event followed by one
+     * kaizen_stack_frame_event_type event per stack frame into the event
+     * buffer attached to the calling thread (see kaizen_event.h).
+     *
+     * Returns ESRCH if the calling thread has no event buffer attached and
+     * ENOMEM if it is full.
+     */
+    int kaizen_sampler_record_events(struct kaizen_raw_sampler_s* sampler);
+
+    /**
+     * Returns the number of samples dropped because the buffer was full.
+     */
+    uint32_t kaizen_sampler_dropped_count(struct kaizen_raw_sampler_s const* sampler);
+
+    /**
+     * Tags samples of all threads taken from now on with @a frame_number,
+     * e.g. called by the main loop when it records its frame event.
+     */
+    void kaizen_sampler_mark_frame(uint64_t frame_number);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_raw_sampler_H */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_sampler.h for platforms without supported
+ * sampling. Initialization reports ENOSYS, reading finds no samples so code
+ * runs unchanged.
+ */
+
+#include "kaizen_raw_sampler.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_arena.h"
+
+
+
+int kaizen_sampler_init_from_arena(struct kaizen_raw_sampler_s* sampler,
+                                   struct kaizen_arena_s* arena,
+                                   uint32_t capacity)
+{
+    assert(NULL != sampler);
+    assert(NULL != arena);
+
+    sampler->samples = NULL;
+    sampler->capacity = capacity;
+    sampler->is_running = KAIZEN_FALSE;
+    kaizen_atomic_uint32_store_release(&(sampler->write_index), 0u);
+    kaizen_atomic_uint32_store_release(&(sampler->read_index), 0u);
+    kaizen_atomic_uint32_store_release(&(sampler->dropped_count), 0u);
+
+    return ENOSYS;
+}
+
+
+
+int kaizen_sampler_finalize(struct kaizen_raw_sampler_s* sampler)
+{
+    assert(NULL != sampler);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_sampler_start(struct kaizen_raw_sampler_s* sampler,
+                         uint64_t interval_nanoseconds)
+{
+    assert(NULL != sampler);
+    (void)interval_nanoseconds;
+
+    return ENOSYS;
+}
+
+
+
+int kaizen_sampler_stop(struct kaizen_raw_sampler_s* sampler)
+{
+    assert(NULL != sampler);
+
+    return ENOSYS;
+}
+
+
+
+int kaizen_sampler_read(struct kaizen_raw_sampler_s* sampler,
+                        struct kaizen_sample_s* sample)
+{
+    assert(NULL != sampler);
+    assert(NULL != sample);
+
+    return EAGAIN;
+}
+
+
+
+int kaizen_sampler_record_events(struct kaizen_raw_sampler_s* sampler)
+{
+    assert(NULL != sampler);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+uint32_t kaizen_sampler_dropped_count(struct kaizen_raw_sampler_s const* sampler)
+{
+    assert(NULL != sampler);
+
+    return 0u;
+}
+
+
+
+void kaizen_sampler_mark_frame(uint64_t frame_number)
+{
+    (void)frame_number;
+}
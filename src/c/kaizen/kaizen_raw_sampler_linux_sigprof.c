@@ -0,0 +1,374 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_sampler.h with a POSIX CPU time timer per
+ * thread (timer_create with CLOCK_THREAD_CPUTIME_ID) delivering SIGPROF to
+ * the sampled thread itself (SIGEV_THREAD_ID).
+ *
+ * The signal handler finds its sampler in the signal value of the timer,
+ * takes the instruction pointer and frame pointer from the interrupted
+ * context and walks the frame pointers inside the stack bounds of the
+ * thread, so stacks of fibers running on other stacks end after the
+ * instruction pointer. It only uses async-signal-safe operations: the frame
+ * time query, lock-free atomics and the thread local thread state pointer,
+ * which requires kaizen to be linked into the executable or a library using
+ * the initial-exec TLS model.
+ *
+ * The buffer is a single producer (the handler), single consumer ring.
+ *
+ * See http://man7.org/linux/man-pages/man2/timer_create.2.html
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "kaizen_raw_sampler.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_arena.h"
+#include "kaizen_event.h"
+#include "kaizen_raw_thread.h"
+#include "kaizen_thread_state.h"
+#include "kaizen_internal_frame_pointer_walk.h"
+
+
+
+static struct kaizen_atomic_uint64_s kaizen_internal_sampler_frame_number __attribute__((aligned(8))) = {0u};
+
+static pthread_once_t kaizen_internal_sampler_signal_once = PTHREAD_ONCE_INIT;
+
+static int kaizen_internal_sampler_signal_errc = KAIZEN_SUCCESS;
+
+
+
+static void kaizen_internal_sampler_take_sample(struct kaizen_raw_sampler_s* sampler,
+                                                ucontext_t const* context);
+void kaizen_internal_sampler_take_sample(struct kaizen_raw_sampler_s* sampler,
+                                         ucontext_t const* context)
+{
+    uint32_t const write_index = kaizen_atomic_uint32_load_acquire(&(sampler->write_index));
+    uint32_t const read_index = kaizen_atomic_uint32_load_acquire(&(sampler->read_index));
+
+    if (write_index - read_index >= sampler->capacity) {
+        (void)kaizen_atomic_uint32_fetch_add(&(sampler->dropped_count), 1u);
+
+        return;
+    }
+
+    struct kaizen_sample_s* const sample = &(sampler->samples[write_index & (sampler->capacity - 1u)]);
+
+    if (KAIZEN_SUCCESS != kaizen_frame_time_query(&(sample->time))) {
+        return;
+    }
+
+    sample->frame_number = kaizen_atomic_uint64_load_acquire(&kaizen_internal_sampler_frame_number);
+
+    struct kaizen_thread_state_s const* const state = kaizen_thread_state_of_current_thread();
+    sample->zone_id = (NULL != state && 0 < kaizen_thread_state_depth(state))
+        ? kaizen_thread_state_top_zone_id(state)
+        : KAIZEN_SAMPLE_NO_ZONE_ID;
+
+#if defined(__x86_64__)
+    size_t const instruction_pointer = (size_t)context->uc_mcontext.gregs[REG_RIP];
+    size_t const frame_pointer = (size_t)context->uc_mcontext.gregs[REG_RBP];
+#elif defined(__i386__)
+    size_t const instruction_pointer = (size_t)context->uc_mcontext.gregs[REG_EIP];
+    size_t const frame_pointer = (size_t)context->uc_mcontext.gregs[REG_EBP];
+#elif defined(__aarch64__)
+    size_t const instruction_pointer = (size_t)context->uc_mcontext.pc;
+    size_t const frame_pointer = (size_t)context->uc_mcontext.regs[29];
+#else
+#   error Unsupported architecture.
+#endif
+
+    sample->stack[0] = (uint64_t)instruction_pointer;
+    sample->stack_depth = 1u + kaizen_internal_frame_pointer_walk(frame_pointer,
+                                                                  sampler->stack_low,
+                                                                  sampler->stack_high,
+                                                                  &(sample->stack[1]),
+                                                                  KAIZEN_SAMPLE_MAX_STACK_DEPTH - 1u);
+
+    kaizen_atomic_uint32_store_release(&(sampler->write_index), write_index + 1u);
+}
+
+
+
+static void kaizen_internal_sampler_handle_signal(int signal_number,
+                                                  siginfo_t* info,
+                                                  void* context);
+void kaizen_internal_sampler_handle_signal(int signal_number,
+                                           siginfo_t* info,
+                                           void* context)
+{
+    (void)signal_number;
+
+    if (NULL == info || SI_TIMER != info->si_code || NULL == info->si_value.sival_ptr || NULL == context) {
+        return;
+    }
+
+    int const saved_errno = errno;
+
+    kaizen_internal_sampler_take_sample((struct kaizen_raw_sampler_s*)info->si_value.sival_ptr,
+                                        (ucontext_t const*)context);
+
+    errno = saved_errno;
+}
+
+
+
+static void kaizen_internal_sampler_install_signal_handler(void);
+void kaizen_internal_sampler_install_signal_handler(void)
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = kaizen_internal_sampler_handle_signal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    (void)sigemptyset(&(action.sa_mask));
+
+    if (0 != sigaction(SIGPROF, &action, NULL)) {
+        kaizen_internal_sampler_signal_errc = errno;
+    }
+}
+
+
+
+int kaizen_sampler_init_from_arena(struct kaizen_raw_sampler_s* sampler,
+                                   struct kaizen_arena_s* arena,
+                                   uint32_t capacity)
+{
+    assert(NULL != sampler);
+    assert(NULL != arena);
+
+    if (0u == capacity || 0u != (capacity & (capacity - 1u))) {
+        return EINVAL;
+    }
+
+    sampler->samples = NULL;
+    sampler->capacity = capacity;
+    sampler->is_running = KAIZEN_FALSE;
+    kaizen_atomic_uint32_store_release(&(sampler->write_index), 0u);
+    kaizen_atomic_uint32_store_release(&(sampler->read_index), 0u);
+    kaizen_atomic_uint32_store_release(&(sampler->dropped_count), 0u);
+
+    void* samples = NULL;
+    int errc = kaizen_arena_allocate_persistent(arena,
+                                                (size_t)capacity * sizeof(struct kaizen_sample_s),
+                                                sizeof(uint64_t),
+                                                &samples);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    sampler->samples = (struct kaizen_sample_s*)samples;
+
+    errc = kaizen_thread_stack_bounds(&(sampler->stack_low), &(sampler->stack_high));
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    (void)pthread_once(&kaizen_internal_sampler_signal_once, kaizen_internal_sampler_install_signal_handler);
+
+    if (KAIZEN_SUCCESS != kaizen_internal_sampler_signal_errc) {
+        return kaizen_internal_sampler_signal_errc;
+    }
+
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_value.sival_ptr = sampler;
+#if defined(sigev_notify_thread_id)
+    event.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+#else
+    event._sigev_un._tid = (pid_t)syscall(SYS_gettid);
+#endif
+
+    if (0 != timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &(sampler->timer))) {
+        return errno;
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_sampler_finalize(struct kaizen_raw_sampler_s* sampler)
+{
+    assert(NULL != sampler);
+    assert(KAIZEN_FALSE == sampler->is_running);
+
+    if (0 != timer_delete(sampler->timer)) {
+        return errno;
+    }
+
+    sampler->samples = NULL;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_sampler_start(struct kaizen_raw_sampler_s* sampler,
+                         uint64_t interval_nanoseconds)
+{
+    assert(NULL != sampler);
+    assert(KAIZEN_FALSE == sampler->is_running);
+
+    if (0 == interval_nanoseconds) {
+        return EINVAL;
+    }
+
+    struct itimerspec interval;
+    interval.it_interval.tv_sec = (time_t)(interval_nanoseconds / (uint64_t)1000000000);
+    interval.it_interval.tv_nsec = (long)(interval_nanoseconds % (uint64_t)1000000000);
+    interval.it_value = interval.it_interval;
+
+    if (0 != timer_settime(sampler->timer, 0, &interval, NULL)) {
+        return errno;
+    }
+
+    sampler->is_running = KAIZEN_TRUE;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_sampler_stop(struct kaizen_raw_sampler_s* sampler)
+{
+    assert(NULL != sampler);
+    assert(KAIZEN_TRUE == sampler->is_running);
+
+    struct itimerspec disarmed;
+    memset(&disarmed, 0, sizeof(disarmed));
+
+    if (0 != timer_settime(sampler->timer, 0, &disarmed, NULL)) {
+        return errno;
+    }
+
+    sampler->is_running = KAIZEN_FALSE;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_sampler_read(struct kaizen_raw_sampler_s* sampler,
+                        struct kaizen_sample_s* sample)
+{
+    assert(NULL != sampler);
+    assert(NULL != sample);
+
+    uint32_t const read_index = kaizen_atomic_uint32_load_acquire(&(sampler->read_index));
+    uint32_t const write_index = kaizen_atomic_uint32_load_acquire(&(sampler->write_index));
+
+    if (read_index == write_index) {
+        return EAGAIN;
+    }
+
+    *sample = sampler->samples[read_index & (sampler->capacity - 1u)];
+
+    kaizen_atomic_uint32_store_release(&(sampler->read_index), read_index + 1u);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_sampler_record_events(struct kaizen_raw_sampler_s* sampler)
+{
+    assert(NULL != sampler);
+
+    struct kaizen_raw_frame_time_s const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+    struct kaizen_sample_s sample;
+
+    while (KAIZEN_SUCCESS == kaizen_sampler_read(sampler, &sample)) {
+        int errc = kaizen_event_record_with_flags(kaizen_sample_event_type,
+                                                  sample.zone_id,
+                                                  &(sample.time),
+                                                  &zero,
+                                                  sample.frame_number,
+                                                  (uint16_t)sample.stack_depth);
+
+        uint32_t i = 0;
+        for (i = 0; i < sample.stack_depth && KAIZEN_SUCCESS == errc; ++i) {
+            errc = kaizen_event_record_with_flags(kaizen_stack_frame_event_type,
+                                                  sample.zone_id,
+                                                  &(sample.time),
+                                                  &zero,
+                                                  sample.stack[i],
+                                                  (uint16_t)i);
+        }
+
+        if (KAIZEN_SUCCESS != errc) {
+            return errc;
+        }
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+uint32_t kaizen_sampler_dropped_count(struct kaizen_raw_sampler_s const* sampler)
+{
+    assert(NULL != sampler);
+
+    return kaizen_atomic_uint32_load_acquire(&(sampler->dropped_count));
+}
+
+
+
+void kaizen_sampler_mark_frame(uint64_t frame_number)
+{
+    kaizen_atomic_uint64_store_release(&kaizen_internal_sampler_frame_number, frame_number);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Per thread scheduling monitor counting how often the thread was switched
+ * out and moved to another processor (migrations), so zones can flag
+ * executions the scheduler interrupted. Such executions measure the
+ * scheduler instead of the code and distort high percentiles.
+ *
+ * Involuntary context switches (the scheduler preempted the thread) and
+ * voluntary ones (the thread blocked, e.g. on a lock, I/O or a sleep) are
+ * counted separately. Only the former interrupt the code, the latter are
+ * part of what it does.
+ *
+ * Attach a monitor to the thread that initialized it and every sampled zone
+ * (see kaizen_zone.h) it runs sets KAIZEN_ZONE_EVENT_DESCHEDULED_FLAG,
+ * KAIZEN_ZONE_EVENT_BLOCKED_FLAG and KAIZEN_ZONE_EVENT_MIGRATED_FLAG of its
+ * zone event (see kaizen_event.h). Reading costs two system calls at zone
+ * begin and end, so attach monitors to threads under investigation.
+ *
+ * Usage: define KAIZEN_USE_LINUX_PERF_EVENT and compile the source file
+ * ending in _linux_perf_event.c on Linux. Counting migrations needs a
+ * /proc/sys/kernel/perf_event_paranoid setting of 1 or less, init reports
+ * EACCES otherwise. On other platforms compile the file ending in
+ * _generic_unsupported.c which reports ENOSYS.
+ */
+
+#ifndef KAIZEN_kaizen_raw_scheduling_monitor_H
+#define KAIZEN_kaizen_raw_scheduling_monitor_H
+
+
+#include <kaizen/kaizen_stddef.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    struct kaizen_scheduling_counts_s {
+        uint64_t involuntary_context_switch_count;
+        uint64_t voluntary_context_switch_count;
+        uint64_t migration_count;
+    };
+    typedef struct kaizen_scheduling_counts_s kaizen_scheduling_counts_t;
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_raw_scheduling_monitor_s {
+#if defined(KAIZEN_USE_LINUX_PERF_EVENT)
+        int migration_file_descriptor;
+#endif
+        kaizen_bool is_enabled;
+    };
+    typedef struct kaizen_raw_scheduling_monitor_s kaizen_raw_scheduling_monitor_t;
+
+
+
+    /**
+     * Starts counting the context switches and migrations of the calling
+     * thread.
+     *
+     * Returns ENOSYS if the platform offers no counts, or the error of the
+     * platform (e.g. EACCES if perf_event_paranoid is greater than 1).
+     */
+    int kaizen_scheduling_monitor_init(struct kaizen_raw_scheduling_monitor_s* monitor);
+
+    int kaizen_scheduling_monitor_finalize(struct kaizen_raw_scheduling_monitor_s* monitor);
+
+    /**
+     * Reads the counts since initialization. Only call from the thread that
+     * initialized @a monitor.
+     */
+    int kaizen_scheduling_monitor_read(struct kaizen_raw_scheduling_monitor_s const* monitor,
+                                       struct kaizen_scheduling_counts_s* result);
+
+    /**
+     * Attaches @a monitor to the calling thread so sampled zones flag
+     * interrupted executions. Pass NULL to detach the current monitor.
+     */
+    int kaizen_scheduling_monitor_attach_to_current_thread(struct kaizen_raw_scheduling_monitor_s* monitor);
+
+    /**
+     * Returns the monitor attached to the calling thread or NULL.
+     */
+    struct kaizen_raw_scheduling_monitor_s* kaizen_scheduling_monitor_of_current_thread(void);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_raw_scheduling_monitor_H */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_scheduling_monitor.h for platforms without
+ * supported scheduling counts. Initialization reports ENOSYS, attaching
+ * monitors is still possible so code runs unchanged.
+ */
+
+#include "kaizen_raw_scheduling_monitor.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_internal_thread_local.h"
+
+
+
+static KAIZEN_THREAD_LOCAL struct kaizen_raw_scheduling_monitor_s* kaizen_internal_current_thread_scheduling_monitor = NULL;
+
+
+
+int kaizen_scheduling_monitor_init(struct kaizen_raw_scheduling_monitor_s* monitor)
+{
+    assert(NULL != monitor);
+
+    monitor->is_enabled = KAIZEN_FALSE;
+
+    return ENOSYS;
+}
+
+
+
+int kaizen_scheduling_monitor_finalize(struct kaizen_raw_scheduling_monitor_s* monitor)
+{
+    assert(NULL != monitor);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_scheduling_monitor_read(struct kaizen_raw_scheduling_monitor_s const* monitor,
+                                   struct kaizen_scheduling_counts_s* result)
+{
+    assert(NULL != monitor);
+    assert(NULL != result);
+
+    result->involuntary_context_switch_count = 0u;
+    result->voluntary_context_switch_count = 0u;
+    result->migration_count = 0u;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_scheduling_monitor_attach_to_current_thread(struct kaizen_raw_scheduling_monitor_s* monitor)
+{
+    kaizen_internal_current_thread_scheduling_monitor = monitor;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+struct kaizen_raw_scheduling_monitor_s* kaizen_scheduling_monitor_of_current_thread(void)
+{
+    return kaizen_internal_current_thread_scheduling_monitor;
+}
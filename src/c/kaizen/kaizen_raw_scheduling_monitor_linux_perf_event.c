@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_scheduling_monitor.h on Linux.
+ *
+ * The context switch software event of perf_event_open counts voluntary
+ * switches too, e.g. waiting on a lock, so the voluntary and involuntary
+ * switches of the thread are read with getrusage(RUSAGE_THREAD) instead.
+ * Migrations are counted with the CPU migrations software event.
+ *
+ * Migrations happen in the kernel, so the event must not exclude it. That
+ * needs a perf_event_paranoid setting of 1 or less
+ * (/proc/sys/kernel/perf_event_paranoid), otherwise opening fails with
+ * EACCES unless the process has CAP_PERFMON or CAP_SYS_ADMIN.
+ *
+ * See http://man7.org/linux/man-pages/man2/perf_event_open.2.html and
+ * http://man7.org/linux/man-pages/man2/getrusage.2.html
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "kaizen_raw_scheduling_monitor.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_internal_thread_local.h"
+
+
+
+static KAIZEN_THREAD_LOCAL struct kaizen_raw_scheduling_monitor_s* kaizen_internal_current_thread_scheduling_monitor = NULL;
+
+
+
+static int kaizen_internal_migration_event_open(void);
+int kaizen_internal_migration_event_open(void)
+{
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_SOFTWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_SW_CPU_MIGRATIONS;
+    attributes.exclude_hv = 1;
+
+    /* Calling thread on any CPU. */
+    return (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+}
+
+
+
+int kaizen_scheduling_monitor_init(struct kaizen_raw_scheduling_monitor_s* monitor)
+{
+    assert(NULL != monitor);
+
+    monitor->is_enabled = KAIZEN_FALSE;
+    monitor->migration_file_descriptor = kaizen_internal_migration_event_open();
+
+    if (0 > monitor->migration_file_descriptor) {
+        return errno;
+    }
+
+    monitor->is_enabled = KAIZEN_TRUE;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_scheduling_monitor_finalize(struct kaizen_raw_scheduling_monitor_s* monitor)
+{
+    assert(NULL != monitor);
+
+    if (KAIZEN_TRUE == monitor->is_enabled) {
+        (void)close(monitor->migration_file_descriptor);
+    }
+
+    monitor->migration_file_descriptor = -1;
+    monitor->is_enabled = KAIZEN_FALSE;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_scheduling_monitor_read(struct kaizen_raw_scheduling_monitor_s const* monitor,
+                                   struct kaizen_scheduling_counts_s* result)
+{
+    assert(NULL != monitor);
+    assert(NULL != result);
+
+    if (KAIZEN_TRUE != monitor->is_enabled) {
+        return EINVAL;
+    }
+
+    struct rusage usage;
+
+    if (0 != getrusage(RUSAGE_THREAD, &usage)) {
+        return errno;
+    }
+
+    uint64_t migration_count = 0u;
+    ssize_t const size = read(monitor->migration_file_descriptor, &migration_count, sizeof(migration_count));
+
+    if ((ssize_t)sizeof(migration_count) != size) {
+        return (0 > size) ? errno : EIO;
+    }
+
+    result->involuntary_context_switch_count = (uint64_t)usage.ru_nivcsw;
+    result->voluntary_context_switch_count = (uint64_t)usage.ru_nvcsw;
+    result->migration_count = migration_count;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_scheduling_monitor_attach_to_current_thread(struct kaizen_raw_scheduling_monitor_s* monitor)
+{
+    kaizen_internal_current_thread_scheduling_monitor = monitor;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+struct kaizen_raw_scheduling_monitor_s* kaizen_scheduling_monitor_of_current_thread(void)
+{
+    return kaizen_internal_current_thread_scheduling_monitor;
+}
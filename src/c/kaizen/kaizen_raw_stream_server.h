@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Optional background server streaming events to one connected viewer over
+ * a Unix domain socket or a localhost TCP connection, e.g. to watch a
+ * running game server live without writing captures.
+ *
+ * Threads submit events which are encoded (see kaizen_event_encoding.h)
+ * into blocks of a bounded queue (see kaizen_block_queue.h). The server
+ * thread sends the stream header to each viewer that connects followed by
+ * the queued blocks. Enable kaizen_stream_server_set_compressed to send
+ * compressed blocks, about half the size, e.g. to stream more events over
+ * a slow connection at the cost of a few nanoseconds per submitted event.
+ *
+ * Submitting never blocks: if the viewer reads slower than events are
+ * submitted the queue fills up and further events are dropped and counted.
+ * Events submitted while no viewer is connected are discarded.
+ *
+ * Usage: define KAIZEN_USE_POSIX_THREADS and compile the source file ending
+ * in _posix_threads.c (Unix domain sockets and TCP), or define
+ * KAIZEN_USE_WIN32_THREADS and compile the file ending in _win32.c (TCP via
+ * Winsock, link with ws2_32.lib).
+ */
+
+#ifndef KAIZEN_kaizen_raw_stream_server_H
+#define KAIZEN_kaizen_raw_stream_server_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_atomic.h>
+#include <kaizen/kaizen_raw_thread.h>
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_block_queue.h>
+#include <kaizen/kaizen_event.h>
+
+
+#if defined(KAIZEN_USE_POSIX_THREADS)
+    /* No platform headers needed, sockets are plain file descriptors. */
+#elif defined(KAIZEN_USE_WIN32_THREADS)
+#   include <winsock2.h>
+#else
+#   error Unsupported platform.
+#endif
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_raw_stream_server_s {
+        struct kaizen_atomic_uint64_s dropped_event_count;
+        struct kaizen_block_queue_s queue;
+        struct kaizen_raw_thread_s thread;
+        struct kaizen_atomic_uint32_s is_running;
+        struct kaizen_atomic_uint32_s is_connected;
+        struct kaizen_atomic_uint32_s is_compressed;
+        uint64_t ticks_per_second;
+#if defined(KAIZEN_USE_POSIX_THREADS)
+        int listen_socket;
+        int client_socket;
+        char unix_socket_path[108];
+#elif defined(KAIZEN_USE_WIN32_THREADS)
+        SOCKET listen_socket;
+        SOCKET client_socket;
+#else
+#   error Unsupported platform.
+#endif
+        uint16_t port;
+    };
+    typedef struct kaizen_raw_stream_server_s kaizen_raw_stream_server_t;
+
+
+
+    /**
+     * Starts a server listening on the Unix domain socket at @a path,
+     * replacing an existing socket file. The queue of @a block_count blocks
+     * of @a block_size bytes is allocated from @a arena.
+     *
+     * @a block_count must be a power of two, @a block_size must be large
+     * enough for at least one encoded event (see kaizen_event_encoding.h).
+     *
+     * Returns ENOSYS if Unix domain sockets are not supported, EINVAL if the
+     * path is too long and ENOMEM if the arena is full.
+     */
+    int kaizen_stream_server_init_unix_socket(struct kaizen_raw_stream_server_s* server,
+                                              struct kaizen_arena_s* arena,
+                                              char const* path,
+                                              uint32_t block_count,
+                                              size_t block_size);
+
+    /**
+     * Starts a server listening on 127.0.0.1 at @a port. Pass 0 to let the
+     * system choose a free port and query it via kaizen_stream_server_port.
+     *
+     * See kaizen_stream_server_init_unix_socket for the other parameters.
+     */
+    int kaizen_stream_server_init_tcp(struct kaizen_raw_stream_server_s* server,
+                                      struct kaizen_arena_s* arena,
+                                      uint16_t port,
+                                      uint32_t block_count,
+                                      size_t block_size);
+
+    /**
+     * Stops the server thread and disconnects the viewer. Blocks still
+     * queued are discarded.
+     */
+    int kaizen_stream_server_finalize(struct kaizen_raw_stream_server_s* server);
+
+    /**
+     * Returns the TCP port the server listens on or 0 for Unix domain
+     * sockets.
+     */
+    uint16_t kaizen_stream_server_port(struct kaizen_raw_stream_server_s const* server);
+
+    kaizen_bool kaizen_stream_server_is_connected(struct kaizen_raw_stream_server_s const* server);
+
+    /**
+     * Encodes submitted events as compressed blocks (see
+     * kaizen_event_block_encode_compressed) if @a is_compressed is
+     * KAIZEN_TRUE. Blocks are not compressed by default. Can be called while
+     * streaming, viewers read both kinds of blocks. Blocks too small to
+     * hold a compressed event are sent uncompressed.
+     */
+    int kaizen_stream_server_set_compressed(struct kaizen_raw_stream_server_s* server,
+                                            kaizen_bool is_compressed);
+
+    /**
+     * Encodes and queues @a event_count @a events for streaming, tagged with
+     * @a stream_id (e.g. the index of the producing thread). Can be called
+     * by multiple threads concurrently and never blocks.
+     *
+     * Returns ESRCH if no viewer is connected, EAGAIN if the queue is full
+     * and some or all events have been dropped.
+     */
+    int kaizen_stream_server_submit(struct kaizen_raw_stream_server_s* server,
+                                    uint32_t stream_id,
+                                    struct kaizen_event_s const* events,
+                                    size_t event_count);
+
+    /**
+     * Returns the number of events dropped because the queue was full.
+     */
+    uint64_t kaizen_stream_server_dropped_event_count(struct kaizen_raw_stream_server_s const* server);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_raw_stream_server_H */
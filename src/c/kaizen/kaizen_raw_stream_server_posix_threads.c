@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_stream_server.h with pthreads and BSD
+ * sockets.
+ *
+ * The server thread polls with short timeouts so it notices finalization
+ * while waiting for a viewer or for a slow viewer to accept more data.
+ *
+ * See http://www.opengroup.org/onlinepubs/000095399/functions/poll.html
+ */
+
+#include "kaizen_raw_stream_server.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_raw_thread.h"
+#include "kaizen_arena.h"
+#include "kaizen_block_queue.h"
+#include "kaizen_event.h"
+#include "kaizen_event_encoding.h"
+
+
+#if defined(MSG_NOSIGNAL)
+#   define KAIZEN_INTERNAL_SEND_FLAGS MSG_NOSIGNAL
+#else
+#   define KAIZEN_INTERNAL_SEND_FLAGS 0
+#endif
+
+#define KAIZEN_INTERNAL_STREAM_SERVER_POLL_MILLISECONDS 10
+
+
+
+static int kaizen_internal_stream_server_send_all(struct kaizen_raw_stream_server_s* server,
+                                                  uint8_t const* data,
+                                                  size_t size);
+int kaizen_internal_stream_server_send_all(struct kaizen_raw_stream_server_s* server,
+                                           uint8_t const* data,
+                                           size_t size)
+{
+    while (0 < size) {
+
+        ssize_t const sent = send(server->client_socket,
+                                  data,
+                                  size,
+                                  KAIZEN_INTERNAL_SEND_FLAGS);
+
+        if (0 < sent) {
+            data += sent;
+            size -= (size_t)sent;
+            continue;
+        }
+
+        if (0 > sent && (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno)) {
+
+            if (0u == kaizen_atomic_uint32_load_acquire(&(server->is_running))) {
+                return EINTR;
+            }
+
+            /* Slow viewer - wait here while producers fill the queue. */
+            struct pollfd client_poll;
+            client_poll.fd = server->client_socket;
+            client_poll.events = POLLOUT;
+            client_poll.revents = 0;
+            (void)poll(&client_poll, 1, KAIZEN_INTERNAL_STREAM_SERVER_POLL_MILLISECONDS);
+
+            continue;
+        }
+
+        return EPIPE;
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+static void kaizen_internal_stream_server_disconnect(struct kaizen_raw_stream_server_s* server);
+void kaizen_internal_stream_server_disconnect(struct kaizen_raw_stream_server_s* server)
+{
+    kaizen_atomic_uint32_store_release(&(server->is_connected), 0u);
+
+    if (0 <= server->client_socket) {
+        (void)close(server->client_socket);
+        server->client_socket = -1;
+    }
+}
+
+
+
+static void kaizen_internal_stream_server_accept(struct kaizen_raw_stream_server_s* server);
+void kaizen_internal_stream_server_accept(struct kaizen_raw_stream_server_s* server)
+{
+    struct pollfd listen_poll;
+    listen_poll.fd = server->listen_socket;
+    listen_poll.events = POLLIN;
+    listen_poll.revents = 0;
+
+    if (0 >= poll(&listen_poll, 1, KAIZEN_INTERNAL_STREAM_SERVER_POLL_MILLISECONDS)) {
+        return;
+    }
+
+    int const client_socket = accept(server->listen_socket, NULL, NULL);
+
+    if (0 > client_socket) {
+        return;
+    }
+
+#if defined(SO_NOSIGPIPE)
+    int const no_sigpipe = 1;
+    (void)setsockopt(client_socket, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+    (void)fcntl(client_socket, F_SETFL, fcntl(client_socket, F_GETFL, 0) | O_NONBLOCK);
+
+    server->client_socket = client_socket;
+
+    uint8_t header[KAIZEN_EVENT_STREAM_HEADER_SIZE];
+    (void)kaizen_event_stream_header_encode(server->ticks_per_second,
+                                            header,
+                                            sizeof(header));
+
+    if (KAIZEN_SUCCESS != kaizen_internal_stream_server_send_all(server, header, sizeof(header))) {
+        kaizen_internal_stream_server_disconnect(server);
+
+        return;
+    }
+
+    kaizen_atomic_uint32_store_release(&(server->is_connected), 1u);
+}
+
+
+
+static void kaizen_internal_stream_server_run(void* context);
+void kaizen_internal_stream_server_run(void* context)
+{
+    struct kaizen_raw_stream_server_s* const server = (struct kaizen_raw_stream_server_s*)context;
+
+    while (0u != kaizen_atomic_uint32_load_acquire(&(server->is_running))) {
+
+        uint8_t const* block = NULL;
+        size_t size = 0;
+        int const errc = kaizen_block_queue_try_pop_begin(&(server->queue), &block, &size);
+
+        if (0 > server->client_socket) {
+
+            /* Discard blocks submitted before the last viewer left. */
+            if (KAIZEN_SUCCESS == errc) {
+                kaizen_block_queue_pop_end(&(server->queue));
+            } else {
+                kaizen_internal_stream_server_accept(server);
+            }
+
+            continue;
+        }
+
+        if (KAIZEN_SUCCESS != errc) {
+            (void)kaizen_thread_sleep_milliseconds(1);
+
+            continue;
+        }
+
+        if (KAIZEN_SUCCESS != kaizen_internal_stream_server_send_all(server, block, size)) {
+            kaizen_internal_stream_server_disconnect(server);
+        }
+
+        kaizen_block_queue_pop_end(&(server->queue));
+    }
+
+    kaizen_internal_stream_server_disconnect(server);
+}
+
+
+
+static int kaizen_internal_stream_server_start(struct kaizen_raw_stream_server_s* server,
+                                               struct kaizen_arena_s* arena,
+                                               uint32_t block_count,
+                                               size_t block_size);
+int kaizen_internal_stream_server_start(struct kaizen_raw_stream_server_s* server,
+                                        struct kaizen_arena_s* arena,
+                                        uint32_t block_count,
+                                        size_t block_size)
+{
+    if (0 != listen(server->listen_socket, 1)) {
+        return errno;
+    }
+
+    int errc = kaizen_frame_time_query_ticks_per_second(&(server->ticks_per_second));
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    errc = kaizen_block_queue_init_from_arena(&(server->queue),
+                                              arena,
+                                              block_count,
+                                              block_size);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    server->client_socket = -1;
+    kaizen_atomic_uint64_store_release(&(server->dropped_event_count), 0u);
+    kaizen_atomic_uint32_store_release(&(server->is_connected), 0u);
+    kaizen_atomic_uint32_store_release(&(server->is_compressed), 0u);
+    kaizen_atomic_uint32_store_release(&(server->is_running), 1u);
+
+    errc = kaizen_thread_launch(&(server->thread),
+                                kaizen_internal_stream_server_run,
+                                server);
+
+    if (KAIZEN_SUCCESS != errc) {
+        (void)kaizen_block_queue_finalize(&(server->queue));
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_stream_server_init_unix_socket(struct kaizen_raw_stream_server_s* server,
+                                          struct kaizen_arena_s* arena,
+                                          char const* path,
+                                          uint32_t block_count,
+                                          size_t block_size)
+{
+    assert(NULL != server);
+    assert(NULL != arena);
+    assert(NULL != path);
+    assert(KAIZEN_EVENT_BLOCK_HEADER_SIZE + KAIZEN_EVENT_ENCODED_MAX_SIZE <= block_size);
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+
+    if (sizeof(address.sun_path) <= strlen(path)
+        || sizeof(server->unix_socket_path) <= strlen(path)) {
+
+        return EINVAL;
+    }
+
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    server->listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (0 > server->listen_socket) {
+        return errno;
+    }
+
+    (void)unlink(path);
+
+    if (0 != bind(server->listen_socket, (struct sockaddr const*)&address, sizeof(address))) {
+        int const errc = errno;
+        (void)close(server->listen_socket);
+
+        return errc;
+    }
+
+    strcpy(server->unix_socket_path, path);
+    server->port = 0;
+
+    int const errc = kaizen_internal_stream_server_start(server, arena, block_count, block_size);
+
+    if (KAIZEN_SUCCESS != errc) {
+        (void)close(server->listen_socket);
+        (void)unlink(path);
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_stream_server_init_tcp(struct kaizen_raw_stream_server_s* server,
+                                  struct kaizen_arena_s* arena,
+                                  uint16_t port,
+                                  uint32_t block_count,
+                                  size_t block_size)
+{
+    assert(NULL != server);
+    assert(NULL != arena);
+    assert(KAIZEN_EVENT_BLOCK_HEADER_SIZE + KAIZEN_EVENT_ENCODED_MAX_SIZE <= block_size);
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    server->listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (0 > server->listen_socket) {
+        return errno;
+    }
+
+    int const reuse_address = 1;
+    (void)setsockopt(server->listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse_address, sizeof(reuse_address));
+
+    socklen_t address_size = sizeof(address);
+
+    if (0 != bind(server->listen_socket, (struct sockaddr const*)&address, sizeof(address))
+        || 0 != getsockname(server->listen_socket, (struct sockaddr*)&address, &address_size)) {
+
+        int const errc = errno;
+        (void)close(server->listen_socket);
+
+        return errc;
+    }
+
+    server->unix_socket_path[0] = '\0';
+    server->port = ntohs(address.sin_port);
+
+    int const errc = kaizen_internal_stream_server_start(server, arena, block_count, block_size);
+
+    if (KAIZEN_SUCCESS != errc) {
+        (void)close(server->listen_socket);
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_stream_server_finalize(struct kaizen_raw_stream_server_s* server)
+{
+    assert(NULL != server);
+
+    kaizen_atomic_uint32_store_release(&(server->is_running), 0u);
+
+    int const errc = kaizen_thread_join(&(server->thread));
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    (void)close(server->listen_socket);
+    server->listen_socket = -1;
+
+    if ('\0' != server->unix_socket_path[0]) {
+        (void)unlink(server->unix_socket_path);
+    }
+
+    return kaizen_block_queue_finalize(&(server->queue));
+}
+
+
+
+uint16_t kaizen_stream_server_port(struct kaizen_raw_stream_server_s const* server)
+{
+    assert(NULL != server);
+
+    return server->port;
+}
+
+
+
+kaizen_bool kaizen_stream_server_is_connected(struct kaizen_raw_stream_server_s const* server)
+{
+    assert(NULL != server);
+
+    return (0u != kaizen_atomic_uint32_load_acquire(&(server->is_connected))) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+int kaizen_stream_server_set_compressed(struct kaizen_raw_stream_server_s* server,
+                                        kaizen_bool is_compressed)
+{
+    assert(NULL != server);
+
+    kaizen_atomic_uint32_store_release(&(server->is_compressed), (KAIZEN_TRUE == is_compressed) ? 1u : 0u);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_stream_server_submit(struct kaizen_raw_stream_server_s* server,
+                                uint32_t stream_id,
+                                struct kaizen_event_s const* events,
+                                size_t event_count)
+{
+    assert(NULL != server);
+    assert(NULL != events || 0 == event_count);
+
+    if (0u == kaizen_atomic_uint32_load_acquire(&(server->is_connected))) {
+        return ESRCH;
+    }
+
+    while (0 < event_count) {
+
+        uint8_t* block = NULL;
+        uint32_t ticket = 0;
+
+        if (KAIZEN_SUCCESS != kaizen_block_queue_try_push_begin(&(server->queue), &block, &ticket)) {
+
+            (void)kaizen_atomic_uint64_fetch_add(&(server->dropped_event_count), event_count);
+
+            return EAGAIN;
+        }
+
+        size_t encoded_event_count = 0;
+        size_t encoded_size = 0;
+        int errc = ENOMEM;
+
+        if (0u != kaizen_atomic_uint32_load_acquire(&(server->is_compressed))) {
+            errc = kaizen_event_block_encode_compressed(stream_id,
+                                                        events,
+                                                        event_count,
+                                                        block,
+                                                        kaizen_block_queue_block_size(&(server->queue)),
+                                                        &encoded_event_count,
+                                                        &encoded_size);
+        }
+
+        /* Blocks too small for a compressed event stay uncompressed. */
+        if (KAIZEN_SUCCESS != errc) {
+            errc = kaizen_event_block_encode(stream_id,
+                                             events,
+                                             event_count,
+                                             block,
+                                             kaizen_block_queue_block_size(&(server->queue)),
+                                             &encoded_event_count,
+                                             &encoded_size);
+        }
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        kaizen_block_queue_push_end(&(server->queue), ticket, encoded_size);
+
+        events += encoded_event_count;
+        event_count -= encoded_event_count;
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+uint64_t kaizen_stream_server_dropped_event_count(struct kaizen_raw_stream_server_s const* server)
+{
+    assert(NULL != server);
+
+    return kaizen_atomic_uint64_load_acquire(&(server->dropped_event_count));
+}
+
+
@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_stream_server.h with Win32 threads and
+ * Winsock. Unix domain sockets are not supported.
+ *
+ * The server thread polls with short timeouts so it notices finalization
+ * while waiting for a viewer or for a slow viewer to accept more data.
+ *
+ * See http://msdn.microsoft.com/en-us/library/ms740141(VS.85).aspx
+ */
+
+#include "kaizen_raw_stream_server.h"
+
+#include <winsock2.h>
+#include <windows.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_raw_thread.h"
+#include "kaizen_arena.h"
+#include "kaizen_block_queue.h"
+#include "kaizen_event.h"
+#include "kaizen_event_encoding.h"
+
+
+#define KAIZEN_INTERNAL_STREAM_SERVER_POLL_MILLISECONDS 10
+
+
+
+static kaizen_bool kaizen_internal_stream_server_wait(SOCKET socket_handle,
+                                                      kaizen_bool wait_for_write);
+kaizen_bool kaizen_internal_stream_server_wait(SOCKET socket_handle,
+                                               kaizen_bool wait_for_write)
+{
+    fd_set sockets;
+    FD_ZERO(&sockets);
+    FD_SET(socket_handle, &sockets);
+
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = KAIZEN_INTERNAL_STREAM_SERVER_POLL_MILLISECONDS * 1000;
+
+    int const result = select(0,
+                              (KAIZEN_FALSE == wait_for_write) ? &sockets : NULL,
+                              (KAIZEN_FALSE == wait_for_write) ? NULL : &sockets,
+                              NULL,
+                              &timeout);
+
+    return (0 < result) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+static int kaizen_internal_stream_server_send_all(struct kaizen_raw_stream_server_s* server,
+                                                  uint8_t const* data,
+                                                  size_t size);
+int kaizen_internal_stream_server_send_all(struct kaizen_raw_stream_server_s* server,
+                                           uint8_t const* data,
+                                           size_t size)
+{
+    while (0 < size) {
+
+        int const sent = send(server->client_socket,
+                              (char const*)data,
+                              (int)size,
+                              0);
+
+        if (0 < sent) {
+            data += sent;
+            size -= (size_t)sent;
+            continue;
+        }
+
+        if (SOCKET_ERROR == sent && WSAEWOULDBLOCK == WSAGetLastError()) {
+
+            if (0u == kaizen_atomic_uint32_load_acquire(&(server->is_running))) {
+                return EINTR;
+            }
+
+            /* Slow viewer - wait here while producers fill the queue. */
+            (void)kaizen_internal_stream_server_wait(server->client_socket, KAIZEN_TRUE);
+
+            continue;
+        }
+
+        return EPIPE;
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+static void kaizen_internal_stream_server_disconnect(struct kaizen_raw_stream_server_s* server);
+void kaizen_internal_stream_server_disconnect(struct kaizen_raw_stream_server_s* server)
+{
+    kaizen_atomic_uint32_store_release(&(server->is_connected), 0u);
+
+    if (INVALID_SOCKET != server->client_socket) {
+        (void)closesocket(server->client_socket);
+        server->client_socket = INVALID_SOCKET;
+    }
+}
+
+
+
+static void kaizen_internal_stream_server_accept(struct kaizen_raw_stream_server_s* server);
+void kaizen_internal_stream_server_accept(struct kaizen_raw_stream_server_s* server)
+{
+    if (KAIZEN_FALSE == kaizen_internal_stream_server_wait(server->listen_socket, KAIZEN_FALSE)) {
+        return;
+    }
+
+    SOCKET const client_socket = accept(server->listen_socket, NULL, NULL);
+
+    if (INVALID_SOCKET == client_socket) {
+        return;
+    }
+
+    u_long non_blocking = 1;
+    (void)ioctlsocket(client_socket, FIONBIO, &non_blocking);
+
+    server->client_socket = client_socket;
+
+    uint8_t header[KAIZEN_EVENT_STREAM_HEADER_SIZE];
+    (void)kaizen_event_stream_header_encode(server->ticks_per_second,
+                                            header,
+                                            sizeof(header));
+
+    if (KAIZEN_SUCCESS != kaizen_internal_stream_server_send_all(server, header, sizeof(header))) {
+        kaizen_internal_stream_server_disconnect(server);
+
+        return;
+    }
+
+    kaizen_atomic_uint32_store_release(&(server->is_connected), 1u);
+}
+
+
+
+static void kaizen_internal_stream_server_run(void* context);
+void kaizen_internal_stream_server_run(void* context)
+{
+    struct kaizen_raw_stream_server_s* const server = (struct kaizen_raw_stream_server_s*)context;
+
+    while (0u != kaizen_atomic_uint32_load_acquire(&(server->is_running))) {
+
+        uint8_t const* block = NULL;
+        size_t size = 0;
+        int const errc = kaizen_block_queue_try_pop_begin(&(server->queue), &block, &size);
+
+        if (INVALID_SOCKET == server->client_socket) {
+
+            /* Discard blocks submitted before the last viewer left. */
+            if (KAIZEN_SUCCESS == errc) {
+                kaizen_block_queue_pop_end(&(server->queue));
+            } else {
+                kaizen_internal_stream_server_accept(server);
+            }
+
+            continue;
+        }
+
+        if (KAIZEN_SUCCESS != errc) {
+            (void)kaizen_thread_sleep_milliseconds(1);
+
+            continue;
+        }
+
+        if (KAIZEN_SUCCESS != kaizen_internal_stream_server_send_all(server, block, size)) {
+            kaizen_internal_stream_server_disconnect(server);
+        }
+
+        kaizen_block_queue_pop_end(&(server->queue));
+    }
+
+    kaizen_internal_stream_server_disconnect(server);
+}
+
+
+
+int kaizen_stream_server_init_unix_socket(struct kaizen_raw_stream_server_s* server,
+                                          struct kaizen_arena_s* arena,
+                                          char const* path,
+                                          uint32_t block_count,
+                                          size_t block_size)
+{
+    assert(NULL != server);
+    assert(NULL != arena);
+    assert(NULL != path);
+
+    return ENOSYS;
+}
+
+
+
+int kaizen_stream_server_init_tcp(struct kaizen_raw_stream_server_s* server,
+                                  struct kaizen_arena_s* arena,
+                                  uint16_t port,
+                                  uint32_t block_count,
+                                  size_t block_size)
+{
+    assert(NULL != server);
+    assert(NULL != arena);
+    assert(KAIZEN_EVENT_BLOCK_HEADER_SIZE + KAIZEN_EVENT_ENCODED_MAX_SIZE <= block_size);
+
+    WSADATA wsa_data;
+
+    if (0 != WSAStartup(MAKEWORD(2, 2), &wsa_data)) {
+        return ENOSYS;
+    }
+
+    struct sockaddr_in address;
+    ZeroMemory(&address, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int address_size = sizeof(address);
+
+    server->listen_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+    if (INVALID_SOCKET == server->listen_socket) {
+        (void)WSACleanup();
+
+        return EAGAIN;
+    }
+
+    if (SOCKET_ERROR == bind(server->listen_socket, (struct sockaddr const*)&address, sizeof(address))
+        || SOCKET_ERROR == getsockname(server->listen_socket, (struct sockaddr*)&address, &address_size)
+        || SOCKET_ERROR == listen(server->listen_socket, 1)) {
+
+        (void)closesocket(server->listen_socket);
+        (void)WSACleanup();
+
+        return EBUSY;
+    }
+
+    server->port = ntohs(address.sin_port);
+
+    int errc = kaizen_frame_time_query_ticks_per_second(&(server->ticks_per_second));
+
+    if (KAIZEN_SUCCESS == errc) {
+        errc = kaizen_block_queue_init_from_arena(&(server->queue),
+                                                  arena,
+                                                  block_count,
+                                                  block_size);
+    }
+
+    if (KAIZEN_SUCCESS != errc) {
+        (void)closesocket(server->listen_socket);
+        (void)WSACleanup();
+
+        return errc;
+    }
+
+    server->client_socket = INVALID_SOCKET;
+    kaizen_atomic_uint64_store_release(&(server->dropped_event_count), 0u);
+    kaizen_atomic_uint32_store_release(&(server->is_connected), 0u);
+    kaizen_atomic_uint32_store_release(&(server->is_compressed), 0u);
+    kaizen_atomic_uint32_store_release(&(server->is_running), 1u);
+
+    errc = kaizen_thread_launch(&(server->thread),
+                                kaizen_internal_stream_server_run,
+                                server);
+
+    if (KAIZEN_SUCCESS != errc) {
+        (void)kaizen_block_queue_finalize(&(server->queue));
+        (void)closesocket(server->listen_socket);
+        (void)WSACleanup();
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_stream_server_finalize(struct kaizen_raw_stream_server_s* server)
+{
+    assert(NULL != server);
+
+    kaizen_atomic_uint32_store_release(&(server->is_running), 0u);
+
+    int const errc = kaizen_thread_join(&(server->thread));
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    (void)closesocket(server->listen_socket);
+    server->listen_socket = INVALID_SOCKET;
+    (void)WSACleanup();
+
+    return kaizen_block_queue_finalize(&(server->queue));
+}
+
+
+
+uint16_t kaizen_stream_server_port(struct kaizen_raw_stream_server_s const* server)
+{
+    assert(NULL != server);
+
+    return server->port;
+}
+
+
+
+kaizen_bool kaizen_stream_server_is_connected(struct kaizen_raw_stream_server_s const* server)
+{
+    assert(NULL != server);
+
+    return (0u != kaizen_atomic_uint32_load_acquire(&(server->is_connected))) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+int kaizen_stream_server_set_compressed(struct kaizen_raw_stream_server_s* server,
+                                        kaizen_bool is_compressed)
+{
+    assert(NULL != server);
+
+    kaizen_atomic_uint32_store_release(&(server->is_compressed), (KAIZEN_TRUE == is_compressed) ? 1u : 0u);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_stream_server_submit(struct kaizen_raw_stream_server_s* server,
+                                uint32_t stream_id,
+                                struct kaizen_event_s const* events,
+                                size_t event_count)
+{
+    assert(NULL != server);
+    assert(NULL != events || 0 == event_count);
+
+    if (0u == kaizen_atomic_uint32_load_acquire(&(server->is_connected))) {
+        return ESRCH;
+    }
+
+    while (0 < event_count) {
+
+        uint8_t* block = NULL;
+        uint32_t ticket = 0;
+
+        if (KAIZEN_SUCCESS != kaizen_block_queue_try_push_begin(&(server->queue), &block, &ticket)) {
+
+            (void)kaizen_atomic_uint64_fetch_add(&(server->dropped_event_count), event_count);
+
+            return EAGAIN;
+        }
+
+        size_t encoded_event_count = 0;
+        size_t encoded_size = 0;
+        int errc = ENOMEM;
+
+        if (0u != kaizen_atomic_uint32_load_acquire(&(server->is_compressed))) {
+            errc = kaizen_event_block_encode_compressed(stream_id,
+                                                        events,
+                                                        event_count,
+                                                        block,
+                                                        kaizen_block_queue_block_size(&(server->queue)),
+                                                        &encoded_event_count,
+                                                        &encoded_size);
+        }
+
+        /* Blocks too small for a compressed event stay uncompressed. */
+        if (KAIZEN_SUCCESS != errc) {
+            errc = kaizen_event_block_encode(stream_id,
+                                             events,
+                                             event_count,
+                                             block,
+                                             kaizen_block_queue_block_size(&(server->queue)),
+                                             &encoded_event_count,
+                                             &encoded_size);
+        }
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        kaizen_block_queue_push_end(&(server->queue), ticket, encoded_size);
+
+        events += encoded_event_count;
+        event_count -= encoded_event_count;
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+uint64_t kaizen_stream_server_dropped_event_count(struct kaizen_raw_stream_server_s const* server)
+{
+    assert(NULL != server);
+
+    return kaizen_atomic_uint64_load_acquire(&(server->dropped_event_count));
+}
+
+
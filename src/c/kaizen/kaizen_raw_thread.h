@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Shallow wrapper around the platform threads kaizen uses to run
+ * background work, e.g. streaming events to a viewer.
+ *
+ * Usage: define KAIZEN_USE_POSIX_THREADS and compile the source file ending
+ * in _posix_threads.c, or define KAIZEN_USE_WIN32_THREADS and compile the
+ * file ending in _win32.c.
+ */
+
+#ifndef KAIZEN_kaizen_raw_thread_H
+#define KAIZEN_kaizen_raw_thread_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+
+
+#if defined(KAIZEN_USE_POSIX_THREADS)
+#   include <pthread.h>
+#elif defined(KAIZEN_USE_WIN32_THREADS)
+#   include <windows.h>
+#else
+#   error Unsupported platform.
+#endif
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    typedef void (*kaizen_thread_func_t)(void* context);
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_raw_thread_s {
+#if defined(KAIZEN_USE_POSIX_THREADS)
+        pthread_t thread;
+#elif defined(KAIZEN_USE_WIN32_THREADS)
+        HANDLE thread;
+#else
+#   error Unsupported platform.
+#endif
+        kaizen_thread_func_t func;
+        void* context;
+    };
+    typedef struct kaizen_raw_thread_s kaizen_raw_thread_t;
+
+
+
+    /**
+     * Launches a thread running @a func with @a context.
+     *
+     * Returns EAGAIN if the platform lacks resources to create the thread.
+     */
+    int kaizen_thread_launch(struct kaizen_raw_thread_s* thread,
+                             kaizen_thread_func_t func,
+                             void* context);
+
+    /**
+     * Waits until the thread finished running its function and releases it.
+     */
+    int kaizen_thread_join(struct kaizen_raw_thread_s* thread);
+
+    /**
+     * Suspends the calling thread for at least @a milliseconds.
+     */
+    int kaizen_thread_sleep_milliseconds(uint32_t milliseconds);
+
+    /**
+     * Suspends the calling thread for about @a nanoseconds. Platforms round
+     * to their timer granularity, e.g. Windows rounds down to milliseconds,
+     * and wake up late by their scheduling latency. Use kaizen_frame_wait_until
+     * of kaizen_frame_limiter.h to wait for precise deadlines.
+     */
+    int kaizen_thread_sleep_nanoseconds(uint64_t nanoseconds);
+
+    /**
+     * Stores the lowest and one past the highest address of the stack of the
+     * calling thread in @a low and @a high, e.g. to bound stack walks.
+     *
+     * Returns ENOSYS if the platform does not report stack bounds.
+     */
+    int kaizen_thread_stack_bounds(size_t* low,
+                                   size_t* high);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_raw_thread_H */
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_thread.h with pthreads.
+ *
+ * Sleeps with clock_nanosleep on an absolute CLOCK_MONOTONIC deadline where
+ * available, so interrupted sleeps resume without accumulating drift.
+ *
+ * Stack bounds come from pthread_getattr_np on Linux and
+ * pthread_get_stackaddr_np on Mac OS X.
+ *
+ * See http://www.opengroup.org/onlinepubs/000095399/functions/pthread_create.html
+ * See http://pubs.opengroup.org/onlinepubs/009695399/functions/clock_nanosleep.html
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "kaizen_raw_thread.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include "kaizen_stddef.h"
+
+
+
+static void* kaizen_internal_thread_start(void* thread);
+void* kaizen_internal_thread_start(void* thread)
+{
+    struct kaizen_raw_thread_s* const self = (struct kaizen_raw_thread_s*)thread;
+
+    self->func(self->context);
+
+    return NULL;
+}
+
+
+
+int kaizen_thread_launch(struct kaizen_raw_thread_s* thread,
+                         kaizen_thread_func_t func,
+                         void* context)
+{
+    assert(NULL != thread);
+    assert(NULL != func);
+
+    thread->func = func;
+    thread->context = context;
+
+    int const errc = pthread_create(&(thread->thread),
+                                    NULL,
+                                    kaizen_internal_thread_start,
+                                    thread);
+    assert(EINVAL != errc);
+
+    return errc;
+}
+
+
+
+int kaizen_thread_join(struct kaizen_raw_thread_s* thread)
+{
+    assert(NULL != thread);
+
+    int const errc = pthread_join(thread->thread, NULL);
+    assert(EINVAL != errc);
+    assert(ESRCH != errc);
+    assert(EDEADLK != errc);
+
+    return errc;
+}
+
+
+
+int kaizen_thread_sleep_milliseconds(uint32_t milliseconds)
+{
+    struct timespec duration;
+    duration.tv_sec = (time_t)(milliseconds / 1000u);
+    duration.tv_nsec = (long)(milliseconds % 1000u) * 1000000L;
+
+    while (0 != nanosleep(&duration, &duration)) {
+        if (EINTR != errno) {
+            return errno;
+        }
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_thread_sleep_nanoseconds(uint64_t nanoseconds)
+{
+    uint64_t const nanoseconds_per_second = (uint64_t)1000000000;
+
+#if defined(TIMER_ABSTIME) && defined(CLOCK_MONOTONIC) && !defined(__APPLE__)
+    struct timespec deadline;
+
+    if (0 != clock_gettime(CLOCK_MONOTONIC, &deadline)) {
+        return errno;
+    }
+
+    uint64_t const deadline_nanoseconds = (uint64_t)deadline.tv_nsec + (nanoseconds % nanoseconds_per_second);
+    deadline.tv_sec += (time_t)((nanoseconds / nanoseconds_per_second) + (deadline_nanoseconds / nanoseconds_per_second));
+    deadline.tv_nsec = (long)(deadline_nanoseconds % nanoseconds_per_second);
+
+    int errc = EINTR;
+
+    while (EINTR == errc) {
+        errc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+    }
+
+    return errc;
+#else
+    struct timespec duration;
+    duration.tv_sec = (time_t)(nanoseconds / nanoseconds_per_second);
+    duration.tv_nsec = (long)(nanoseconds % nanoseconds_per_second);
+
+    while (0 != nanosleep(&duration, &duration)) {
+        if (EINTR != errno) {
+            return errno;
+        }
+    }
+
+    return KAIZEN_SUCCESS;
+#endif
+}
+
+
+
+int kaizen_thread_stack_bounds(size_t* low,
+                               size_t* high)
+{
+    assert(NULL != low);
+    assert(NULL != high);
+
+#if defined(__linux__)
+    pthread_attr_t attributes;
+    int errc = pthread_getattr_np(pthread_self(), &attributes);
+
+    if (0 != errc) {
+        return errc;
+    }
+
+    void* stack_address = NULL;
+    size_t stack_size = 0;
+    errc = pthread_attr_getstack(&attributes, &stack_address, &stack_size);
+    (void)pthread_attr_destroy(&attributes);
+
+    if (0 != errc) {
+        return errc;
+    }
+
+    *low = (size_t)stack_address;
+    *high = (size_t)stack_address + stack_size;
+
+    return KAIZEN_SUCCESS;
+#elif defined(__APPLE__)
+    /* Reports the highest address, stacks grow down. */
+    size_t const stack_high = (size_t)pthread_get_stackaddr_np(pthread_self());
+
+    *low = stack_high - pthread_get_stacksize_np(pthread_self());
+    *high = stack_high;
+
+    return KAIZEN_SUCCESS;
+#else
+    return ENOSYS;
+#endif
+}
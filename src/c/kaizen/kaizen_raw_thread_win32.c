@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_raw_thread.h with Win32 threads.
+ *
+ * Uses _beginthreadex instead of CreateThread so threads can use the C
+ * runtime.
+ *
+ * See http://msdn.microsoft.com/en-us/library/kdzttdcb(VS.90).aspx
+ */
+
+#include "kaizen_raw_thread.h"
+
+#include <windows.h>
+#include <process.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+
+
+
+static unsigned __stdcall kaizen_internal_thread_start(void* thread);
+unsigned __stdcall kaizen_internal_thread_start(void* thread)
+{
+    struct kaizen_raw_thread_s* const self = (struct kaizen_raw_thread_s*)thread;
+
+    self->func(self->context);
+
+    return 0;
+}
+
+
+
+int kaizen_thread_launch(struct kaizen_raw_thread_s* thread,
+                         kaizen_thread_func_t func,
+                         void* context)
+{
+    assert(NULL != thread);
+    assert(NULL != func);
+
+    thread->func = func;
+    thread->context = context;
+
+    uintptr_t const handle = _beginthreadex(NULL,
+                                            0,
+                                            kaizen_internal_thread_start,
+                                            thread,
+                                            0,
+                                            NULL);
+
+    if (0 == handle) {
+        return EAGAIN;
+    }
+
+    thread->thread = (HANDLE)handle;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_thread_join(struct kaizen_raw_thread_s* thread)
+{
+    assert(NULL != thread);
+
+    DWORD const wait_result = WaitForSingleObject(thread->thread, INFINITE);
+    assert(WAIT_OBJECT_0 == wait_result);
+    (void)wait_result;
+
+    BOOL const close_result = CloseHandle(thread->thread);
+    assert(FALSE != close_result);
+    (void)close_result;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_thread_sleep_milliseconds(uint32_t milliseconds)
+{
+    Sleep((DWORD)milliseconds);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_thread_sleep_nanoseconds(uint64_t nanoseconds)
+{
+    Sleep((DWORD)(nanoseconds / (uint64_t)1000000));
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_thread_stack_bounds(size_t* low,
+                               size_t* high)
+{
+    assert(NULL != low);
+    assert(NULL != high);
+
+    return ENOSYS;
+}
@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_thread_state.h for all platforms.
+ */
+
+#include "kaizen_thread_state.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_event.h"
+#include "kaizen_arena.h"
+#include "kaizen_internal_thread_local.h"
+
+
+
+static KAIZEN_THREAD_LOCAL struct kaizen_thread_state_s* kaizen_internal_current_thread_state = NULL;
+
+
+
+int kaizen_thread_state_allocate_from_arena(struct kaizen_arena_s* arena,
+                                            size_t event_capacity,
+                                            struct kaizen_thread_state_s** result)
+{
+    assert(NULL != arena);
+    assert(0 < event_capacity);
+    assert(NULL != result);
+
+    void* state = NULL;
+    int errc = kaizen_arena_allocate_persistent(arena,
+                                                sizeof(struct kaizen_thread_state_s),
+                                                KAIZEN_CACHE_LINE_SIZE,
+                                                &state);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    /* Event storage of different threads must not share a line either. */
+    void* event_storage = NULL;
+    errc = kaizen_arena_allocate_persistent(arena,
+                                            event_capacity * sizeof(struct kaizen_event_s),
+                                            KAIZEN_CACHE_LINE_SIZE,
+                                            &event_storage);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    errc = kaizen_thread_state_init((struct kaizen_thread_state_s*)state,
+                                    (struct kaizen_event_s*)event_storage,
+                                    event_capacity);
+
+    if (KAIZEN_SUCCESS == errc) {
+        *result = (struct kaizen_thread_state_s*)state;
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_thread_state_init(struct kaizen_thread_state_s* state,
+                             struct kaizen_event_s* event_storage,
+                             size_t event_capacity)
+{
+    assert(NULL != state);
+    assert(NULL != event_storage);
+    assert(0 < event_capacity);
+    assert(0 == ((size_t)state % KAIZEN_CACHE_LINE_SIZE));
+
+    state->depth_stack.depth = 0;
+    state->stats.zone_count = 0;
+    state->stats.max_depth = 0;
+    state->stats.untracked_depth_count = 0;
+
+    struct kaizen_raw_frame_time_s const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+    state->suspension.switch_out_time = zero;
+    state->suspension.suspended_ticks = 0;
+    state->suspension.resumed_thread_state = NULL;
+    state->suspension.resumed_event_buffer = NULL;
+    state->suspension.switch_count = 0;
+    state->suspension.is_switched_out = KAIZEN_FALSE;
+
+    kaizen_thread_state_set_sample_counts_collected(state, KAIZEN_FALSE);
+
+    return kaizen_event_buffer_init(&(state->cursor.event_buffer),
+                                    event_storage,
+                                    event_capacity);
+}
+
+
+
+int kaizen_thread_state_finalize(struct kaizen_thread_state_s* state)
+{
+    assert(NULL != state);
+    assert(kaizen_internal_current_thread_state != state);
+    assert(0 == state->depth_stack.depth);
+
+    return kaizen_event_buffer_finalize(&(state->cursor.event_buffer));
+}
+
+
+
+int kaizen_thread_state_attach_to_current_thread(struct kaizen_thread_state_s* state)
+{
+    kaizen_internal_current_thread_state = state;
+
+    return kaizen_event_buffer_attach_to_current_thread((NULL != state) ? &(state->cursor.event_buffer) : NULL);
+}
+
+
+
+struct kaizen_thread_state_s* kaizen_thread_state_of_current_thread(void)
+{
+    return kaizen_internal_current_thread_state;
+}
+
+
+
+struct kaizen_event_buffer_s* kaizen_thread_state_event_buffer(struct kaizen_thread_state_s* state)
+{
+    assert(NULL != state);
+
+    return &(state->cursor.event_buffer);
+}
+
+
+
+void kaizen_thread_state_push_zone(struct kaizen_thread_state_s* state,
+                                   uint32_t zone_id)
+{
+    assert(NULL != state);
+
+    uint32_t const depth = state->depth_stack.depth;
+
+    if (depth < KAIZEN_THREAD_STATE_MAX_DEPTH) {
+        state->depth_stack.zone_ids[depth] = zone_id;
+    } else {
+        ++(state->stats.untracked_depth_count);
+    }
+
+    state->depth_stack.depth = depth + 1;
+
+    ++(state->stats.zone_count);
+
+    if (depth + 1 > state->stats.max_depth) {
+        state->stats.max_depth = depth + 1;
+    }
+}
+
+
+
+void kaizen_thread_state_pop_zone(struct kaizen_thread_state_s* state)
+{
+    assert(NULL != state);
+    assert(0 < state->depth_stack.depth);
+
+    --(state->depth_stack.depth);
+}
+
+
+
+uint32_t kaizen_thread_state_depth(struct kaizen_thread_state_s const* state)
+{
+    assert(NULL != state);
+
+    return state->depth_stack.depth;
+}
+
+
+
+uint32_t kaizen_thread_state_top_zone_id(struct kaizen_thread_state_s const* state)
+{
+    assert(NULL != state);
+    assert(0 < state->depth_stack.depth);
+
+    uint32_t const depth = state->depth_stack.depth;
+    uint32_t const tracked_depth = (depth < KAIZEN_THREAD_STATE_MAX_DEPTH) ? depth : KAIZEN_THREAD_STATE_MAX_DEPTH;
+
+    return state->depth_stack.zone_ids[tracked_depth - 1];
+}
+
+
+
+uint64_t kaizen_thread_state_zone_count(struct kaizen_thread_state_s const* state)
+{
+    assert(NULL != state);
+
+    return state->stats.zone_count;
+}
+
+
+
+kaizen_bool kaizen_thread_state_count_sample(struct kaizen_thread_state_s* state,
+                                             uint32_t slot)
+{
+    assert(NULL != state);
+
+    if (KAIZEN_THREAD_STATE_SAMPLE_COUNT_CAPACITY <= slot
+        || 0u == kaizen_atomic_uint32_load_acquire(&(state->sample_counts.is_collected))) {
+
+        return KAIZEN_FALSE;
+    }
+
+    (void)kaizen_atomic_uint32_fetch_add(&(state->sample_counts.counts[slot]), 1u);
+
+    return KAIZEN_TRUE;
+}
+
+
+
+void kaizen_thread_state_set_sample_counts_collected(struct kaizen_thread_state_s* state,
+                                                     kaizen_bool is_collected)
+{
+    assert(NULL != state);
+
+    uint32_t slot = 0;
+    for (slot = 0; slot < KAIZEN_THREAD_STATE_SAMPLE_COUNT_CAPACITY; ++slot) {
+        kaizen_atomic_uint32_store_release(&(state->sample_counts.counts[slot]), 0u);
+    }
+
+    kaizen_atomic_uint32_store_release(&(state->sample_counts.is_collected),
+                                       (KAIZEN_TRUE == is_collected) ? 1u : 0u);
+}
+
+
+
+uint32_t kaizen_thread_state_exchange_sample_count(struct kaizen_thread_state_s* state,
+                                                   uint32_t slot)
+{
+    assert(NULL != state);
+    assert(KAIZEN_THREAD_STATE_SAMPLE_COUNT_CAPACITY > slot);
+
+    return kaizen_atomic_uint32_exchange(&(state->sample_counts.counts[slot]), 0u);
+}
+
+
+
+uint32_t kaizen_thread_state_max_depth(struct kaizen_thread_state_s const* state)
+{
+    assert(NULL != state);
+
+    return state->stats.max_depth;
+}
+
+
+
+int kaizen_thread_state_switch_in(struct kaizen_thread_state_s* state,
+                                  struct kaizen_raw_frame_time_s const* now)
+{
+    assert(NULL != state);
+    assert(NULL != now);
+    assert(kaizen_internal_current_thread_state != state);
+
+    if (KAIZEN_TRUE == state->suspension.is_switched_out
+        && KAIZEN_TRUE == kaizen_frame_time_greater(now, &(state->suspension.switch_out_time))) {
+
+        struct kaizen_raw_frame_time_s suspended = KAIZEN_RAW_FRAME_TIME_ZERO;
+        uint64_t suspended_ticks = 0;
+        int errc = kaizen_frame_time_subtract(now, &(state->suspension.switch_out_time), &suspended);
+
+        if (KAIZEN_SUCCESS == errc) {
+            errc = kaizen_frame_time_convert_to_ticks(&suspended, &suspended_ticks);
+        }
+
+        if (KAIZEN_SUCCESS != errc) {
+            return errc;
+        }
+
+        state->suspension.suspended_ticks += suspended_ticks;
+    }
+
+    state->suspension.resumed_thread_state = kaizen_internal_current_thread_state;
+    state->suspension.resumed_event_buffer = kaizen_event_buffer_of_current_thread();
+    state->suspension.is_switched_out = KAIZEN_FALSE;
+    ++(state->suspension.switch_count);
+
+    return kaizen_thread_state_attach_to_current_thread(state);
+}
+
+
+
+int kaizen_thread_state_switch_out(struct kaizen_thread_state_s* state,
+                                   struct kaizen_raw_frame_time_s const* now)
+{
+    assert(NULL != state);
+    assert(NULL != now);
+    assert(kaizen_internal_current_thread_state == state);
+
+    state->suspension.switch_out_time = *now;
+    state->suspension.is_switched_out = KAIZEN_TRUE;
+
+    kaizen_internal_current_thread_state = state->suspension.resumed_thread_state;
+    int const errc = kaizen_event_buffer_attach_to_current_thread(state->suspension.resumed_event_buffer);
+
+    state->suspension.resumed_thread_state = NULL;
+    state->suspension.resumed_event_buffer = NULL;
+
+    return errc;
+}
+
+
+
+uint64_t kaizen_thread_state_suspended_ticks(struct kaizen_thread_state_s const* state)
+{
+    assert(NULL != state);
+
+    return state->suspension.suspended_ticks;
+}
+
+
+
+uint32_t kaizen_thread_state_switch_count(struct kaizen_thread_state_s const* state)
+{
+    assert(NULL != state);
+
+    return state->suspension.switch_count;
+}
+
+
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Per thread profiler state: the event write cursor, the stack of open zones
+ * and statistics of the thread, each in its own cache line aligned block so
+ * threads never write to a cache line another thread writes to (no false
+ * sharing), even if the states of all threads are allocated next to each
+ * other.
+ *
+ * Attaching a thread state to a thread stores it in a thread local pointer
+ * so instrumentation finds it without a lock or a lookup. Attaching also
+ * attaches the event buffer of the state (see kaizen_event.h).
+ *
+ * Allocate states via kaizen_thread_state_allocate_from_arena, or as static
+ * or automatic variables - heap allocations via malloc are not guaranteed to
+ * be cache line aligned.
+ *
+ * Fibers and coroutines which suspend inside zones and resume on another
+ * thread own a state of their own. Switching the state in attaches it to
+ * the resuming thread, switching it out restores the state the thread had
+ * attached before, so zones nest per fiber and their durations exclude the
+ * time the fiber was suspended:
+ * <code>
+ * kaizen_frame_time_query(&now);
+ * kaizen_thread_state_switch_out(previous_fiber->profiler_state, &now);
+ * kaizen_thread_state_switch_in(next_fiber->profiler_state, &now);
+ * switch_to_fiber(next_fiber);
+ * </code>
+ */
+
+#ifndef KAIZEN_kaizen_thread_state_H
+#define KAIZEN_kaizen_thread_state_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_atomic.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_arena.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    /**
+     * Define KAIZEN_CACHE_LINE_SIZE to the destructive interference size of
+     * the target if it differs, e.g. 128 on some ARM cores.
+     */
+#if !defined(KAIZEN_CACHE_LINE_SIZE)
+#   define KAIZEN_CACHE_LINE_SIZE 64
+#endif
+
+#if defined(_MSC_VER)
+#   define KAIZEN_CACHE_LINE_ALIGNED __declspec(align(KAIZEN_CACHE_LINE_SIZE))
+#elif defined(__GNUC__)
+#   define KAIZEN_CACHE_LINE_ALIGNED __attribute__((aligned(KAIZEN_CACHE_LINE_SIZE)))
+#else
+#   error Unsupported compiler.
+#endif
+
+    /**
+     * Nesting depth of zones tracked per thread. Deeper zones are recorded
+     * but not tracked.
+     */
+#define KAIZEN_THREAD_STATE_MAX_DEPTH 30
+
+    /**
+     * Number of zone sampler slots a thread state counts recorded
+     * executions for (see kaizen_zone_sampler_add_thread_state). Zones in
+     * higher slots count on the zone.
+     */
+#define KAIZEN_THREAD_STATE_SAMPLE_COUNT_CAPACITY 128
+
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct KAIZEN_CACHE_LINE_ALIGNED kaizen_thread_state_cursor_s {
+        struct kaizen_event_buffer_s event_buffer;
+    };
+
+    struct KAIZEN_CACHE_LINE_ALIGNED kaizen_thread_state_depth_stack_s {
+        uint32_t depth;
+        uint32_t zone_ids[KAIZEN_THREAD_STATE_MAX_DEPTH];
+    };
+
+    struct KAIZEN_CACHE_LINE_ALIGNED kaizen_thread_state_stats_s {
+        uint64_t zone_count;
+        uint32_t max_depth;
+        uint32_t untracked_depth_count;
+    };
+
+    struct KAIZEN_CACHE_LINE_ALIGNED kaizen_thread_state_suspension_s {
+        struct kaizen_raw_frame_time_s switch_out_time;
+        uint64_t suspended_ticks;
+        struct kaizen_thread_state_s* resumed_thread_state;
+        struct kaizen_event_buffer_s* resumed_event_buffer;
+        uint32_t switch_count;
+        kaizen_bool is_switched_out;
+    };
+
+    struct KAIZEN_CACHE_LINE_ALIGNED kaizen_thread_state_sample_counts_s {
+        struct kaizen_atomic_uint32_s is_collected;
+        struct kaizen_atomic_uint32_s counts[KAIZEN_THREAD_STATE_SAMPLE_COUNT_CAPACITY];
+    };
+
+    struct KAIZEN_CACHE_LINE_ALIGNED kaizen_thread_state_s {
+        struct kaizen_thread_state_cursor_s cursor;
+        struct kaizen_thread_state_depth_stack_s depth_stack;
+        struct kaizen_thread_state_stats_s stats;
+        struct kaizen_thread_state_suspension_s suspension;
+        struct kaizen_thread_state_sample_counts_s sample_counts;
+    };
+    typedef struct kaizen_thread_state_s kaizen_thread_state_t;
+
+
+
+    /**
+     * Allocates a cache line aligned thread state and storage for
+     * @a event_capacity events from the persistent part of @a arena and
+     * initializes the state.
+     *
+     * Returns ENOMEM if the arena is full.
+     */
+    int kaizen_thread_state_allocate_from_arena(struct kaizen_arena_s* arena,
+                                                size_t event_capacity,
+                                                struct kaizen_thread_state_s** result);
+
+    /**
+     * Initializes @a state to record into the caller owned @a event_storage
+     * of @a event_capacity events.
+     */
+    int kaizen_thread_state_init(struct kaizen_thread_state_s* state,
+                                 struct kaizen_event_s* event_storage,
+                                 size_t event_capacity);
+
+    /**
+     * Must not be attached to any thread.
+     */
+    int kaizen_thread_state_finalize(struct kaizen_thread_state_s* state);
+
+    /**
+     * Attaches @a state and its event buffer to the calling thread. Pass NULL
+     * to detach the current state.
+     *
+     * A state must only be attached to one thread at a time.
+     */
+    int kaizen_thread_state_attach_to_current_thread(struct kaizen_thread_state_s* state);
+
+    /**
+     * Returns the state attached to the calling thread or NULL.
+     */
+    struct kaizen_thread_state_s* kaizen_thread_state_of_current_thread(void);
+
+    struct kaizen_event_buffer_s* kaizen_thread_state_event_buffer(struct kaizen_thread_state_s* state);
+
+    /**
+     * Tracks entering the zone with @a zone_id, called by kaizen_zone_begin
+     * for sampled and unsampled executions.
+     */
+    void kaizen_thread_state_push_zone(struct kaizen_thread_state_s* state,
+                                       uint32_t zone_id);
+
+    void kaizen_thread_state_pop_zone(struct kaizen_thread_state_s* state);
+
+    uint32_t kaizen_thread_state_depth(struct kaizen_thread_state_s const* state);
+
+    /**
+     * Returns the id of the innermost tracked zone.
+     *
+     * Depth must be greater than 0.
+     */
+    uint32_t kaizen_thread_state_top_zone_id(struct kaizen_thread_state_s const* state);
+
+    uint64_t kaizen_thread_state_zone_count(struct kaizen_thread_state_s const* state);
+
+    /**
+     * Counts a recorded execution of the zone in sampler @a slot (see
+     * kaizen_zone_set_sampler_slot), called by kaizen_zone_end. Only the
+     * zone sampler collecting the counts of @a state writes the same cache
+     * line, once per frame, so threads do not contend on a shared count.
+     *
+     * Returns KAIZEN_FALSE without counting if no sampler collects the
+     * counts of @a state or the slot is out of range, the caller counts on
+     * the zone then.
+     */
+    kaizen_bool kaizen_thread_state_count_sample(struct kaizen_thread_state_s* state,
+                                                 uint32_t slot);
+
+    /**
+     * Marks the sample counts of @a state as collected by a zone sampler,
+     * or not if @a is_collected is KAIZEN_FALSE, and resets them.
+     */
+    void kaizen_thread_state_set_sample_counts_collected(struct kaizen_thread_state_s* state,
+                                                         kaizen_bool is_collected);
+
+    /**
+     * Returns the executions counted in @a slot since the last call and
+     * resets the count.
+     */
+    uint32_t kaizen_thread_state_exchange_sample_count(struct kaizen_thread_state_s* state,
+                                                       uint32_t slot);
+
+    uint32_t kaizen_thread_state_max_depth(struct kaizen_thread_state_s const* state);
+
+
+
+    /**
+     * Attaches the state of a fiber or coroutine to the calling thread when
+     * it resumes on it at the frame time @a now, remembering the state and
+     * event buffer attached to the thread before. Time since the state was
+     * switched out counts as suspended.
+     *
+     * All parameters must not be NULL.
+     */
+    int kaizen_thread_state_switch_in(struct kaizen_thread_state_s* state,
+                                      struct kaizen_raw_frame_time_s const* now);
+
+    /**
+     * Detaches @a state from the calling thread when its fiber or coroutine
+     * suspends at the frame time @a now and attaches the state and event
+     * buffer the thread had before kaizen_thread_state_switch_in.
+     *
+     * @a state must be switched in on the calling thread.
+     */
+    int kaizen_thread_state_switch_out(struct kaizen_thread_state_s* state,
+                                       struct kaizen_raw_frame_time_s const* now);
+
+    /**
+     * Returns the ticks (see kaizen_frame_time_convert_to_ticks) @a state
+     * has been switched out in total.
+     */
+    uint64_t kaizen_thread_state_suspended_ticks(struct kaizen_thread_state_s const* state);
+
+    /**
+     * Returns how often @a state has been switched in.
+     */
+    uint32_t kaizen_thread_state_switch_count(struct kaizen_thread_state_s const* state);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_thread_state_H */
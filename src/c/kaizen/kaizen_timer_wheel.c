@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_timer_wheel.h for all platforms.
+ *
+ * Works like the classic Linux kernel timer wheel: a timer due in d granules
+ * goes into the level whose slots span d, indexed by the bits of its expiry
+ * granule for that level. Whenever the low bits of the next granule wrap to
+ * zero the slot of the level above is cascaded, re-inserting its timers
+ * relative to the next granule, before the level 0 slot is called.
+ *
+ * Slots are circular doubly linked lists with the slot as sentinel, so
+ * timers unlink in O(1) without knowing their slot.
+ *
+ * See http://lwn.net/Articles/156329/
+ */
+
+#include "kaizen_timer_wheel.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_frame_time.h"
+
+
+
+#define KAIZEN_INTERNAL_TIMER_WHEEL_SLOT_MASK ((uint64_t)(KAIZEN_TIMER_WHEEL_SLOT_COUNT - 1))
+#define KAIZEN_INTERNAL_TIMER_WHEEL_MAX_DELTA (((uint64_t)1 << (KAIZEN_TIMER_WHEEL_SLOT_BITS * KAIZEN_TIMER_WHEEL_LEVEL_COUNT)) - 1u)
+
+
+
+inline static void kaizen_internal_timer_link_init(struct kaizen_timer_link_s* link)
+{
+    assert(NULL != link);
+
+    link->next = link;
+    link->previous = link;
+}
+
+
+
+inline static kaizen_bool kaizen_internal_timer_link_is_empty(struct kaizen_timer_link_s const* link)
+{
+    assert(NULL != link);
+
+    return (link->next == link) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+inline static void kaizen_internal_timer_link_push_back(struct kaizen_timer_link_s* sentinel,
+                                                        struct kaizen_timer_link_s* link)
+{
+    assert(NULL != sentinel);
+    assert(NULL != link);
+
+    link->next = sentinel;
+    link->previous = sentinel->previous;
+    sentinel->previous->next = link;
+    sentinel->previous = link;
+}
+
+
+
+inline static void kaizen_internal_timer_link_unlink(struct kaizen_timer_link_s* link)
+{
+    assert(NULL != link);
+
+    link->previous->next = link->next;
+    link->next->previous = link->previous;
+    link->next = NULL;
+    link->previous = NULL;
+}
+
+
+
+/**
+ * Moves all links of @a source to the empty @a destination.
+ */
+inline static void kaizen_internal_timer_link_splice(struct kaizen_timer_link_s* source,
+                                                     struct kaizen_timer_link_s* destination)
+{
+    assert(NULL != source);
+    assert(NULL != destination);
+    assert(KAIZEN_TRUE == kaizen_internal_timer_link_is_empty(destination));
+
+    if (KAIZEN_TRUE == kaizen_internal_timer_link_is_empty(source)) {
+        return;
+    }
+
+    destination->next = source->next;
+    destination->previous = source->previous;
+    destination->next->previous = destination;
+    destination->previous->next = destination;
+
+    kaizen_internal_timer_link_init(source);
+}
+
+
+
+/**
+ * Links @a timer into the slot for its expiry granule relative to the next
+ * granule of @a wheel.
+ */
+static void kaizen_internal_timer_wheel_insert(struct kaizen_timer_wheel_s* wheel,
+                                               struct kaizen_timer_s* timer);
+
+static void kaizen_internal_timer_wheel_insert(struct kaizen_timer_wheel_s* wheel,
+                                               struct kaizen_timer_s* timer)
+{
+    assert(NULL != wheel);
+    assert(NULL != timer);
+
+    uint64_t granule = timer->expiry_granule;
+
+    if (granule < wheel->next_granule) {
+        granule = wheel->next_granule;
+    }
+
+    uint64_t delta = granule - wheel->next_granule;
+
+    if (delta > KAIZEN_INTERNAL_TIMER_WHEEL_MAX_DELTA) {
+        delta = KAIZEN_INTERNAL_TIMER_WHEEL_MAX_DELTA;
+        granule = wheel->next_granule + delta;
+    }
+
+    unsigned int level = 0;
+
+    while ((delta >> (KAIZEN_TIMER_WHEEL_SLOT_BITS * (level + 1))) != 0) {
+        ++level;
+    }
+
+    assert(level < KAIZEN_TIMER_WHEEL_LEVEL_COUNT);
+
+    uint64_t const slot = (granule >> (KAIZEN_TIMER_WHEEL_SLOT_BITS * level)) & KAIZEN_INTERNAL_TIMER_WHEEL_SLOT_MASK;
+
+    kaizen_internal_timer_link_push_back(&(wheel->slots[level][slot]), &(timer->link));
+}
+
+
+
+/**
+ * Re-inserts the timers of the slot of @a level for the next granule into
+ * lower levels.
+ */
+static void kaizen_internal_timer_wheel_cascade(struct kaizen_timer_wheel_s* wheel,
+                                                unsigned int level);
+
+static void kaizen_internal_timer_wheel_cascade(struct kaizen_timer_wheel_s* wheel,
+                                                unsigned int level)
+{
+    assert(NULL != wheel);
+    assert(0 < level && level < KAIZEN_TIMER_WHEEL_LEVEL_COUNT);
+
+    uint64_t const slot = (wheel->next_granule >> (KAIZEN_TIMER_WHEEL_SLOT_BITS * level)) & KAIZEN_INTERNAL_TIMER_WHEEL_SLOT_MASK;
+
+    struct kaizen_timer_link_s cascading;
+    kaizen_internal_timer_link_init(&cascading);
+    kaizen_internal_timer_link_splice(&(wheel->slots[level][slot]), &cascading);
+
+    while (KAIZEN_FALSE == kaizen_internal_timer_link_is_empty(&cascading)) {
+        struct kaizen_timer_s* const timer = (struct kaizen_timer_s*)cascading.next;
+
+        kaizen_internal_timer_link_unlink(&(timer->link));
+        kaizen_internal_timer_wheel_insert(wheel, timer);
+    }
+}
+
+
+
+int kaizen_timer_init(struct kaizen_timer_s* timer,
+                      kaizen_timer_func_t func,
+                      void* context)
+{
+    assert(NULL != timer);
+    assert(NULL != func);
+
+    timer->link.next = NULL;
+    timer->link.previous = NULL;
+    timer->expiry_granule = 0;
+    timer->func = func;
+    timer->context = context;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_timer_finalize(struct kaizen_timer_s* timer)
+{
+    assert(NULL != timer);
+    assert(KAIZEN_FALSE == kaizen_timer_is_scheduled(timer));
+
+    timer->func = NULL;
+    timer->context = NULL;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+kaizen_bool kaizen_timer_is_scheduled(struct kaizen_timer_s const* timer)
+{
+    assert(NULL != timer);
+
+    return (NULL != timer->link.next) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
+
+int kaizen_timer_wheel_init(struct kaizen_timer_wheel_s* wheel,
+                            struct kaizen_raw_frame_time_s const* now,
+                            struct kaizen_raw_frame_time_s const* granularity)
+{
+    assert(NULL != wheel);
+    assert(NULL != now);
+    assert(NULL != granularity);
+
+    uint64_t now_ticks = 0;
+    uint64_t granularity_ticks = 0;
+    int errc = kaizen_frame_time_convert_to_ticks(granularity, &granularity_ticks);
+
+    if (KAIZEN_SUCCESS == errc) {
+        errc = kaizen_frame_time_convert_to_ticks(now, &now_ticks);
+    }
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    if (0 == granularity_ticks) {
+        return EINVAL;
+    }
+
+    for (unsigned int level = 0; level < KAIZEN_TIMER_WHEEL_LEVEL_COUNT; ++level) {
+        for (unsigned int slot = 0; slot < KAIZEN_TIMER_WHEEL_SLOT_COUNT; ++slot) {
+            kaizen_internal_timer_link_init(&(wheel->slots[level][slot]));
+        }
+    }
+
+    wheel->granularity_ticks = granularity_ticks;
+    wheel->next_granule = now_ticks / granularity_ticks;
+    wheel->timer_count = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_timer_wheel_finalize(struct kaizen_timer_wheel_s* wheel)
+{
+    assert(NULL != wheel);
+
+    for (unsigned int level = 0; level < KAIZEN_TIMER_WHEEL_LEVEL_COUNT; ++level) {
+        for (unsigned int slot = 0; slot < KAIZEN_TIMER_WHEEL_SLOT_COUNT; ++slot) {
+            struct kaizen_timer_link_s* const sentinel = &(wheel->slots[level][slot]);
+
+            while (KAIZEN_FALSE == kaizen_internal_timer_link_is_empty(sentinel)) {
+                kaizen_internal_timer_link_unlink(sentinel->next);
+            }
+        }
+    }
+
+    wheel->timer_count = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_timer_wheel_schedule(struct kaizen_timer_wheel_s* wheel,
+                                struct kaizen_timer_s* timer,
+                                struct kaizen_raw_frame_time_s const* deadline)
+{
+    assert(NULL != wheel);
+    assert(NULL != timer);
+    assert(NULL != deadline);
+
+    uint64_t deadline_ticks = 0;
+    int const errc = kaizen_frame_time_convert_to_ticks(deadline, &deadline_ticks);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    kaizen_timer_wheel_cancel(wheel, timer);
+
+    /* Round up so timers are never called before their deadline. */
+    timer->expiry_granule = (deadline_ticks / wheel->granularity_ticks)
+        + ((0 != (deadline_ticks % wheel->granularity_ticks)) ? 1u : 0u);
+
+    kaizen_internal_timer_wheel_insert(wheel, timer);
+    ++(wheel->timer_count);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+void kaizen_timer_wheel_cancel(struct kaizen_timer_wheel_s* wheel,
+                               struct kaizen_timer_s* timer)
+{
+    assert(NULL != wheel);
+    assert(NULL != timer);
+
+    if (KAIZEN_FALSE == kaizen_timer_is_scheduled(timer)) {
+        return;
+    }
+
+    assert(0 < wheel->timer_count);
+
+    kaizen_internal_timer_link_unlink(&(timer->link));
+    --(wheel->timer_count);
+}
+
+
+
+int kaizen_timer_wheel_advance(struct kaizen_timer_wheel_s* wheel,
+                               struct kaizen_raw_frame_time_s const* now)
+{
+    assert(NULL != wheel);
+    assert(NULL != now);
+
+    uint64_t now_ticks = 0;
+    int const errc = kaizen_frame_time_convert_to_ticks(now, &now_ticks);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    uint64_t const now_granule = now_ticks / wheel->granularity_ticks;
+
+    while (wheel->next_granule <= now_granule) {
+
+        if (0 == wheel->timer_count) {
+            wheel->next_granule = now_granule + 1u;
+            break;
+        }
+
+        uint64_t const granule = wheel->next_granule;
+
+        for (unsigned int level = 1; level < KAIZEN_TIMER_WHEEL_LEVEL_COUNT; ++level) {
+            if (0 != ((granule >> (KAIZEN_TIMER_WHEEL_SLOT_BITS * (level - 1))) & KAIZEN_INTERNAL_TIMER_WHEEL_SLOT_MASK)) {
+                break;
+            }
+
+            kaizen_internal_timer_wheel_cascade(wheel, level);
+        }
+
+        struct kaizen_timer_link_s expired;
+        kaizen_internal_timer_link_init(&expired);
+        kaizen_internal_timer_link_splice(&(wheel->slots[0][granule & KAIZEN_INTERNAL_TIMER_WHEEL_SLOT_MASK]), &expired);
+
+        /* Timers scheduled by callbacks for passed deadlines go into the
+         * following granule instead of the one being called.
+         */
+        wheel->next_granule = granule + 1u;
+
+        while (KAIZEN_FALSE == kaizen_internal_timer_link_is_empty(&expired)) {
+            struct kaizen_timer_s* const timer = (struct kaizen_timer_s*)expired.next;
+
+            assert(timer->expiry_granule <= granule);
+
+            kaizen_internal_timer_link_unlink(&(timer->link));
+            --(wheel->timer_count);
+
+            timer->func(timer, timer->context);
+        }
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+uint64_t kaizen_timer_wheel_timer_count(struct kaizen_timer_wheel_s const* wheel)
+{
+    assert(NULL != wheel);
+
+    return wheel->timer_count;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Hierarchical timer wheel scheduling callbacks against frame time
+ * deadlines, e.g. thousands of delayed game or server actions, with O(1)
+ * schedule and cancel.
+ *
+ * Deadlines are rounded up to the granularity of the wheel (e.g. 1 ms or
+ * the server tick). Advance the wheel once per frame or tick with the
+ * current frame time to call the callbacks of all timers whose deadline
+ * passed. Timers due in the same granule are called in schedule order.
+ *
+ * The wheel has KAIZEN_TIMER_WHEEL_LEVEL_COUNT levels of
+ * KAIZEN_TIMER_WHEEL_SLOT_COUNT slots, each level covering 64 times the
+ * span of the level below (2^36 granules in total). Timers move down one
+ * level when the wheel reaches their span, timers beyond the wheel wait
+ * in its top level.
+ *
+ * Timers are owned by the caller and linked into the wheel, it never
+ * allocates memory. A wheel and its timers must only be used by one thread.
+ *
+ * <code>
+ * kaizen_timer_init(&respawn_timer, respawn, player);
+ * kaizen_timer_wheel_schedule(&wheel, &respawn_timer, &respawn_deadline);
+ * // once per tick
+ * kaizen_frame_time_query(&now);
+ * kaizen_timer_wheel_advance(&wheel, &now);
+ * </code>
+ */
+
+#ifndef KAIZEN_kaizen_timer_wheel_H
+#define KAIZEN_kaizen_timer_wheel_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+
+
+
+#define KAIZEN_TIMER_WHEEL_LEVEL_COUNT 6
+#define KAIZEN_TIMER_WHEEL_SLOT_BITS 6
+#define KAIZEN_TIMER_WHEEL_SLOT_COUNT (1 << KAIZEN_TIMER_WHEEL_SLOT_BITS)
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    struct kaizen_timer_s;
+
+    /**
+     * Called by kaizen_timer_wheel_advance once the deadline of @a timer
+     * passed. @a timer is no longer scheduled and can be scheduled again,
+     * e.g. for periodic timers.
+     */
+    typedef void (*kaizen_timer_func_t)(struct kaizen_timer_s* timer, void* context);
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_timer_link_s {
+        struct kaizen_timer_link_s* next;
+        struct kaizen_timer_link_s* previous;
+    };
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_timer_s {
+        struct kaizen_timer_link_s link;
+        uint64_t expiry_granule;
+        kaizen_timer_func_t func;
+        void* context;
+    };
+    typedef struct kaizen_timer_s kaizen_timer_t;
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_timer_wheel_s {
+        struct kaizen_timer_link_s slots[KAIZEN_TIMER_WHEEL_LEVEL_COUNT][KAIZEN_TIMER_WHEEL_SLOT_COUNT];
+        uint64_t granularity_ticks;
+        uint64_t next_granule;
+        uint64_t timer_count;
+    };
+    typedef struct kaizen_timer_wheel_s kaizen_timer_wheel_t;
+
+
+
+    /**
+     * Initializes an unscheduled @a timer calling @a func with @a context.
+     */
+    int kaizen_timer_init(struct kaizen_timer_s* timer,
+                          kaizen_timer_func_t func,
+                          void* context);
+
+    /**
+     * @a timer must not be scheduled.
+     */
+    int kaizen_timer_finalize(struct kaizen_timer_s* timer);
+
+    kaizen_bool kaizen_timer_is_scheduled(struct kaizen_timer_s const* timer);
+
+
+
+    /**
+     * Initializes an empty @a wheel starting at the frame time @a now with
+     * deadlines rounded up to @a granularity.
+     *
+     * Returns EINVAL if @a granularity is zero.
+     */
+    int kaizen_timer_wheel_init(struct kaizen_timer_wheel_s* wheel,
+                                struct kaizen_raw_frame_time_s const* now,
+                                struct kaizen_raw_frame_time_s const* granularity);
+
+    /**
+     * Unschedules all timers still scheduled without calling them.
+     */
+    int kaizen_timer_wheel_finalize(struct kaizen_timer_wheel_s* wheel);
+
+    /**
+     * Schedules @a timer to be called by the first advance reaching
+     * @a deadline. Timers already scheduled are rescheduled, deadlines
+     * already passed are called by the next advance.
+     */
+    int kaizen_timer_wheel_schedule(struct kaizen_timer_wheel_s* wheel,
+                                    struct kaizen_timer_s* timer,
+                                    struct kaizen_raw_frame_time_s const* deadline);
+
+    /**
+     * Unschedules @a timer if it is scheduled in @a wheel, safe to call from
+     * timer callbacks.
+     */
+    void kaizen_timer_wheel_cancel(struct kaizen_timer_wheel_s* wheel,
+                                   struct kaizen_timer_s* timer);
+
+    /**
+     * Calls the timers whose deadlines are not later than @a now, the frame
+     * time of the current frame or tick.
+     *
+     * Costs one step per granule passed while timers are scheduled, advance
+     * at least once per few granules.
+     */
+    int kaizen_timer_wheel_advance(struct kaizen_timer_wheel_s* wheel,
+                                   struct kaizen_raw_frame_time_s const* now);
+
+    uint64_t kaizen_timer_wheel_timer_count(struct kaizen_timer_wheel_s const* wheel);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_timer_wheel_H */
@@ -0,0 +1,520 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_zone.h for all platforms.
+ *
+ * Sampling decisions use a thread local xorshift generator so threads
+ * executing the same zone never share a cache line for the decision.
+ */
+
+#include "kaizen_zone.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_atomic.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_raw_hardware_counters.h"
+#include "kaizen_raw_scheduling_monitor.h"
+#include "kaizen_event.h"
+#include "kaizen_callstack.h"
+#include "kaizen_thread_state.h"
+#include "kaizen_internal_thread_local.h"
+
+
+
+static KAIZEN_THREAD_LOCAL uint32_t kaizen_internal_zone_random_state = 0;
+
+
+
+static uint32_t kaizen_internal_zone_random(void);
+static uint32_t kaizen_internal_zone_random(void)
+{
+    uint32_t x = kaizen_internal_zone_random_state;
+
+    if (0 == x) {
+        /* The address of the thread local differs between threads. */
+        x = (uint32_t)((size_t)&kaizen_internal_zone_random_state) ^ 0x9e3779b9u;
+        x = (0 == x) ? 0x9e3779b9u : x;
+    }
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    kaizen_internal_zone_random_state = x;
+
+    return x;
+}
+
+
+
+/**
+ * Packs @a interval and the threshold of kaizen_internal_zone_random values
+ * sampling one in @a interval executions into one word.
+ */
+static uint64_t kaizen_internal_zone_sampling(uint32_t interval);
+uint64_t kaizen_internal_zone_sampling(uint32_t interval)
+{
+    return ((uint64_t)interval << 32) | (uint64_t)(0xffffffffu / interval);
+}
+
+
+
+int kaizen_zone_init(struct kaizen_zone_s* zone,
+                     char const* name,
+                     uint32_t id)
+{
+    assert(NULL != zone);
+    assert(NULL != name);
+
+    zone->name = name;
+    zone->id = id;
+    kaizen_atomic_uint64_store_release(&(zone->sampling), kaizen_internal_zone_sampling(1u));
+    kaizen_atomic_uint32_store_release(&(zone->sample_count), 0u);
+    kaizen_atomic_uint32_store_release(&(zone->sampler_slot), KAIZEN_ZONE_NO_SAMPLER_SLOT);
+    kaizen_atomic_uint32_store_release(&(zone->callstack_depth), 0u);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_zone_finalize(struct kaizen_zone_s* zone)
+{
+    assert(NULL != zone);
+    (void)zone;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+char const* kaizen_zone_name(struct kaizen_zone_s const* zone)
+{
+    assert(NULL != zone);
+
+    return zone->name;
+}
+
+
+
+uint32_t kaizen_zone_id(struct kaizen_zone_s const* zone)
+{
+    assert(NULL != zone);
+
+    return zone->id;
+}
+
+
+
+int kaizen_zone_set_sample_interval(struct kaizen_zone_s* zone,
+                                    uint32_t interval)
+{
+    assert(NULL != zone);
+
+    if (0u == interval) {
+        return EINVAL;
+    }
+
+    /* One store, a racing begin samples with either the old or the new
+     * interval and records the one it sampled with.
+     */
+    kaizen_atomic_uint64_store_release(&(zone->sampling), kaizen_internal_zone_sampling(interval));
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+uint32_t kaizen_zone_sample_interval(struct kaizen_zone_s const* zone)
+{
+    assert(NULL != zone);
+
+    return (uint32_t)(kaizen_atomic_uint64_load_acquire(&(zone->sampling)) >> 32);
+}
+
+
+
+uint32_t kaizen_zone_exchange_sample_count(struct kaizen_zone_s* zone)
+{
+    assert(NULL != zone);
+
+    return kaizen_atomic_uint32_exchange(&(zone->sample_count), 0u);
+}
+
+
+
+void kaizen_zone_set_sampler_slot(struct kaizen_zone_s* zone,
+                                  uint32_t slot)
+{
+    assert(NULL != zone);
+
+    kaizen_atomic_uint32_store_release(&(zone->sampler_slot), slot);
+}
+
+
+
+uint32_t kaizen_zone_sampler_slot(struct kaizen_zone_s const* zone)
+{
+    assert(NULL != zone);
+
+    return kaizen_atomic_uint32_load_acquire(&(zone->sampler_slot));
+}
+
+
+
+int kaizen_zone_set_callstack_depth(struct kaizen_zone_s* zone,
+                                    uint32_t depth)
+{
+    assert(NULL != zone);
+
+    if (KAIZEN_CALLSTACK_MAX_DEPTH < depth) {
+        return EINVAL;
+    }
+
+    kaizen_atomic_uint32_store_release(&(zone->callstack_depth), depth);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+uint32_t kaizen_zone_callstack_depth(struct kaizen_zone_s const* zone)
+{
+    assert(NULL != zone);
+
+    return kaizen_atomic_uint32_load_acquire(&(zone->callstack_depth));
+}
+
+
+
+int kaizen_zone_record_name(struct kaizen_zone_s const* zone)
+{
+    assert(NULL != zone);
+    assert(NULL != zone->name);
+
+    struct kaizen_raw_frame_time_s const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+    struct kaizen_raw_frame_time_s now = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int errc = kaizen_frame_time_query(&now);
+
+    char const* name = zone->name;
+    kaizen_bool is_terminated = KAIZEN_FALSE;
+    uint16_t chunk_index = 0;
+
+    /* Each event carries eight bytes, the last one includes the zero byte. */
+    while (KAIZEN_SUCCESS == errc && KAIZEN_FALSE == is_terminated) {
+        uint64_t chunk = 0u;
+        unsigned int i = 0;
+
+        for (i = 0; i < 8u && KAIZEN_FALSE == is_terminated; ++i) {
+            if ('\0' == *name) {
+                is_terminated = KAIZEN_TRUE;
+            } else {
+                chunk |= (uint64_t)(unsigned char)*name << (8u * i);
+                ++name;
+            }
+        }
+
+        errc = kaizen_event_record_with_flags(kaizen_zone_name_event_type,
+                                              zone->id,
+                                              &now,
+                                              &zero,
+                                              chunk,
+                                              chunk_index);
+        ++chunk_index;
+    }
+
+    return errc;
+}
+
+
+
+int kaizen_zone_begin(struct kaizen_zone_s* zone,
+                      struct kaizen_zone_scope_s* scope)
+{
+    assert(NULL != zone);
+    assert(NULL != scope);
+
+    scope->zone = zone;
+    scope->thread_state = kaizen_thread_state_of_current_thread();
+
+    /* Track unsampled executions too so samples and nested zones always see
+     * the innermost zone.
+     */
+    if (NULL != scope->thread_state) {
+        kaizen_thread_state_push_zone(scope->thread_state, zone->id);
+    }
+
+    uint64_t const sampling = kaizen_atomic_uint64_load_acquire(&(zone->sampling));
+    uint32_t const interval = (uint32_t)(sampling >> 32);
+
+    if (1u != interval
+        && kaizen_internal_zone_random() > (uint32_t)sampling) {
+
+        scope->sample_interval = 0u;
+
+        return KAIZEN_SUCCESS;
+    }
+
+    /* Read counters first so their reads stay out of the measured time. */
+    scope->scheduling_monitor = kaizen_scheduling_monitor_of_current_thread();
+
+    if (NULL != scope->scheduling_monitor
+        && KAIZEN_SUCCESS != kaizen_scheduling_monitor_read(scope->scheduling_monitor, &(scope->scheduling_counts))) {
+
+        scope->scheduling_monitor = NULL;
+    }
+
+    scope->counters = kaizen_hardware_counters_of_current_thread();
+
+    if (NULL != scope->counters
+        && KAIZEN_SUCCESS != kaizen_hardware_counters_read(scope->counters, &(scope->counter_values))) {
+
+        scope->counters = NULL;
+    }
+
+    int const errc = kaizen_frame_time_query(&(scope->start));
+
+    if (KAIZEN_SUCCESS != errc) {
+        scope->sample_interval = 0u;
+
+        return errc;
+    }
+
+    scope->sample_interval = interval;
+
+    if (NULL != scope->thread_state) {
+        scope->suspended_ticks = kaizen_thread_state_suspended_ticks(scope->thread_state);
+        scope->switch_count = kaizen_thread_state_switch_count(scope->thread_state);
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+static int kaizen_internal_zone_record_counters(struct kaizen_zone_scope_s const* scope,
+                                                struct kaizen_hardware_counter_values_s const* now,
+                                                struct kaizen_raw_frame_time_s const* duration);
+int kaizen_internal_zone_record_counters(struct kaizen_zone_scope_s const* scope,
+                                         struct kaizen_hardware_counter_values_s const* now,
+                                         struct kaizen_raw_frame_time_s const* duration)
+{
+    int errc = KAIZEN_SUCCESS;
+
+    int i = 0;
+    for (i = 0; i < KAIZEN_HARDWARE_COUNTER_COUNT && KAIZEN_SUCCESS == errc; ++i) {
+        if (KAIZEN_FALSE == kaizen_hardware_counters_is_enabled(scope->counters, (kaizen_hardware_counter_t)i)) {
+            continue;
+        }
+
+        errc = kaizen_event_record_with_flags(kaizen_hardware_counter_event_type,
+                                              scope->zone->id,
+                                              &(scope->start),
+                                              duration,
+                                              now->values[i] - scope->counter_values.values[i],
+                                              (uint16_t)i);
+    }
+
+    return errc;
+}
+
+
+
+static uint16_t kaizen_internal_zone_scheduling_flags(struct kaizen_zone_scope_s const* scope);
+uint16_t kaizen_internal_zone_scheduling_flags(struct kaizen_zone_scope_s const* scope)
+{
+    struct kaizen_scheduling_counts_s now;
+
+    if (NULL == scope->scheduling_monitor) {
+        return 0u;
+    }
+
+    /* A fiber resumed the zone on another thread. */
+    if (kaizen_scheduling_monitor_of_current_thread() != scope->scheduling_monitor) {
+        return KAIZEN_ZONE_EVENT_MIGRATED_FLAG;
+    }
+
+    if (KAIZEN_SUCCESS != kaizen_scheduling_monitor_read(scope->scheduling_monitor, &now)) {
+        return 0u;
+    }
+
+    uint16_t flags = 0u;
+
+    if (now.involuntary_context_switch_count != scope->scheduling_counts.involuntary_context_switch_count) {
+        flags |= KAIZEN_ZONE_EVENT_DESCHEDULED_FLAG;
+    }
+
+    if (now.voluntary_context_switch_count != scope->scheduling_counts.voluntary_context_switch_count) {
+        flags |= KAIZEN_ZONE_EVENT_BLOCKED_FLAG;
+    }
+
+    if (now.migration_count != scope->scheduling_counts.migration_count) {
+        flags |= KAIZEN_ZONE_EVENT_MIGRATED_FLAG;
+    }
+
+    return flags;
+}
+
+
+
+/**
+ * Subtracts the time the fiber of @a scope was suspended since the zone
+ * began from @a duration.
+ */
+static int kaizen_internal_zone_exclude_suspension(struct kaizen_zone_scope_s const* scope,
+                                                   struct kaizen_raw_frame_time_s* duration);
+int kaizen_internal_zone_exclude_suspension(struct kaizen_zone_scope_s const* scope,
+                                            struct kaizen_raw_frame_time_s* duration)
+{
+    uint64_t const suspended_ticks = kaizen_thread_state_suspended_ticks(scope->thread_state) - scope->suspended_ticks;
+    uint64_t duration_ticks = 0;
+    int const errc = kaizen_frame_time_convert_to_ticks(duration, &duration_ticks);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    duration_ticks = (duration_ticks > suspended_ticks) ? (duration_ticks - suspended_ticks) : 0u;
+
+    return kaizen_frame_time_convert_from_ticks(duration, duration_ticks);
+}
+
+
+
+int kaizen_zone_end(struct kaizen_zone_scope_s* scope)
+{
+    assert(NULL != scope);
+    assert(NULL != scope->zone);
+
+    if (NULL != scope->thread_state) {
+        kaizen_thread_state_pop_zone(scope->thread_state);
+    }
+
+    if (0u == scope->sample_interval) {
+        return KAIZEN_SUCCESS;
+    }
+
+    struct kaizen_raw_frame_time_s now = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int errc = kaizen_frame_time_query(&now);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    /* Read counters right away, mirroring kaizen_zone_begin, so recording,
+     * the scheduling read and the stack walk stay out of the deltas. Zones
+     * resumed on another thread skip the read of the counters of the
+     * thread they began on.
+     */
+    struct kaizen_hardware_counter_values_s counter_values;
+    kaizen_bool const is_counted = (NULL != scope->counters
+                                    && kaizen_hardware_counters_of_current_thread() == scope->counters
+                                    && KAIZEN_SUCCESS == kaizen_hardware_counters_read(scope->counters, &counter_values)) ? KAIZEN_TRUE : KAIZEN_FALSE;
+
+    struct kaizen_raw_frame_time_s duration = KAIZEN_RAW_FRAME_TIME_ZERO;
+    errc = kaizen_frame_time_subtract(&now, &(scope->start), &duration);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    kaizen_bool const is_switched = (NULL != scope->thread_state
+                                     && scope->switch_count != kaizen_thread_state_switch_count(scope->thread_state)) ? KAIZEN_TRUE : KAIZEN_FALSE;
+
+    if (KAIZEN_TRUE == is_switched) {
+        errc = kaizen_internal_zone_exclude_suspension(scope, &duration);
+
+        if (KAIZEN_SUCCESS != errc) {
+            return errc;
+        }
+    }
+
+    /* Threads counting samples in their own state keep the shared zone
+     * count out of the hot path.
+     */
+    if (NULL == scope->thread_state
+        || KAIZEN_FALSE == kaizen_thread_state_count_sample(scope->thread_state,
+                                                            kaizen_atomic_uint32_load_acquire(&(scope->zone->sampler_slot)))) {
+
+        (void)kaizen_atomic_uint32_fetch_add(&(scope->zone->sample_count), 1u);
+    }
+
+    uint16_t flags = kaizen_internal_zone_scheduling_flags(scope);
+
+    if (NULL != scope->thread_state && 0u == kaizen_thread_state_depth(scope->thread_state)) {
+        flags |= KAIZEN_ZONE_EVENT_OUTERMOST_FLAG;
+    }
+
+    errc = kaizen_event_record_with_flags(kaizen_zone_event_type,
+                                          scope->zone->id,
+                                          &(scope->start),
+                                          &duration,
+                                          scope->sample_interval,
+                                          flags);
+
+    uint32_t const callstack_depth = kaizen_atomic_uint32_load_acquire(&(scope->zone->callstack_depth));
+
+    if (KAIZEN_SUCCESS == errc && 0u < callstack_depth && NULL != kaizen_callstack_table_of_current_thread()) {
+        uint64_t frames[KAIZEN_CALLSTACK_MAX_DEPTH];
+        uint32_t depth = 0u;
+
+        /* Skips the call inside kaizen_zone_end, a full table only drops the stack. */
+        if (KAIZEN_SUCCESS == kaizen_callstack_capture(1u, callstack_depth, frames, &depth) && 0u < depth) {
+            (void)kaizen_callstack_record(scope->zone->id, &(scope->start), &duration, frames, depth);
+        }
+    }
+
+    /* Counters of the resuming thread include the work of other fibers. */
+    if (KAIZEN_SUCCESS != errc || KAIZEN_FALSE == is_counted || KAIZEN_TRUE == is_switched) {
+        return errc;
+    }
+
+    return kaizen_internal_zone_record_counters(scope, &counter_values, &duration);
+}
+
+
+
+kaizen_bool kaizen_zone_scope_is_sampled(struct kaizen_zone_scope_s const* scope)
+{
+    assert(NULL != scope);
+
+    return (0u != scope->sample_interval) ? KAIZEN_TRUE : KAIZEN_FALSE;
+}
+
+
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Zones measure the runtime of a code section (e.g. a function or a game
+ * system update) and record it as kaizen_zone_event_type event into the
+ * event buffer of the calling thread (see kaizen_event.h).
+ *
+ * Each zone has a sample interval N. A zone with an interval of 1 records
+ * every execution, a zone with an interval of N records a random sample of
+ * one in N executions on average. Not recorded executions neither query the
+ * frame time nor touch the event buffer. Each recorded event stores the
+ * interval it was sampled with so counts and totals can be extrapolated.
+ *
+ * The sample interval is set explicitly or adapted automatically by a
+ * kaizen_zone_sampler (see kaizen_zone_sampler.h).
+ *
+ * Zones with a call stack depth additionally record the call stack of each
+ * recorded execution (see kaizen_callstack.h).
+ *
+ * Zones are typically static and shared by all threads executing the
+ * zone's code. The zone scope lives on the stack of the measuring thread:
+ * <code>
+ * static kaizen_zone_t physics_zone = KAIZEN_ZONE_INITIALIZER("physics", 1);
+ *
+ * kaizen_zone_scope_t scope;
+ * kaizen_zone_begin(&physics_zone, &scope);
+ * // ...
+ * kaizen_zone_end(&scope);
+ * </code>
+ */
+
+#ifndef KAIZEN_kaizen_zone_H
+#define KAIZEN_kaizen_zone_H
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_atomic.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_raw_hardware_counters.h>
+#include <kaizen/kaizen_raw_scheduling_monitor.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    struct kaizen_thread_state_s;
+
+
+    /**
+     * Sampler slot of zones not managed by a zone sampler.
+     */
+#define KAIZEN_ZONE_NO_SAMPLER_SLOT 0xffffffffu
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     *
+     * The sample interval (high half) and the random threshold derived from
+     * it (low half) share one word, so begin never pairs an interval with
+     * the threshold of another one.
+     */
+    struct kaizen_zone_s {
+        struct kaizen_atomic_uint64_s sampling;
+        char const* name;
+        uint32_t id;
+        struct kaizen_atomic_uint32_s sample_count;
+        struct kaizen_atomic_uint32_s sampler_slot;
+        struct kaizen_atomic_uint32_s callstack_depth;
+    };
+    typedef struct kaizen_zone_s kaizen_zone_t;
+
+    /**
+     * Static initializer for a zone recording every execution.
+     */
+#define KAIZEN_ZONE_INITIALIZER(name, id) {{0x1ffffffffull}, (name), (id), {0u}, {KAIZEN_ZONE_NO_SAMPLER_SLOT}, {0u}}
+
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_zone_scope_s {
+        struct kaizen_raw_frame_time_s start;
+        struct kaizen_zone_s* zone;
+        struct kaizen_thread_state_s* thread_state;
+        struct kaizen_raw_hardware_counters_s* counters;
+        struct kaizen_hardware_counter_values_s counter_values;
+        struct kaizen_raw_scheduling_monitor_s* scheduling_monitor;
+        struct kaizen_scheduling_counts_s scheduling_counts;
+        uint64_t suspended_ticks;
+        uint32_t switch_count;
+        uint32_t sample_interval;
+    };
+    typedef struct kaizen_zone_scope_s kaizen_zone_scope_t;
+
+
+
+    /**
+     * Initializes @a zone to record every execution.
+     *
+     * @a name must stay valid as long as the zone is used.
+     */
+    int kaizen_zone_init(struct kaizen_zone_s* zone,
+                         char const* name,
+                         uint32_t id);
+
+    int kaizen_zone_finalize(struct kaizen_zone_s* zone);
+
+    char const* kaizen_zone_name(struct kaizen_zone_s const* zone);
+
+    uint32_t kaizen_zone_id(struct kaizen_zone_s const* zone);
+
+    /**
+     * Sets the sample interval so the zone records one in @a interval
+     * executions. An interval of 1 records every execution.
+     *
+     * Can be called while other threads execute the zone.
+     *
+     * interval must be greater than 0.
+     */
+    int kaizen_zone_set_sample_interval(struct kaizen_zone_s* zone,
+                                        uint32_t interval);
+
+    uint32_t kaizen_zone_sample_interval(struct kaizen_zone_s const* zone);
+
+    /**
+     * Returns the number of executions recorded since the last call and
+     * resets the count.
+     *
+     * Executions recorded on threads whose thread state counts the samples
+     * of the zone itself are not included (see
+     * kaizen_zone_sampler_add_thread_state of kaizen_zone_sampler.h).
+     */
+    uint32_t kaizen_zone_exchange_sample_count(struct kaizen_zone_s* zone);
+
+    /**
+     * Sets the slot thread states count the recorded executions of @a zone
+     * in (see kaizen_thread_state_count_sample), called by the zone sampler
+     * managing the zone. KAIZEN_ZONE_NO_SAMPLER_SLOT counts them on the zone
+     * again.
+     */
+    void kaizen_zone_set_sampler_slot(struct kaizen_zone_s* zone,
+                                      uint32_t slot);
+
+    uint32_t kaizen_zone_sampler_slot(struct kaizen_zone_s const* zone);
+
+    /**
+     * Sets the number of callers whose return addresses recorded executions
+     * of @a zone capture into the callstack table attached to the calling
+     * thread (see kaizen_callstack.h). A depth of 0, the default, captures
+     * no stacks.
+     *
+     * Can be called while other threads execute the zone.
+     *
+     * Returns EINVAL if depth is greater than KAIZEN_CALLSTACK_MAX_DEPTH.
+     */
+    int kaizen_zone_set_callstack_depth(struct kaizen_zone_s* zone,
+                                        uint32_t depth);
+
+    uint32_t kaizen_zone_callstack_depth(struct kaizen_zone_s const* zone);
+
+    /**
+     * Records the name of @a zone as kaizen_zone_name_event_type events
+     * into the event buffer of the calling thread, so analysis tools print
+     * names instead of ids. Record the names of the zones once per capture,
+     * e.g. when a viewer connects to the stream server.
+     *
+     * Returns ESRCH if the calling thread has no event buffer attached and
+     * ENOMEM if it is full.
+     */
+    int kaizen_zone_record_name(struct kaizen_zone_s const* zone);
+
+
+
+    /**
+     * Pushes @a zone onto the depth stack of the thread state attached to
+     * the calling thread, if any (see kaizen_thread_state.h), and decides
+     * if this execution is sampled. If it is stores the start time in
+     * @a scope and reads the hardware counters and the scheduling monitor
+     * attached to the calling thread, if any (see
+     * kaizen_raw_hardware_counters.h and kaizen_raw_scheduling_monitor.h).
+     *
+     * Call kaizen_zone_end for every begin, even if begin failed, to pop
+     * the zone again.
+     *
+     * All parameters must not be NULL.
+     */
+    int kaizen_zone_begin(struct kaizen_zone_s* zone,
+                          struct kaizen_zone_scope_s* scope);
+
+    /**
+     * Pops the zone of @a scope from the thread state depth stack and
+     * records the zone event if the execution has been sampled, flagged if
+     * the scheduling monitor read at the begin saw the thread preempted,
+     * blocked or migrated, followed by one
+     * kaizen_hardware_counter_event_type event per enabled counter if
+     * counters were read at the begin.
+     *
+     * Zones with a call stack depth capture the stack of the caller of
+     * kaizen_zone_end and record it after the zone event if a callstack
+     * table is attached to the calling thread. Stacks are best effort and
+     * never fail the zone.
+     *
+     * Zones of fibers or coroutines (see kaizen_thread_state_switch_in)
+     * exclude the time the fiber was suspended from their duration. Zones
+     * resumed on another thread are flagged as migrated and record no
+     * hardware counters as these are per thread.
+     *
+     * Returns ESRCH if the calling thread has no event buffer attached and
+     * ENOMEM if it is full.
+     */
+    int kaizen_zone_end(struct kaizen_zone_scope_s* scope);
+
+    kaizen_bool kaizen_zone_scope_is_sampled(struct kaizen_zone_scope_s const* scope);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_zone_H */
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Macros to instrument code with zones (see kaizen_zone.h) that are
+ * stripped at compile time.
+ *
+ * Every zone belongs to a level: COARSE, FINE or VERBOSE. Define
+ * KAIZEN_ZONE_LEVEL before including this header (or via the build system)
+ * to select the highest compiled level:
+ *
+ *  - KAIZEN_ZONE_LEVEL_OFF (0): no zone is compiled, e.g. for retail builds.
+ *  - KAIZEN_ZONE_LEVEL_COARSE (1): only COARSE zones.
+ *  - KAIZEN_ZONE_LEVEL_FINE (2): COARSE and FINE zones.
+ *  - KAIZEN_ZONE_LEVEL_VERBOSE (3): all zones, the default.
+ *
+ * The level is selected by token pasting in the preprocessor, so macros of
+ * disabled zones expand to nothing the compiler could emit code for - no
+ * variable, no branch, no static initializer.
+ *
+ * <code>
+ * KAIZEN_ZONE_DEFINE(FINE, physics_zone, "physics", 1);
+ *
+ * void physics_update(void)
+ * {
+ *     KAIZEN_ZONE_BEGIN(FINE, physics_zone);
+ *     // ...
+ *     KAIZEN_ZONE_END(FINE, physics_zone);
+ * }
+ * </code>
+ *
+ * The level argument must be the plain token COARSE, FINE or VERBOSE.
+ *
+ * Define the same level in all translation units, e.g. via the build
+ * system. Inline functions compiled with different levels differ, which
+ * breaks the one definition rule in C++ (see kaizen_zone.hpp).
+ */
+
+#ifndef KAIZEN_kaizen_zone_macros_H
+#define KAIZEN_kaizen_zone_macros_H
+
+
+#include <kaizen/kaizen_zone.h>
+
+
+
+#define KAIZEN_ZONE_LEVEL_OFF 0
+#define KAIZEN_ZONE_LEVEL_COARSE 1
+#define KAIZEN_ZONE_LEVEL_FINE 2
+#define KAIZEN_ZONE_LEVEL_VERBOSE 3
+
+
+#if !defined(KAIZEN_ZONE_LEVEL)
+#   define KAIZEN_ZONE_LEVEL KAIZEN_ZONE_LEVEL_VERBOSE
+#endif
+
+
+#if KAIZEN_ZONE_LEVEL >= KAIZEN_ZONE_LEVEL_COARSE
+#   define KAIZEN_INTERNAL_ZONE_ENABLED_COARSE 1
+#else
+#   define KAIZEN_INTERNAL_ZONE_ENABLED_COARSE 0
+#endif
+
+#if KAIZEN_ZONE_LEVEL >= KAIZEN_ZONE_LEVEL_FINE
+#   define KAIZEN_INTERNAL_ZONE_ENABLED_FINE 1
+#else
+#   define KAIZEN_INTERNAL_ZONE_ENABLED_FINE 0
+#endif
+
+#if KAIZEN_ZONE_LEVEL >= KAIZEN_ZONE_LEVEL_VERBOSE
+#   define KAIZEN_INTERNAL_ZONE_ENABLED_VERBOSE 1
+#else
+#   define KAIZEN_INTERNAL_ZONE_ENABLED_VERBOSE 0
+#endif
+
+
+
+/* Two step paste so the enabled flag of the level is expanded first. */
+#define KAIZEN_INTERNAL_ZONE_PASTE(prefix, enabled) KAIZEN_INTERNAL_ZONE_PASTE_EXPANDED(prefix, enabled)
+#define KAIZEN_INTERNAL_ZONE_PASTE_EXPANDED(prefix, enabled) prefix##enabled
+
+#define KAIZEN_INTERNAL_ZONE_SELECT(prefix, level) KAIZEN_INTERNAL_ZONE_PASTE(prefix, KAIZEN_INTERNAL_ZONE_ENABLED_##level)
+
+
+/* A redundant declaration generates no code and keeps the trailing
+ * semicolon of the macro invocation legal at file scope.
+ */
+#define KAIZEN_INTERNAL_ZONE_DEFINE_0(variable, name, id) \
+    extern int kaizen_internal_zone_disabled_declaration
+#define KAIZEN_INTERNAL_ZONE_DEFINE_1(variable, name, id) \
+    static kaizen_zone_t variable = KAIZEN_ZONE_INITIALIZER(name, id)
+
+#define KAIZEN_INTERNAL_ZONE_BEGIN_0(variable) \
+    ((void)0)
+#define KAIZEN_INTERNAL_ZONE_BEGIN_1(variable) \
+    kaizen_zone_scope_t kaizen_internal_zone_scope_##variable; \
+    (void)kaizen_zone_begin(&(variable), &kaizen_internal_zone_scope_##variable)
+
+#define KAIZEN_INTERNAL_ZONE_END_0(variable) \
+    ((void)0)
+#define KAIZEN_INTERNAL_ZONE_END_1(variable) \
+    (void)kaizen_zone_end(&kaizen_internal_zone_scope_##variable)
+
+
+
+/**
+ * Defines a static zone named @a variable of @a level.
+ */
+#define KAIZEN_ZONE_DEFINE(level, variable, name, id) \
+    KAIZEN_INTERNAL_ZONE_SELECT(KAIZEN_INTERNAL_ZONE_DEFINE_, level)(variable, name, id)
+
+/**
+ * Begins an execution of zone @a variable. Declares the zone scope in the
+ * current block so it must be matched by KAIZEN_ZONE_END in the same block.
+ */
+#define KAIZEN_ZONE_BEGIN(level, variable) \
+    KAIZEN_INTERNAL_ZONE_SELECT(KAIZEN_INTERNAL_ZONE_BEGIN_, level)(variable)
+
+#define KAIZEN_ZONE_END(level, variable) \
+    KAIZEN_INTERNAL_ZONE_SELECT(KAIZEN_INTERNAL_ZONE_END_, level)(variable)
+
+
+#endif /* KAIZEN_kaizen_zone_macros_H */
@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of kaizen_zone_sampler.h for all platforms.
+ *
+ * The per frame budget of recordable samples is distributed by water
+ * filling: zones are visited from the least to the most executed one and
+ * each receives at most an even share of the budget still left, so budget
+ * not needed by rare zones flows to the hot ones.
+ */
+
+#include "kaizen_zone_sampler.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "kaizen_stddef.h"
+#include "kaizen_raw_frame_time.h"
+#include "kaizen_event.h"
+#include "kaizen_zone.h"
+#include "kaizen_thread_state.h"
+#include "kaizen_arena.h"
+
+
+#define KAIZEN_INTERNAL_ZONE_SAMPLER_CALIBRATION_COUNT 64
+#define KAIZEN_INTERNAL_ZONE_SAMPLER_DEFAULT_MAX_SAMPLE_INTERVAL 65536u
+
+
+
+static double kaizen_internal_zone_sampler_calibrate_sample_cost(void);
+double kaizen_internal_zone_sampler_calibrate_sample_cost(void)
+{
+    struct kaizen_event_s storage[KAIZEN_INTERNAL_ZONE_SAMPLER_CALIBRATION_COUNT];
+    struct kaizen_event_buffer_s buffer;
+    (void)kaizen_event_buffer_init(&buffer,
+                                   storage,
+                                   KAIZEN_INTERNAL_ZONE_SAMPLER_CALIBRATION_COUNT);
+
+    struct kaizen_raw_frame_time_s calibration_start = KAIZEN_RAW_FRAME_TIME_ZERO;
+    int errc = kaizen_frame_time_query(&calibration_start);
+
+    /* Replays what kaizen_zone_begin and kaizen_zone_end do for a sampled
+     * execution.
+     */
+    int i = 0;
+    for (i = 0; i < KAIZEN_INTERNAL_ZONE_SAMPLER_CALIBRATION_COUNT; ++i) {
+
+        struct kaizen_raw_frame_time_s end = KAIZEN_RAW_FRAME_TIME_ZERO;
+        struct kaizen_event_s event;
+        (void)kaizen_frame_time_query(&(event.time));
+        (void)kaizen_frame_time_query(&end);
+        (void)kaizen_frame_time_subtract(&end, &(event.time), &(event.duration));
+        event.value = 1;
+        event.id = (uint32_t)i;
+        event.type = (uint16_t)kaizen_zone_event_type;
+        event.flags = 0;
+
+        (void)kaizen_event_buffer_push(&buffer, &event);
+    }
+
+    struct kaizen_raw_frame_time_s calibration_end = KAIZEN_RAW_FRAME_TIME_ZERO;
+    struct kaizen_raw_frame_time_s calibration_duration = KAIZEN_RAW_FRAME_TIME_ZERO;
+    double nanoseconds = 0.0;
+
+    if (KAIZEN_SUCCESS == errc) {
+        errc = kaizen_frame_time_query(&calibration_end);
+    }
+
+    if (KAIZEN_SUCCESS == errc) {
+        errc = kaizen_frame_time_subtract(&calibration_end,
+                                          &calibration_start,
+                                          &calibration_duration);
+    }
+
+    if (KAIZEN_SUCCESS == errc) {
+        errc = kaizen_frame_time_convert_to_nanoseconds(&calibration_duration,
+                                                        &nanoseconds);
+    }
+
+    (void)kaizen_event_buffer_finalize(&buffer);
+
+    double const cost = nanoseconds / KAIZEN_INTERNAL_ZONE_SAMPLER_CALIBRATION_COUNT;
+
+    /* A sample never costs less than a nanosecond - also guards against
+     * timers too coarse to measure the calibration loop.
+     */
+    return (KAIZEN_SUCCESS == errc && 1.0 < cost) ? cost : 1.0;
+}
+
+
+
+int kaizen_zone_sampler_init(struct kaizen_zone_sampler_s* sampler,
+                             struct kaizen_zone_s** zone_storage,
+                             double* estimate_storage,
+                             size_t capacity,
+                             double overhead_budget)
+{
+    assert(NULL != sampler);
+    assert(NULL != zone_storage);
+    assert(NULL != estimate_storage);
+    assert(0 < capacity);
+
+    if (!(0.0 < overhead_budget)) {
+        return EINVAL;
+    }
+
+    sampler->zones = zone_storage;
+    sampler->estimated_executions = estimate_storage;
+    sampler->capacity = capacity;
+    sampler->count = 0;
+    sampler->overhead_budget = overhead_budget;
+    sampler->sample_cost_nanoseconds = kaizen_internal_zone_sampler_calibrate_sample_cost();
+    sampler->max_sample_interval = KAIZEN_INTERNAL_ZONE_SAMPLER_DEFAULT_MAX_SAMPLE_INTERVAL;
+    sampler->thread_state_count = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_zone_sampler_init_from_arena(struct kaizen_zone_sampler_s* sampler,
+                                        struct kaizen_arena_s* arena,
+                                        size_t capacity,
+                                        double overhead_budget)
+{
+    assert(NULL != sampler);
+    assert(NULL != arena);
+    assert(0 < capacity);
+
+    void* zone_storage = NULL;
+    int errc = kaizen_arena_allocate_persistent(arena,
+                                                capacity * sizeof(struct kaizen_zone_s*),
+                                                KAIZEN_ARENA_DEFAULT_ALIGNMENT,
+                                                &zone_storage);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    void* estimate_storage = NULL;
+    errc = kaizen_arena_allocate_persistent(arena,
+                                            capacity * sizeof(double),
+                                            KAIZEN_ARENA_DEFAULT_ALIGNMENT,
+                                            &estimate_storage);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    return kaizen_zone_sampler_init(sampler,
+                                    (struct kaizen_zone_s**)zone_storage,
+                                    (double*)estimate_storage,
+                                    capacity,
+                                    overhead_budget);
+}
+
+
+
+int kaizen_zone_sampler_finalize(struct kaizen_zone_sampler_s* sampler)
+{
+    assert(NULL != sampler);
+
+    size_t i = 0;
+    for (i = 0; i < sampler->count; ++i) {
+        kaizen_zone_set_sampler_slot(sampler->zones[i], KAIZEN_ZONE_NO_SAMPLER_SLOT);
+    }
+
+    for (i = 0; i < sampler->thread_state_count; ++i) {
+        kaizen_thread_state_set_sample_counts_collected(sampler->thread_states[i], KAIZEN_FALSE);
+    }
+
+    sampler->zones = NULL;
+    sampler->estimated_executions = NULL;
+    sampler->capacity = 0;
+    sampler->count = 0;
+    sampler->thread_state_count = 0;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_zone_sampler_add(struct kaizen_zone_sampler_s* sampler,
+                            struct kaizen_zone_s* zone)
+{
+    assert(NULL != sampler);
+    assert(NULL != zone);
+
+    size_t const count = sampler->count;
+
+    if (count >= sampler->capacity) {
+        return ENOMEM;
+    }
+
+    sampler->zones[count] = zone;
+    sampler->estimated_executions[count] = 0.0;
+    sampler->count = count + 1;
+
+    /* Adapt reorders the zones, the slot stays. Drop samples collected
+     * before the zone was managed.
+     */
+    kaizen_zone_set_sampler_slot(zone, (uint32_t)count);
+    (void)kaizen_zone_exchange_sample_count(zone);
+
+    size_t i = 0;
+    for (i = 0; i < sampler->thread_state_count && count < KAIZEN_THREAD_STATE_SAMPLE_COUNT_CAPACITY; ++i) {
+        (void)kaizen_thread_state_exchange_sample_count(sampler->thread_states[i], (uint32_t)count);
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_zone_sampler_add_thread_state(struct kaizen_zone_sampler_s* sampler,
+                                         struct kaizen_thread_state_s* state)
+{
+    assert(NULL != sampler);
+    assert(NULL != state);
+
+    size_t const count = sampler->thread_state_count;
+
+    if (KAIZEN_ZONE_SAMPLER_MAX_THREAD_STATE_COUNT <= count) {
+        return ENOMEM;
+    }
+
+    sampler->thread_states[count] = state;
+    sampler->thread_state_count = count + 1;
+
+    kaizen_thread_state_set_sample_counts_collected(state, KAIZEN_TRUE);
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_zone_sampler_remove_thread_state(struct kaizen_zone_sampler_s* sampler,
+                                            struct kaizen_thread_state_s* state)
+{
+    assert(NULL != sampler);
+    assert(NULL != state);
+
+    size_t i = 0;
+    for (i = 0; i < sampler->thread_state_count; ++i) {
+        if (state == sampler->thread_states[i]) {
+            kaizen_thread_state_set_sample_counts_collected(state, KAIZEN_FALSE);
+
+            --(sampler->thread_state_count);
+            sampler->thread_states[i] = sampler->thread_states[sampler->thread_state_count];
+
+            return KAIZEN_SUCCESS;
+        }
+    }
+
+    return ESRCH;
+}
+
+
+
+int kaizen_zone_sampler_set_sample_cost(struct kaizen_zone_sampler_s* sampler,
+                                        double cost_nanoseconds)
+{
+    assert(NULL != sampler);
+
+    if (!(0.0 < cost_nanoseconds)) {
+        return EINVAL;
+    }
+
+    sampler->sample_cost_nanoseconds = cost_nanoseconds;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+double kaizen_zone_sampler_sample_cost(struct kaizen_zone_sampler_s const* sampler)
+{
+    assert(NULL != sampler);
+
+    return sampler->sample_cost_nanoseconds;
+}
+
+
+
+int kaizen_zone_sampler_set_max_sample_interval(struct kaizen_zone_sampler_s* sampler,
+                                                uint32_t max_interval)
+{
+    assert(NULL != sampler);
+
+    if (0u == max_interval) {
+        return EINVAL;
+    }
+
+    sampler->max_sample_interval = max_interval;
+
+    return KAIZEN_SUCCESS;
+}
+
+
+
+int kaizen_zone_sampler_adapt(struct kaizen_zone_sampler_s* sampler,
+                              struct kaizen_raw_frame_time_s const* frame_duration)
+{
+    assert(NULL != sampler);
+    assert(NULL != frame_duration);
+
+    double frame_nanoseconds = 0.0;
+    int const errc = kaizen_frame_time_convert_to_nanoseconds(frame_duration,
+                                                              &frame_nanoseconds);
+
+    if (KAIZEN_SUCCESS != errc) {
+        return errc;
+    }
+
+    struct kaizen_zone_s** const zones = sampler->zones;
+    double* const estimates = sampler->estimated_executions;
+    size_t const count = sampler->count;
+
+    /* Extrapolate executions from the samples and smooth them over frames
+     * so a single unlucky frame without samples does not reset a hot zone
+     * to full rate recording.
+     */
+    size_t i = 0;
+    for (i = 0; i < count; ++i) {
+
+        double const interval = (double)kaizen_zone_sample_interval(zones[i]);
+        double samples = (double)kaizen_zone_exchange_sample_count(zones[i]);
+        uint32_t const slot = kaizen_zone_sampler_slot(zones[i]);
+
+        size_t t = 0;
+        for (t = 0; t < sampler->thread_state_count && slot < KAIZEN_THREAD_STATE_SAMPLE_COUNT_CAPACITY; ++t) {
+            samples += (double)kaizen_thread_state_exchange_sample_count(sampler->thread_states[t], slot);
+        }
+
+        estimates[i] = 0.5 * estimates[i] + 0.5 * samples * interval;
+    }
+
+    /* Insertion sort ascending by estimate - the number of zones is small
+     * and mostly sorted from the previous frame.
+     */
+    for (i = 1; i < count; ++i) {
+
+        struct kaizen_zone_s* const zone = zones[i];
+        double const estimate = estimates[i];
+
+        size_t j = i;
+        while (0 < j && estimates[j - 1] > estimate) {
+            zones[j] = zones[j - 1];
+            estimates[j] = estimates[j - 1];
+            --j;
+        }
+
+        zones[j] = zone;
+        estimates[j] = estimate;
+    }
+
+    double remaining_samples = frame_nanoseconds * sampler->overhead_budget
+                               / sampler->sample_cost_nanoseconds;
+    double const max_interval = (double)sampler->max_sample_interval;
+
+    for (i = 0; i < count; ++i) {
+
+        double const share = remaining_samples / (double)(count - i);
+        double const estimate = estimates[i];
+        double interval = 1.0;
+
+        if (estimate > share) {
+            interval = (1.0 < share) ? (estimate / share) : estimate;
+            interval = (interval < max_interval) ? interval : max_interval;
+            interval = (double)(uint32_t)(interval + 0.999999);
+        }
+
+        remaining_samples -= estimate / interval;
+        remaining_samples = (0.0 < remaining_samples) ? remaining_samples : 0.0;
+
+        (void)kaizen_zone_set_sample_interval(zones[i], (uint32_t)interval);
+    }
+
+    return KAIZEN_SUCCESS;
+}
+
+
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * A zone sampler adapts the sample intervals of its zones (see
+ * kaizen_zone.h) once per frame so the estimated recording overhead of all
+ * zones stays below a configured fraction of the frame time.
+ *
+ * The overhead budget is shared fairly: rarely executed zones record every
+ * execution, hot zones get the remaining budget split evenly and record one
+ * in N executions with N derived from their estimated execution count.
+ *
+ * Each recorded execution is counted for the sampler. Counting on the
+ * shared zone makes all threads executing a hot zone contend for one cache
+ * line, so add the thread states of the recording threads with
+ * kaizen_zone_sampler_add_thread_state and they count their executions
+ * themselves. The sampler sums the counts of all of them.
+ *
+ * The sampler is not thread-safe and is meant to be called by one thread,
+ * typically at the end of each frame:
+ * <code>
+ * kaizen_zone_sampler_adapt(&sampler, &frame_duration);
+ * </code>
+ */
+
+#ifndef KAIZEN_kaizen_zone_sampler_H
+#define KAIZEN_kaizen_zone_sampler_H
+
+
+#include <stddef.h>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_arena.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+    struct kaizen_thread_state_s;
+
+
+    /**
+     * Maximum number of thread states collected by one sampler.
+     */
+#define KAIZEN_ZONE_SAMPLER_MAX_THREAD_STATE_COUNT 64
+
+
+    /**
+     * Treat as opaque type and do not rely on implementation details.
+     */
+    struct kaizen_zone_sampler_s {
+        struct kaizen_zone_s** zones;
+        double* estimated_executions;
+        size_t capacity;
+        size_t count;
+        double overhead_budget;
+        double sample_cost_nanoseconds;
+        uint32_t max_sample_interval;
+        size_t thread_state_count;
+        struct kaizen_thread_state_s* thread_states[KAIZEN_ZONE_SAMPLER_MAX_THREAD_STATE_COUNT];
+    };
+    typedef struct kaizen_zone_sampler_s kaizen_zone_sampler_t;
+
+
+
+    /**
+     * Initializes @a sampler to manage up to @a capacity zones using the
+     * caller provided @a zone_storage and @a estimate_storage arrays of
+     * @a capacity elements each, which must outlive the sampler.
+     *
+     * @a overhead_budget is the fraction of the frame time all sampled zones
+     * may cost together, e.g. 0.01 for one percent. Must be greater than 0.
+     *
+     * Calibrates the cost of recording one zone execution by measuring the
+     * frame time queries and the event push it needs.
+     */
+    int kaizen_zone_sampler_init(struct kaizen_zone_sampler_s* sampler,
+                                 struct kaizen_zone_s** zone_storage,
+                                 double* estimate_storage,
+                                 size_t capacity,
+                                 double overhead_budget);
+
+    /**
+     * Like kaizen_zone_sampler_init but allocates the storage for
+     * @a capacity zones from the persistent part of @a arena.
+     *
+     * Returns ENOMEM if the arena is full.
+     */
+    int kaizen_zone_sampler_init_from_arena(struct kaizen_zone_sampler_s* sampler,
+                                            struct kaizen_arena_s* arena,
+                                            size_t capacity,
+                                            double overhead_budget);
+
+    /**
+     * Zones and thread states count on the zones again.
+     */
+    int kaizen_zone_sampler_finalize(struct kaizen_zone_sampler_s* sampler);
+
+    /**
+     * Adds @a zone to the zones whose sample interval is adapted.
+     *
+     * Returns ENOMEM if the sampler is full.
+     */
+    int kaizen_zone_sampler_add(struct kaizen_zone_sampler_s* sampler,
+                                struct kaizen_zone_s* zone);
+
+    /**
+     * Lets @a state count the recorded executions of the zones of
+     * @a sampler and collects the counts in kaizen_zone_sampler_adapt.
+     * Add each state to one sampler at most and remove it before finalizing
+     * it. Adding and removing must not race with adapt.
+     *
+     * Returns ENOMEM if KAIZEN_ZONE_SAMPLER_MAX_THREAD_STATE_COUNT states
+     * are collected already.
+     */
+    int kaizen_zone_sampler_add_thread_state(struct kaizen_zone_sampler_s* sampler,
+                                             struct kaizen_thread_state_s* state);
+
+    /**
+     * Stops collecting the counts of @a state, its counts since the last
+     * adapt are dropped.
+     *
+     * Returns ESRCH if @a state is not collected by @a sampler.
+     */
+    int kaizen_zone_sampler_remove_thread_state(struct kaizen_zone_sampler_s* sampler,
+                                                struct kaizen_thread_state_s* state);
+
+    /**
+     * Overrides the calibrated cost of recording one zone execution.
+     *
+     * @a cost_nanoseconds must be greater than 0.
+     */
+    int kaizen_zone_sampler_set_sample_cost(struct kaizen_zone_sampler_s* sampler,
+                                            double cost_nanoseconds);
+
+    double kaizen_zone_sampler_sample_cost(struct kaizen_zone_sampler_s const* sampler);
+
+    /**
+     * Sets the largest sample interval the sampler assigns. Defaults to
+     * 65536.
+     */
+    int kaizen_zone_sampler_set_max_sample_interval(struct kaizen_zone_sampler_s* sampler,
+                                                    uint32_t max_interval);
+
+    /**
+     * Collects the samples recorded since the last call, estimates the
+     * executions of each zone and assigns new sample intervals so that the
+     * estimated recording cost of the next frame stays below the overhead
+     * budget of @a frame_duration.
+     */
+    int kaizen_zone_sampler_adapt(struct kaizen_zone_sampler_s* sampler,
+                                  struct kaizen_raw_frame_time_s const* frame_duration);
+
+
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* KAIZEN_kaizen_zone_sampler_H */
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Allocation tracking hooks for C++ (see kaizen_allocation.h):
+ *
+ *  - tracking_allocator records the allocations of one container.
+ *  - KAIZEN_DEFINE_TRACKED_GLOBAL_NEW_DELETE replaces the global operator
+ *    new and delete to record every allocation via new. Expand it once in
+ *    one source file of the program.
+ *
+ * <code>
+ * // main.cpp
+ * KAIZEN_DEFINE_TRACKED_GLOBAL_NEW_DELETE
+ *
+ * std::vector<particle, kaizen::tracking_allocator<particle> > particles;
+ * </code>
+ *
+ * Allocations of threads without an attached event buffer are not recorded
+ * but cost a thread local lookup. The global operators store the
+ * allocation size in a header of allocation_header_size bytes in front of
+ * each block. Over-aligned new (C++17) is not tracked.
+ */
+
+#ifndef KAIZEN_kaizen_allocation_tracking_HPP
+#define KAIZEN_kaizen_allocation_tracking_HPP
+
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_allocation.h>
+
+
+
+namespace kaizen {
+
+    namespace detail {
+
+        // Keeps blocks behind the header aligned for any fundamental type.
+        std::size_t const allocation_header_size = 16;
+
+
+        inline void* tracked_allocate(std::size_t const size) noexcept
+        {
+            if (size > static_cast<std::size_t>(-1) - allocation_header_size) {
+                return nullptr;
+            }
+
+            void* const block = std::malloc(allocation_header_size + size);
+
+            if (nullptr == block) {
+                return nullptr;
+            }
+
+            *static_cast<std::size_t*>(block) = size;
+            (void)kaizen_allocation_record(size);
+
+            return static_cast<char*>(block) + allocation_header_size;
+        }
+
+
+        inline void tracked_deallocate(void* const pointer) noexcept
+        {
+            if (nullptr == pointer) {
+                return;
+            }
+
+            void* const block = static_cast<char*>(pointer) - allocation_header_size;
+            (void)kaizen_deallocation_record(*static_cast<std::size_t*>(block));
+            std::free(block);
+        }
+
+
+        inline void* tracked_allocate_or_throw(std::size_t const size)
+        {
+            void* const pointer = tracked_allocate(size);
+
+            if (nullptr == pointer) {
+                throw std::bad_alloc();
+            }
+
+            return pointer;
+        }
+
+    } // namespace detail
+
+
+
+    /**
+     * Allocator recording its allocations, independent of the global
+     * operator new.
+     */
+    template <typename T>
+    class tracking_allocator {
+    public:
+        typedef T value_type;
+
+        tracking_allocator() noexcept
+        {
+        }
+
+        template <typename U>
+        tracking_allocator(tracking_allocator<U> const&) noexcept
+        {
+        }
+
+        T* allocate(std::size_t const count)
+        {
+            if (count > static_cast<std::size_t>(-1) / sizeof(T)) {
+                throw std::bad_alloc();
+            }
+
+            void* const pointer = std::malloc(count * sizeof(T));
+
+            if (nullptr == pointer) {
+                throw std::bad_alloc();
+            }
+
+            (void)kaizen_allocation_record(count * sizeof(T));
+
+            return static_cast<T*>(pointer);
+        }
+
+        void deallocate(T* const pointer, std::size_t const count) noexcept
+        {
+            (void)kaizen_deallocation_record(count * sizeof(T));
+            std::free(pointer);
+        }
+    };
+
+
+    template <typename T, typename U>
+    bool operator==(tracking_allocator<T> const&, tracking_allocator<U> const&) noexcept
+    {
+        return true;
+    }
+
+
+    template <typename T, typename U>
+    bool operator!=(tracking_allocator<T> const&, tracking_allocator<U> const&) noexcept
+    {
+        return false;
+    }
+
+} // namespace kaizen
+
+
+
+#if defined(__cpp_sized_deallocation)
+#   define KAIZEN_INTERNAL_TRACKED_SIZED_DELETE \
+    void operator delete(void* pointer, std::size_t) noexcept { kaizen::detail::tracked_deallocate(pointer); } \
+    void operator delete[](void* pointer, std::size_t) noexcept { kaizen::detail::tracked_deallocate(pointer); }
+#else
+#   define KAIZEN_INTERNAL_TRACKED_SIZED_DELETE
+#endif
+
+#define KAIZEN_DEFINE_TRACKED_GLOBAL_NEW_DELETE \
+    void* operator new(std::size_t size) { return kaizen::detail::tracked_allocate_or_throw(size); } \
+    void* operator new[](std::size_t size) { return kaizen::detail::tracked_allocate_or_throw(size); } \
+    void* operator new(std::size_t size, std::nothrow_t const&) noexcept { return kaizen::detail::tracked_allocate(size); } \
+    void* operator new[](std::size_t size, std::nothrow_t const&) noexcept { return kaizen::detail::tracked_allocate(size); } \
+    void operator delete(void* pointer) noexcept { kaizen::detail::tracked_deallocate(pointer); } \
+    void operator delete[](void* pointer) noexcept { kaizen::detail::tracked_deallocate(pointer); } \
+    void operator delete(void* pointer, std::nothrow_t const&) noexcept { kaizen::detail::tracked_deallocate(pointer); } \
+    void operator delete[](void* pointer, std::nothrow_t const&) noexcept { kaizen::detail::tracked_deallocate(pointer); } \
+    KAIZEN_INTERNAL_TRACKED_SIZED_DELETE
+
+
+#endif /* KAIZEN_kaizen_allocation_tracking_HPP */
@@ -0,0 +1,1682 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Reading, writing and analyzing captures, i.e. recorded event streams
+ * (see kaizen_event_encoding.h). A capture is the stream header followed by
+ * event blocks, e.g. the bytes a viewer received from the stream server
+ * (see kaizen_raw_stream_server.h) or blocks written by capture_writer.
+ *
+ * <code>
+ * kaizen::capture_report const report = kaizen::analyze_capture_file("game.kzs");
+ * </code>
+ *
+ * analyze_capture_file decodes and analyzes a capture block by block, so
+ * captures of any size are analyzed with constant memory, read_capture
+ * holds all events of a capture in memory, e.g. to filter or merge them.
+ *
+ * Blocks are decoded and analyzed in parallel, also the blocks of a single
+ * stream. Zone events are attributed to the frame (see
+ * kaizen_frame_event_type) they begin in.
+ * Captures without frame events are analyzed as one frame.
+ *
+ * compare_reports detects zones which regressed or improved significantly
+ * between two captures, e.g. to fail nightly performance tests.
+ *
+ * merge_captures combines the captures of several drains or processes,
+ * compress_capture rewrites a capture with compressed blocks.
+ *
+ * Malformed captures throw std::system_error with EINVAL.
+ */
+
+#ifndef KAIZEN_kaizen_capture_analysis_HPP
+#define KAIZEN_kaizen_capture_analysis_HPP
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_event_encoding.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_raw_hardware_counters.h>
+
+
+
+namespace kaizen {
+
+    /**
+     * Decoded event with times in ticks of the capturing platform.
+     */
+    struct capture_event {
+        std::uint64_t time;
+        std::uint64_t duration;
+        std::uint64_t value;
+        std::uint32_t id;
+        std::uint32_t stream_id;
+        std::uint16_t type;
+        std::uint16_t flags;
+    };
+
+
+    /**
+     * Events in capture order, i.e. ordered per stream but not across
+     * streams.
+     */
+    struct capture {
+        std::uint64_t ticks_per_second;
+        std::vector<capture_event> events;
+    };
+
+
+    struct zone_report {
+        std::uint32_t zone_id;
+        std::string name;
+        std::uint64_t count;
+        double total_seconds;
+        double self_seconds;
+        double p50_seconds;
+        double p95_seconds;
+        double p99_seconds;
+        double max_seconds;
+        std::vector<double> frame_seconds;
+        std::uint64_t hardware_counter_sample_count;
+        std::uint64_t hardware_counter_totals[KAIZEN_HARDWARE_COUNTER_COUNT];
+        std::uint64_t allocation_count;
+        std::uint64_t allocated_bytes;
+        std::uint64_t deallocation_count;
+        std::uint64_t deallocated_bytes;
+        std::uint64_t descheduled_count;
+        std::uint64_t migrated_count;
+    };
+
+
+    struct frame_report {
+        std::uint64_t frame_number;
+        double begin_seconds;
+        double duration_seconds;
+    };
+
+
+    /**
+     * Zones are ordered by id, frames by begin time. Zone names are taken
+     * from kaizen_zone_name_event_type events (see kaizen_zone_record_name)
+     * and empty for zones the capture does not name.
+     *
+     * Count, total and self time of sampled zones are scaled by their sample
+     * interval to estimate all executions, percentiles and maximum are taken
+     * from the recorded executions. Percentiles are read from a histogram
+     * and are off by less than 1% for durations above 256 ticks.
+     *
+     * The frame_seconds of a zone hold its total time in each frame it ran
+     * in, in frame order.
+     *
+     * Hardware counter totals sum the deltas of the recorded executions
+     * measured with counters (see kaizen_raw_hardware_counters.h), indexed by
+     * kaizen_hardware_counter. Compare ratios, e.g. instructions per cycle,
+     * as they are not scaled by sample intervals.
+     *
+     * Allocations and deallocations (see kaizen_allocation.h) count towards
+     * the innermost zone open when they happened, like self time.
+     *
+     * Descheduled and migrated counts are the recorded executions flagged by
+     * a scheduling monitor (see kaizen_raw_scheduling_monitor.h), use
+     * exclude_descheduled_zones to analyze without them.
+     */
+    struct capture_report {
+        std::vector<zone_report> zones;
+        std::vector<frame_report> frames;
+    };
+
+
+    struct zone_difference {
+        std::uint32_t zone_id;
+        zone_report baseline;
+        zone_report current;
+    };
+
+
+    enum class zone_change {
+        none,
+        regression,
+        improvement
+    };
+
+
+    /**
+     * Result of the Mann-Whitney U test of the per-frame times of a zone in
+     * two captures. confidence is one minus the two-sided p-value,
+     * probability_slower the probability that a frame of the current
+     * capture spends more time in the zone than a baseline frame.
+     */
+    struct zone_comparison {
+        std::uint32_t zone_id;
+        std::string name;
+        std::size_t baseline_frame_count;
+        std::size_t current_frame_count;
+        double baseline_median_seconds;
+        double current_median_seconds;
+        double z_score;
+        double p_value;
+        double confidence;
+        double probability_slower;
+        zone_change change;
+    };
+
+
+
+    namespace detail {
+
+        inline void throw_on_capture_error(int const error_code, char const* what)
+        {
+            if (KAIZEN_SUCCESS != error_code) {
+                throw std::system_error(error_code, std::generic_category(), what);
+            }
+        }
+
+        inline unsigned default_thread_count()
+        {
+            unsigned const count = std::thread::hardware_concurrency();
+            return (0 == count) ? 1 : count;
+        }
+
+        /**
+         * Calls func(begin, end, worker) for thread_count contiguous ranges
+         * of [0, count), each on its own thread.
+         */
+        template <typename Func>
+        void parallel_for(std::size_t const count, unsigned thread_count, Func func)
+        {
+            if (count < thread_count) {
+                thread_count = static_cast<unsigned>(count);
+            }
+
+            if (thread_count <= 1) {
+                func(std::size_t(0), count, 0u);
+                return;
+            }
+
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count);
+
+            for (unsigned worker = 0; worker < thread_count; ++worker) {
+                std::size_t const begin = count * worker / thread_count;
+                std::size_t const end = count * (worker + 1) / thread_count;
+                threads.push_back(std::thread(func, begin, end, worker));
+            }
+
+            for (std::size_t i = 0; i < threads.size(); ++i) {
+                threads[i].join();
+            }
+        }
+
+
+        inline std::uint64_t read_capture_header(std::istream& stream)
+        {
+            std::uint8_t header[KAIZEN_EVENT_STREAM_HEADER_SIZE];
+            stream.read(reinterpret_cast<char*>(header), sizeof(header));
+
+            std::uint64_t ticks_per_second = 0;
+            throw_on_capture_error(kaizen_event_stream_header_decode(header,
+                                                                     static_cast<std::size_t>(stream.gcount()),
+                                                                     &ticks_per_second),
+                                   "kaizen_event_stream_header_decode");
+
+            return ticks_per_second;
+        }
+
+
+        /**
+         * Decodes the block at @a block of at most @a size bytes into
+         * @a result, which has room for the event count of the block header,
+         * and returns the number of decoded events.
+         */
+        inline std::size_t decode_block(std::uint8_t const* block,
+                                        std::size_t const size,
+                                        std::vector<kaizen_event_t>& scratch,
+                                        capture_event* result)
+        {
+            std::size_t block_size = 0;
+            std::uint32_t event_count = 0;
+            std::uint32_t stream_id = 0;
+            throw_on_capture_error(kaizen_event_block_peek(block, size, &block_size, &event_count, &stream_id),
+                                   "kaizen_event_block_peek");
+
+            scratch.resize(event_count);
+            std::size_t decoded_event_count = 0;
+            throw_on_capture_error(kaizen_event_block_decode(block,
+                                                             size,
+                                                             scratch.empty() ? NULL : &scratch[0],
+                                                             scratch.size(),
+                                                             &decoded_event_count),
+                                   "kaizen_event_block_decode");
+
+            for (std::size_t i = 0; i < decoded_event_count; ++i) {
+                capture_event& event = result[i];
+                throw_on_capture_error(kaizen_frame_time_convert_to_ticks(&scratch[i].time, &event.time),
+                                       "kaizen_frame_time_convert_to_ticks");
+                throw_on_capture_error(kaizen_frame_time_convert_to_ticks(&scratch[i].duration, &event.duration),
+                                       "kaizen_frame_time_convert_to_ticks");
+                event.value = scratch[i].value;
+                event.id = scratch[i].id;
+                event.stream_id = stream_id;
+                event.type = scratch[i].type;
+                event.flags = scratch[i].flags;
+            }
+
+            return decoded_event_count;
+        }
+
+
+        struct capture_block {
+            std::size_t offset;
+            std::size_t size;
+            std::uint32_t event_count;
+            std::uint32_t stream_id;
+        };
+
+
+        /**
+         * Reads the blocks following the stream header in chunks of
+         * chunk_size bytes and calls func(data, blocks) with the complete
+         * blocks of each chunk. A truncated last block, e.g. of a stream cut
+         * off by the viewer, is ignored.
+         */
+        template <typename Func>
+        void for_each_chunk(std::istream& stream, std::size_t const chunk_size, Func func)
+        {
+            std::vector<std::uint8_t> chunk;
+            std::vector<capture_block> blocks;
+
+            while (stream) {
+                std::size_t const carried_size = chunk.size();
+                chunk.resize(carried_size + chunk_size);
+                stream.read(reinterpret_cast<char*>(&chunk[carried_size]), static_cast<std::streamsize>(chunk_size));
+                chunk.resize(carried_size + static_cast<std::size_t>(stream.gcount()));
+
+                std::uint8_t const* const data = chunk.empty() ? NULL : &chunk[0];
+                std::size_t const data_size = chunk.size();
+
+                blocks.clear();
+                std::size_t offset = 0;
+
+                for (;;) {
+                    capture_block block;
+                    block.offset = offset;
+                    block.size = 0;
+                    block.event_count = 0;
+                    block.stream_id = 0;
+                    int const errc = kaizen_event_block_peek(data + offset,
+                                                             data_size - offset,
+                                                             &block.size,
+                                                             &block.event_count,
+                                                             &block.stream_id);
+
+                    if (EAGAIN == errc || data_size - offset < block.size) {
+                        break;
+                    }
+
+                    throw_on_capture_error(errc, "kaizen_event_block_peek");
+                    blocks.push_back(block);
+                    offset += block.size;
+                }
+
+                if (!blocks.empty()) {
+                    func(data, blocks);
+                }
+
+                chunk.erase(chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(offset));
+            }
+        }
+
+
+        inline bool starts_before(capture_event const& lhs, capture_event const& rhs)
+        {
+            if (lhs.time != rhs.time) {
+                return lhs.time < rhs.time;
+            }
+
+            // Enclosing zones first.
+            return lhs.duration > rhs.duration;
+        }
+
+
+        inline bool has_earlier_frame(std::pair<std::size_t, double> const& lhs,
+                                      std::pair<std::size_t, double> const& rhs)
+        {
+            return lhs.first < rhs.first;
+        }
+
+
+        inline std::uint64_t sample_interval_of(capture_event const& zone)
+        {
+            return (0 == zone.value) ? 1 : zone.value;
+        }
+
+
+        inline unsigned most_significant_bit(std::uint64_t value)
+        {
+            unsigned bit = 0;
+
+            for (unsigned shift = 32; 0 < shift; shift /= 2) {
+                if (0 != (value >> shift)) {
+                    value >>= shift;
+                    bit += shift;
+                }
+            }
+
+            return bit;
+        }
+
+
+        /**
+         * Log-linear histogram of durations in ticks, mergeable across
+         * threads. Durations below 256 ticks are counted exactly, longer
+         * ones in 128 buckets per power of two, so percentiles are off by
+         * less than 1% while a zone needs at most a few thousand counts
+         * however often it ran. The maximum is kept exactly.
+         */
+        class duration_histogram {
+        public:
+            duration_histogram()
+            :   first_index_(0), counts_(), count_(0), max_(0)
+            {}
+
+            void add(std::uint64_t const duration)
+            {
+                add_to_bucket(index_of(duration), 1);
+                ++count_;
+                max_ = std::max(max_, duration);
+            }
+
+            void merge(duration_histogram const& other)
+            {
+                for (std::size_t i = 0; i < other.counts_.size(); ++i) {
+                    if (0 < other.counts_[i]) {
+                        add_to_bucket(other.first_index_ + i, other.counts_[i]);
+                    }
+                }
+
+                count_ += other.count_;
+                max_ = std::max(max_, other.max_);
+            }
+
+            /**
+             * Nearest rank percentile, the middle of the bucket holding the
+             * rank.
+             */
+            std::uint64_t percentile(double const fraction) const
+            {
+                if (0 == count_) {
+                    return 0;
+                }
+
+                std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count_)));
+                rank = (0 == rank) ? 1 : std::min(rank, count_);
+
+                if (count_ == rank) {
+                    return max_;
+                }
+
+                std::uint64_t counted = 0;
+                std::size_t i = 0;
+
+                while (counted + counts_[i] < rank) {
+                    counted += counts_[i];
+                    ++i;
+                }
+
+                return std::min(middle_of(first_index_ + i), max_);
+            }
+
+        private:
+            static std::size_t const exact_limit = 256;
+            static unsigned const sub_bucket_bits = 7;
+
+            static std::size_t index_of(std::uint64_t const duration)
+            {
+                if (duration < exact_limit) {
+                    return static_cast<std::size_t>(duration);
+                }
+
+                unsigned const shift = most_significant_bit(duration) - sub_bucket_bits;
+
+                return (static_cast<std::size_t>(shift) << sub_bucket_bits) + static_cast<std::size_t>(duration >> shift);
+            }
+
+            static std::uint64_t middle_of(std::size_t const index)
+            {
+                if (index < exact_limit) {
+                    return index;
+                }
+
+                std::size_t const sub_bucket_count = std::size_t(1) << sub_bucket_bits;
+                unsigned const shift = static_cast<unsigned>(index >> sub_bucket_bits) - 1;
+                std::uint64_t const low = static_cast<std::uint64_t>(sub_bucket_count + index % sub_bucket_count) << shift;
+
+                return low + ((std::uint64_t(1) << shift) >> 1);
+            }
+
+            void add_to_bucket(std::size_t const index, std::uint64_t const count)
+            {
+                if (counts_.empty()) {
+                    first_index_ = index;
+                } else if (index < first_index_) {
+                    counts_.insert(counts_.begin(), first_index_ - index, 0);
+                    first_index_ = index;
+                }
+
+                if (counts_.size() <= index - first_index_) {
+                    counts_.resize(index - first_index_ + 1, 0);
+                }
+
+                counts_[index - first_index_] += count;
+            }
+
+            std::size_t first_index_;
+            std::vector<std::uint64_t> counts_;
+            std::uint64_t count_;
+            std::uint64_t max_;
+        };
+
+
+        /**
+         * Statistics of a zone, totals holds the summed counts of the
+         * report.
+         */
+        struct zone_accumulator {
+            zone_accumulator()
+            :   totals(zone_report()), count(0), total_ticks(0.0), self_ticks(0.0), durations(), frame_ticks()
+            {
+                std::fill(counter_event_counts, counter_event_counts + KAIZEN_HARDWARE_COUNTER_COUNT, std::uint64_t(0));
+            }
+
+            void merge(zone_accumulator const& other)
+            {
+                for (std::size_t i = 0; i < KAIZEN_HARDWARE_COUNTER_COUNT; ++i) {
+                    totals.hardware_counter_totals[i] += other.totals.hardware_counter_totals[i];
+                    counter_event_counts[i] += other.counter_event_counts[i];
+                }
+
+                totals.allocation_count += other.totals.allocation_count;
+                totals.allocated_bytes += other.totals.allocated_bytes;
+                totals.deallocation_count += other.totals.deallocation_count;
+                totals.deallocated_bytes += other.totals.deallocated_bytes;
+                totals.descheduled_count += other.totals.descheduled_count;
+                totals.migrated_count += other.totals.migrated_count;
+
+                count += other.count;
+                total_ticks += other.total_ticks;
+                self_ticks += other.self_ticks;
+                durations.merge(other.durations);
+                frame_ticks.insert(frame_ticks.end(), other.frame_ticks.begin(), other.frame_ticks.end());
+            }
+
+            zone_report totals;
+            std::uint64_t counter_event_counts[KAIZEN_HARDWARE_COUNTER_COUNT];
+            std::uint64_t count;
+            double total_ticks;
+            double self_ticks;
+            duration_histogram durations;
+            std::vector<std::pair<std::size_t, double> > frame_ticks;
+        };
+
+        typedef std::map<std::uint32_t, zone_accumulator> zone_accumulator_map;
+        typedef std::map<std::uint32_t, std::string> zone_name_map;
+
+
+        /**
+         * Zone no zone recorded after it on its stream encloses yet.
+         */
+        struct unclaimed_zone {
+            std::uint64_t begin;
+            std::uint64_t end;
+            std::uint64_t duration;
+        };
+
+
+        /**
+         * Zone which claimed all unclaimed zones of its segment of a stream,
+         * so it may enclose zones left unclaimed by earlier segments too, or
+         * an outermost zone dropping them.
+         */
+        struct boundary_zone {
+            unclaimed_zone zone;
+            std::uint32_t id;
+            std::uint64_t sample_interval;
+            double child_ticks;
+            bool has_claimed_segment;
+            bool is_outermost;
+        };
+
+
+        struct stream_analysis {
+            stream_analysis()
+            :   unclaimed_zones(), excluded_zone(), has_excluded_zone(false), name(),
+                has_zone(false), has_name(false), leading_events(), boundary_zones()
+            {}
+
+            std::vector<unclaimed_zone> unclaimed_zones;
+            capture_event excluded_zone;
+            bool has_excluded_zone;
+            std::string name;
+
+            // Whether the segment set the state above, events continuing the
+            // state of the previous segment wait in leading_events.
+            bool has_zone;
+            bool has_name;
+            std::vector<capture_event> leading_events;
+            std::vector<boundary_zone> boundary_zones;
+        };
+
+        typedef std::map<std::uint32_t, stream_analysis> stream_analysis_map;
+
+
+        /**
+         * Accumulates the zones of a contiguous segment of a capture's
+         * events, e.g. a range of its blocks, in capture order.
+         *
+         * Zones are recorded when they end, so nested zones precede the zone
+         * enclosing them in their stream. Each stream keeps the zones not
+         * enclosed by a later zone yet, a zone takes the durations of the
+         * ones it encloses off its self time. Outermost zones (see
+         * KAIZEN_ZONE_EVENT_OUTERMOST_FLAG) drop them, so a stream only keeps
+         * the zones nested in open zones. Streams of threads without a
+         * thread state keep their outermost zones too.
+         *
+         * Segments start without the state of earlier events. Zones which
+         * may enclose zones of earlier segments, counter events of zones
+         * and name chunks of earlier segments are kept until carry_over
+         * continues the state left by the earlier segments, so segments are
+         * analyzed in parallel and the results do not depend on the split.
+         *
+         * Zones are attributed to the frame they begin in, work unit 0 holds
+         * zones beginning before the first frame.
+         */
+        class zone_analysis {
+        public:
+            zone_analysis(std::vector<std::uint64_t> const* frame_begins,
+                          bool const exclude_descheduled)
+            :   frame_begins_(frame_begins), exclude_descheduled_(exclude_descheduled), streams_(), zones_(), names_()
+            {}
+
+            void add(capture_event const& event)
+            {
+                stream_analysis& stream = streams_[event.stream_id];
+
+                if (kaizen_zone_event_type == event.type) {
+                    std::uint16_t const interrupted_flags = KAIZEN_ZONE_EVENT_DESCHEDULED_FLAG | KAIZEN_ZONE_EVENT_MIGRATED_FLAG;
+
+                    // Counter events directly follow the zone event of their stream.
+                    stream.has_zone = true;
+                    stream.has_excluded_zone = exclude_descheduled_ && (0 != (event.flags & interrupted_flags));
+                    stream.excluded_zone = event;
+
+                    if (!stream.has_excluded_zone) {
+                        add_zone(event, stream);
+                    }
+                } else if (kaizen_hardware_counter_event_type == event.type
+                           && KAIZEN_HARDWARE_COUNTER_COUNT > event.flags) {
+
+                    if (!stream.has_zone) {
+                        stream.leading_events.push_back(event);
+                    } else {
+                        add_counter(event, stream);
+                    }
+                } else if (kaizen_allocation_event_type == event.type) {
+                    zone_accumulator& zone = zones_[event.id];
+                    ++zone.totals.allocation_count;
+                    zone.totals.allocated_bytes += event.value;
+                } else if (kaizen_deallocation_event_type == event.type) {
+                    zone_accumulator& zone = zones_[event.id];
+                    ++zone.totals.deallocation_count;
+                    zone.totals.deallocated_bytes += event.value;
+                } else if (kaizen_zone_name_event_type == event.type) {
+                    stream.has_name = stream.has_name || (0 == event.flags);
+
+                    if (!stream.has_name) {
+                        stream.leading_events.push_back(event);
+                    } else {
+                        add_name_chunk(event, stream);
+                    }
+                }
+            }
+
+            /**
+             * Continues the state of the streams left by the earlier
+             * segments in @a streams with the segment added since the last
+             * call and leaves the state after the segment in @a streams.
+             * Call for the segments in capture order.
+             */
+            void carry_over(stream_analysis_map& streams)
+            {
+                for (stream_analysis_map::iterator it = streams_.begin(); it != streams_.end(); ++it) {
+                    stream_analysis& segment = it->second;
+                    stream_analysis& stream = streams[it->first];
+
+                    for (std::size_t i = 0; i < segment.leading_events.size(); ++i) {
+                        if (kaizen_zone_name_event_type == segment.leading_events[i].type) {
+                            add_name_chunk(segment.leading_events[i], stream);
+                        } else {
+                            add_counter(segment.leading_events[i], stream);
+                        }
+                    }
+
+                    for (std::size_t i = 0; i < segment.boundary_zones.size(); ++i) {
+                        claim_unclaimed_zones(segment.boundary_zones[i], stream.unclaimed_zones);
+                    }
+
+                    stream.unclaimed_zones.insert(stream.unclaimed_zones.end(),
+                                                  segment.unclaimed_zones.begin(),
+                                                  segment.unclaimed_zones.end());
+
+                    if (segment.has_zone) {
+                        stream.has_excluded_zone = segment.has_excluded_zone;
+                        stream.excluded_zone = segment.excluded_zone;
+                    }
+
+                    if (segment.has_name) {
+                        stream.name = segment.name;
+                    }
+                }
+
+                streams_.clear();
+            }
+
+            zone_accumulator_map const& zones() const
+            {
+                return zones_;
+            }
+
+            zone_name_map const& names() const
+            {
+                return names_;
+            }
+
+        private:
+            void add_zone(capture_event const& event, stream_analysis& stream)
+            {
+                std::uint64_t const end = event.time + event.duration;
+                double child_ticks = 0.0;
+
+                // Later recorded zones enclosing an unclaimed zone enclose all zones after it.
+                std::vector<unclaimed_zone>& unclaimed_zones = stream.unclaimed_zones;
+                while (!unclaimed_zones.empty()
+                       && event.time <= unclaimed_zones.back().begin
+                       && unclaimed_zones.back().end <= end) {
+
+                    child_ticks += static_cast<double>(unclaimed_zones.back().duration);
+                    unclaimed_zones.pop_back();
+                }
+
+                unclaimed_zone zone_extent;
+                zone_extent.begin = event.time;
+                zone_extent.end = end;
+                zone_extent.duration = event.duration;
+
+                bool const is_outermost = (0 != (event.flags & KAIZEN_ZONE_EVENT_OUTERMOST_FLAG));
+
+                // Zones after an outermost one do not reach earlier segments.
+                if ((unclaimed_zones.empty() || is_outermost)
+                    && (stream.boundary_zones.empty() || !stream.boundary_zones.back().is_outermost)) {
+
+                    boundary_zone boundary;
+                    boundary.zone = zone_extent;
+                    boundary.id = event.id;
+                    boundary.sample_interval = sample_interval_of(event);
+                    boundary.child_ticks = child_ticks;
+                    boundary.has_claimed_segment = unclaimed_zones.empty();
+                    boundary.is_outermost = is_outermost;
+                    stream.boundary_zones.push_back(boundary);
+                }
+
+                if (is_outermost) {
+                    unclaimed_zones.clear();
+                } else {
+                    unclaimed_zones.push_back(zone_extent);
+                }
+
+                std::size_t const unit = static_cast<std::size_t>(std::upper_bound(frame_begins_->begin(),
+                                                                                   frame_begins_->end(),
+                                                                                   event.time) - frame_begins_->begin());
+                double const duration = static_cast<double>(event.duration);
+                double const sample_interval = static_cast<double>(sample_interval_of(event));
+                double const ticks = duration * sample_interval;
+
+                zone_accumulator& zone = zones_[event.id];
+                zone.count += sample_interval_of(event);
+                zone.total_ticks += ticks;
+                zone.self_ticks += self_ticks_of(duration, child_ticks) * sample_interval;
+                zone.durations.add(event.duration);
+
+                if (0 != (event.flags & KAIZEN_ZONE_EVENT_DESCHEDULED_FLAG)) {
+                    ++zone.totals.descheduled_count;
+                }
+
+                if (0 != (event.flags & KAIZEN_ZONE_EVENT_MIGRATED_FLAG)) {
+                    ++zone.totals.migrated_count;
+                }
+
+                if (zone.frame_ticks.empty() || unit != zone.frame_ticks.back().first) {
+                    zone.frame_ticks.push_back(std::make_pair(unit, ticks));
+                } else {
+                    zone.frame_ticks.back().second += ticks;
+                }
+            }
+
+            /**
+             * Lets @a boundary claim the zones of earlier segments it
+             * encloses.
+             */
+            void claim_unclaimed_zones(boundary_zone const& boundary,
+                                       std::vector<unclaimed_zone>& unclaimed_zones)
+            {
+                double child_ticks = boundary.child_ticks;
+
+                while (boundary.has_claimed_segment
+                       && !unclaimed_zones.empty()
+                       && boundary.zone.begin <= unclaimed_zones.back().begin
+                       && unclaimed_zones.back().end <= boundary.zone.end) {
+
+                    child_ticks += static_cast<double>(unclaimed_zones.back().duration);
+                    unclaimed_zones.pop_back();
+                }
+
+                if (boundary.is_outermost) {
+                    unclaimed_zones.clear();
+                }
+
+                if (child_ticks != boundary.child_ticks) {
+                    double const duration = static_cast<double>(boundary.zone.duration);
+                    double const sample_interval = static_cast<double>(boundary.sample_interval);
+
+                    zones_[boundary.id].self_ticks += (self_ticks_of(duration, child_ticks) - self_ticks_of(duration, boundary.child_ticks)) * sample_interval;
+                }
+            }
+
+            static double self_ticks_of(double const duration, double const child_ticks)
+            {
+                return (child_ticks < duration) ? duration - child_ticks : 0.0;
+            }
+
+            void add_counter(capture_event const& event, stream_analysis const& stream)
+            {
+                if (stream.has_excluded_zone
+                    && stream.excluded_zone.id == event.id
+                    && stream.excluded_zone.time == event.time) {
+
+                    return;
+                }
+
+                // Every measured execution records each enabled counter once.
+                zone_accumulator& zone = zones_[event.id];
+                zone.totals.hardware_counter_totals[event.flags] += event.value;
+                zone.counter_event_counts[event.flags] += 1;
+            }
+
+            void add_name_chunk(capture_event const& event, stream_analysis& stream)
+            {
+                if (0 == event.flags) {
+                    stream.name.clear();
+                }
+
+                for (unsigned i = 0; i < 8; ++i) {
+                    char const c = static_cast<char>((event.value >> (8 * i)) & 0xff);
+
+                    if ('\0' == c) {
+                        names_[event.id] = stream.name;
+                        stream.name.clear();
+
+                        return;
+                    }
+
+                    stream.name.push_back(c);
+                }
+            }
+
+            std::vector<std::uint64_t> const* frame_begins_;
+            bool exclude_descheduled_;
+            stream_analysis_map streams_;
+            zone_accumulator_map zones_;
+            zone_name_map names_;
+        };
+
+
+        inline void add_frame(capture_event const& event,
+                              double const seconds_per_tick,
+                              capture_report& report,
+                              std::vector<std::uint64_t>& frame_begins)
+        {
+            frame_report frame;
+            frame.frame_number = event.value;
+            frame.begin_seconds = static_cast<double>(event.time) * seconds_per_tick;
+            frame.duration_seconds = static_cast<double>(event.duration) * seconds_per_tick;
+            report.frames.push_back(frame);
+            frame_begins.push_back(event.time);
+        }
+
+
+        inline void sort_frames(capture_report& report,
+                                std::vector<std::uint64_t>& frame_begins)
+        {
+            std::sort(frame_begins.begin(), frame_begins.end());
+            std::sort(report.frames.begin(),
+                      report.frames.end(),
+                      [](frame_report const& lhs, frame_report const& rhs) {
+                          return lhs.begin_seconds < rhs.begin_seconds;
+                      });
+        }
+
+
+        /**
+         * Merges the zones of the per thread analyses into report.zones,
+         * leaving out zones without recorded executions.
+         */
+        inline void report_zones(std::vector<zone_analysis> const& analyses,
+                                 double const seconds_per_tick,
+                                 unsigned const thread_count,
+                                 capture_report& report)
+        {
+            zone_accumulator_map zones;
+            zone_name_map names;
+
+            for (std::size_t i = 0; i < analyses.size(); ++i) {
+                zone_accumulator_map const& partial_zones = analyses[i].zones();
+                for (zone_accumulator_map::const_iterator it = partial_zones.begin(); it != partial_zones.end(); ++it) {
+                    zones[it->first].merge(it->second);
+                }
+
+                names.insert(analyses[i].names().begin(), analyses[i].names().end());
+            }
+
+            std::vector<zone_accumulator*> zone_accumulators;
+            for (zone_accumulator_map::iterator it = zones.begin(); it != zones.end(); ++it) {
+                if (0 == it->second.count) {
+                    continue;
+                }
+
+                zone_report zone = it->second.totals;
+                zone.zone_id = it->first;
+                zone.hardware_counter_sample_count = *std::max_element(it->second.counter_event_counts,
+                                                                       it->second.counter_event_counts + KAIZEN_HARDWARE_COUNTER_COUNT);
+
+                zone_name_map::const_iterator const name = names.find(it->first);
+                if (name != names.end()) {
+                    zone.name = name->second;
+                }
+
+                report.zones.push_back(zone);
+                zone_accumulators.push_back(&(it->second));
+            }
+
+            parallel_for(report.zones.size(),
+                         thread_count,
+                         [&](std::size_t const begin, std::size_t const end, unsigned) {
+                             for (std::size_t i = begin; i < end; ++i) {
+                                 zone_accumulator& accumulator = *zone_accumulators[i];
+
+                                 zone_report& zone = report.zones[i];
+                                 zone.count = accumulator.count;
+                                 zone.total_seconds = accumulator.total_ticks * seconds_per_tick;
+                                 zone.self_seconds = accumulator.self_ticks * seconds_per_tick;
+                                 zone.p50_seconds = static_cast<double>(accumulator.durations.percentile(0.50)) * seconds_per_tick;
+                                 zone.p95_seconds = static_cast<double>(accumulator.durations.percentile(0.95)) * seconds_per_tick;
+                                 zone.p99_seconds = static_cast<double>(accumulator.durations.percentile(0.99)) * seconds_per_tick;
+                                 zone.max_seconds = static_cast<double>(accumulator.durations.percentile(1.0)) * seconds_per_tick;
+
+                                 // Streams add to the same frames, merge them.
+                                 std::stable_sort(accumulator.frame_ticks.begin(),
+                                                  accumulator.frame_ticks.end(),
+                                                  has_earlier_frame);
+                                 for (std::size_t j = 0; j < accumulator.frame_ticks.size(); ++j) {
+                                     if (0 < j && accumulator.frame_ticks[j - 1].first == accumulator.frame_ticks[j].first) {
+                                         zone.frame_seconds.back() += accumulator.frame_ticks[j].second * seconds_per_tick;
+                                     } else {
+                                         zone.frame_seconds.push_back(accumulator.frame_ticks[j].second * seconds_per_tick);
+                                     }
+                                 }
+                             }
+                         });
+        }
+
+
+        inline double median(std::vector<double> values)
+        {
+            if (values.empty()) {
+                return 0.0;
+            }
+
+            std::size_t const middle = values.size() / 2;
+            std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(middle), values.end());
+            double const upper = values[middle];
+
+            if (0 != values.size() % 2) {
+                return upper;
+            }
+
+            double const lower = *std::max_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(middle));
+
+            return 0.5 * (lower + upper);
+        }
+
+
+        /**
+         * Mann-Whitney U test with average ranks for ties, tie corrected
+         * variance and continuity correction, using the normal approximation.
+         *
+         * See http://en.wikipedia.org/wiki/Mann%E2%80%93Whitney_U
+         */
+        inline void mann_whitney_u_test(std::vector<double> const& baseline,
+                                        std::vector<double> const& current,
+                                        zone_comparison& result)
+        {
+            double const n1 = static_cast<double>(baseline.size());
+            double const n2 = static_cast<double>(current.size());
+            double const n = n1 + n2;
+
+            result.z_score = 0.0;
+            result.p_value = 1.0;
+            result.probability_slower = 0.5;
+
+            if (0.0 == n1 || 0.0 == n2) {
+                return;
+            }
+
+            // Second marks samples of the current capture.
+            std::vector<std::pair<double, bool> > samples;
+            samples.reserve(baseline.size() + current.size());
+            for (std::size_t i = 0; i < baseline.size(); ++i) {
+                samples.push_back(std::make_pair(baseline[i], false));
+            }
+            for (std::size_t i = 0; i < current.size(); ++i) {
+                samples.push_back(std::make_pair(current[i], true));
+            }
+            std::sort(samples.begin(), samples.end());
+
+            double current_rank_sum = 0.0;
+            double tie_sum = 0.0;
+            std::size_t tie_begin = 0;
+
+            while (tie_begin < samples.size()) {
+                std::size_t tie_end = tie_begin + 1;
+                while (tie_end < samples.size() && samples[tie_end].first == samples[tie_begin].first) {
+                    ++tie_end;
+                }
+
+                double const tie_count = static_cast<double>(tie_end - tie_begin);
+                double const average_rank = 0.5 * static_cast<double>(tie_begin + 1 + tie_end);
+                for (std::size_t i = tie_begin; i < tie_end; ++i) {
+                    if (samples[i].second) {
+                        current_rank_sum += average_rank;
+                    }
+                }
+                tie_sum += tie_count * tie_count * tie_count - tie_count;
+
+                tie_begin = tie_end;
+            }
+
+            double const u = current_rank_sum - n2 * (n2 + 1.0) / 2.0;
+            double const mean = n1 * n2 / 2.0;
+            double const variance = n1 * n2 / 12.0 * ((n + 1.0) - tie_sum / (n * (n - 1.0)));
+
+            result.probability_slower = u / (n1 * n2);
+
+            if (0.0 >= variance) {
+                return;
+            }
+
+            double const difference = u - mean;
+            double const corrected = (0.0 < difference) ? std::max(0.0, difference - 0.5) : std::min(0.0, difference + 0.5);
+
+            result.z_score = corrected / std::sqrt(variance);
+            result.p_value = std::erfc(std::fabs(result.z_score) / std::sqrt(2.0));
+        }
+
+    } // namespace detail
+
+
+
+    /**
+     * Writes the stream header on construction and events as blocks of at
+     * most block_size bytes, compressed ones (see
+     * kaizen_event_block_encode_compressed) if is_compressed is true.
+     */
+    class capture_writer {
+    public:
+        capture_writer(std::ostream& stream,
+                       std::uint64_t const ticks_per_second,
+                       std::size_t const block_size = 64 * 1024,
+                       bool const is_compressed = false)
+        :   stream_(stream), block_(block_size), is_compressed_(is_compressed)
+        {
+            std::uint8_t header[KAIZEN_EVENT_STREAM_HEADER_SIZE];
+            detail::throw_on_capture_error(kaizen_event_stream_header_encode(ticks_per_second, header, sizeof(header)),
+                                           "kaizen_event_stream_header_encode");
+            stream_.write(reinterpret_cast<char const*>(header), sizeof(header));
+        }
+
+        void write(std::uint32_t const stream_id,
+                   kaizen_event_t const* events,
+                   std::size_t event_count)
+        {
+            while (0 < event_count) {
+                std::size_t encoded_event_count = 0;
+                std::size_t encoded_size = 0;
+                int const errc = is_compressed_
+                                 ? kaizen_event_block_encode_compressed(stream_id,
+                                                                        events,
+                                                                        event_count,
+                                                                        &block_[0],
+                                                                        block_.size(),
+                                                                        &encoded_event_count,
+                                                                        &encoded_size)
+                                 : kaizen_event_block_encode(stream_id,
+                                                             events,
+                                                             event_count,
+                                                             &block_[0],
+                                                             block_.size(),
+                                                             &encoded_event_count,
+                                                             &encoded_size);
+                detail::throw_on_capture_error(errc, "kaizen_event_block_encode");
+                stream_.write(reinterpret_cast<char const*>(&block_[0]), static_cast<std::streamsize>(encoded_size));
+
+                events += encoded_event_count;
+                event_count -= encoded_event_count;
+            }
+        }
+
+    private:
+        capture_writer(capture_writer const&);
+        capture_writer& operator=(capture_writer const&);
+
+        std::ostream& stream_;
+        std::vector<std::uint8_t> block_;
+        bool is_compressed_;
+    };
+
+
+
+    /**
+     * Reads a capture one block at a time, e.g. to convert captures too
+     * large to hold in memory. Reads the stream header on construction.
+     */
+    class capture_reader {
+    public:
+        explicit capture_reader(std::istream& stream)
+        :   stream_(stream), ticks_per_second_(detail::read_capture_header(stream)), block_(), decoded_()
+        {}
+
+        std::uint64_t ticks_per_second() const
+        {
+            return ticks_per_second_;
+        }
+
+        /**
+         * Replaces events with the events of the next block. Returns false
+         * at the end of the capture; a truncated last block is ignored.
+         */
+        bool read_block(std::vector<capture_event>& events)
+        {
+            events.clear();
+
+            block_.resize(KAIZEN_EVENT_BLOCK_HEADER_SIZE);
+            stream_.read(reinterpret_cast<char*>(&block_[0]), KAIZEN_EVENT_BLOCK_HEADER_SIZE);
+
+            if (KAIZEN_EVENT_BLOCK_HEADER_SIZE != stream_.gcount()) {
+                return false;
+            }
+
+            std::size_t block_size = 0;
+            std::uint32_t event_count = 0;
+            std::uint32_t stream_id = 0;
+            detail::throw_on_capture_error(kaizen_event_block_peek(&block_[0], block_.size(), &block_size, &event_count, &stream_id),
+                                           "kaizen_event_block_peek");
+
+            block_.resize(block_size);
+            std::streamsize const payload_size = static_cast<std::streamsize>(block_size - KAIZEN_EVENT_BLOCK_HEADER_SIZE);
+            stream_.read(reinterpret_cast<char*>(block_.data() + KAIZEN_EVENT_BLOCK_HEADER_SIZE), payload_size);
+
+            if (payload_size != stream_.gcount()) {
+                return false;
+            }
+
+            events.resize(event_count);
+            (void)detail::decode_block(&block_[0], block_.size(), decoded_, events.empty() ? NULL : &events[0]);
+
+            return true;
+        }
+
+    private:
+        capture_reader(capture_reader const&);
+        capture_reader& operator=(capture_reader const&);
+
+        std::istream& stream_;
+        std::uint64_t ticks_per_second_;
+        std::vector<std::uint8_t> block_;
+        std::vector<kaizen_event_t> decoded_;
+    };
+
+
+
+    /**
+     * Rewrites the capture read from @a capture with compressed blocks (see
+     * kaizen_event_block_encode_compressed) to @a compressed, one block at a
+     * time so captures of any size are compressed with constant memory.
+     */
+    inline void compress_capture(std::istream& capture,
+                                 std::ostream& compressed)
+    {
+        capture_reader reader(capture);
+        capture_writer writer(compressed, reader.ticks_per_second(), 64 * 1024, true);
+        std::vector<capture_event> events;
+        std::vector<kaizen_event_t> block;
+
+        while (reader.read_block(events)) {
+            block.resize(events.size());
+
+            for (std::size_t i = 0; i < events.size(); ++i) {
+                detail::throw_on_capture_error(kaizen_frame_time_convert_from_ticks(&block[i].time, events[i].time),
+                                               "kaizen_frame_time_convert_from_ticks");
+                detail::throw_on_capture_error(kaizen_frame_time_convert_from_ticks(&block[i].duration, events[i].duration),
+                                               "kaizen_frame_time_convert_from_ticks");
+                block[i].value = events[i].value;
+                block[i].id = events[i].id;
+                block[i].type = events[i].type;
+                block[i].flags = events[i].flags;
+            }
+
+            // All events of a block share its stream.
+            if (!events.empty()) {
+                writer.write(events[0].stream_id, &block[0], block.size());
+            }
+        }
+    }
+
+
+
+    /**
+     * Reads the capture in chunks of chunk_size bytes and decodes the blocks
+     * of each chunk on thread_count threads, each block directly into its
+     * place in the capture. A truncated last block, e.g. of a stream cut
+     * off by the viewer, is ignored.
+     *
+     * The capture holds all events, analyze large captures with
+     * analyze_capture_file instead.
+     */
+    inline capture read_capture(std::istream& stream,
+                                unsigned const thread_count = detail::default_thread_count(),
+                                std::size_t const chunk_size = 64 * 1024 * 1024)
+    {
+        capture result;
+        result.ticks_per_second = detail::read_capture_header(stream);
+
+        std::vector<std::vector<kaizen_event_t> > decoded(std::max(thread_count, 1u));
+        std::vector<std::size_t> first_events;
+
+        detail::for_each_chunk(stream,
+                               chunk_size,
+                               [&](std::uint8_t const* data, std::vector<detail::capture_block> const& blocks) {
+                                   std::size_t event_count = result.events.size();
+                                   first_events.resize(blocks.size());
+
+                                   for (std::size_t i = 0; i < blocks.size(); ++i) {
+                                       first_events[i] = event_count;
+                                       event_count += blocks[i].event_count;
+                                   }
+
+                                   result.events.resize(event_count);
+
+                                   detail::parallel_for(blocks.size(),
+                                                        thread_count,
+                                                        [&](std::size_t const begin, std::size_t const end, unsigned const worker) {
+                                                            for (std::size_t i = begin; i < end; ++i) {
+                                                                (void)detail::decode_block(data + blocks[i].offset,
+                                                                                           blocks[i].size,
+                                                                                           decoded[worker],
+                                                                                           result.events.data() + first_events[i]);
+                                                            }
+                                                        });
+                               });
+
+        return result;
+    }
+
+
+    inline capture read_capture_file(std::string const& path,
+                                     unsigned const thread_count = detail::default_thread_count())
+    {
+        std::ifstream stream(path.c_str(), std::ios::in | std::ios::binary);
+
+        if (!stream) {
+            throw std::system_error(ENOENT, std::generic_category(), path);
+        }
+
+        return read_capture(stream, thread_count);
+    }
+
+
+
+    /**
+     * Computes per-zone statistics and frame times. The events are split
+     * into thread_count contiguous segments, each accumulating its zones on
+     * its own thread (see detail::zone_analysis), so captures of a single
+     * thread are analyzed in parallel too. The results do not depend on the
+     * thread count.
+     */
+    inline capture_report analyze_capture(capture const& capture,
+                                          unsigned const thread_count = detail::default_thread_count())
+    {
+        double const seconds_per_tick = 1.0 / static_cast<double>(capture.ticks_per_second);
+
+        capture_report report;
+        std::vector<std::uint64_t> frame_begins;
+
+        for (std::size_t i = 0; i < capture.events.size(); ++i) {
+            if (kaizen_frame_event_type == capture.events[i].type) {
+                detail::add_frame(capture.events[i], seconds_per_tick, report, frame_begins);
+            }
+        }
+
+        detail::sort_frames(report, frame_begins);
+
+        std::vector<detail::zone_analysis> analyses(std::max(thread_count, 1u), detail::zone_analysis(&frame_begins, false));
+        detail::stream_analysis_map streams;
+
+        detail::parallel_for(capture.events.size(),
+                             thread_count,
+                             [&](std::size_t const begin, std::size_t const end, unsigned const worker) {
+                                 for (std::size_t i = begin; i < end; ++i) {
+                                     analyses[worker].add(capture.events[i]);
+                                 }
+                             });
+
+        for (std::size_t a = 0; a < analyses.size(); ++a) {
+            analyses[a].carry_over(streams);
+        }
+
+        detail::report_zones(analyses, seconds_per_tick, thread_count, report);
+
+        return report;
+    }
+
+
+
+    /**
+     * Analyzes the capture read from @a stream like analyze_capture of the
+     * read capture, but decodes and analyzes it one chunk of chunk_size
+     * bytes at a time, so memory does not grow with the capture size. The
+     * blocks of each chunk are split into thread_count contiguous segments
+     * analyzed in parallel.
+     * Zone executions the scheduler interrupted are left out like with
+     * exclude_descheduled_zones if exclude_descheduled is true.
+     *
+     * The stream is read twice, first for the frames, and must be
+     * seekable, e.g. a file. Throws std::system_error with ESPIPE
+     * otherwise.
+     */
+    inline capture_report analyze_capture(std::istream& stream,
+                                          unsigned const thread_count = detail::default_thread_count(),
+                                          bool const exclude_descheduled = false,
+                                          std::size_t const chunk_size = 4 * 1024 * 1024)
+    {
+        std::istream::pos_type const capture_begin = stream.tellg();
+
+        if (std::istream::pos_type(-1) == capture_begin) {
+            throw std::system_error(ESPIPE, std::generic_category(), "analyze_capture");
+        }
+
+        double const seconds_per_tick = 1.0 / static_cast<double>(detail::read_capture_header(stream));
+        unsigned const worker_count = std::max(thread_count, 1u);
+
+        capture_report report;
+        std::vector<std::uint64_t> frame_begins;
+        std::vector<std::vector<kaizen_event_t> > decoded(worker_count);
+        std::vector<std::vector<capture_event> > events(worker_count);
+        std::vector<std::vector<capture_event> > frames(worker_count);
+
+        detail::for_each_chunk(stream,
+                               chunk_size,
+                               [&](std::uint8_t const* data, std::vector<detail::capture_block> const& blocks) {
+                                   detail::parallel_for(blocks.size(),
+                                                        worker_count,
+                                                        [&](std::size_t const begin, std::size_t const end, unsigned const worker) {
+                                                            for (std::size_t i = begin; i < end; ++i) {
+                                                                events[worker].resize(blocks[i].event_count);
+                                                                std::size_t const event_count = detail::decode_block(data + blocks[i].offset,
+                                                                                                                     blocks[i].size,
+                                                                                                                     decoded[worker],
+                                                                                                                     events[worker].data());
+
+                                                                for (std::size_t j = 0; j < event_count; ++j) {
+                                                                    if (kaizen_frame_event_type == events[worker][j].type) {
+                                                                        frames[worker].push_back(events[worker][j]);
+                                                                    }
+                                                                }
+                                                            }
+                                                        });
+                               });
+
+        for (std::size_t worker = 0; worker < frames.size(); ++worker) {
+            for (std::size_t i = 0; i < frames[worker].size(); ++i) {
+                detail::add_frame(frames[worker][i], seconds_per_tick, report, frame_begins);
+            }
+        }
+
+        detail::sort_frames(report, frame_begins);
+
+        stream.clear();
+        stream.seekg(capture_begin);
+        (void)detail::read_capture_header(stream);
+
+        std::vector<detail::zone_analysis> analyses(worker_count, detail::zone_analysis(&frame_begins, exclude_descheduled));
+        detail::stream_analysis_map streams;
+
+        detail::for_each_chunk(stream,
+                               chunk_size,
+                               [&](std::uint8_t const* data, std::vector<detail::capture_block> const& blocks) {
+                                   detail::parallel_for(blocks.size(),
+                                                        worker_count,
+                                                        [&](std::size_t const begin, std::size_t const end, unsigned const worker) {
+                                                            for (std::size_t i = begin; i < end; ++i) {
+                                                                events[worker].resize(blocks[i].event_count);
+                                                                std::size_t const event_count = detail::decode_block(data + blocks[i].offset,
+                                                                                                                     blocks[i].size,
+                                                                                                                     decoded[worker],
+                                                                                                                     events[worker].data());
+
+                                                                for (std::size_t j = 0; j < event_count; ++j) {
+                                                                    analyses[worker].add(events[worker][j]);
+                                                                }
+                                                            }
+                                                        });
+
+                                   // Workers get the segments in capture order.
+                                   for (std::size_t a = 0; a < analyses.size(); ++a) {
+                                       analyses[a].carry_over(streams);
+                                   }
+                               });
+
+        detail::report_zones(analyses, seconds_per_tick, worker_count, report);
+
+        return report;
+    }
+
+
+    inline capture_report analyze_capture_file(std::string const& path,
+                                               unsigned const thread_count = detail::default_thread_count(),
+                                               bool const exclude_descheduled = false)
+    {
+        std::ifstream stream(path.c_str(), std::ios::in | std::ios::binary);
+
+        if (!stream) {
+            throw std::system_error(ENOENT, std::generic_category(), path);
+        }
+
+        return analyze_capture(stream, thread_count, exclude_descheduled);
+    }
+
+
+
+    /**
+     * Returns @a capture without the zone executions the scheduler
+     * interrupted (flagged descheduled or migrated) and their hardware
+     * counter events, e.g. to take percentiles of the code alone.
+     * Executions flagged blocked waited by themselves and are kept.
+     *
+     * Time the interrupted executions spent in enclosing zones remains
+     * in the self time of these zones.
+     */
+    inline capture exclude_descheduled_zones(capture const& capture)
+    {
+        std::uint16_t const interrupted_flags = KAIZEN_ZONE_EVENT_DESCHEDULED_FLAG | KAIZEN_ZONE_EVENT_MIGRATED_FLAG;
+
+        kaizen::capture result;
+        result.ticks_per_second = capture.ticks_per_second;
+        result.events.reserve(capture.events.size());
+
+        // Counter events directly follow the zone event of their stream.
+        std::map<std::uint32_t, capture_event const*> excluded_zones;
+
+        for (std::size_t i = 0; i < capture.events.size(); ++i) {
+            capture_event const& event = capture.events[i];
+
+            if (kaizen_zone_event_type == event.type) {
+                if (0 != (event.flags & interrupted_flags)) {
+                    excluded_zones[event.stream_id] = &event;
+
+                    continue;
+                }
+
+                excluded_zones.erase(event.stream_id);
+            } else if (kaizen_hardware_counter_event_type == event.type) {
+                std::map<std::uint32_t, capture_event const*>::const_iterator const excluded = excluded_zones.find(event.stream_id);
+
+                if (excluded != excluded_zones.end()
+                    && excluded->second->id == event.id
+                    && excluded->second->time == event.time) {
+
+                    continue;
+                }
+            }
+
+            result.events.push_back(event);
+        }
+
+        return result;
+    }
+
+
+
+    /**
+     * Merges @a captures, e.g. of the per NUMA node drains (see
+     * kaizen_event_drain.h), into one capture ordered by event end time,
+     * i.e. time plus duration.
+     *
+     * The events of a capture are not ordered by time: zones are recorded
+     * when they end but carry their start time, samples and call stack
+     * definitions are recorded in batches after the fact, and a drain
+     * interleaves the streams of its threads in poll order. The merge sorts
+     * all events by end time, events with equal end times keep their order
+     * within and across the captures, e.g. stack frame events stay behind
+     * their sample. Stream ids must be unique across the captures.
+     *
+     * Merges events while recording with kaizen_event_merge.h instead.
+     *
+     * Throws std::system_error with EINVAL if the captures disagree on
+     * ticks_per_second.
+     */
+    inline capture merge_captures(std::vector<capture> const& captures)
+    {
+        kaizen::capture result;
+        result.ticks_per_second = 0;
+
+        if (captures.empty()) {
+            return result;
+        }
+
+        result.ticks_per_second = captures[0].ticks_per_second;
+
+        std::size_t event_count = 0;
+
+        for (std::size_t i = 0; i < captures.size(); ++i) {
+            if (captures[i].ticks_per_second != result.ticks_per_second) {
+                throw std::system_error(EINVAL, std::generic_category(), "merge_captures");
+            }
+
+            event_count += captures[i].events.size();
+        }
+
+        result.events.reserve(event_count);
+
+        for (std::size_t i = 0; i < captures.size(); ++i) {
+            result.events.insert(result.events.end(), captures[i].events.begin(), captures[i].events.end());
+        }
+
+        std::stable_sort(result.events.begin(),
+                         result.events.end(),
+                         [](capture_event const& lhs, capture_event const& rhs) {
+                             return lhs.time + lhs.duration < rhs.time + rhs.duration;
+                         });
+
+        return result;
+    }
+
+
+
+    /**
+     * Returns the count longest frames, longest first.
+     */
+    inline std::vector<frame_report> worst_frames(capture_report const& report,
+                                                  std::size_t const count)
+    {
+        std::vector<frame_report> frames(report.frames);
+        std::size_t const worst_count = std::min(count, frames.size());
+
+        std::partial_sort(frames.begin(),
+                          frames.begin() + static_cast<std::ptrdiff_t>(worst_count),
+                          frames.end(),
+                          [](frame_report const& lhs, frame_report const& rhs) {
+                              return lhs.duration_seconds > rhs.duration_seconds;
+                          });
+        frames.resize(worst_count);
+
+        return frames;
+    }
+
+
+
+    /**
+     * Pairs the zones of two reports by id. Zones missing from one report
+     * are paired with an all zero report.
+     */
+    inline std::vector<zone_difference> diff_reports(capture_report const& baseline,
+                                                     capture_report const& current)
+    {
+        std::map<std::uint32_t, zone_difference> differences;
+
+        for (std::size_t i = 0; i < baseline.zones.size(); ++i) {
+            zone_difference& difference = differences[baseline.zones[i].zone_id];
+            difference.zone_id = baseline.zones[i].zone_id;
+            difference.baseline = baseline.zones[i];
+        }
+
+        for (std::size_t i = 0; i < current.zones.size(); ++i) {
+            zone_difference& difference = differences[current.zones[i].zone_id];
+            difference.zone_id = current.zones[i].zone_id;
+            difference.current = current.zones[i];
+        }
+
+        std::vector<zone_difference> result;
+        for (std::map<std::uint32_t, zone_difference>::iterator it = differences.begin(); it != differences.end(); ++it) {
+            it->second.baseline.zone_id = it->first;
+            it->second.current.zone_id = it->first;
+            result.push_back(it->second);
+        }
+
+        return result;
+    }
+
+
+
+    /**
+     * Compares the per-frame times of each zone of two reports with the
+     * Mann-Whitney U test, which neither assumes normally distributed frame
+     * times nor is skewed by a few outlier frames like comparing means.
+     *
+     * A zone regressed or improved if the change is significant at
+     * significance (the p-value is smaller) and the median per-frame time
+     * changed by at least min_relative_change, e.g. 0.02 to ignore tiny but
+     * significant changes in long captures.
+     */
+    inline std::vector<zone_comparison> compare_reports(capture_report const& baseline,
+                                                        capture_report const& current,
+                                                        double const significance = 0.01,
+                                                        double const min_relative_change = 0.0,
+                                                        unsigned const thread_count = detail::default_thread_count())
+    {
+        std::vector<zone_difference> const differences = diff_reports(baseline, current);
+        std::vector<zone_comparison> comparisons(differences.size());
+
+        detail::parallel_for(differences.size(),
+                             thread_count,
+                             [&](std::size_t const begin, std::size_t const end, unsigned) {
+                                 for (std::size_t i = begin; i < end; ++i) {
+                                     std::vector<double> const& before = differences[i].baseline.frame_seconds;
+                                     std::vector<double> const& after = differences[i].current.frame_seconds;
+
+                                     zone_comparison& comparison = comparisons[i];
+                                     comparison.zone_id = differences[i].zone_id;
+                                     comparison.name = differences[i].current.name.empty() ? differences[i].baseline.name : differences[i].current.name;
+                                     comparison.baseline_frame_count = before.size();
+                                     comparison.current_frame_count = after.size();
+                                     comparison.baseline_median_seconds = detail::median(before);
+                                     comparison.current_median_seconds = detail::median(after);
+                                     detail::mann_whitney_u_test(before, after, comparison);
+                                     comparison.confidence = 1.0 - comparison.p_value;
+
+                                     double const threshold = min_relative_change * comparison.baseline_median_seconds;
+                                     double const change = comparison.current_median_seconds - comparison.baseline_median_seconds;
+
+                                     comparison.change = zone_change::none;
+                                     if (comparison.p_value < significance) {
+                                         if (0.0 < comparison.z_score && threshold <= change) {
+                                             comparison.change = zone_change::regression;
+                                         } else if (0.0 > comparison.z_score && threshold <= -change) {
+                                             comparison.change = zone_change::improvement;
+                                         }
+                                     }
+                                 }
+                             });
+
+        return comparisons;
+    }
+
+} // namespace kaizen
+
+
+#endif /* KAIZEN_kaizen_capture_analysis_HPP */
@@ -0,0 +1,775 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Streaming conversion of captures (see kaizen_capture_analysis.hpp) into
+ * trace formats of existing viewers:
+ *
+ *  - export_chrome_trace writes the Chrome trace event JSON format for
+ *    chrome://tracing and https://ui.perfetto.dev
+ *  - export_perfetto_trace writes the Perfetto protobuf trace format.
+ *  - export_sample_folded_stacks, export_zone_folded_stacks and
+ *    export_zone_callstack_folded_stacks write the folded stacks of flame
+ *    graph tools, e.g.
+ *    https://github.com/brendangregg/FlameGraph and https://www.speedscope.app
+ *
+ * The trace exporters read and convert one block at a time, so captures of
+ * any size are exported with constant memory. Each capture stream (producing thread)
+ * becomes a thread track, zones, lock waits and holds, and frames become
+ * slices named after their type and id, e.g. "zone 3". Allocations become
+ * instant events, e.g. "allocation in zone 3" with the size in bytes.
+ * Hardware counter events are left out as they only annotate the zone
+ * preceding them, as are samples and call stacks which flame graphs show
+ * better.
+ *
+ * <code>
+ * std::ifstream capture("game.kzs", std::ios::binary);
+ * std::ofstream trace("game.json", std::ios::binary);
+ * kaizen::export_chrome_trace(capture, trace);
+ * </code>
+ *
+ * See https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+ * and https://perfetto.dev/docs/reference/trace-packet-proto
+ */
+
+#ifndef KAIZEN_kaizen_capture_export_HPP
+#define KAIZEN_kaizen_capture_export_HPP
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_allocation.h>
+#include <kaizen/kaizen_raw_sampler.h>
+#include <kaizen/kaizen_frame_time_converter.h>
+#include <kaizen/kaizen_capture_analysis.hpp>
+
+
+
+namespace kaizen {
+
+    namespace detail {
+
+        // Allocations take no time and become instant events.
+        inline bool is_instant_event(capture_event const& event)
+        {
+            return kaizen_allocation_event_type == event.type || kaizen_deallocation_event_type == event.type;
+        }
+
+
+        // Only annotate other events or belong into flame graphs.
+        inline bool is_trace_event(capture_event const& event)
+        {
+            return kaizen_hardware_counter_event_type != event.type
+                   && kaizen_sample_event_type != event.type
+                   && kaizen_stack_frame_event_type != event.type
+                   && kaizen_callstack_event_type != event.type
+                   && kaizen_zone_callstack_event_type != event.type
+                   && kaizen_zone_name_event_type != event.type;
+        }
+
+
+        inline std::string event_name(capture_event const& event)
+        {
+            char const* type_name = "event";
+
+            switch (event.type) {
+                case kaizen_zone_event_type:
+                    type_name = "zone";
+                    break;
+                case kaizen_lock_wait_event_type:
+                    type_name = "lock wait";
+                    break;
+                case kaizen_lock_hold_event_type:
+                    type_name = "lock hold";
+                    break;
+                case kaizen_frame_event_type:
+                    type_name = "frame";
+                    break;
+                case kaizen_allocation_event_type:
+                    type_name = "allocation";
+                    break;
+                case kaizen_deallocation_event_type:
+                    type_name = "deallocation";
+                    break;
+                default:
+                    break;
+            }
+
+            char name[64];
+
+            if (is_instant_event(event)) {
+                if (KAIZEN_ALLOCATION_NO_ZONE_ID == event.id) {
+                    return type_name;
+                }
+
+                std::snprintf(name, sizeof(name), "%s in zone %lu", type_name, static_cast<unsigned long>(event.id));
+
+                return name;
+            }
+
+            std::snprintf(name,
+                          sizeof(name),
+                          "%s %llu",
+                          type_name,
+                          static_cast<unsigned long long>((kaizen_frame_event_type == event.type) ? event.value : event.id));
+
+            return name;
+        }
+
+
+        inline char const* event_category(capture_event const& event)
+        {
+            switch (event.type) {
+                case kaizen_zone_event_type:
+                    return "zone";
+                case kaizen_lock_wait_event_type:
+                case kaizen_lock_hold_event_type:
+                    return "lock";
+                case kaizen_frame_event_type:
+                    return "frame";
+                case kaizen_allocation_event_type:
+                case kaizen_deallocation_event_type:
+                    return "memory";
+                default:
+                    return "event";
+            }
+        }
+
+
+        inline kaizen_frame_time_converter_t make_converter(std::uint64_t const ticks_per_second)
+        {
+            kaizen_frame_time_converter_t converter;
+            throw_on_capture_error(kaizen_frame_time_converter_init_with_ticks_per_second(&converter, ticks_per_second),
+                                   "kaizen_frame_time_converter_init_with_ticks_per_second");
+
+            return converter;
+        }
+
+
+        inline void write_varint(std::string& buffer, std::uint64_t value)
+        {
+            while (0x80 <= value) {
+                buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+                value >>= 7;
+            }
+
+            buffer.push_back(static_cast<char>(value));
+        }
+
+
+        inline void write_varint_field(std::string& buffer, std::uint32_t const field, std::uint64_t const value)
+        {
+            write_varint(buffer, static_cast<std::uint64_t>(field) << 3);
+            write_varint(buffer, value);
+        }
+
+
+        inline void write_bytes_field(std::string& buffer, std::uint32_t const field, std::string const& bytes)
+        {
+            write_varint(buffer, (static_cast<std::uint64_t>(field) << 3) | 2);
+            write_varint(buffer, bytes.size());
+            buffer.append(bytes);
+        }
+
+
+        // Field numbers of perfetto_trace.proto.
+        std::uint32_t const perfetto_trace_packet = 1;
+        std::uint32_t const perfetto_packet_timestamp = 8;
+        std::uint32_t const perfetto_packet_sequence_id = 10;
+        std::uint32_t const perfetto_packet_track_event = 11;
+        std::uint32_t const perfetto_packet_sequence_flags = 13;
+        std::uint32_t const perfetto_packet_track_descriptor = 60;
+        std::uint32_t const perfetto_track_descriptor_uuid = 1;
+        std::uint32_t const perfetto_track_descriptor_name = 2;
+        std::uint32_t const perfetto_track_event_type = 9;
+        std::uint32_t const perfetto_track_event_track_uuid = 11;
+        std::uint32_t const perfetto_track_event_categories = 22;
+        std::uint32_t const perfetto_track_event_name = 23;
+        std::uint64_t const perfetto_slice_begin = 1;
+        std::uint64_t const perfetto_slice_end = 2;
+        std::uint64_t const perfetto_instant = 3;
+        std::uint64_t const perfetto_sequence_incremental_state_cleared = 1;
+        std::uint64_t const perfetto_sequence_id = 1;
+
+
+        /**
+         * Slice begin or end of an event, ordered so slices nest when the
+         * viewer sorts by timestamp: at equal timestamps ends come first,
+         * outer slices begin first and end last.
+         */
+        struct perfetto_slice_edge {
+            std::uint64_t timestamp;
+            std::uint64_t duration;
+            bool is_begin;
+            std::size_t event_index;
+        };
+
+
+        inline bool perfetto_slice_edge_before(perfetto_slice_edge const& lhs, perfetto_slice_edge const& rhs)
+        {
+            if (lhs.timestamp != rhs.timestamp) {
+                return lhs.timestamp < rhs.timestamp;
+            }
+
+            if (lhs.is_begin != rhs.is_begin) {
+                return !lhs.is_begin;
+            }
+
+            return lhs.is_begin ? (lhs.duration > rhs.duration) : (lhs.duration < rhs.duration);
+        }
+
+
+        inline void write_perfetto_packet(std::ostream& trace, std::string const& packet)
+        {
+            std::string framed;
+            write_bytes_field(framed, perfetto_trace_packet, packet);
+            trace.write(framed.data(), static_cast<std::streamsize>(framed.size()));
+        }
+
+
+        typedef std::map<std::string, std::uint64_t> folded_stack_map;
+
+
+        inline void write_folded_stacks(folded_stack_map const& stacks, std::ostream& folded)
+        {
+            for (folded_stack_map::const_iterator it = stacks.begin(); it != stacks.end(); ++it) {
+                if (0 < it->second) {
+                    folded << it->first << ' ' << it->second << '\n';
+                }
+            }
+        }
+
+
+        inline std::string zone_frame_name(std::uint32_t const zone_id)
+        {
+            return "zone " + std::to_string(zone_id);
+        }
+
+
+        /**
+         * Sample event and the addresses of the stack frame events following
+         * it so far.
+         */
+        struct pending_sample {
+            capture_event sample;
+            std::vector<std::uint64_t> addresses;
+        };
+
+
+        /**
+         * Appends the frames of @a addresses, innermost first, to @a stack
+         * outermost first. The innermost address of a sample is the
+         * interrupted instruction, all others are return addresses.
+         */
+        inline void fold_addresses(std::vector<std::uint64_t> const& addresses,
+                                   bool const is_innermost_return_address,
+                                   std::function<std::string(std::uint64_t)> const& symbolize,
+                                   std::string& stack)
+        {
+            char address_name[32];
+
+            for (std::size_t i = addresses.size(); 0 < i; --i) {
+                // Callers are named by their call instead of the return address.
+                std::uint64_t const address = (1 < i || is_innermost_return_address) ? addresses[i - 1] - 1 : addresses[i - 1];
+                std::string name;
+
+                if (symbolize) {
+                    name = symbolize(address);
+                } else {
+                    std::snprintf(address_name, sizeof(address_name), "0x%llx", static_cast<unsigned long long>(address));
+                    name = address_name;
+                }
+
+                std::replace(name.begin(), name.end(), ';', ':');
+
+                if (!stack.empty()) {
+                    stack += ';';
+                }
+                stack += name;
+            }
+        }
+
+
+        // Outermost frame first, rooted in the zone the sample was taken in.
+        inline void fold_sample(pending_sample const& pending,
+                                std::function<std::string(std::uint64_t)> const& symbolize,
+                                folded_stack_map& stacks)
+        {
+            std::string stack;
+
+            if (KAIZEN_SAMPLE_NO_ZONE_ID != pending.sample.id) {
+                stack = zone_frame_name(pending.sample.id);
+            }
+
+            fold_addresses(pending.addresses, false, symbolize, stack);
+
+            if (!stack.empty()) {
+                ++stacks[stack];
+            }
+        }
+
+
+        /**
+         * Returns the number of the frame event beginning last before or at
+         * @a time in the time ordered @a frames, 0 before the first frame.
+         */
+        inline std::uint64_t frame_number_at(std::vector<std::pair<std::uint64_t, std::uint64_t> > const& frames,
+                                             std::uint64_t const time)
+        {
+            std::vector<std::pair<std::uint64_t, std::uint64_t> >::const_iterator const frame
+                = std::upper_bound(frames.begin(), frames.end(), std::make_pair(time, ~std::uint64_t(0)));
+
+            return (frames.begin() == frame) ? 0 : (frame - 1)->second;
+        }
+
+    } // namespace detail
+
+
+
+    /**
+     * Converts the capture read from @a capture into a Chrome trace event
+     * JSON object written to @a trace. Times are in microseconds.
+     *
+     * Throws std::system_error with EINVAL for malformed captures.
+     */
+    inline void export_chrome_trace(std::istream& capture, std::ostream& trace)
+    {
+        capture_reader reader(capture);
+        kaizen_frame_time_converter_t const converter = detail::make_converter(reader.ticks_per_second());
+
+        trace << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        std::set<std::uint32_t> named_streams;
+        std::vector<capture_event> events;
+        bool is_first = true;
+        char line[256];
+
+        while (reader.read_block(events)) {
+            for (std::size_t i = 0; i < events.size(); ++i) {
+                capture_event const& event = events[i];
+
+                if (!detail::is_trace_event(event)) {
+                    continue;
+                }
+
+                if (named_streams.insert(event.stream_id).second) {
+                    std::snprintf(line,
+                                  sizeof(line),
+                                  "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"stream %lu\"}}",
+                                  is_first ? "" : ",\n",
+                                  static_cast<unsigned long>(event.stream_id),
+                                  static_cast<unsigned long>(event.stream_id));
+                    trace << line;
+                    is_first = false;
+                }
+
+                if (detail::is_instant_event(event)) {
+                    std::snprintf(line,
+                                  sizeof(line),
+                                  ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%lu,\"args\":{\"bytes\":%llu}}",
+                                  detail::event_name(event).c_str(),
+                                  detail::event_category(event),
+                                  kaizen_frame_time_converter_ticks_to_microseconds(&converter, event.time),
+                                  static_cast<unsigned long>(event.stream_id),
+                                  static_cast<unsigned long long>(event.value));
+                } else {
+                    std::snprintf(line,
+                                  sizeof(line),
+                                  ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu,\"args\":{\"value\":%llu}}",
+                                  detail::event_name(event).c_str(),
+                                  detail::event_category(event),
+                                  kaizen_frame_time_converter_ticks_to_microseconds(&converter, event.time),
+                                  kaizen_frame_time_converter_ticks_to_microseconds(&converter, event.duration),
+                                  static_cast<unsigned long>(event.stream_id),
+                                  static_cast<unsigned long long>(event.value));
+                }
+                trace << line;
+            }
+        }
+
+        trace << "\n]}\n";
+    }
+
+
+
+    /**
+     * Converts the capture read from @a capture into a Perfetto protobuf
+     * trace written to @a trace. Every event becomes a slice begin and end
+     * (allocations an instant) with nanosecond timestamps on the track of
+     * its stream.
+     *
+     * Throws std::system_error with EINVAL for malformed captures.
+     */
+    inline void export_perfetto_trace(std::istream& capture, std::ostream& trace)
+    {
+        capture_reader reader(capture);
+        kaizen_frame_time_converter_t const converter = detail::make_converter(reader.ticks_per_second());
+
+        std::set<std::uint32_t> described_streams;
+        std::vector<capture_event> events;
+        std::vector<detail::perfetto_slice_edge> edges;
+        std::string packet;
+        std::string track_event;
+        bool is_first = true;
+
+        while (reader.read_block(events)) {
+            edges.clear();
+
+            for (std::size_t i = 0; i < events.size(); ++i) {
+                capture_event const& event = events[i];
+
+                if (!detail::is_trace_event(event)) {
+                    continue;
+                }
+
+                if (described_streams.insert(event.stream_id).second) {
+                    std::string descriptor;
+                    detail::write_varint_field(descriptor, detail::perfetto_track_descriptor_uuid, event.stream_id + 1u);
+                    detail::write_bytes_field(descriptor, detail::perfetto_track_descriptor_name, "stream " + std::to_string(event.stream_id));
+
+                    packet.clear();
+                    detail::write_varint_field(packet, detail::perfetto_packet_sequence_id, detail::perfetto_sequence_id);
+                    if (is_first) {
+                        detail::write_varint_field(packet,
+                                                   detail::perfetto_packet_sequence_flags,
+                                                   detail::perfetto_sequence_incremental_state_cleared);
+                        is_first = false;
+                    }
+                    detail::write_bytes_field(packet, detail::perfetto_packet_track_descriptor, descriptor);
+                    detail::write_perfetto_packet(trace, packet);
+                }
+
+                std::uint64_t const begin = static_cast<std::uint64_t>(std::llround(kaizen_frame_time_converter_ticks_to_nanoseconds(&converter, event.time)));
+                std::uint64_t const duration = static_cast<std::uint64_t>(std::llround(kaizen_frame_time_converter_ticks_to_nanoseconds(&converter, event.duration)));
+
+                detail::perfetto_slice_edge edge;
+                edge.timestamp = begin;
+                edge.duration = duration;
+                edge.is_begin = true;
+                edge.event_index = i;
+                edges.push_back(edge);
+
+                // Instant events only have their begin edge.
+                if (!detail::is_instant_event(event)) {
+                    edge.timestamp = begin + duration;
+                    edge.is_begin = false;
+                    edges.push_back(edge);
+                }
+            }
+
+            std::sort(edges.begin(), edges.end(), detail::perfetto_slice_edge_before);
+
+            for (std::size_t i = 0; i < edges.size(); ++i) {
+                capture_event const& event = events[edges[i].event_index];
+
+                std::uint64_t track_event_type = edges[i].is_begin ? detail::perfetto_slice_begin : detail::perfetto_slice_end;
+                if (detail::is_instant_event(event)) {
+                    track_event_type = detail::perfetto_instant;
+                }
+
+                track_event.clear();
+                detail::write_varint_field(track_event, detail::perfetto_track_event_type, track_event_type);
+                detail::write_varint_field(track_event, detail::perfetto_track_event_track_uuid, event.stream_id + 1u);
+                if (edges[i].is_begin) {
+                    detail::write_bytes_field(track_event, detail::perfetto_track_event_categories, detail::event_category(event));
+                    detail::write_bytes_field(track_event, detail::perfetto_track_event_name, detail::event_name(event));
+                }
+
+                packet.clear();
+                detail::write_varint_field(packet, detail::perfetto_packet_timestamp, edges[i].timestamp);
+                detail::write_varint_field(packet, detail::perfetto_packet_sequence_id, detail::perfetto_sequence_id);
+                detail::write_bytes_field(packet, detail::perfetto_packet_track_event, track_event);
+                detail::write_perfetto_packet(trace, packet);
+            }
+        }
+    }
+
+
+
+    /**
+     * Writes the stacks sampled (see kaizen_raw_sampler.h) in the frames
+     * first_frame to last_frame, as marked by kaizen_sampler_mark_frame, of
+     * @a capture as folded stacks to @a folded. Each distinct stack becomes
+     * one line of its frames, outermost first, rooted in the zone the
+     * samples were taken in and followed by the sample count, e.g.
+     * "zone 3;main;update;step 12".
+     *
+     * @a symbolize names the addresses, e.g. with elf_symbolizer::symbolize
+     * of kaizen_symbolizer.hpp, return addresses are passed minus one.
+     * Addresses are written in hex without it.
+     */
+    inline void export_sample_folded_stacks(capture const& capture,
+                                            std::ostream& folded,
+                                            std::function<std::string(std::uint64_t)> const& symbolize = std::function<std::string(std::uint64_t)>(),
+                                            std::uint64_t const first_frame = 0,
+                                            std::uint64_t const last_frame = ~std::uint64_t(0))
+    {
+        detail::folded_stack_map stacks;
+        std::map<std::uint32_t, detail::pending_sample> pending_samples;
+
+        for (std::size_t i = 0; i < capture.events.size(); ++i) {
+            capture_event const& event = capture.events[i];
+
+            if (kaizen_sample_event_type == event.type) {
+                // Stacks of samples missing frame events, e.g. dropped ones, end early.
+                std::map<std::uint32_t, detail::pending_sample>::iterator const previous = pending_samples.find(event.stream_id);
+                if (pending_samples.end() != previous) {
+                    detail::fold_sample(previous->second, symbolize, stacks);
+                    pending_samples.erase(previous);
+                }
+
+                if (first_frame <= event.value && event.value <= last_frame) {
+                    detail::pending_sample& pending = pending_samples[event.stream_id];
+                    pending.sample = event;
+                    pending.addresses.reserve(event.flags);
+                }
+            } else if (kaizen_stack_frame_event_type == event.type) {
+                std::map<std::uint32_t, detail::pending_sample>::iterator const pending = pending_samples.find(event.stream_id);
+
+                if (pending_samples.end() == pending
+                    || pending->second.sample.time != event.time
+                    || pending->second.addresses.size() != event.flags) {
+                    continue;
+                }
+
+                pending->second.addresses.push_back(event.value);
+
+                if (pending->second.addresses.size() >= pending->second.sample.flags) {
+                    detail::fold_sample(pending->second, symbolize, stacks);
+                    pending_samples.erase(pending);
+                }
+            }
+        }
+
+        for (std::map<std::uint32_t, detail::pending_sample>::iterator it = pending_samples.begin(); it != pending_samples.end(); ++it) {
+            detail::fold_sample(it->second, symbolize, stacks);
+        }
+
+        detail::write_folded_stacks(stacks, folded);
+    }
+
+
+
+    /**
+     * Writes the zone hierarchies of @a capture as folded stacks to
+     * @a folded. Each distinct nesting of zones becomes one line of its
+     * zones, outermost first, followed by the self time in microseconds of
+     * its innermost zone beginning in the frames first_frame to last_frame
+     * (see kaizen_frame_event_type), e.g. "zone 1;zone 2 1500". Zones
+     * beginning before the first frame count as frame 0.
+     */
+    inline void export_zone_folded_stacks(capture const& capture,
+                                          std::ostream& folded,
+                                          std::uint64_t const first_frame = 0,
+                                          std::uint64_t const last_frame = ~std::uint64_t(0))
+    {
+        std::vector<std::pair<std::uint64_t, std::uint64_t> > frames;
+        std::map<std::uint32_t, std::vector<capture_event> > streams;
+
+        for (std::size_t i = 0; i < capture.events.size(); ++i) {
+            capture_event const& event = capture.events[i];
+
+            if (kaizen_frame_event_type == event.type) {
+                frames.push_back(std::make_pair(event.time, event.value));
+            } else if (kaizen_zone_event_type == event.type) {
+                streams[event.stream_id].push_back(event);
+            }
+        }
+
+        std::sort(frames.begin(), frames.end());
+
+        std::map<std::string, double> stack_ticks;
+
+        for (std::map<std::uint32_t, std::vector<capture_event> >::iterator it = streams.begin(); it != streams.end(); ++it) {
+            std::vector<capture_event>& zones = it->second;
+            std::sort(zones.begin(), zones.end(), detail::starts_before);
+
+            std::vector<capture_event const*> open_zones;
+            std::vector<double> child_ticks;
+            std::vector<std::string> open_stacks;
+
+            for (std::size_t i = 0; i <= zones.size(); ++i) {
+
+                // Closes every open zone after the last one.
+                while (!open_zones.empty()
+                       && (zones.size() == i || open_zones.back()->time + open_zones.back()->duration <= zones[i].time)) {
+
+                    capture_event const& zone = *open_zones.back();
+                    std::uint64_t const frame_number = detail::frame_number_at(frames, zone.time);
+
+                    if (first_frame <= frame_number && frame_number <= last_frame) {
+                        double const duration = static_cast<double>(zone.duration);
+                        double const self_ticks = (child_ticks.back() < duration) ? duration - child_ticks.back() : 0.0;
+                        stack_ticks[open_stacks.back()] += self_ticks * static_cast<double>(detail::sample_interval_of(zone));
+                    }
+
+                    open_zones.pop_back();
+                    child_ticks.pop_back();
+                    open_stacks.pop_back();
+                }
+
+                if (zones.size() == i) {
+                    break;
+                }
+
+                std::string stack = detail::zone_frame_name(zones[i].id);
+
+                if (!open_zones.empty()) {
+                    child_ticks.back() += static_cast<double>(zones[i].duration);
+                    stack = open_stacks.back() + ';' + stack;
+                }
+
+                open_zones.push_back(&zones[i]);
+                child_ticks.push_back(0.0);
+                open_stacks.push_back(stack);
+            }
+        }
+
+        double const microseconds_per_tick = 1000000.0 / static_cast<double>(capture.ticks_per_second);
+        detail::folded_stack_map stacks;
+
+        for (std::map<std::string, double>::const_iterator it = stack_ticks.begin(); it != stack_ticks.end(); ++it) {
+            stacks[it->first] = static_cast<std::uint64_t>(std::llround(it->second * microseconds_per_tick));
+        }
+
+        detail::write_folded_stacks(stacks, folded);
+    }
+
+
+
+    /**
+     * Writes the call stacks recorded with zones (see kaizen_callstack.h)
+     * beginning in the frames first_frame to last_frame of @a capture as
+     * folded stacks to @a folded. Each distinct stack and zone becomes one
+     * line of the callers, outermost first, and the zone, followed by the
+     * total time in microseconds of the zone called from there, e.g.
+     * "main;update;spawn;zone 7 1500".
+     *
+     * @a symbolize names the addresses like for
+     * export_sample_folded_stacks.
+     */
+    inline void export_zone_callstack_folded_stacks(capture const& capture,
+                                                    std::ostream& folded,
+                                                    std::function<std::string(std::uint64_t)> const& symbolize = std::function<std::string(std::uint64_t)>(),
+                                                    std::uint64_t const first_frame = 0,
+                                                    std::uint64_t const last_frame = ~std::uint64_t(0))
+    {
+        std::vector<std::pair<std::uint64_t, std::uint64_t> > frames;
+        std::map<std::uint32_t, std::vector<std::uint64_t> > callstacks;
+        std::map<std::uint32_t, std::uint32_t> defining_streams;
+        std::map<std::uint32_t, std::uint64_t> sample_intervals;
+        // Zone callstack events and the sample interval of their zone.
+        std::vector<std::pair<capture_event, std::uint64_t> > zone_callstacks;
+
+        for (std::size_t i = 0; i < capture.events.size(); ++i) {
+            capture_event const& event = capture.events[i];
+
+            if (kaizen_frame_event_type == event.type) {
+                frames.push_back(std::make_pair(event.time, event.value));
+            } else if (kaizen_zone_event_type == event.type) {
+                sample_intervals[event.stream_id] = detail::sample_interval_of(event);
+            } else if (kaizen_callstack_event_type == event.type) {
+                callstacks[event.id].clear();
+                defining_streams[event.stream_id] = event.id;
+            } else if (kaizen_stack_frame_event_type == event.type) {
+                std::map<std::uint32_t, std::uint32_t>::const_iterator const defining = defining_streams.find(event.stream_id);
+
+                // Frames of samples follow sample events instead.
+                if (defining_streams.end() != defining && defining->second == event.id) {
+                    std::vector<std::uint64_t>& addresses = callstacks[event.id];
+
+                    if (addresses.size() == event.flags) {
+                        addresses.push_back(event.value);
+                    }
+                }
+            } else if (kaizen_zone_callstack_event_type == event.type) {
+                std::map<std::uint32_t, std::uint64_t>::const_iterator const interval = sample_intervals.find(event.stream_id);
+
+                zone_callstacks.push_back(std::make_pair(event, (sample_intervals.end() == interval) ? 1 : interval->second));
+            }
+
+            if (kaizen_callstack_event_type != event.type && kaizen_stack_frame_event_type != event.type) {
+                defining_streams.erase(event.stream_id);
+            }
+        }
+
+        std::sort(frames.begin(), frames.end());
+
+        std::map<std::pair<std::uint32_t, std::uint32_t>, double> zone_ticks;
+
+        for (std::size_t i = 0; i < zone_callstacks.size(); ++i) {
+            capture_event const& event = zone_callstacks[i].first;
+            std::uint64_t const frame_number = detail::frame_number_at(frames, event.time);
+
+            if (first_frame <= frame_number && frame_number <= last_frame) {
+                zone_ticks[std::make_pair(static_cast<std::uint32_t>(event.value), event.id)]
+                    += static_cast<double>(event.duration) * static_cast<double>(zone_callstacks[i].second);
+            }
+        }
+
+        double const microseconds_per_tick = 1000000.0 / static_cast<double>(capture.ticks_per_second);
+        detail::folded_stack_map stacks;
+
+        for (std::map<std::pair<std::uint32_t, std::uint32_t>, double>::const_iterator it = zone_ticks.begin(); it != zone_ticks.end(); ++it) {
+            std::string stack;
+            detail::fold_addresses(callstacks[it->first.first], true, symbolize, stack);
+
+            if (!stack.empty()) {
+                stack += ';';
+            }
+            stack += detail::zone_frame_name(it->first.second);
+
+            stacks[stack] += static_cast<std::uint64_t>(std::llround(it->second * microseconds_per_tick));
+        }
+
+        detail::write_folded_stacks(stacks, folded);
+    }
+
+} // namespace kaizen
+
+
+#endif /* KAIZEN_kaizen_capture_export_HPP */
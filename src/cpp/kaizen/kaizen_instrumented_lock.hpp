@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * C++ wrappers for the instrumented kaizen locks satisfying the Lockable
+ * requirements of std::mutex so they work with std::lock_guard,
+ * std::unique_lock and std::lock.
+ *
+ * Failing platform calls throw std::system_error like std::mutex does.
+ */
+
+#ifndef KAIZEN_kaizen_instrumented_lock_HPP
+#define KAIZEN_kaizen_instrumented_lock_HPP
+
+
+#include <cerrno>
+#include <system_error>
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_raw_instrumented_mutex.h>
+#include <kaizen/kaizen_instrumented_spinlock.h>
+
+
+
+namespace kaizen {
+
+    namespace detail {
+
+        inline void throw_on_error(int const error_code, char const* what)
+        {
+            if (KAIZEN_SUCCESS != error_code) {
+                throw std::system_error(error_code, std::generic_category(), what);
+            }
+        }
+
+        inline kaizen_raw_frame_time_t zero_frame_time()
+        {
+            kaizen_raw_frame_time_t const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+            return zero;
+        }
+
+    } // namespace detail
+
+
+
+    class instrumented_mutex {
+    public:
+        typedef kaizen_raw_instrumented_mutex_t* native_handle_type;
+
+        explicit instrumented_mutex(uint32_t const lock_id,
+                                    kaizen_raw_frame_time_t const& wait_threshold = detail::zero_frame_time())
+        {
+            detail::throw_on_error(kaizen_instrumented_mutex_init(&mutex_, lock_id, &wait_threshold),
+                                   "kaizen_instrumented_mutex_init");
+        }
+
+        ~instrumented_mutex()
+        {
+            (void)kaizen_instrumented_mutex_finalize(&mutex_);
+        }
+
+        void lock()
+        {
+            detail::throw_on_error(kaizen_instrumented_mutex_lock(&mutex_),
+                                   "kaizen_instrumented_mutex_lock");
+        }
+
+        bool try_lock()
+        {
+            int const errc = kaizen_instrumented_mutex_trylock(&mutex_);
+
+            if (EBUSY == errc) {
+                return false;
+            }
+
+            detail::throw_on_error(errc, "kaizen_instrumented_mutex_trylock");
+
+            return true;
+        }
+
+        void unlock()
+        {
+            (void)kaizen_instrumented_mutex_unlock(&mutex_);
+        }
+
+        native_handle_type native_handle()
+        {
+            return &mutex_;
+        }
+
+    private:
+        instrumented_mutex(instrumented_mutex const&);
+        instrumented_mutex& operator=(instrumented_mutex const&);
+
+        kaizen_raw_instrumented_mutex_t mutex_;
+    };
+
+
+
+    class instrumented_spinlock {
+    public:
+        typedef kaizen_instrumented_spinlock_t* native_handle_type;
+
+        explicit instrumented_spinlock(uint32_t const lock_id,
+                                       kaizen_raw_frame_time_t const& wait_threshold = detail::zero_frame_time())
+        {
+            detail::throw_on_error(kaizen_instrumented_spinlock_init(&spinlock_, lock_id, &wait_threshold),
+                                   "kaizen_instrumented_spinlock_init");
+        }
+
+        ~instrumented_spinlock()
+        {
+            (void)kaizen_instrumented_spinlock_finalize(&spinlock_);
+        }
+
+        void lock()
+        {
+            (void)kaizen_instrumented_spinlock_lock(&spinlock_);
+        }
+
+        bool try_lock()
+        {
+            return KAIZEN_SUCCESS == kaizen_instrumented_spinlock_trylock(&spinlock_);
+        }
+
+        void unlock()
+        {
+            (void)kaizen_instrumented_spinlock_unlock(&spinlock_);
+        }
+
+        native_handle_type native_handle()
+        {
+            return &spinlock_;
+        }
+
+    private:
+        instrumented_spinlock(instrumented_spinlock const&);
+        instrumented_spinlock& operator=(instrumented_spinlock const&);
+
+        kaizen_instrumented_spinlock_t spinlock_;
+    };
+
+} // namespace kaizen
+
+
+#endif /* KAIZEN_kaizen_instrumented_lock_HPP */
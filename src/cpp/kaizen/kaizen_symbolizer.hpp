@@ -0,0 +1,513 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Offline symbolization of the stack addresses of captured samples (see
+ * kaizen_raw_sampler.h). Symbolizing in the profiled process costs too
+ * much, so captures only carry addresses and elf_symbolizer resolves them
+ * afterwards from the binaries on disk.
+ *
+ * Modules are ELF executables and shared objects, 32 or 64 bit little
+ * endian. Their function symbols are read once from the symbol tables
+ * (.symtab, or .dynsym of stripped binaries) and each address is resolved
+ * by binary search and cached. Names are demangled with GCC and Clang.
+ *
+ * Position independent binaries are loaded at a different address in each
+ * run, so add them with the load bias of the profiled process, e.g. by
+ * saving /proc/self/maps next to the capture and passing it to
+ * add_mapped_modules.
+ *
+ * <code>
+ * kaizen::elf_symbolizer symbolizer;
+ * std::ifstream maps("game.maps");
+ * symbolizer.add_mapped_modules(maps);
+ * std::string const& name = symbolizer.symbolize(address);
+ * </code>
+ *
+ * Unreadable or malformed binaries throw std::system_error with ENOENT or
+ * EINVAL.
+ */
+
+#ifndef KAIZEN_kaizen_symbolizer_HPP
+#define KAIZEN_kaizen_symbolizer_HPP
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__GNUC__)
+#   include <cxxabi.h>
+#endif
+
+
+
+namespace kaizen {
+
+    namespace detail {
+
+        // Fields of the ELF headers, see elf.h.
+        unsigned char const elf_class_32 = 1;
+        unsigned char const elf_class_64 = 2;
+        unsigned char const elf_data_little_endian = 1;
+        std::uint32_t const elf_segment_load = 1;
+        std::uint32_t const elf_segment_executable_flag = 1;
+        std::uint32_t const elf_section_symbol_table = 2;
+        std::uint32_t const elf_section_dynamic_symbol_table = 11;
+        unsigned const elf_symbol_function = 2;
+
+
+        struct elf_segment {
+            std::uint64_t file_offset;
+            std::uint64_t file_size;
+            std::uint64_t address;
+            std::uint64_t memory_size;
+            bool is_executable;
+        };
+
+
+        struct elf_symbol {
+            std::uint64_t address;
+            std::uint64_t size;
+            std::string name;
+        };
+
+
+        /**
+         * Segments and function symbols of a binary with the addresses it
+         * was linked at.
+         */
+        struct elf_file {
+            std::vector<elf_segment> segments;
+            std::vector<elf_symbol> symbols;
+        };
+
+
+        inline std::uint64_t read_little_endian(std::vector<char> const& data,
+                                                std::size_t const offset,
+                                                std::size_t const size)
+        {
+            if (offset > data.size() || size > data.size() - offset) {
+                throw std::system_error(EINVAL, std::generic_category(), "truncated ELF data");
+            }
+
+            std::uint64_t value = 0;
+            for (std::size_t i = size; 0 < i; --i) {
+                value = (value << 8) | static_cast<unsigned char>(data[offset + i - 1]);
+            }
+
+            return value;
+        }
+
+
+        inline std::vector<char> read_file_range(std::ifstream& file,
+                                                 std::uint64_t const offset,
+                                                 std::uint64_t const size)
+        {
+            std::vector<char> data(static_cast<std::size_t>(size));
+
+            if (0 < size) {
+                file.seekg(static_cast<std::streamoff>(offset));
+                file.read(&data[0], static_cast<std::streamsize>(size));
+
+                if (static_cast<std::streamsize>(size) != file.gcount()) {
+                    throw std::system_error(EINVAL, std::generic_category(), "truncated ELF file");
+                }
+            }
+
+            return data;
+        }
+
+
+        inline elf_file read_elf_file(std::string const& path)
+        {
+            std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+
+            if (!file) {
+                throw std::system_error(ENOENT, std::generic_category(), path);
+            }
+
+            std::vector<char> const header = read_file_range(file, 0, 52);
+
+            if (0x7f != static_cast<unsigned char>(header[0]) || 'E' != header[1] || 'L' != header[2] || 'F' != header[3]
+                || elf_data_little_endian != static_cast<unsigned char>(header[5])) {
+
+                throw std::system_error(EINVAL, std::generic_category(), path + " is no little endian ELF file");
+            }
+
+            bool const is_64_bit = (elf_class_64 == static_cast<unsigned char>(header[4]));
+
+            if (!is_64_bit && elf_class_32 != static_cast<unsigned char>(header[4])) {
+                throw std::system_error(EINVAL, std::generic_category(), path + " has an unknown ELF class");
+            }
+
+            std::vector<char> const full_header = is_64_bit ? read_file_range(file, 0, 64) : header;
+            std::size_t const word = is_64_bit ? 8 : 4;
+            std::uint64_t const segment_table = read_little_endian(full_header, is_64_bit ? 32 : 28, word);
+            std::uint64_t const section_table = read_little_endian(full_header, is_64_bit ? 40 : 32, word);
+            std::uint64_t const segment_entry_size = read_little_endian(full_header, is_64_bit ? 54 : 42, 2);
+            std::uint64_t const segment_count = read_little_endian(full_header, is_64_bit ? 56 : 44, 2);
+            std::uint64_t const section_entry_size = read_little_endian(full_header, is_64_bit ? 58 : 46, 2);
+            std::uint64_t const section_count = read_little_endian(full_header, is_64_bit ? 60 : 48, 2);
+
+            elf_file result;
+
+            std::vector<char> const segments = read_file_range(file, segment_table, segment_entry_size * segment_count);
+            for (std::uint64_t i = 0; i < segment_count; ++i) {
+                std::size_t const entry = static_cast<std::size_t>(i * segment_entry_size);
+
+                if (elf_segment_load != read_little_endian(segments, entry, 4)) {
+                    continue;
+                }
+
+                elf_segment segment;
+                segment.file_offset = read_little_endian(segments, entry + (is_64_bit ? 8 : 4), word);
+                segment.address = read_little_endian(segments, entry + (is_64_bit ? 16 : 8), word);
+                segment.file_size = read_little_endian(segments, entry + (is_64_bit ? 32 : 16), word);
+                segment.memory_size = read_little_endian(segments, entry + (is_64_bit ? 40 : 20), word);
+                segment.is_executable = 0 != (elf_segment_executable_flag
+                                              & read_little_endian(segments, entry + (is_64_bit ? 4 : 24), 4));
+                result.segments.push_back(segment);
+            }
+
+            std::vector<char> const sections = read_file_range(file, section_table, section_entry_size * section_count);
+            bool has_symbol_table = false;
+
+            for (std::uint64_t i = 0; i < section_count; ++i) {
+                std::size_t const entry = static_cast<std::size_t>(i * section_entry_size);
+                has_symbol_table = has_symbol_table
+                                   || (elf_section_symbol_table == read_little_endian(sections, entry + 4, 4));
+            }
+
+            for (std::uint64_t i = 0; i < section_count; ++i) {
+                std::size_t const entry = static_cast<std::size_t>(i * section_entry_size);
+                std::uint64_t const type = read_little_endian(sections, entry + 4, 4);
+
+                // .dynsym only lists exported symbols, .symtab all of them.
+                if (elf_section_symbol_table != type
+                    && (elf_section_dynamic_symbol_table != type || has_symbol_table)) {
+                    continue;
+                }
+
+                std::uint64_t const offset = read_little_endian(sections, entry + (is_64_bit ? 24 : 16), word);
+                std::uint64_t const size = read_little_endian(sections, entry + (is_64_bit ? 32 : 20), word);
+                std::uint64_t const link = read_little_endian(sections, entry + (is_64_bit ? 40 : 24), 4);
+                std::uint64_t const symbol_size = read_little_endian(sections, entry + (is_64_bit ? 56 : 36), word);
+
+                if (0 == symbol_size || link >= section_count) {
+                    throw std::system_error(EINVAL, std::generic_category(), path + " has a malformed symbol table");
+                }
+
+                std::size_t const string_entry = static_cast<std::size_t>(link * section_entry_size);
+                std::vector<char> const strings = read_file_range(file,
+                                                                  read_little_endian(sections, string_entry + (is_64_bit ? 24 : 16), word),
+                                                                  read_little_endian(sections, string_entry + (is_64_bit ? 32 : 20), word));
+                std::vector<char> const symbols = read_file_range(file, offset, size);
+
+                for (std::uint64_t j = 0; j < size / symbol_size; ++j) {
+                    std::size_t const symbol = static_cast<std::size_t>(j * symbol_size);
+                    std::uint64_t const info = read_little_endian(symbols, symbol + (is_64_bit ? 4 : 12), 1);
+                    std::uint64_t const section_index = read_little_endian(symbols, symbol + (is_64_bit ? 6 : 14), 2);
+                    std::uint64_t const name = read_little_endian(symbols, symbol, 4);
+
+                    // Undefined functions live in other modules.
+                    if (elf_symbol_function != (info & 0xf) || 0 == section_index || name >= strings.size()) {
+                        continue;
+                    }
+
+                    elf_symbol function;
+                    function.address = read_little_endian(symbols, symbol + (is_64_bit ? 8 : 4), word);
+                    function.size = read_little_endian(symbols, symbol + (is_64_bit ? 16 : 8), word);
+                    function.name.assign(strings.begin() + static_cast<std::ptrdiff_t>(name),
+                                         std::find(strings.begin() + static_cast<std::ptrdiff_t>(name), strings.end(), '\0'));
+                    result.symbols.push_back(function);
+                }
+            }
+
+            return result;
+        }
+
+
+        inline std::string demangle(std::string const& name)
+        {
+#if defined(__GNUC__)
+            int status = 0;
+            char* const demangled = abi::__cxa_demangle(name.c_str(), NULL, NULL, &status);
+
+            if (NULL != demangled) {
+                std::string const result(demangled);
+                std::free(demangled);
+
+                return result;
+            }
+#endif
+
+            return name;
+        }
+
+    } // namespace detail
+
+
+
+    /**
+     * Resolves addresses of the profiled process to function names.
+     *
+     * Addresses outside of any function become "module+0xoffset" inside a
+     * module and "0xaddress" otherwise.
+     */
+    class elf_symbolizer {
+    public:
+        elf_symbolizer()
+        :   symbols_(), modules_(), cache_(), is_sorted_(true)
+        {}
+
+
+        /**
+         * Adds the functions of the binary at @a path loaded with
+         * @a load_bias, the difference between the run time and the link
+         * time addresses (e.g. dlpi_addr of dl_iterate_phdr), 0 for
+         * executables linked without -pie.
+         */
+        void add_module(std::string const& path, std::uint64_t const load_bias)
+        {
+            add_elf_file(path, detail::read_elf_file(path), load_bias);
+        }
+
+
+        /**
+         * Adds the binaries of the executable mappings listed in
+         * @a maps, the contents of /proc/<pid>/maps of the profiled
+         * process, at their mapped addresses. Binaries missing on this
+         * machine are skipped.
+         *
+         * Returns the number of added modules.
+         */
+        std::size_t add_mapped_modules(std::istream& maps)
+        {
+            std::size_t module_count = 0;
+            std::string line;
+
+            while (std::getline(maps, line)) {
+                std::istringstream fields(line);
+                std::string range;
+                std::string permissions;
+                std::string offset;
+                std::string device;
+                std::string inode;
+                std::string path;
+                fields >> range >> permissions >> offset >> device >> inode;
+                std::getline(fields >> std::ws, path);
+
+                if (std::string::npos == permissions.find('x') || path.empty() || '/' != path[0]) {
+                    continue;
+                }
+
+                bool is_added = false;
+                for (std::size_t i = 0; i < modules_.size(); ++i) {
+                    is_added = is_added || (path == modules_[i].path);
+                }
+
+                std::ifstream probe(path.c_str(), std::ios::in | std::ios::binary);
+                if (is_added || !probe) {
+                    continue;
+                }
+
+                std::string::size_type const separator = range.find('-');
+                std::uint64_t const mapping_begin = std::strtoull(range.c_str(), NULL, 16);
+                std::uint64_t const mapping_end = std::strtoull(range.c_str() + separator + 1, NULL, 16);
+                std::uint64_t const mapping_offset = std::strtoull(offset.c_str(), NULL, 16);
+                detail::elf_file const file = detail::read_elf_file(path);
+
+                // The executable segment lies in the file range of the mapping.
+                for (std::size_t i = 0; i < file.segments.size(); ++i) {
+                    detail::elf_segment const& segment = file.segments[i];
+
+                    if (segment.is_executable
+                        && mapping_offset <= segment.file_offset
+                        && segment.file_offset - mapping_offset < mapping_end - mapping_begin) {
+
+                        add_elf_file(path, file, mapping_begin + (segment.file_offset - mapping_offset) - segment.address);
+                        ++module_count;
+                        break;
+                    }
+                }
+            }
+
+            return module_count;
+        }
+
+
+        /**
+         * Returns the name of the function containing @a address. For
+         * return addresses of callers pass the address minus one, so calls
+         * ending a function resolve to the caller.
+         */
+        std::string const& symbolize(std::uint64_t const address)
+        {
+            std::unordered_map<std::uint64_t, std::string>::const_iterator const cached = cache_.find(address);
+
+            if (cache_.end() != cached) {
+                return cached->second;
+            }
+
+            sort_symbols();
+
+            std::vector<symbol>::const_iterator it = std::upper_bound(symbols_.begin(),
+                                                                      symbols_.end(),
+                                                                      address,
+                                                                      [](std::uint64_t const lhs, symbol const& rhs) {
+                                                                          return lhs < rhs.begin;
+                                                                      });
+            if (symbols_.begin() != it && address < (it - 1)->end) {
+                return cache_[address] = detail::demangle((it - 1)->name);
+            }
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "0x%llx", static_cast<unsigned long long>(address));
+
+            for (std::size_t i = 0; i < modules_.size(); ++i) {
+                if (modules_[i].begin <= address && address < modules_[i].end) {
+                    std::size_t const separator = modules_[i].path.find_last_of('/');
+                    std::snprintf(name,
+                                  sizeof(name),
+                                  "%s+0x%llx",
+                                  modules_[i].path.substr((std::string::npos == separator) ? 0 : separator + 1).c_str(),
+                                  static_cast<unsigned long long>(address - modules_[i].load_bias));
+                    break;
+                }
+            }
+
+            return cache_[address] = name;
+        }
+
+
+        std::size_t symbol_count() const
+        {
+            return symbols_.size();
+        }
+
+
+    private:
+        struct symbol {
+            std::uint64_t begin;
+            std::uint64_t end;
+            std::string name;
+        };
+
+
+        struct module {
+            std::string path;
+            std::uint64_t load_bias;
+            std::uint64_t begin;
+            std::uint64_t end;
+        };
+
+
+        void add_elf_file(std::string const& path,
+                          detail::elf_file const& file,
+                          std::uint64_t const load_bias)
+        {
+            module added;
+            added.path = path;
+            added.load_bias = load_bias;
+            added.begin = ~std::uint64_t(0);
+            added.end = 0;
+
+            for (std::size_t i = 0; i < file.segments.size(); ++i) {
+                if (file.segments[i].is_executable) {
+                    added.begin = std::min(added.begin, file.segments[i].address + load_bias);
+                    added.end = std::max(added.end, file.segments[i].address + file.segments[i].memory_size + load_bias);
+                }
+            }
+
+            if (added.begin < added.end) {
+                modules_.push_back(added);
+            }
+
+            for (std::size_t i = 0; i < file.symbols.size(); ++i) {
+                symbol function;
+                function.begin = file.symbols[i].address + load_bias;
+                function.end = function.begin + file.symbols[i].size;
+                function.name = file.symbols[i].name;
+                symbols_.push_back(function);
+            }
+
+            is_sorted_ = false;
+            cache_.clear();
+        }
+
+
+        // Symbols without size, e.g. of assembly, extend to the next one.
+        void sort_symbols()
+        {
+            if (is_sorted_) {
+                return;
+            }
+
+            std::sort(symbols_.begin(),
+                      symbols_.end(),
+                      [](symbol const& lhs, symbol const& rhs) {
+                          return (lhs.begin != rhs.begin) ? (lhs.begin < rhs.begin) : (lhs.end > rhs.end);
+                      });
+
+            for (std::size_t i = 0; i + 1 < symbols_.size(); ++i) {
+                if (symbols_[i].begin == symbols_[i].end) {
+                    symbols_[i].end = symbols_[i + 1].begin;
+                }
+            }
+
+            is_sorted_ = true;
+        }
+
+
+        std::vector<symbol> symbols_;
+        std::vector<module> modules_;
+        std::unordered_map<std::uint64_t, std::string> cache_;
+        bool is_sorted_;
+    };
+
+} // namespace kaizen
+
+
+#endif /* KAIZEN_kaizen_symbolizer_HPP */
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * C++ zones declared by constexpr descriptors and stripped at compile time
+ * based on KAIZEN_ZONE_LEVEL (see kaizen_zone_macros.h).
+ *
+ * <code>
+ * constexpr kaizen::zone_descriptor physics_zone = {"physics", 1, kaizen::zone_level::fine};
+ *
+ * void physics_update()
+ * {
+ *     kaizen::scoped_zone<physics_zone> zone;
+ *     // ...
+ * }
+ * </code>
+ *
+ * For zones of a disabled level scoped_zone is an empty class with a
+ * trivial destructor and the zone storage is never instantiated. Its
+ * constructor is user-provided, so stripped zones do not trigger unused
+ * variable warnings, but empty and inlines to nothing. Storage of enabled
+ * zones is constant initialized, so no zone runs a static initializer
+ * either way.
+ *
+ * @attention Define KAIZEN_ZONE_LEVEL the same in all translation units. A
+ *            scoped_zone of one descriptor is a different class per level,
+ *            so inline functions and templates with zones that are compiled
+ *            with different levels violate the one definition rule: the
+ *            linker keeps one of the definitions and the zone is enabled or
+ *            stripped in all of them. Zones whose descriptor has internal
+ *            linkage, like namespace scope constexpr descriptors, and that
+ *            are only used in non-inline functions are safe.
+ */
+
+#ifndef KAIZEN_kaizen_zone_HPP
+#define KAIZEN_kaizen_zone_HPP
+
+
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_zone_macros.h>
+
+
+
+namespace kaizen {
+
+    enum class zone_level : int {
+        off = KAIZEN_ZONE_LEVEL_OFF,
+        coarse = KAIZEN_ZONE_LEVEL_COARSE,
+        fine = KAIZEN_ZONE_LEVEL_FINE,
+        verbose = KAIZEN_ZONE_LEVEL_VERBOSE
+    };
+
+    constexpr zone_level compiled_zone_level = static_cast<zone_level>(KAIZEN_ZONE_LEVEL);
+
+
+
+    struct zone_descriptor {
+        char const* name;
+        uint32_t id;
+        zone_level level;
+    };
+
+    constexpr bool zone_is_enabled(zone_descriptor const& descriptor)
+    {
+        return zone_level::off != descriptor.level
+            && descriptor.level <= compiled_zone_level;
+    }
+
+
+
+    namespace detail {
+
+        template <zone_descriptor const& Descriptor>
+        struct zone_storage {
+            static kaizen_zone_t zone;
+        };
+
+        template <zone_descriptor const& Descriptor>
+        kaizen_zone_t zone_storage<Descriptor>::zone = KAIZEN_ZONE_INITIALIZER(Descriptor.name, Descriptor.id);
+
+    } // namespace detail
+
+
+
+    template <zone_descriptor const& Descriptor, bool Enabled = zone_is_enabled(Descriptor)>
+    class scoped_zone;
+
+
+
+    template <zone_descriptor const& Descriptor>
+    class scoped_zone<Descriptor, true> {
+    public:
+        scoped_zone()
+        {
+            (void)kaizen_zone_begin(&detail::zone_storage<Descriptor>::zone, &scope_);
+        }
+
+        ~scoped_zone()
+        {
+            (void)kaizen_zone_end(&scope_);
+        }
+
+        static kaizen_zone_t* native_handle()
+        {
+            return &detail::zone_storage<Descriptor>::zone;
+        }
+
+    private:
+        scoped_zone(scoped_zone const&);
+        scoped_zone& operator=(scoped_zone const&);
+
+        kaizen_zone_scope_t scope_;
+    };
+
+
+
+    template <zone_descriptor const& Descriptor>
+    class scoped_zone<Descriptor, false> {
+    public:
+        // User-provided so stripped zones do not trigger unused variable
+        // warnings, still inlines to nothing.
+        scoped_zone() {}
+
+    private:
+        scoped_zone(scoped_zone const&);
+        scoped_zone& operator=(scoped_zone const&);
+    };
+
+} // namespace kaizen
+
+
+#endif /* KAIZEN_kaizen_zone_HPP */
@@ -0,0 +1,160 @@
+// Scaling benchmark for per thread profiler state.
+//
+// Every thread records zone events as fast as it can, once with event
+// buffers packed next to each other in an array (their write cursors share
+// cache lines) and once with cache line aligned kaizen_thread_state blocks.
+// Prints the average time per recorded zone for 1 up to the number of
+// hardware threads. Without false sharing the time per zone stays flat as
+// threads are added.
+//
+// Each thread uses its own zone so the shared sample counter of a zone
+// executed by all threads does not hide the effect of the state layout.
+//
+// Build with the kaizen sources and the C++11 standard library, e.g.:
+// c++ -std=c++11 -O2 -DKAIZEN_USE_... -I../../src/c kaizen_thread_state_scaling_benchmark.cpp <kaizen objects> -lpthread
+
+#include <kaizen/kaizen_thread_state.h>
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_raw_memory.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+
+
+namespace {
+
+    std::size_t const event_capacity = 4096;
+    std::size_t const zones_per_thread = 1 << 20;
+
+    void record_zones(kaizen_event_buffer_t* buffer)
+    {
+        kaizen_zone_t benchmark_zone = KAIZEN_ZONE_INITIALIZER("benchmark", 1);
+
+        for (std::size_t i = 0; i < zones_per_thread; ++i) {
+            kaizen_zone_scope_t scope;
+            (void)kaizen_zone_begin(&benchmark_zone, &scope);
+            (void)kaizen_zone_end(&scope);
+
+            if (event_capacity == kaizen_event_buffer_count(buffer)) {
+                (void)kaizen_event_buffer_clear(buffer);
+            }
+        }
+    }
+
+
+    template <typename ThreadFunction>
+    double run_threads(std::size_t const thread_count, ThreadFunction function)
+    {
+        std::vector<std::thread> threads;
+        std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads.push_back(std::thread(function, t));
+        }
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads[t].join();
+        }
+
+        std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now() - start;
+
+        return elapsed.count() / static_cast<double>(zones_per_thread);
+    }
+
+
+    double run_packed(std::size_t const thread_count)
+    {
+        std::vector<kaizen_event_t> storage(thread_count * event_capacity);
+        std::vector<kaizen_event_buffer_t> buffers(thread_count);
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            int const errc = kaizen_event_buffer_init(&buffers[t], &storage[t * event_capacity], event_capacity);
+            assert(KAIZEN_SUCCESS == errc);
+            (void)errc;
+        }
+
+        double const nanoseconds = run_threads(thread_count, [&](std::size_t const t) {
+            (void)kaizen_event_buffer_attach_to_current_thread(&buffers[t]);
+            record_zones(&buffers[t]);
+            (void)kaizen_event_buffer_attach_to_current_thread(NULL);
+        });
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            (void)kaizen_event_buffer_finalize(&buffers[t]);
+        }
+
+        return nanoseconds;
+    }
+
+
+    double run_thread_states(std::size_t const thread_count)
+    {
+        std::size_t const state_size = sizeof(kaizen_thread_state_t) + event_capacity * sizeof(kaizen_event_t);
+
+        kaizen_raw_memory_region_t region;
+        int errc = kaizen_memory_region_init(&region,
+                                             thread_count * (state_size + 2 * KAIZEN_CACHE_LINE_SIZE),
+                                             kaizen_memory_huge_page_size);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_arena_t arena;
+        errc = kaizen_arena_init(&arena,
+                                 kaizen_memory_region_memory(&region),
+                                 kaizen_memory_region_size(&region));
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::vector<kaizen_thread_state_t*> states(thread_count, static_cast<kaizen_thread_state_t*>(NULL));
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            errc = kaizen_thread_state_allocate_from_arena(&arena, event_capacity, &states[t]);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        double const nanoseconds = run_threads(thread_count, [&](std::size_t const t) {
+            (void)kaizen_thread_state_attach_to_current_thread(states[t]);
+            record_zones(kaizen_thread_state_event_buffer(states[t]));
+            (void)kaizen_thread_state_attach_to_current_thread(NULL);
+        });
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            (void)kaizen_thread_state_finalize(states[t]);
+        }
+
+        (void)kaizen_arena_finalize(&arena);
+        (void)kaizen_memory_region_finalize(&region);
+
+        return nanoseconds;
+    }
+
+} // anonymous namespace
+
+
+
+int main()
+{
+    std::size_t max_thread_count = std::thread::hardware_concurrency();
+    max_thread_count = (0 == max_thread_count) ? 1 : max_thread_count;
+
+    std::printf("threads  packed ns/zone  thread state ns/zone\n");
+
+    for (std::size_t thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+
+        double const packed = run_packed(thread_count);
+        double const aligned = run_thread_states(thread_count);
+
+        std::printf("%7u  %14.2f  %20.2f\n",
+                    static_cast<unsigned>(thread_count),
+                    packed,
+                    aligned);
+    }
+
+    return 0;
+}
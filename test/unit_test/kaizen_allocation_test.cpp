@@ -0,0 +1,142 @@
+#include <kaizen/kaizen_allocation.h>
+#include <kaizen/kaizen_thread_state.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_allocation_tracking.hpp>
+#include <kaizen/kaizen_capture_analysis.hpp>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "kaizen_test_events.hpp"
+
+
+
+namespace {
+
+    std::size_t const event_capacity = 16;
+
+    uint32_t const test_zone_id = 5;
+
+} // anonymous namespace
+
+
+SUITE(kaizen_allocation_test)
+{
+    TEST(recording_without_event_buffer_fails)
+    {
+        CHECK_EQUAL(ESRCH, kaizen_allocation_record(16));
+        CHECK_EQUAL(ESRCH, kaizen_deallocation_record(16));
+        CHECK_EQUAL(KAIZEN_ALLOCATION_NO_ZONE_ID, kaizen_allocation_zone_id_of_current_thread());
+    }
+
+
+
+    TEST(allocations_are_attributed_to_innermost_zone)
+    {
+        kaizen_event_t storage[event_capacity];
+        kaizen_thread_state_t state;
+        int errc = kaizen_thread_state_init(&state, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_thread_state_attach_to_current_thread(&state);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_allocation_record(8));
+
+        kaizen_zone_t zone = KAIZEN_ZONE_INITIALIZER("zone", test_zone_id);
+        kaizen_zone_scope_t scope;
+        errc = kaizen_zone_begin(&zone, &scope);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(test_zone_id, kaizen_allocation_zone_id_of_current_thread());
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_allocation_record(32));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_deallocation_record(8));
+        errc = kaizen_zone_end(&scope);
+        assert(KAIZEN_SUCCESS == errc);
+
+        struct kaizen_event_buffer_s const* buffer = kaizen_thread_state_event_buffer(&state);
+        CHECK_EQUAL(4u, kaizen_event_buffer_count(buffer));
+
+        kaizen_event_t const* event = kaizen_event_buffer_at(buffer, 0);
+        CHECK_EQUAL(kaizen_allocation_event_type, event->type);
+        CHECK_EQUAL(KAIZEN_ALLOCATION_NO_ZONE_ID, event->id);
+        CHECK_EQUAL(8u, event->value);
+
+        event = kaizen_event_buffer_at(buffer, 1);
+        CHECK_EQUAL(kaizen_allocation_event_type, event->type);
+        CHECK_EQUAL(test_zone_id, event->id);
+        CHECK_EQUAL(32u, event->value);
+
+        event = kaizen_event_buffer_at(buffer, 2);
+        CHECK_EQUAL(kaizen_deallocation_event_type, event->type);
+        CHECK_EQUAL(test_zone_id, event->id);
+        CHECK_EQUAL(8u, event->value);
+
+        CHECK_EQUAL(kaizen_zone_event_type, kaizen_event_buffer_at(buffer, 3)->type);
+
+        errc = kaizen_thread_state_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_thread_state_finalize(&state);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(tracking_hooks_record_sizes)
+    {
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        int errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        void* const pointer = kaizen::detail::tracked_allocate(24);
+        CHECK(NULL != pointer);
+        CHECK_EQUAL(0u, reinterpret_cast<std::size_t>(pointer) % kaizen::detail::allocation_header_size);
+        kaizen::detail::tracked_deallocate(pointer);
+
+        {
+            std::vector<int, kaizen::tracking_allocator<int> > values;
+            values.reserve(4);
+        }
+
+        CHECK_EQUAL(4u, kaizen_event_buffer_count(&buffer));
+        CHECK_EQUAL(24u, kaizen_event_buffer_at(&buffer, 0)->value);
+        CHECK_EQUAL(kaizen_deallocation_event_type, kaizen_event_buffer_at(&buffer, 1)->type);
+        CHECK_EQUAL(24u, kaizen_event_buffer_at(&buffer, 1)->value);
+        CHECK_EQUAL(4u * sizeof(int), kaizen_event_buffer_at(&buffer, 2)->value);
+        CHECK_EQUAL(4u * sizeof(int), kaizen_event_buffer_at(&buffer, 3)->value);
+
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(analysis_sums_allocations_per_zone)
+    {
+        kaizen::capture capture;
+        capture.ticks_per_second = 1000;
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, test_zone_id, 0, 10, 1));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_allocation_event_type, test_zone_id, 2, 0, 100));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_allocation_event_type, test_zone_id, 3, 0, 28));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_deallocation_event_type, test_zone_id, 4, 0, 100));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_allocation_event_type, KAIZEN_ALLOCATION_NO_ZONE_ID, 20, 0, 64));
+
+        kaizen::capture_report const report = kaizen::analyze_capture(capture, 1);
+
+        CHECK_EQUAL(1u, report.zones.size());
+        CHECK_EQUAL(2u, report.zones[0].allocation_count);
+        CHECK_EQUAL(128u, report.zones[0].allocated_bytes);
+        CHECK_EQUAL(1u, report.zones[0].deallocation_count);
+        CHECK_EQUAL(100u, report.zones[0].deallocated_bytes);
+    }
+
+} // SUITE(kaizen_allocation_test)
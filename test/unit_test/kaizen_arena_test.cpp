@@ -0,0 +1,154 @@
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_raw_memory.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    std::size_t const arena_size = 4096;
+
+    bool is_aligned(void* pointer, std::size_t const alignment)
+    {
+        return 0 == (reinterpret_cast<std::size_t>(pointer) % alignment);
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_arena_test)
+{
+    TEST(persistent_and_frame_allocations_are_aligned_and_disjoint)
+    {
+        static char memory[arena_size];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, arena_size);
+        assert(KAIZEN_SUCCESS == errc);
+
+        void* persistent = NULL;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_arena_allocate_persistent(&arena, 100, 64, &persistent));
+        CHECK(is_aligned(persistent, 64));
+
+        void* frame = NULL;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_arena_allocate_frame(&arena, 100, 64, &frame));
+        CHECK(is_aligned(frame, 64));
+        CHECK(static_cast<char*>(persistent) + 100 <= static_cast<char*>(frame));
+        CHECK(static_cast<char*>(frame) + 100 <= memory + arena_size);
+
+        CHECK(100u <= kaizen_arena_persistent_size(&arena));
+        CHECK(100u <= kaizen_arena_frame_size(&arena));
+        CHECK_EQUAL(arena_size, kaizen_arena_capacity(&arena));
+
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(frame_reset_releases_frame_allocations_only)
+    {
+        static char memory[arena_size];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, arena_size);
+        assert(KAIZEN_SUCCESS == errc);
+
+        void* persistent = NULL;
+        errc = kaizen_arena_allocate_persistent(&arena, 1024, KAIZEN_ARENA_DEFAULT_ALIGNMENT, &persistent);
+        assert(KAIZEN_SUCCESS == errc);
+        std::size_t const persistent_size = kaizen_arena_persistent_size(&arena);
+
+        void* frame = NULL;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_arena_allocate_frame(&arena, 2048, KAIZEN_ARENA_DEFAULT_ALIGNMENT, &frame));
+        CHECK_EQUAL(ENOMEM, kaizen_arena_allocate_frame(&arena, 2048, KAIZEN_ARENA_DEFAULT_ALIGNMENT, &frame));
+        CHECK_EQUAL(ENOMEM, kaizen_arena_allocate_persistent(&arena, 2048, KAIZEN_ARENA_DEFAULT_ALIGNMENT, &persistent));
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_arena_reset_frame(&arena));
+        CHECK_EQUAL(0u, kaizen_arena_frame_size(&arena));
+        CHECK_EQUAL(persistent_size, kaizen_arena_persistent_size(&arena));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_arena_allocate_frame(&arena, 2048, KAIZEN_ARENA_DEFAULT_ALIGNMENT, &frame));
+
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(concurrent_frame_allocations_do_not_overlap)
+    {
+        std::size_t const thread_count = 4;
+        std::size_t const allocation_count = 64;
+        std::size_t const allocation_size = 24;
+
+        kaizen_raw_memory_region_t region;
+        int errc = kaizen_memory_region_init(&region,
+                                             thread_count * allocation_count * 32,
+                                             kaizen_memory_huge_page_size);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_arena_t arena;
+        errc = kaizen_arena_init(&arena,
+                                 kaizen_memory_region_memory(&region),
+                                 kaizen_memory_region_size(&region));
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::vector<char*> allocations(thread_count * allocation_count, static_cast<char*>(NULL));
+        std::vector<std::thread> threads;
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads.push_back(std::thread([&, t]() {
+                for (std::size_t i = 0; i < allocation_count; ++i) {
+                    void* allocation = NULL;
+                    (void)kaizen_arena_allocate_frame(&arena, allocation_size, 8, &allocation);
+                    allocations[t * allocation_count + i] = static_cast<char*>(allocation);
+                }
+            }));
+        }
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads[t].join();
+        }
+
+        std::sort(allocations.begin(), allocations.end());
+        CHECK(NULL != allocations.front());
+
+        for (std::size_t i = 1; i < allocations.size(); ++i) {
+            CHECK(allocations[i - 1] + allocation_size <= allocations[i]);
+        }
+
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_memory_region_finalize(&region);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(event_buffer_from_arena)
+    {
+        static char memory[arena_size];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, arena_size);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_buffer_t buffer;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_buffer_init_from_arena(&buffer, &arena, 8));
+        CHECK(8 * sizeof(kaizen_event_t) <= kaizen_arena_persistent_size(&arena));
+        CHECK_EQUAL(ENOMEM, kaizen_event_buffer_init_from_arena(&buffer, &arena, arena_size));
+
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_arena_test)
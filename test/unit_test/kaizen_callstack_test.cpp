@@ -0,0 +1,266 @@
+
+#include <kaizen/kaizen_callstack.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    uint32_t const table_capacity = 64;
+
+    std::size_t const event_capacity = 256;
+
+    uint32_t const test_zone_id = 11;
+
+
+    std::size_t const table_memory_size = table_capacity * sizeof(kaizen_callstack_entry_t) + 512;
+
+
+    void init_table(kaizen_callstack_table_t* table,
+                    kaizen_arena_t* arena,
+                    void* memory)
+    {
+        int errc = kaizen_arena_init(arena, memory, table_memory_size);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_callstack_table_init_from_arena(table, arena, table_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+    }
+
+
+    void finalize_table(kaizen_callstack_table_t* table,
+                        kaizen_arena_t* arena)
+    {
+        int errc = kaizen_callstack_table_finalize(table);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(arena);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+    }
+
+
+#if defined(__GNUC__)
+    __attribute__((noinline))
+#endif
+    void execute_zone(kaizen_zone_t* zone)
+    {
+        kaizen_zone_scope_t scope;
+        (void)kaizen_zone_begin(zone, &scope);
+        (void)kaizen_zone_end(&scope);
+    }
+
+
+    // Runs execute_zone count times from a single call site so every run
+    // captures the same stack. The volatile bound and function pointer keep
+    // the compiler from unrolling the loop into several call sites.
+#if defined(__GNUC__)
+    __attribute__((noinline))
+#endif
+    void execute_zone_repeatedly(kaizen_zone_t* zone, int count)
+    {
+        void (* volatile execute)(kaizen_zone_t*) = &execute_zone;
+        volatile int const repeat_count = count;
+        for (int i = 0; i < repeat_count; ++i) {
+            execute(zone);
+        }
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_callstack_test)
+{
+    TEST(same_stack_is_interned_once)
+    {
+        static uint64_t memory[table_memory_size / sizeof(uint64_t)];
+        kaizen_arena_t arena;
+        kaizen_callstack_table_t table;
+        init_table(&table, &arena, memory);
+
+        uint64_t const frames[] = {0x1000u, 0x2000u, 0x3000u};
+        uint64_t const other_frames[] = {0x1000u, 0x2000u, 0x4000u};
+
+        uint32_t stack_id = KAIZEN_CALLSTACK_NO_ID;
+        kaizen_bool is_new = KAIZEN_FALSE;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_callstack_table_intern(&table, frames, 3u, &stack_id, &is_new));
+        CHECK_EQUAL(KAIZEN_TRUE, is_new);
+        CHECK(KAIZEN_CALLSTACK_NO_ID != stack_id);
+
+        uint32_t same_stack_id = KAIZEN_CALLSTACK_NO_ID;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_callstack_table_intern(&table, frames, 3u, &same_stack_id, &is_new));
+        CHECK_EQUAL(KAIZEN_FALSE, is_new);
+        CHECK_EQUAL(stack_id, same_stack_id);
+
+        uint32_t other_stack_id = KAIZEN_CALLSTACK_NO_ID;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_callstack_table_intern(&table, other_frames, 3u, &other_stack_id, &is_new));
+        CHECK_EQUAL(KAIZEN_TRUE, is_new);
+        CHECK(stack_id != other_stack_id);
+
+        uint32_t shorter_stack_id = KAIZEN_CALLSTACK_NO_ID;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_callstack_table_intern(&table, frames, 2u, &shorter_stack_id, &is_new));
+        CHECK_EQUAL(KAIZEN_TRUE, is_new);
+        CHECK_EQUAL(3u, kaizen_callstack_table_count(&table));
+
+        uint64_t stored_frames[KAIZEN_CALLSTACK_MAX_DEPTH];
+        uint32_t depth = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_callstack_table_frames(&table, other_stack_id, stored_frames, &depth));
+        CHECK_EQUAL(3u, depth);
+        CHECK_ARRAY_EQUAL(other_frames, stored_frames, 3);
+
+        CHECK_EQUAL(ESRCH, kaizen_callstack_table_frames(&table, KAIZEN_CALLSTACK_NO_ID, stored_frames, &depth));
+        CHECK_EQUAL(EINVAL, kaizen_callstack_table_intern(&table, frames, 0u, &stack_id, &is_new));
+        CHECK_EQUAL(EINVAL, kaizen_callstack_table_intern(&table, frames, KAIZEN_CALLSTACK_MAX_DEPTH + 1u, &stack_id, &is_new));
+
+        finalize_table(&table, &arena);
+    }
+
+
+
+    TEST(threads_adding_the_same_stacks_get_one_id_each)
+    {
+        static uint64_t memory[table_memory_size / sizeof(uint64_t)];
+        kaizen_arena_t arena;
+        kaizen_callstack_table_t table;
+        init_table(&table, &arena, memory);
+
+        std::size_t const thread_count = 4;
+        std::size_t const stack_count = 32;
+
+        std::vector<uint32_t> stack_ids(thread_count * stack_count, KAIZEN_CALLSTACK_NO_ID);
+        std::vector<std::thread> threads;
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads.push_back(std::thread([&, t]() {
+                for (std::size_t i = 0; i < stack_count; ++i) {
+                    uint64_t const frames[] = {0x1000u + i * 16u, 0x8000u};
+                    kaizen_bool is_new = KAIZEN_FALSE;
+                    (void)kaizen_callstack_table_intern(&table, frames, 2u, &stack_ids[t * stack_count + i], &is_new);
+                }
+            }));
+        }
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads[t].join();
+        }
+
+        CHECK_EQUAL(stack_count, kaizen_callstack_table_count(&table));
+
+        for (std::size_t t = 1; t < thread_count; ++t) {
+            CHECK_ARRAY_EQUAL(&stack_ids[0], &stack_ids[t * stack_count], stack_count);
+        }
+
+        finalize_table(&table, &arena);
+    }
+
+
+
+    TEST(full_table_drops_new_stacks)
+    {
+        static uint64_t memory[table_memory_size / sizeof(uint64_t)];
+        kaizen_arena_t arena;
+        kaizen_callstack_table_t table;
+        init_table(&table, &arena, memory);
+
+        kaizen_bool is_new = KAIZEN_FALSE;
+        uint32_t stack_id = KAIZEN_CALLSTACK_NO_ID;
+
+        for (uint64_t i = 0; i < table_capacity; ++i) {
+            uint64_t const frame = 0x1000u + i * 16u;
+            CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_callstack_table_intern(&table, &frame, 1u, &stack_id, &is_new));
+        }
+
+        uint64_t const frame = 0x1000u;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_callstack_table_intern(&table, &frame, 1u, &stack_id, &is_new));
+        CHECK_EQUAL(KAIZEN_FALSE, is_new);
+
+        uint64_t const new_frame = 0x9000u;
+        CHECK_EQUAL(ENOMEM, kaizen_callstack_table_intern(&table, &new_frame, 1u, &stack_id, &is_new));
+        CHECK_EQUAL(table_capacity, kaizen_callstack_table_count(&table));
+        CHECK_EQUAL(1u, kaizen_callstack_table_dropped_count(&table));
+
+        finalize_table(&table, &arena);
+    }
+
+
+
+    TEST(zone_records_stack_definition_once)
+    {
+        static uint64_t memory[table_memory_size / sizeof(uint64_t)];
+        kaizen_arena_t arena;
+        kaizen_callstack_table_t table;
+        init_table(&table, &arena, memory);
+
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        int errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_callstack_table_attach_to_current_thread(&table);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_zone_t zone = KAIZEN_ZONE_INITIALIZER("zone", test_zone_id);
+        CHECK_EQUAL(0u, kaizen_zone_callstack_depth(&zone));
+        CHECK_EQUAL(EINVAL, kaizen_zone_set_callstack_depth(&zone, KAIZEN_CALLSTACK_MAX_DEPTH + 1u));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_set_callstack_depth(&zone, 4u));
+        CHECK_EQUAL(4u, kaizen_zone_callstack_depth(&zone));
+
+        execute_zone_repeatedly(&zone, 3);
+
+        std::size_t zone_event_count = 0;
+        std::size_t definition_count = 0;
+        std::size_t zone_callstack_count = 0;
+        uint32_t stack_id = KAIZEN_CALLSTACK_NO_ID;
+
+        for (std::size_t i = 0; i < kaizen_event_buffer_count(&buffer); ++i) {
+            kaizen_event_t const* const event = kaizen_event_buffer_at(&buffer, i);
+
+            if (kaizen_zone_event_type == event->type) {
+                ++zone_event_count;
+            } else if (kaizen_callstack_event_type == event->type) {
+                ++definition_count;
+                CHECK(1u <= event->flags && 4u >= event->flags);
+                stack_id = event->id;
+            } else if (kaizen_zone_callstack_event_type == event->type) {
+                ++zone_callstack_count;
+                CHECK_EQUAL(test_zone_id, event->id);
+                CHECK_EQUAL(static_cast<uint64_t>(stack_id), event->value);
+            } else {
+                CHECK_EQUAL(static_cast<uint16_t>(kaizen_stack_frame_event_type), event->type);
+                CHECK_EQUAL(stack_id, event->id);
+            }
+        }
+
+        CHECK_EQUAL(3u, zone_event_count);
+
+        // Builds without frame pointers or stack bounds only record the zones.
+        if (0u != definition_count) {
+            CHECK_EQUAL(1u, definition_count);
+            CHECK_EQUAL(3u, zone_callstack_count);
+            CHECK_EQUAL(1u, kaizen_callstack_table_count(&table));
+        } else {
+            CHECK_EQUAL(0u, zone_callstack_count);
+        }
+
+        errc = kaizen_callstack_table_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+        finalize_table(&table, &arena);
+    }
+
+} // SUITE(kaizen_callstack_test)
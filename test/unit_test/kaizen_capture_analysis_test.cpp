@@ -0,0 +1,422 @@
+#include <kaizen/kaizen_capture_analysis.hpp>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_event_encoding.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_zone.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "kaizen_test_events.hpp"
+
+
+
+namespace {
+
+    std::uint64_t const ticks_per_second = 1000000;
+    double const tolerance = 1.0e-9;
+
+
+    // Frame n lasts 1000 + n * 100 ticks, zone 1 encloses zone 2 in every
+    // frame on stream 0, zone 3 runs once per frame on stream 1. Events are
+    // in recording order, i.e. when they end.
+    std::string make_capture(std::size_t const frame_count, std::size_t const block_size)
+    {
+        std::ostringstream stream;
+        kaizen::capture_writer writer(stream, ticks_per_second, block_size);
+
+        std::vector<kaizen_event_t> main_thread;
+        std::vector<kaizen_event_t> worker_thread;
+        std::uint64_t begin = 0;
+
+        for (std::size_t n = 0; n < frame_count; ++n) {
+            std::uint64_t const frame_duration = 1000 + n * 100;
+            main_thread.push_back(kaizen_test::make_event(kaizen_zone_event_type, 2, begin + 20, 200, 1));
+            main_thread.push_back(kaizen_test::make_event(kaizen_zone_event_type, 1, begin + 10, 500, 1));
+            main_thread.push_back(kaizen_test::make_event(kaizen_frame_event_type, 0, begin, frame_duration, n));
+            worker_thread.push_back(kaizen_test::make_event(kaizen_zone_event_type, 3, begin + 5, 100 + n, 1));
+            begin += frame_duration;
+        }
+
+        writer.write(0, &main_thread[0], main_thread.size());
+        writer.write(1, &worker_thread[0], worker_thread.size());
+
+        return stream.str();
+    }
+
+
+    void check_equal_reports(kaizen::capture_report const& expected,
+                             kaizen::capture_report const& actual)
+    {
+        CHECK_EQUAL(expected.frames.size(), actual.frames.size());
+        CHECK_EQUAL(expected.zones.size(), actual.zones.size());
+
+        for (std::size_t i = 0; i < expected.zones.size() && i < actual.zones.size(); ++i) {
+            CHECK_EQUAL(expected.zones[i].zone_id, actual.zones[i].zone_id);
+            CHECK_EQUAL(expected.zones[i].name, actual.zones[i].name);
+            CHECK_EQUAL(expected.zones[i].count, actual.zones[i].count);
+            CHECK_CLOSE(expected.zones[i].total_seconds, actual.zones[i].total_seconds, tolerance);
+            CHECK_CLOSE(expected.zones[i].self_seconds, actual.zones[i].self_seconds, tolerance);
+            CHECK_CLOSE(expected.zones[i].p95_seconds, actual.zones[i].p95_seconds, tolerance);
+            CHECK_CLOSE(expected.zones[i].max_seconds, actual.zones[i].max_seconds, tolerance);
+            CHECK_EQUAL(expected.zones[i].frame_seconds.size(), actual.zones[i].frame_seconds.size());
+        }
+    }
+
+
+    kaizen::capture_report make_report(std::uint32_t const zone_id,
+                                       std::vector<double> const& frame_seconds)
+    {
+        kaizen::capture_report report;
+        kaizen::zone_report zone = kaizen::zone_report();
+        zone.zone_id = zone_id;
+        zone.frame_seconds = frame_seconds;
+        report.zones.push_back(zone);
+
+        return report;
+    }
+
+
+    // Deterministic jittered frame times around median_seconds.
+    std::vector<double> make_frame_seconds(double const median_seconds, std::size_t const count)
+    {
+        std::vector<double> frame_seconds;
+
+        for (std::size_t i = 0; i < count; ++i) {
+            double const jitter = static_cast<double>((i * 7919) % 101) / 100.0 - 0.5;
+            frame_seconds.push_back(median_seconds * (1.0 + 0.1 * jitter));
+        }
+
+        return frame_seconds;
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_capture_analysis_test)
+{
+    TEST(written_capture_reads_back_in_parallel)
+    {
+        std::istringstream stream(make_capture(50, 128));
+        kaizen::capture const capture = kaizen::read_capture(stream, 3, 256);
+
+        CHECK_EQUAL(ticks_per_second, capture.ticks_per_second);
+        CHECK_EQUAL(200u, capture.events.size());
+
+        // Per stream order is kept across blocks and chunks.
+        std::uint64_t previous_time = 0;
+        for (std::size_t i = 0; i < capture.events.size(); ++i) {
+            if (1 == capture.events[i].stream_id) {
+                CHECK(previous_time <= capture.events[i].time);
+                previous_time = capture.events[i].time;
+            }
+        }
+    }
+
+
+
+    TEST(compressed_capture_reads_back_the_same_events)
+    {
+        std::string const capture = make_capture(200, 4096);
+        std::istringstream stream(capture);
+        std::ostringstream compressed;
+        kaizen::compress_capture(stream, compressed);
+
+        CHECK(compressed.str().size() < capture.size());
+
+        std::istringstream capture_stream(capture);
+        std::istringstream compressed_stream(compressed.str());
+        kaizen::capture const expected = kaizen::read_capture(capture_stream, 1);
+        kaizen::capture const actual = kaizen::read_capture(compressed_stream, 2, 256);
+
+        CHECK_EQUAL(expected.ticks_per_second, actual.ticks_per_second);
+        CHECK_EQUAL(expected.events.size(), actual.events.size());
+
+        for (std::size_t i = 0; i < expected.events.size() && i < actual.events.size(); ++i) {
+            CHECK_EQUAL(expected.events[i].time, actual.events[i].time);
+            CHECK_EQUAL(expected.events[i].duration, actual.events[i].duration);
+            CHECK_EQUAL(expected.events[i].value, actual.events[i].value);
+            CHECK_EQUAL(expected.events[i].id, actual.events[i].id);
+            CHECK_EQUAL(expected.events[i].stream_id, actual.events[i].stream_id);
+            CHECK_EQUAL(expected.events[i].type, actual.events[i].type);
+        }
+    }
+
+
+
+    TEST(zone_statistics_include_self_time_and_percentiles)
+    {
+        std::istringstream stream(make_capture(100, 4096));
+        kaizen::capture const capture = kaizen::read_capture(stream, 2);
+        kaizen::capture_report const report = kaizen::analyze_capture(capture, 4);
+
+        CHECK_EQUAL(3u, report.zones.size());
+        CHECK_EQUAL(100u, report.frames.size());
+
+        kaizen::zone_report const& outer = report.zones[0];
+        CHECK_EQUAL(1u, outer.zone_id);
+        CHECK_EQUAL(100u, outer.count);
+        CHECK_CLOSE(100 * 500.0e-6, outer.total_seconds, tolerance);
+        CHECK_CLOSE(100 * 300.0e-6, outer.self_seconds, tolerance);
+
+        kaizen::zone_report const& inner = report.zones[1];
+        CHECK_CLOSE(inner.total_seconds, inner.self_seconds, tolerance);
+
+        // Zone 3 runs 100 to 199 ticks.
+        kaizen::zone_report const& worker = report.zones[2];
+        CHECK_CLOSE(149.0e-6, worker.p50_seconds, tolerance);
+        CHECK_CLOSE(194.0e-6, worker.p95_seconds, tolerance);
+        CHECK_CLOSE(198.0e-6, worker.p99_seconds, tolerance);
+        CHECK_CLOSE(199.0e-6, worker.max_seconds, tolerance);
+    }
+
+
+
+    TEST(zone_frame_times_are_in_frame_order)
+    {
+        std::istringstream stream(make_capture(30, 4096));
+        kaizen::capture_report const report = kaizen::analyze_capture(kaizen::read_capture(stream, 1), 4);
+
+        kaizen::zone_report const& outer = report.zones[0];
+        CHECK_EQUAL(30u, outer.frame_seconds.size());
+        CHECK_CLOSE(500.0e-6, outer.frame_seconds[7], tolerance);
+
+        kaizen::zone_report const& worker = report.zones[2];
+        CHECK_EQUAL(30u, worker.frame_seconds.size());
+        for (std::size_t i = 0; i < worker.frame_seconds.size(); ++i) {
+            CHECK_CLOSE((100.0 + i) * 1.0e-6, worker.frame_seconds[i], tolerance);
+        }
+    }
+
+
+
+    TEST(self_times_do_not_depend_on_the_thread_count)
+    {
+        std::string const capture = make_capture(60, 256);
+        std::istringstream stream(capture);
+        kaizen::capture const events = kaizen::read_capture(stream, 1);
+        kaizen::capture_report const expected = kaizen::analyze_capture(events, 1);
+
+        CHECK_CLOSE(60 * 300.0e-6, expected.zones[0].self_seconds, tolerance);
+
+        for (unsigned thread_count = 2; thread_count <= 8; thread_count *= 2) {
+            check_equal_reports(expected, kaizen::analyze_capture(events, thread_count));
+
+            std::istringstream capture_stream(capture);
+            check_equal_reports(expected, kaizen::analyze_capture(capture_stream, thread_count, false, 512));
+        }
+    }
+
+
+
+    TEST(single_stream_captures_split_across_threads_report_the_same)
+    {
+        std::ostringstream capture;
+        kaizen::capture_writer writer(capture, ticks_per_second, 96);
+
+        // Zone 1 encloses zone 2 enclosing zone 3 on one stream, zone 2
+        // records two counters and every third zone 3 was descheduled.
+        std::vector<kaizen_event_t> events;
+        std::uint64_t begin = 0;
+        char const name[] = "render_shadow_maps";
+
+        for (std::uint64_t n = 0; n < 40; ++n) {
+            std::uint16_t const zone_3_flags = (0 == n % 3) ? KAIZEN_ZONE_EVENT_DESCHEDULED_FLAG : 0;
+            events.push_back(kaizen_test::make_event(kaizen_zone_event_type, 3, begin + 30, 50 + n, 1, zone_3_flags));
+            events.push_back(kaizen_test::make_event(kaizen_zone_event_type, 2, begin + 20, 200));
+            events.push_back(kaizen_test::make_event(kaizen_hardware_counter_event_type, 2, begin + 20, 0, 1000 + n, 0));
+            events.push_back(kaizen_test::make_event(kaizen_hardware_counter_event_type, 2, begin + 20, 0, 10, 1));
+            events.push_back(kaizen_test::make_event(kaizen_zone_event_type, 1, begin + 10, 500, 1, KAIZEN_ZONE_EVENT_OUTERMOST_FLAG));
+            events.push_back(kaizen_test::make_event(kaizen_frame_event_type, 0, begin, 1000, n));
+
+            if (20 == n) {
+                for (std::size_t chunk = 0; chunk * 8 < sizeof(name); ++chunk) {
+                    std::uint64_t value = 0;
+                    for (std::size_t i = 0; i < 8 && chunk * 8 + i < sizeof(name); ++i) {
+                        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(name[chunk * 8 + i])) << (8 * i);
+                    }
+
+                    events.push_back(kaizen_test::make_event(kaizen_zone_name_event_type, 3, begin, 0, value, static_cast<std::uint16_t>(chunk)));
+                }
+            }
+
+            begin += 1000;
+        }
+
+        writer.write(0, &events[0], events.size());
+
+        for (int exclude_descheduled = 0; exclude_descheduled < 2; ++exclude_descheduled) {
+            std::istringstream expected_stream(capture.str());
+            kaizen::capture_report const expected = kaizen::analyze_capture(expected_stream, 1, 0 != exclude_descheduled);
+
+            CHECK_EQUAL(3u, expected.zones.size());
+            CHECK_CLOSE(40 * 300.0e-6, expected.zones[0].self_seconds, tolerance);
+            CHECK_EQUAL("render_shadow_maps", expected.zones[2].name);
+
+            for (unsigned thread_count = 2; thread_count <= 8; ++thread_count) {
+                std::istringstream stream(capture.str());
+                kaizen::capture_report const actual = kaizen::analyze_capture(stream, thread_count, 0 != exclude_descheduled, 512);
+                check_equal_reports(expected, actual);
+
+                for (std::size_t i = 0; i < expected.zones.size() && i < actual.zones.size(); ++i) {
+                    CHECK_EQUAL(expected.zones[i].hardware_counter_totals[0], actual.zones[i].hardware_counter_totals[0]);
+                    CHECK_EQUAL(expected.zones[i].hardware_counter_sample_count, actual.zones[i].hardware_counter_sample_count);
+                    CHECK_EQUAL(expected.zones[i].descheduled_count, actual.zones[i].descheduled_count);
+                }
+            }
+        }
+
+        std::istringstream stream(capture.str());
+        kaizen::capture const events_in_memory = kaizen::read_capture(stream, 1);
+        kaizen::capture_report const expected = kaizen::analyze_capture(events_in_memory, 1);
+
+        for (unsigned thread_count = 2; thread_count <= 8; ++thread_count) {
+            check_equal_reports(expected, kaizen::analyze_capture(events_in_memory, thread_count));
+        }
+    }
+
+
+
+    TEST(zone_names_recorded_in_the_capture_are_reported)
+    {
+        kaizen_event_t storage[8];
+        kaizen_event_buffer_t buffer;
+        int errc = kaizen_event_buffer_init(&buffer, storage, 8);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_zone_t zone = KAIZEN_ZONE_INITIALIZER("render_shadow_maps", 2);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_record_name(&zone));
+
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::ostringstream capture;
+        kaizen::capture_writer writer(capture, ticks_per_second);
+        std::vector<kaizen_event_t> events(storage, storage + kaizen_event_buffer_count(&buffer));
+        events.push_back(kaizen_test::make_event(kaizen_zone_event_type, 2, 10, 200));
+        events.push_back(kaizen_test::make_event(kaizen_zone_event_type, 1, 5, 300));
+        writer.write(0, &events[0], events.size());
+
+        std::istringstream stream(capture.str());
+        kaizen::capture_report const report = kaizen::analyze_capture(stream, 2);
+
+        CHECK_EQUAL(2u, report.zones.size());
+        CHECK_EQUAL("", report.zones[0].name);
+        CHECK_EQUAL("render_shadow_maps", report.zones[1].name);
+
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(mann_whitney_matches_reference_values)
+    {
+        double const baseline[] = {1.0, 2.0, 3.0};
+        double const current[] = {4.0, 5.0, 6.0};
+
+        std::vector<kaizen::zone_comparison> const comparisons = kaizen::compare_reports(make_report(1, std::vector<double>(baseline, baseline + 3)),
+                                                                                         make_report(1, std::vector<double>(current, current + 3)),
+                                                                                         0.05);
+        CHECK_EQUAL(1u, comparisons.size());
+        CHECK_CLOSE(1.7457, comparisons[0].z_score, 1.0e-4);
+        CHECK_CLOSE(0.0809, comparisons[0].p_value, 1.0e-4);
+        CHECK_CLOSE(1.0, comparisons[0].probability_slower, tolerance);
+        CHECK_CLOSE(2.0, comparisons[0].baseline_median_seconds, tolerance);
+        CHECK(kaizen::zone_change::none == comparisons[0].change);
+    }
+
+
+
+    TEST(significant_changes_are_flagged)
+    {
+        std::vector<double> const baseline = make_frame_seconds(1.0e-3, 300);
+
+        std::vector<kaizen::zone_comparison> comparisons = kaizen::compare_reports(make_report(1, baseline),
+                                                                                   make_report(1, make_frame_seconds(1.05e-3, 300)));
+        CHECK(kaizen::zone_change::regression == comparisons[0].change);
+        CHECK(0.99 < comparisons[0].confidence);
+        CHECK(0.5 < comparisons[0].probability_slower);
+
+        comparisons = kaizen::compare_reports(make_report(1, baseline),
+                                              make_report(1, make_frame_seconds(0.95e-3, 300)));
+        CHECK(kaizen::zone_change::improvement == comparisons[0].change);
+
+        comparisons = kaizen::compare_reports(make_report(1, baseline),
+                                              make_report(1, make_frame_seconds(1.0e-3, 250)));
+        CHECK(kaizen::zone_change::none == comparisons[0].change);
+
+        // Significant but smaller than the minimal relative change.
+        comparisons = kaizen::compare_reports(make_report(1, baseline),
+                                              make_report(1, make_frame_seconds(1.05e-3, 300)),
+                                              0.01,
+                                              0.1);
+        CHECK(kaizen::zone_change::none == comparisons[0].change);
+    }
+
+
+
+    TEST(worst_frames_are_longest_first)
+    {
+        std::istringstream stream(make_capture(20, 4096));
+        kaizen::capture_report const report = kaizen::analyze_capture(kaizen::read_capture(stream, 1), 3);
+
+        std::vector<kaizen::frame_report> const frames = kaizen::worst_frames(report, 3);
+        CHECK_EQUAL(3u, frames.size());
+        CHECK_EQUAL(19u, frames[0].frame_number);
+        CHECK_EQUAL(18u, frames[1].frame_number);
+        CHECK_EQUAL(17u, frames[2].frame_number);
+    }
+
+
+
+    TEST(diff_pairs_zones_of_both_reports)
+    {
+        kaizen::capture_report baseline;
+        kaizen::capture_report current;
+        kaizen::zone_report zone = kaizen::zone_report();
+        zone.zone_id = 1;
+        zone.total_seconds = 1.0;
+        baseline.zones.push_back(zone);
+        zone.total_seconds = 2.0;
+        current.zones.push_back(zone);
+        zone.zone_id = 2;
+        current.zones.push_back(zone);
+
+        std::vector<kaizen::zone_difference> const differences = kaizen::diff_reports(baseline, current);
+        CHECK_EQUAL(2u, differences.size());
+        CHECK_EQUAL(1.0, differences[0].baseline.total_seconds);
+        CHECK_EQUAL(2.0, differences[0].current.total_seconds);
+        CHECK_EQUAL(2u, differences[1].zone_id);
+        CHECK_EQUAL(0u, differences[1].baseline.count);
+    }
+
+
+
+    TEST(malformed_capture_throws)
+    {
+        std::string capture = make_capture(2, 4096);
+        capture[KAIZEN_EVENT_STREAM_HEADER_SIZE] = 'X';
+        std::istringstream stream(capture);
+
+        bool thrown = false;
+        try {
+            (void)kaizen::read_capture(stream, 1);
+        } catch (std::system_error const& e) {
+            thrown = (EINVAL == e.code().value());
+        }
+        CHECK(thrown);
+    }
+
+} // SUITE(kaizen_capture_analysis_test)
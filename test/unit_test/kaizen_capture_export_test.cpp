@@ -0,0 +1,327 @@
+#include <kaizen/kaizen_capture_analysis.hpp>
+#include <kaizen/kaizen_capture_export.hpp>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_raw_sampler.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "kaizen_test_events.hpp"
+
+
+
+namespace {
+
+    // 1000 ticks per second, so one tick is one millisecond. The inner zone
+    // is recorded first and begins with the outer one.
+    std::string make_capture()
+    {
+        std::ostringstream stream;
+        kaizen::capture_writer writer(stream, 1000);
+
+        kaizen_event_t const events[] = {
+            kaizen_test::make_event(kaizen_zone_event_type, 2, 10, 5),
+            kaizen_test::make_event(kaizen_zone_event_type, 1, 10, 20)
+        };
+        writer.write(3, events, 2);
+
+        return stream.str();
+    }
+
+
+    // Appends a sample of frame_number with the addresses innermost first.
+    void add_sample(kaizen::capture& capture,
+                    std::uint32_t zone_id,
+                    std::uint64_t time,
+                    std::uint64_t frame_number,
+                    std::vector<std::uint64_t> const& addresses)
+    {
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_sample_event_type,
+                                                                 zone_id,
+                                                                 time,
+                                                                 0,
+                                                                 frame_number,
+                                                                 static_cast<std::uint16_t>(addresses.size())));
+
+        for (std::size_t i = 0; i < addresses.size(); ++i) {
+            capture.events.push_back(kaizen_test::make_capture_event(kaizen_stack_frame_event_type,
+                                                                     zone_id,
+                                                                     time,
+                                                                     0,
+                                                                     addresses[i],
+                                                                     static_cast<std::uint16_t>(i)));
+        }
+    }
+
+
+    std::string name_address(std::uint64_t address)
+    {
+        switch (address) {
+            case 0x100:
+                return "step";
+            case 0x1ff:
+                return "update";
+            case 0x2ff:
+                return "main";
+            default:
+                return "unknown";
+        }
+    }
+
+
+    std::uint64_t read_varint(std::string const& buffer, std::size_t& offset)
+    {
+        std::uint64_t value = 0;
+        unsigned shift = 0;
+
+        while (static_cast<unsigned char>(buffer[offset]) & 0x80) {
+            value |= static_cast<std::uint64_t>(buffer[offset++] & 0x7f) << shift;
+            shift += 7;
+        }
+        value |= static_cast<std::uint64_t>(buffer[offset++]) << shift;
+
+        return value;
+    }
+
+
+    struct perfetto_packet {
+        std::uint64_t timestamp;
+        std::uint64_t slice_type;
+        std::string name;
+        bool has_track_descriptor;
+    };
+
+
+    // Minimal protobuf walk over the fields written by the exporter.
+    std::vector<perfetto_packet> parse_perfetto_trace(std::string const& trace)
+    {
+        std::vector<perfetto_packet> packets;
+        std::size_t offset = 0;
+
+        while (offset < trace.size()) {
+            std::uint64_t const key = read_varint(trace, offset);
+            assert((1u << 3 | 2u) == key);
+            (void)key;
+            std::size_t const size = static_cast<std::size_t>(read_varint(trace, offset));
+            std::string const packet_bytes = trace.substr(offset, size);
+            offset += size;
+
+            perfetto_packet packet = {0, 0, std::string(), false};
+            std::size_t field_offset = 0;
+
+            while (field_offset < packet_bytes.size()) {
+                std::uint64_t const field_key = read_varint(packet_bytes, field_offset);
+
+                if (2u == (field_key & 7u)) {
+                    std::size_t const field_size = static_cast<std::size_t>(read_varint(packet_bytes, field_offset));
+                    std::string const field = packet_bytes.substr(field_offset, field_size);
+                    field_offset += field_size;
+
+                    if (60u == (field_key >> 3)) {
+                        packet.has_track_descriptor = true;
+                    } else if (11u == (field_key >> 3)) {
+                        std::size_t event_offset = 0;
+                        while (event_offset < field.size()) {
+                            std::uint64_t const event_key = read_varint(field, event_offset);
+                            if (2u == (event_key & 7u)) {
+                                std::size_t const event_field_size = static_cast<std::size_t>(read_varint(field, event_offset));
+                                if (23u == (event_key >> 3)) {
+                                    packet.name = field.substr(event_offset, event_field_size);
+                                }
+                                event_offset += event_field_size;
+                            } else {
+                                std::uint64_t const value = read_varint(field, event_offset);
+                                if (9u == (event_key >> 3)) {
+                                    packet.slice_type = value;
+                                }
+                            }
+                        }
+                    }
+                } else {
+                    std::uint64_t const value = read_varint(packet_bytes, field_offset);
+                    if (8u == (field_key >> 3)) {
+                        packet.timestamp = value;
+                    }
+                }
+            }
+
+            packets.push_back(packet);
+        }
+
+        return packets;
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_capture_export_test)
+{
+    TEST(chrome_trace_contains_complete_events_in_microseconds)
+    {
+        std::istringstream capture(make_capture());
+        std::ostringstream trace;
+        kaizen::export_chrome_trace(capture, trace);
+
+        std::string const json = trace.str();
+        CHECK(std::string::npos != json.find("\"traceEvents\":["));
+        CHECK(std::string::npos != json.find("\"args\":{\"name\":\"stream 3\"}"));
+        CHECK(std::string::npos != json.find("{\"name\":\"zone 1\",\"cat\":\"zone\",\"ph\":\"X\",\"ts\":10000.000,\"dur\":20000.000,\"pid\":1,\"tid\":3"));
+        CHECK(std::string::npos != json.find("{\"name\":\"zone 2\",\"cat\":\"zone\",\"ph\":\"X\",\"ts\":10000.000,\"dur\":5000.000"));
+        CHECK_EQUAL("\n]}\n", json.substr(json.size() - 4));
+    }
+
+
+
+    TEST(perfetto_trace_nests_slices)
+    {
+        std::istringstream capture(make_capture());
+        std::ostringstream trace;
+        kaizen::export_perfetto_trace(capture, trace);
+
+        std::vector<perfetto_packet> const packets = parse_perfetto_trace(trace.str());
+        CHECK_EQUAL(5u, packets.size());
+        CHECK(packets[0].has_track_descriptor);
+
+        // Outer zone begins first and ends last.
+        CHECK_EQUAL(1u, packets[1].slice_type);
+        CHECK_EQUAL("zone 1", packets[1].name);
+        CHECK_EQUAL(10000000u, packets[1].timestamp);
+        CHECK_EQUAL(1u, packets[2].slice_type);
+        CHECK_EQUAL("zone 2", packets[2].name);
+        CHECK_EQUAL(2u, packets[3].slice_type);
+        CHECK_EQUAL(15000000u, packets[3].timestamp);
+        CHECK_EQUAL(2u, packets[4].slice_type);
+        CHECK_EQUAL(30000000u, packets[4].timestamp);
+    }
+
+
+
+    TEST(reader_streams_blocks)
+    {
+        std::istringstream capture(make_capture());
+        kaizen::capture_reader reader(capture);
+        CHECK_EQUAL(1000u, reader.ticks_per_second());
+
+        std::vector<kaizen::capture_event> events;
+        CHECK(reader.read_block(events));
+        CHECK_EQUAL(2u, events.size());
+        CHECK_EQUAL(3u, events[0].stream_id);
+        CHECK(!reader.read_block(events));
+        CHECK(events.empty());
+    }
+
+
+
+    TEST(zone_folded_stacks_nest_zones_with_self_time)
+    {
+        std::istringstream stream(make_capture());
+        kaizen::capture const capture = kaizen::read_capture(stream);
+        std::ostringstream folded;
+        kaizen::export_zone_folded_stacks(capture, folded);
+
+        CHECK_EQUAL("zone 1 15000\nzone 1;zone 2 5000\n", folded.str());
+    }
+
+
+
+    TEST(zone_folded_stacks_only_contain_requested_frames)
+    {
+        kaizen::capture capture;
+        capture.ticks_per_second = 1000;
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_frame_event_type, 0, 0, 0, 1));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_frame_event_type, 0, 100, 0, 2));
+
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, 4, 10, 3));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, 4, 110, 7));
+
+        std::ostringstream folded;
+        kaizen::export_zone_folded_stacks(capture, folded, 2, 2);
+
+        CHECK_EQUAL("zone 4 7000\n", folded.str());
+    }
+
+
+
+    TEST(sample_folded_stacks_start_at_outermost_caller_in_zone)
+    {
+        kaizen::capture capture;
+        capture.ticks_per_second = 1000;
+
+        std::vector<std::uint64_t> addresses;
+        addresses.push_back(0x100);
+        addresses.push_back(0x200);
+        addresses.push_back(0x300);
+        add_sample(capture, 3, 10, 1, addresses);
+        add_sample(capture, 3, 11, 1, addresses);
+        add_sample(capture, KAIZEN_SAMPLE_NO_ZONE_ID, 12, 1, addresses);
+        add_sample(capture, 3, 13, 2, addresses);
+
+        std::ostringstream folded;
+        kaizen::export_sample_folded_stacks(capture, folded, name_address, 0, 1);
+
+        CHECK_EQUAL("main;update;step 1\nzone 3;main;update;step 2\n", folded.str());
+    }
+
+
+
+    TEST(sample_folded_stacks_without_symbolizer_use_addresses)
+    {
+        kaizen::capture capture;
+        capture.ticks_per_second = 1000;
+
+        std::vector<std::uint64_t> addresses;
+        addresses.push_back(0x10);
+        addresses.push_back(0x21);
+        add_sample(capture, KAIZEN_SAMPLE_NO_ZONE_ID, 10, 0, addresses);
+
+        std::ostringstream folded;
+        kaizen::export_sample_folded_stacks(capture, folded);
+
+        CHECK_EQUAL("0x20;0x10 1\n", folded.str());
+    }
+
+
+
+
+    TEST(zone_callstack_folded_stacks_end_in_zone_with_its_time)
+    {
+        kaizen::capture capture;
+        capture.ticks_per_second = 1000;
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_frame_event_type, 0, 0, 0, 1));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_frame_event_type, 0, 100, 0, 2));
+
+        // Stack 5 is update called from main, defined once.
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_callstack_event_type, 5, 10, 0, 0, 2));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_stack_frame_event_type, 5, 10, 0, 0x200, 0));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_stack_frame_event_type, 5, 10, 0, 0x300, 1));
+
+        kaizen::capture_event zone = kaizen_test::make_capture_event(kaizen_zone_event_type, 8, 10, 0);
+        kaizen::capture_event zone_callstack = kaizen_test::make_capture_event(kaizen_zone_callstack_event_type, 8, 10, 0, 5);
+        std::uint64_t const times[] = {10, 20, 110};
+        std::uint64_t const durations[] = {2, 3, 7};
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            zone.time = zone_callstack.time = times[i];
+            zone.duration = zone_callstack.duration = durations[i];
+            capture.events.push_back(zone);
+            capture.events.push_back(zone_callstack);
+        }
+
+        std::ostringstream all_frames;
+        kaizen::export_zone_callstack_folded_stacks(capture, all_frames, name_address);
+        CHECK_EQUAL("main;update;zone 8 12000\n", all_frames.str());
+
+        std::ostringstream first_frame;
+        kaizen::export_zone_callstack_folded_stacks(capture, first_frame, name_address, 1, 1);
+        CHECK_EQUAL("main;update;zone 8 5000\n", first_frame.str());
+    }
+
+} // SUITE(kaizen_capture_export_test)
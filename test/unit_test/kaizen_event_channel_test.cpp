@@ -0,0 +1,225 @@
+#include <kaizen/kaizen_event_channel.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <thread>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    std::size_t const arena_capacity = 256 * 1024;
+
+
+    void record_events(std::size_t const count, uint32_t const first_id, kaizen_event_type_t const type = kaizen_zone_event_type)
+    {
+        kaizen_raw_frame_time_t const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+        for (std::size_t i = 0; i < count; ++i) {
+            (void)kaizen_event_record(type, first_id + static_cast<uint32_t>(i), &zero, &zero, 0);
+        }
+    }
+
+
+    std::size_t pop_block(kaizen_event_channel_t* channel, uint32_t* first_id)
+    {
+        kaizen_event_t const* events = NULL;
+        std::size_t count = 0;
+
+        if (KAIZEN_SUCCESS != kaizen_event_channel_try_pop_begin(channel, &events, &count)) {
+            return 0;
+        }
+
+        *first_id = events[0].id;
+        kaizen_event_channel_pop_end(channel);
+
+        return count;
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_event_channel_test)
+{
+    TEST(full_blocks_and_flushes_are_published)
+    {
+        static char memory[arena_capacity];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_channel_t channel;
+        errc = kaizen_event_channel_init_from_arena(&channel, &arena, 4);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_channel_attach_to_current_thread(&channel);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK(kaizen_event_channel_event_buffer(&channel) == kaizen_event_buffer_of_current_thread());
+
+        kaizen_event_t const* events = NULL;
+        std::size_t count = 0;
+        CHECK_EQUAL(EAGAIN, kaizen_event_channel_try_pop_begin(&channel, &events, &count));
+
+        record_events(KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT, 0);
+        CHECK_EQUAL(EAGAIN, kaizen_event_channel_try_pop_begin(&channel, &events, &count));
+
+        record_events(10, KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_channel_flush(&channel));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_channel_flush(&channel));
+
+        uint32_t first_id = 0;
+        CHECK_EQUAL(static_cast<std::size_t>(KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT), pop_block(&channel, &first_id));
+        CHECK_EQUAL(0u, first_id);
+        CHECK_EQUAL(10u, pop_block(&channel, &first_id));
+        CHECK_EQUAL(static_cast<uint32_t>(KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT), first_id);
+        CHECK_EQUAL(0u, pop_block(&channel, &first_id));
+
+        errc = kaizen_event_channel_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_channel_finalize(&channel);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(frame_event_publishes_block)
+    {
+        static char memory[arena_capacity];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_channel_t channel;
+        errc = kaizen_event_channel_init_from_arena(&channel, &arena, 2);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_channel_attach_to_current_thread(&channel);
+        assert(KAIZEN_SUCCESS == errc);
+
+        record_events(3, 0);
+        record_events(1, 3, kaizen_frame_event_type);
+
+        uint32_t first_id = 0;
+        CHECK_EQUAL(4u, pop_block(&channel, &first_id));
+
+        errc = kaizen_event_channel_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_channel_finalize(&channel);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(events_are_dropped_while_all_blocks_are_published)
+    {
+        static char memory[arena_capacity];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_channel_t channel;
+        errc = kaizen_event_channel_init_from_arena(&channel, &arena, 2);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_channel_attach_to_current_thread(&channel);
+        assert(KAIZEN_SUCCESS == errc);
+
+        record_events(2 * KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT + 5, 0);
+        CHECK_EQUAL(EAGAIN, kaizen_event_channel_flush(&channel));
+        CHECK_EQUAL(5u, kaizen_event_channel_dropped_count(&channel));
+
+        uint32_t first_id = 0;
+        CHECK_EQUAL(static_cast<std::size_t>(KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT), pop_block(&channel, &first_id));
+
+        // Recording resumes once the consumer released a block.
+        record_events(1, 1000);
+        CHECK_EQUAL(EAGAIN, kaizen_event_channel_flush(&channel));
+        CHECK_EQUAL(5u, kaizen_event_channel_dropped_count(&channel));
+        CHECK_EQUAL(static_cast<std::size_t>(KAIZEN_EVENT_CHANNEL_BLOCK_EVENT_COUNT), pop_block(&channel, &first_id));
+        CHECK_EQUAL(1u, pop_block(&channel, &first_id));
+        CHECK_EQUAL(1000u, first_id);
+
+        errc = kaizen_event_channel_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_channel_finalize(&channel);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(consumer_thread_receives_all_events_in_order)
+    {
+        static char memory[arena_capacity];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_channel_t channel;
+        errc = kaizen_event_channel_init_from_arena(&channel, &arena, 8);
+        assert(KAIZEN_SUCCESS == errc);
+
+        uint32_t const event_count = 100000;
+
+        std::thread producer([&channel, event_count]() {
+            int const attach_errc = kaizen_event_channel_attach_to_current_thread(&channel);
+            assert(KAIZEN_SUCCESS == attach_errc);
+            (void)attach_errc;
+
+            kaizen_raw_frame_time_t const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+            for (uint32_t i = 0; i < event_count; ++i) {
+                // Retry dropped events so every event arrives.
+                while (KAIZEN_SUCCESS != kaizen_event_record(kaizen_zone_event_type, i, &zero, &zero, 0)) {
+                    std::this_thread::yield();
+                }
+            }
+
+            while (EAGAIN == kaizen_event_channel_flush(&channel)) {
+                std::this_thread::yield();
+            }
+
+            (void)kaizen_event_channel_attach_to_current_thread(NULL);
+        });
+
+        uint32_t expected_id = 0;
+        bool is_ordered = true;
+
+        while (expected_id < event_count) {
+            kaizen_event_t const* events = NULL;
+            std::size_t count = 0;
+
+            if (KAIZEN_SUCCESS != kaizen_event_channel_try_pop_begin(&channel, &events, &count)) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                is_ordered = is_ordered && (expected_id == events[i].id);
+                ++expected_id;
+            }
+
+            kaizen_event_channel_pop_end(&channel);
+        }
+
+        producer.join();
+
+        CHECK(is_ordered);
+        CHECK_EQUAL(event_count, expected_id);
+
+        errc = kaizen_event_channel_finalize(&channel);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_event_channel_test)
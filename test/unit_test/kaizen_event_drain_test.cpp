@@ -0,0 +1,322 @@
+#include <kaizen/kaizen_event_drain.h>
+#include <kaizen/kaizen_event_channel.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_raw_memory.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_capture_analysis.hpp>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "kaizen_test_events.hpp"
+
+
+
+namespace {
+
+    std::size_t const region_size = 1024 * 1024;
+    std::size_t const capture_capacity = 64 * 1024;
+    std::uint64_t const ticks_per_second = 1000000;
+
+
+    void record_zones(kaizen_event_channel_t* channel,
+                      std::uint32_t const first_id,
+                      std::size_t const count,
+                      std::uint64_t const first_time_ticks,
+                      std::uint64_t const time_step_ticks)
+    {
+        int errc = kaizen_event_channel_attach_to_current_thread(channel);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t duration;
+        errc = kaizen_frame_time_convert_from_ticks(&duration, 1);
+        assert(KAIZEN_SUCCESS == errc);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            kaizen_raw_frame_time_t time;
+            errc = kaizen_frame_time_convert_from_ticks(&time, first_time_ticks + i * time_step_ticks);
+            assert(KAIZEN_SUCCESS == errc);
+            errc = kaizen_event_record(kaizen_zone_event_type, first_id + static_cast<std::uint32_t>(i), &time, &duration, 0);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        errc = kaizen_event_channel_flush(channel);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_channel_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+    }
+
+
+    kaizen::capture read_drain_capture(kaizen_event_drain_t const* drain)
+    {
+        std::size_t size = 0;
+        std::uint8_t const* const data = kaizen_event_drain_capture(drain, &size);
+        std::istringstream stream(std::string(reinterpret_cast<char const*>(data), size));
+
+        return kaizen::read_capture(stream);
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_event_drain_test)
+{
+    TEST(numa_topology_is_consistent)
+    {
+        uint32_t const node_count = kaizen_memory_numa_node_count();
+
+        CHECK(1u <= node_count);
+        CHECK(kaizen_memory_numa_node_of_current_thread() < node_count);
+    }
+
+
+
+    TEST(region_on_numa_node)
+    {
+        kaizen_raw_memory_region_t region;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_memory_region_init_on_numa_node(&region, region_size, kaizen_memory_default_page_size, 0));
+        CHECK(NULL != kaizen_memory_region_memory(&region));
+        CHECK(region_size <= kaizen_memory_region_size(&region));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_memory_region_finalize(&region));
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_memory_region_init_on_numa_node(&region, region_size, kaizen_memory_default_page_size, KAIZEN_MEMORY_ANY_NUMA_NODE));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_memory_region_finalize(&region));
+
+        CHECK_EQUAL(EINVAL, kaizen_memory_region_init_on_numa_node(&region, region_size, kaizen_memory_default_page_size, kaizen_memory_numa_node_count()));
+    }
+
+
+
+    TEST(bind_thread_to_numa_node)
+    {
+        int bind_errc = -1;
+        int missing_node_errc = -1;
+        uint32_t node = KAIZEN_MEMORY_ANY_NUMA_NODE;
+
+        // Bind a separate thread to leave the affinity of the test runner untouched.
+        std::thread thread([&]() {
+            bind_errc = kaizen_memory_numa_bind_current_thread(0);
+            node = kaizen_memory_numa_node_of_current_thread();
+            missing_node_errc = kaizen_memory_numa_bind_current_thread(kaizen_memory_numa_node_count());
+        });
+        thread.join();
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, bind_errc);
+        CHECK_EQUAL(0u, node);
+        CHECK_EQUAL(EINVAL, missing_node_errc);
+    }
+
+
+
+    TEST(drain_encodes_blocks_of_all_channels)
+    {
+        kaizen_raw_memory_region_t region;
+        int errc = kaizen_memory_region_init_on_numa_node(&region, region_size, kaizen_memory_default_page_size, 0);
+        assert(KAIZEN_SUCCESS == errc);
+        kaizen_arena_t arena;
+        errc = kaizen_arena_init(&arena, kaizen_memory_region_memory(&region), kaizen_memory_region_size(&region));
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_drain_t drain;
+        errc = kaizen_event_drain_init_from_arena(&drain, &arena, 0, 2, capture_capacity, ticks_per_second);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_channel_t channels[3];
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            errc = kaizen_event_channel_init_from_arena(&channels[i], &arena, 4);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_drain_add_channel(&drain, &channels[0], 7));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_drain_add_channel(&drain, &channels[1], 8));
+        CHECK_EQUAL(ENOMEM, kaizen_event_drain_add_channel(&drain, &channels[2], 9));
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_drain_start(&drain));
+        record_zones(&channels[0], 0, 100, 0, 2);
+        record_zones(&channels[1], 1000, 100, 1, 2);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_drain_stop(&drain));
+
+        CHECK_EQUAL(0u, kaizen_event_drain_dropped_count(&drain));
+
+        kaizen::capture const capture = read_drain_capture(&drain);
+        CHECK_EQUAL(ticks_per_second, capture.ticks_per_second);
+        CHECK_EQUAL(200u, capture.events.size());
+
+        std::size_t first_stream_count = 0;
+
+        for (std::size_t i = 0; i < capture.events.size(); ++i) {
+            if (7u == capture.events[i].stream_id) {
+                CHECK_EQUAL(static_cast<std::uint32_t>(first_stream_count), capture.events[i].id);
+                ++first_stream_count;
+            } else {
+                CHECK_EQUAL(8u, capture.events[i].stream_id);
+            }
+        }
+
+        CHECK_EQUAL(100u, first_stream_count);
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            errc = kaizen_event_channel_finalize(&channels[i]);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        errc = kaizen_event_drain_finalize(&drain);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_memory_region_finalize(&region);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(compressed_drain_capture_decodes_to_same_events)
+    {
+        static char memory[region_size];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, region_size);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_drain_t drain;
+        errc = kaizen_event_drain_init_from_arena(&drain, &arena, KAIZEN_MEMORY_ANY_NUMA_NODE, 1, capture_capacity, ticks_per_second);
+        assert(KAIZEN_SUCCESS == errc);
+        kaizen_event_channel_t channel;
+        errc = kaizen_event_channel_init_from_arena(&channel, &arena, 32);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_drain_add_channel(&drain, &channel, 3);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_drain_set_compressed(&drain, KAIZEN_TRUE));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_drain_start(&drain));
+        record_zones(&channel, 0, 1000, 5, 3);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_drain_stop(&drain));
+
+        CHECK_EQUAL(0u, kaizen_event_drain_dropped_count(&drain));
+
+        std::size_t size = 0;
+        (void)kaizen_event_drain_capture(&drain, &size);
+        CHECK(size < 1000 * 4);
+
+        kaizen::capture const capture = read_drain_capture(&drain);
+        CHECK_EQUAL(1000u, capture.events.size());
+
+        for (std::size_t i = 0; i < capture.events.size(); ++i) {
+            CHECK_EQUAL(static_cast<std::uint64_t>(5 + i * 3), capture.events[i].time);
+            CHECK_EQUAL(static_cast<std::uint32_t>(i), capture.events[i].id);
+            CHECK_EQUAL(3u, capture.events[i].stream_id);
+        }
+
+        errc = kaizen_event_channel_finalize(&channel);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_drain_finalize(&drain);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(merged_drain_captures_are_ordered_by_end_time)
+    {
+        static char memory[2][region_size];
+        kaizen_arena_t arenas[2];
+        kaizen_event_drain_t drains[2];
+        kaizen_event_channel_t channels[2];
+        std::vector<kaizen::capture> captures;
+
+        for (std::size_t i = 0; i < 2; ++i) {
+            int errc = kaizen_arena_init(&arenas[i], memory[i], region_size);
+            assert(KAIZEN_SUCCESS == errc);
+            errc = kaizen_event_drain_init_from_arena(&drains[i], &arenas[i], KAIZEN_MEMORY_ANY_NUMA_NODE, 1, capture_capacity, ticks_per_second);
+            assert(KAIZEN_SUCCESS == errc);
+            errc = kaizen_event_channel_init_from_arena(&channels[i], &arenas[i], 4);
+            assert(KAIZEN_SUCCESS == errc);
+            errc = kaizen_event_drain_add_channel(&drains[i], &channels[i], static_cast<uint32_t>(i));
+            assert(KAIZEN_SUCCESS == errc);
+
+            errc = kaizen_event_drain_start(&drains[i]);
+            assert(KAIZEN_SUCCESS == errc);
+            record_zones(&channels[i], 0, 150, i, 2);
+            errc = kaizen_event_drain_stop(&drains[i]);
+            assert(KAIZEN_SUCCESS == errc);
+            (void)errc;
+
+            captures.push_back(read_drain_capture(&drains[i]));
+        }
+
+        kaizen::capture const merged = kaizen::merge_captures(captures);
+        CHECK_EQUAL(ticks_per_second, merged.ticks_per_second);
+        CHECK_EQUAL(300u, merged.events.size());
+
+        for (std::size_t i = 0; i < merged.events.size(); ++i) {
+            CHECK_EQUAL(static_cast<std::uint64_t>(i), merged.events[i].time);
+            CHECK_EQUAL(static_cast<std::uint32_t>(i % 2), merged.events[i].stream_id);
+        }
+
+        captures[1].ticks_per_second = 2 * ticks_per_second;
+        bool thrown = false;
+        try {
+            (void)kaizen::merge_captures(captures);
+        } catch (std::system_error const& e) {
+            thrown = (EINVAL == e.code().value());
+        }
+        CHECK(thrown);
+
+        for (std::size_t i = 0; i < 2; ++i) {
+            int errc = kaizen_event_channel_finalize(&channels[i]);
+            assert(KAIZEN_SUCCESS == errc);
+            errc = kaizen_event_drain_finalize(&drains[i]);
+            assert(KAIZEN_SUCCESS == errc);
+            errc = kaizen_arena_finalize(&arenas[i]);
+            assert(KAIZEN_SUCCESS == errc);
+            (void)errc;
+        }
+    }
+
+
+
+    TEST(merged_captures_order_nested_zones_and_late_samples_by_end_time)
+    {
+        // Each capture records inner zones before their outer zone and a
+        // sample with its stack frame after the zones.
+        std::vector<kaizen::capture> captures(2);
+
+        for (std::size_t i = 0; i < 2; ++i) {
+            captures[i].ticks_per_second = ticks_per_second;
+        }
+
+        captures[0].events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, 2, 10, 10));
+        captures[0].events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, 1, 0, 40));
+        captures[0].events.push_back(kaizen_test::make_capture_event(kaizen_sample_event_type, 3, 5, 0));
+        captures[0].events.push_back(kaizen_test::make_capture_event(kaizen_stack_frame_event_type, 4, 5, 0));
+        captures[1].events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, 6, 15, 10));
+        captures[1].events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, 5, 12, 20));
+
+        for (std::size_t i = 0; i < captures[1].events.size(); ++i) {
+            captures[1].events[i].stream_id = 1;
+        }
+
+        kaizen::capture const merged = kaizen::merge_captures(captures);
+        CHECK_EQUAL(6u, merged.events.size());
+
+        std::uint32_t const expected_ids[] = { 3, 4, 2, 6, 5, 1 };
+
+        for (std::size_t i = 0; i < merged.events.size() && i < 6; ++i) {
+            CHECK_EQUAL(expected_ids[i], merged.events[i].id);
+        }
+    }
+
+} // SUITE(kaizen_event_drain_test)
@@ -0,0 +1,379 @@
+#include <kaizen/kaizen_event_merge.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <UnitTest++.h>
+
+#include "kaizen_test_events.hpp"
+
+
+
+namespace {
+
+    std::size_t const arena_capacity = 64 * 1024;
+
+
+    std::uint64_t end_ticks_of(kaizen_event_t const& event)
+    {
+        std::uint64_t time = 0;
+        std::uint64_t duration = 0;
+        int errc = kaizen_frame_time_convert_to_ticks(&event.time, &time);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_frame_time_convert_to_ticks(&event.duration, &duration);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        return time + duration;
+    }
+
+
+    // Spins until the frame time moved on so consecutive zone ends differ.
+    void wait_for_next_tick()
+    {
+        kaizen_raw_frame_time_t start;
+        int errc = kaizen_frame_time_query(&start);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t now = start;
+
+        while (KAIZEN_FALSE == kaizen_frame_time_lesser(&start, &now)) {
+            errc = kaizen_frame_time_query(&now);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        (void)errc;
+    }
+
+
+    // Pops all events, supplying the streams in blocks of block_size events
+    // whenever the merge asks. Returns (end time in ticks, stream index) pairs.
+    std::vector<std::pair<std::uint64_t, std::size_t> > merge_all(kaizen_event_merge_t* merge,
+                                                                  std::vector<std::vector<kaizen_event_t> > const& streams,
+                                                                  std::size_t const block_size,
+                                                                  std::vector<kaizen_event_t>* merged_events = NULL)
+    {
+        std::vector<std::size_t> positions(streams.size(), 0);
+        std::vector<std::pair<std::uint64_t, std::size_t> > result;
+
+        for (;;) {
+            kaizen_event_t event;
+            std::size_t stream_index = 0;
+            int const errc = kaizen_event_merge_pop(merge, &event, &stream_index);
+
+            if (KAIZEN_SUCCESS == errc) {
+                result.push_back(std::make_pair(end_ticks_of(event), stream_index));
+
+                if (NULL != merged_events) {
+                    merged_events->push_back(event);
+                }
+            } else if (EAGAIN == errc) {
+                std::vector<kaizen_event_t> const& events = streams[stream_index];
+                std::size_t const position = positions[stream_index];
+
+                if (position == events.size()) {
+                    (void)kaizen_event_merge_finish_stream(merge, stream_index);
+                } else {
+                    std::size_t const count = std::min(block_size, events.size() - position);
+                    (void)kaizen_event_merge_supply(merge, stream_index, &events[position], count);
+                    positions[stream_index] += count;
+                }
+            } else {
+                CHECK_EQUAL(ENOENT, errc);
+                break;
+            }
+        }
+
+        return result;
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_event_merge_test)
+{
+    TEST(streams_are_merged_by_end_time)
+    {
+        static char memory[arena_capacity];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        // 64 streams, stream s records every (s + 1)th tick, two streams stay empty.
+        std::size_t const stream_count = 64;
+        std::vector<std::vector<kaizen_event_t> > streams(stream_count);
+
+        for (std::size_t s = 2; s < stream_count; ++s) {
+            for (std::uint64_t t = s; t < 2000; t += s + 1) {
+                streams[s].push_back(kaizen_test::make_event(kaizen_zone_event_type, static_cast<std::uint32_t>(s), t, 0));
+            }
+        }
+
+        kaizen_event_merge_t merge;
+        errc = kaizen_event_merge_init_from_arena(&merge, &arena, stream_count, 1);
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::vector<std::pair<std::uint64_t, std::size_t> > const merged = merge_all(&merge, streams, 7);
+
+        std::size_t event_count = 0;
+
+        for (std::size_t s = 0; s < stream_count; ++s) {
+            event_count += streams[s].size();
+        }
+
+        CHECK_EQUAL(event_count, merged.size());
+
+        std::vector<std::pair<std::uint64_t, std::size_t> > expected(merged);
+        std::sort(expected.begin(), expected.end());
+        CHECK(expected == merged);
+
+        errc = kaizen_event_merge_finalize(&merge);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(merge_waits_for_every_stream)
+    {
+        static char memory[arena_capacity];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_merge_t merge;
+        errc = kaizen_event_merge_init_from_arena(&merge, &arena, 3, 1);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_t const first[] = { kaizen_test::make_event(kaizen_zone_event_type, 0, 10, 0), kaizen_test::make_event(kaizen_zone_event_type, 1, 30, 0) };
+        kaizen_event_t const second[] = { kaizen_test::make_event(kaizen_zone_event_type, 2, 20, 0) };
+
+        kaizen_event_t event;
+        std::size_t stream_index = 99;
+
+        CHECK_EQUAL(EAGAIN, kaizen_event_merge_pop(&merge, &event, &stream_index));
+        CHECK_EQUAL(0u, stream_index);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_merge_supply(&merge, 0, first, 2));
+        CHECK_EQUAL(EAGAIN, kaizen_event_merge_pop(&merge, &event, &stream_index));
+        CHECK_EQUAL(1u, stream_index);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_merge_supply(&merge, 1, second, 1));
+        CHECK_EQUAL(EAGAIN, kaizen_event_merge_pop(&merge, &event, &stream_index));
+        CHECK_EQUAL(2u, stream_index);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_merge_finish_stream(&merge, 2));
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_merge_pop(&merge, &event, &stream_index));
+        CHECK_EQUAL(0u, event.id);
+        CHECK_EQUAL(0u, stream_index);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_merge_pop(&merge, &event, &stream_index));
+        CHECK_EQUAL(2u, event.id);
+
+        // The event at 30 can not be emitted before stream 1 tells its next event.
+        CHECK_EQUAL(EAGAIN, kaizen_event_merge_pop(&merge, &event, &stream_index));
+        CHECK_EQUAL(1u, stream_index);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_merge_finish_stream(&merge, 1));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_merge_pop(&merge, &event, &stream_index));
+        CHECK_EQUAL(1u, event.id);
+        CHECK_EQUAL(EAGAIN, kaizen_event_merge_pop(&merge, &event, &stream_index));
+        CHECK_EQUAL(0u, stream_index);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_merge_finish_stream(&merge, 0));
+        CHECK_EQUAL(ENOENT, kaizen_event_merge_pop(&merge, &event, &stream_index));
+
+        errc = kaizen_event_merge_finalize(&merge);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(skew_is_corrected_and_ties_keep_stream_order)
+    {
+        static char memory[arena_capacity];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_merge_t merge;
+        errc = kaizen_event_merge_init_from_arena(&merge, &arena, 3, 1);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t skew;
+        errc = kaizen_frame_time_convert_from_ticks(&skew, 5);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_merge_set_stream_skew(&merge, 1, &skew, KAIZEN_TRUE));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_merge_set_stream_skew(&merge, 2, &skew, KAIZEN_FALSE));
+
+        std::vector<std::vector<kaizen_event_t> > streams(3);
+        streams[0].push_back(kaizen_test::make_event(kaizen_zone_event_type, 0, 10, 0));
+        streams[1].push_back(kaizen_test::make_event(kaizen_zone_event_type, 1, 3, 0));
+        streams[1].push_back(kaizen_test::make_event(kaizen_zone_event_type, 1, 15, 0));
+        streams[2].push_back(kaizen_test::make_event(kaizen_zone_event_type, 2, 5, 0));
+
+        std::vector<std::pair<std::uint64_t, std::size_t> > const merged = merge_all(&merge, streams, 1);
+
+        CHECK_EQUAL(4u, merged.size());
+        CHECK_EQUAL(0u, merged[0].first);
+        CHECK_EQUAL(1u, merged[0].second);
+        CHECK_EQUAL(10u, merged[1].first);
+        CHECK_EQUAL(0u, merged[1].second);
+        CHECK_EQUAL(10u, merged[2].first);
+        CHECK_EQUAL(1u, merged[2].second);
+        CHECK_EQUAL(10u, merged[3].first);
+        CHECK_EQUAL(2u, merged[3].second);
+
+        errc = kaizen_event_merge_finalize(&merge);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+    TEST(nested_zones_are_merged_by_end_time)
+    {
+        static char memory[arena_capacity];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::size_t const event_capacity = 8;
+        kaizen_event_t storage[2][event_capacity];
+        kaizen_event_buffer_t buffers[2];
+
+        for (std::size_t s = 0; s < 2; ++s) {
+            errc = kaizen_event_buffer_init(&buffers[s], storage[s], event_capacity);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        kaizen_zone_t outer_a = KAIZEN_ZONE_INITIALIZER("outer_a", 1);
+        kaizen_zone_t inner_a = KAIZEN_ZONE_INITIALIZER("inner_a", 2);
+        kaizen_zone_t outer_b = KAIZEN_ZONE_INITIALIZER("outer_b", 3);
+        kaizen_zone_t inner_b = KAIZEN_ZONE_INITIALIZER("inner_b", 4);
+        kaizen_zone_scope_t outer_a_scope;
+        kaizen_zone_scope_t inner_a_scope;
+        kaizen_zone_scope_t outer_b_scope;
+        kaizen_zone_scope_t inner_b_scope;
+
+        // Interleaves the nested zones of two streams on one thread, each
+        // stream records its inner zone first but with the later start.
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffers[0]);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_begin(&outer_a, &outer_a_scope));
+        wait_for_next_tick();
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffers[1]);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_begin(&outer_b, &outer_b_scope));
+        wait_for_next_tick();
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_begin(&inner_b, &inner_b_scope));
+        wait_for_next_tick();
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_end(&inner_b_scope));
+        wait_for_next_tick();
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffers[0]);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_begin(&inner_a, &inner_a_scope));
+        wait_for_next_tick();
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_end(&inner_a_scope));
+        wait_for_next_tick();
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_end(&outer_a_scope));
+        wait_for_next_tick();
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffers[1]);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_end(&outer_b_scope));
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::vector<std::vector<kaizen_event_t> > streams(2);
+
+        for (std::size_t s = 0; s < 2; ++s) {
+            for (std::size_t i = 0; i < kaizen_event_buffer_count(&buffers[s]); ++i) {
+                streams[s].push_back(*kaizen_event_buffer_at(&buffers[s], i));
+            }
+        }
+
+        CHECK_EQUAL(2u, streams[0].size());
+        CHECK_EQUAL(2u, streams[1].size());
+
+        kaizen_event_merge_t merge;
+        errc = kaizen_event_merge_init_from_arena(&merge, &arena, 2, 1);
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::vector<kaizen_event_t> events;
+        std::vector<std::pair<std::uint64_t, std::size_t> > const merged = merge_all(&merge, streams, 1, &events);
+
+        CHECK_EQUAL(4u, merged.size());
+        CHECK(std::is_sorted(merged.begin(), merged.end()));
+
+        if (4u == events.size()) {
+            CHECK_EQUAL(4u, events[0].id);
+            CHECK_EQUAL(2u, events[1].id);
+            CHECK_EQUAL(1u, events[2].id);
+            CHECK_EQUAL(3u, events[3].id);
+        }
+
+        errc = kaizen_event_merge_finalize(&merge);
+        assert(KAIZEN_SUCCESS == errc);
+
+        for (std::size_t s = 0; s < 2; ++s) {
+            errc = kaizen_event_buffer_finalize(&buffers[s]);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(late_events_within_the_reorder_window_are_emitted_in_order)
+    {
+        static char memory[arena_capacity];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        // Stream 0 records its samples after the zones, each sample is
+        // followed by a stack frame event with the same time.
+        std::vector<std::vector<kaizen_event_t> > streams(2);
+        streams[0].push_back(kaizen_test::make_event(kaizen_zone_event_type, 1, 0, 10));
+        streams[0].push_back(kaizen_test::make_event(kaizen_zone_event_type, 2, 10, 10));
+        streams[0].push_back(kaizen_test::make_event(kaizen_zone_event_type, 3, 0, 30));
+        streams[0].push_back(kaizen_test::make_event(kaizen_sample_event_type, 4, 5, 0));
+        streams[0].push_back(kaizen_test::make_event(kaizen_stack_frame_event_type, 5, 5, 0));
+        streams[0].push_back(kaizen_test::make_event(kaizen_sample_event_type, 6, 25, 0));
+        streams[0].push_back(kaizen_test::make_event(kaizen_stack_frame_event_type, 7, 25, 0));
+        streams[1].push_back(kaizen_test::make_event(kaizen_zone_event_type, 8, 12, 3));
+        streams[1].push_back(kaizen_test::make_event(kaizen_zone_event_type, 9, 26, 1));
+
+        kaizen_event_merge_t merge;
+        errc = kaizen_event_merge_init_from_arena(&merge, &arena, 2, 5);
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::vector<kaizen_event_t> events;
+        std::vector<std::pair<std::uint64_t, std::size_t> > const merged = merge_all(&merge, streams, 2, &events);
+
+        CHECK_EQUAL(9u, merged.size());
+        CHECK(std::is_sorted(merged.begin(), merged.end()));
+
+        std::uint32_t const expected_ids[] = { 4, 5, 1, 8, 2, 6, 7, 9, 3 };
+
+        for (std::size_t i = 0; i < events.size() && i < 9; ++i) {
+            CHECK_EQUAL(expected_ids[i], events[i].id);
+        }
+
+        errc = kaizen_event_merge_finalize(&merge);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_event_merge_test)
@@ -0,0 +1,479 @@
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_block_queue.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_event_encoding.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_raw_stream_server.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(KAIZEN_USE_POSIX_THREADS)
+#   include <arpa/inet.h>
+#   include <netinet/in.h>
+#   include <sys/socket.h>
+#   include <unistd.h>
+#endif
+
+#include <UnitTest++.h>
+
+#include "kaizen_test_events.hpp"
+
+
+
+namespace {
+
+    std::size_t const arena_size = 64 * 1024;
+
+    kaizen_event_t make_event(std::uint64_t time_ticks,
+                              std::uint64_t duration_ticks,
+                              std::uint32_t id)
+    {
+        return kaizen_test::make_event(kaizen_zone_event_type, id, time_ticks, duration_ticks, id * 1000u);
+    }
+
+
+    std::uint64_t ticks_of(kaizen_raw_frame_time_t const& time)
+    {
+        std::uint64_t ticks = 0;
+        int const errc = kaizen_frame_time_convert_to_ticks(&time, &ticks);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        return ticks;
+    }
+
+
+#if defined(KAIZEN_USE_POSIX_THREADS)
+
+    int connect_viewer(kaizen_raw_stream_server_t const& server)
+    {
+        int const viewer = socket(AF_INET, SOCK_STREAM, 0);
+        assert(0 <= viewer);
+
+        sockaddr_in address = sockaddr_in();
+        address.sin_family = AF_INET;
+        address.sin_port = htons(kaizen_stream_server_port(&server));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int const errc = connect(viewer, reinterpret_cast<sockaddr const*>(&address), sizeof(address));
+        assert(0 == errc);
+        (void)errc;
+
+        while (KAIZEN_FALSE == kaizen_stream_server_is_connected(&server)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return viewer;
+    }
+
+
+    // Receives the stream header and the first block.
+    std::vector<std::uint8_t> receive_first_block(int const viewer)
+    {
+        std::vector<std::uint8_t> received;
+        std::size_t block_size = KAIZEN_EVENT_BLOCK_HEADER_SIZE;
+        while (received.size() < KAIZEN_EVENT_STREAM_HEADER_SIZE + block_size) {
+            std::uint8_t chunk[256];
+            ssize_t const size = recv(viewer, chunk, sizeof(chunk), 0);
+            assert(0 < size);
+            received.insert(received.end(), chunk, chunk + size);
+
+            std::uint32_t event_count = 0;
+            std::uint32_t stream_id = 0;
+            (void)kaizen_event_block_peek(&received[0] + KAIZEN_EVENT_STREAM_HEADER_SIZE,
+                                          received.size() - KAIZEN_EVENT_STREAM_HEADER_SIZE,
+                                          &block_size,
+                                          &event_count,
+                                          &stream_id);
+        }
+
+        return received;
+    }
+
+#endif // defined(KAIZEN_USE_POSIX_THREADS)
+
+} // anonymous namespace
+
+
+SUITE(kaizen_event_stream_test)
+{
+    TEST(encoded_block_decodes_to_same_events)
+    {
+        std::vector<kaizen_event_t> events;
+        events.push_back(make_event(1000, 20, 1));
+        events.push_back(make_event(900, 5, 2));
+        events.push_back(make_event(5000000, 100000, 70000));
+
+        std::uint8_t buffer[256];
+        std::size_t encoded_event_count = 0;
+        std::size_t encoded_size = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_encode(7,
+                                                              &events[0],
+                                                              events.size(),
+                                                              buffer,
+                                                              sizeof(buffer),
+                                                              &encoded_event_count,
+                                                              &encoded_size));
+        CHECK_EQUAL(events.size(), encoded_event_count);
+
+        std::size_t block_size = 0;
+        std::uint32_t event_count = 0;
+        std::uint32_t stream_id = 0;
+        CHECK_EQUAL(EAGAIN, kaizen_event_block_peek(buffer, 4, &block_size, &event_count, &stream_id));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_peek(buffer, encoded_size, &block_size, &event_count, &stream_id));
+        CHECK_EQUAL(encoded_size, block_size);
+        CHECK_EQUAL(3u, event_count);
+        CHECK_EQUAL(7u, stream_id);
+
+        kaizen_event_t decoded[3];
+        std::size_t decoded_event_count = 0;
+        CHECK_EQUAL(EAGAIN, kaizen_event_block_decode(buffer, encoded_size - 1, decoded, 3, &decoded_event_count));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_decode(buffer, encoded_size, decoded, 3, &decoded_event_count));
+        CHECK_EQUAL(3u, decoded_event_count);
+
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            CHECK_EQUAL(ticks_of(events[i].time), ticks_of(decoded[i].time));
+            CHECK_EQUAL(ticks_of(events[i].duration), ticks_of(decoded[i].duration));
+            CHECK_EQUAL(events[i].value, decoded[i].value);
+            CHECK_EQUAL(events[i].id, decoded[i].id);
+            CHECK_EQUAL(events[i].type, decoded[i].type);
+        }
+    }
+
+
+
+    TEST(block_encoding_stops_at_capacity)
+    {
+        std::vector<kaizen_event_t> events(100, make_event(1000000, 1000, 3));
+
+        std::uint8_t buffer[KAIZEN_EVENT_BLOCK_HEADER_SIZE + 2 * KAIZEN_EVENT_ENCODED_MAX_SIZE];
+        std::size_t encoded_event_count = 0;
+        std::size_t encoded_size = 0;
+        CHECK_EQUAL(ENOMEM, kaizen_event_block_encode(0, &events[0], events.size(), buffer, KAIZEN_EVENT_BLOCK_HEADER_SIZE, &encoded_event_count, &encoded_size));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_encode(0, &events[0], events.size(), buffer, sizeof(buffer), &encoded_event_count, &encoded_size));
+        CHECK(2u <= encoded_event_count);
+        CHECK(encoded_event_count < events.size());
+        CHECK(encoded_size <= sizeof(buffer));
+    }
+
+
+
+    TEST(compressed_block_decodes_to_same_events)
+    {
+        // Three groups, the last one partial, with extreme and unordered fields.
+        std::vector<kaizen_event_t> events;
+
+        for (std::uint32_t i = 0; i < 150; ++i) {
+            kaizen_event_t event = make_event(1000000 + i * 37 - (i % 3) * 50, (i * 7919) % 5000, i % 11);
+            event.type = static_cast<std::uint16_t>(kaizen_zone_event_type + (i % 2));
+            event.flags = static_cast<std::uint16_t>(i % 5);
+            events.push_back(event);
+        }
+
+        events[3].value = ~std::uint64_t(0);
+        events[70].id = 0xffffffffu;
+        events[71] = make_event(0, 0, 0);
+        events[140].flags = 0xffff;
+
+        std::vector<std::uint8_t> buffer(events.size() * sizeof(kaizen_event_t));
+        std::size_t encoded_event_count = 0;
+        std::size_t encoded_size = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_encode_compressed(5,
+                                                                         &events[0],
+                                                                         events.size(),
+                                                                         &buffer[0],
+                                                                         buffer.size(),
+                                                                         &encoded_event_count,
+                                                                         &encoded_size));
+        CHECK_EQUAL(events.size(), encoded_event_count);
+
+        std::size_t block_size = 0;
+        std::uint32_t event_count = 0;
+        std::uint32_t stream_id = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_peek(&buffer[0], encoded_size, &block_size, &event_count, &stream_id));
+        CHECK_EQUAL(encoded_size, block_size);
+        CHECK_EQUAL(150u, event_count);
+        CHECK_EQUAL(5u, stream_id);
+
+        std::vector<kaizen_event_t> decoded(events.size());
+        std::size_t decoded_event_count = 0;
+        CHECK_EQUAL(EAGAIN, kaizen_event_block_decode(&buffer[0], encoded_size - 1, &decoded[0], decoded.size(), &decoded_event_count));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_decode(&buffer[0], encoded_size, &decoded[0], decoded.size(), &decoded_event_count));
+        CHECK_EQUAL(events.size(), decoded_event_count);
+
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            CHECK_EQUAL(ticks_of(events[i].time), ticks_of(decoded[i].time));
+            CHECK_EQUAL(ticks_of(events[i].duration), ticks_of(decoded[i].duration));
+            CHECK_EQUAL(events[i].value, decoded[i].value);
+            CHECK_EQUAL(events[i].id, decoded[i].id);
+            CHECK_EQUAL(events[i].type, decoded[i].type);
+            CHECK_EQUAL(events[i].flags, decoded[i].flags);
+        }
+
+        // A corrupted bit width is rejected instead of read past the block.
+        buffer[KAIZEN_EVENT_BLOCK_HEADER_SIZE + 4] = 65;
+        CHECK_EQUAL(EINVAL, kaizen_event_block_decode(&buffer[0], encoded_size, &decoded[0], decoded.size(), &decoded_event_count));
+    }
+
+
+
+    TEST(compressed_zone_events_are_five_times_smaller)
+    {
+        // Zones of a frame: nested, close in time, small ids and durations.
+        std::vector<kaizen_event_t> events;
+        std::uint64_t time = 1000000000;
+        std::uint32_t random = 12345;
+
+        for (std::size_t i = 0; i < 4096; ++i) {
+            random = random * 1103515245u + 12345u;
+            time += 50 + (random >> 16) % 400;
+            events.push_back(make_event(time, 100 + (random >> 8) % 20000, 1 + (random >> 4) % 40));
+            events.back().value = 1;
+        }
+
+        std::vector<std::uint8_t> buffer(events.size() * sizeof(kaizen_event_t));
+        std::size_t total_size = 0;
+
+        // Blocks of 64 events like the drain gets them from event channels.
+        for (std::size_t i = 0; i < events.size(); i += 64) {
+            std::size_t encoded_event_count = 0;
+            std::size_t encoded_size = 0;
+            CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_encode_compressed(0,
+                                                                             &events[i],
+                                                                             64,
+                                                                             &buffer[total_size],
+                                                                             buffer.size() - total_size,
+                                                                             &encoded_event_count,
+                                                                             &encoded_size));
+            CHECK_EQUAL(64u, encoded_event_count);
+            total_size += encoded_size;
+        }
+
+        CHECK(5 * total_size <= events.size() * sizeof(kaizen_event_t));
+    }
+
+
+
+    TEST(compressed_block_encoding_stops_at_capacity)
+    {
+        std::vector<kaizen_event_t> events;
+
+        for (std::uint32_t i = 0; i < 1000; ++i) {
+            events.push_back(make_event(1000000 + i * 1000, i, i));
+        }
+
+        std::uint8_t buffer[512];
+        std::size_t encoded_event_count = 0;
+        std::size_t encoded_size = 0;
+        CHECK_EQUAL(ENOMEM, kaizen_event_block_encode_compressed(0, &events[0], events.size(), buffer, KAIZEN_EVENT_BLOCK_HEADER_SIZE, &encoded_event_count, &encoded_size));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_encode_compressed(0, &events[0], events.size(), buffer, sizeof(buffer), &encoded_event_count, &encoded_size));
+        CHECK(KAIZEN_EVENT_COMPRESSED_GROUP_SIZE <= encoded_event_count);
+        CHECK(encoded_event_count < events.size());
+        CHECK(encoded_size <= sizeof(buffer));
+
+        std::vector<kaizen_event_t> decoded(encoded_event_count);
+        std::size_t decoded_event_count = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_decode(buffer, encoded_size, &decoded[0], decoded.size(), &decoded_event_count));
+        CHECK_EQUAL(encoded_event_count, decoded_event_count);
+        CHECK_EQUAL(ticks_of(events[encoded_event_count - 1].time), ticks_of(decoded[encoded_event_count - 1].time));
+    }
+
+
+
+    TEST(stream_header_roundtrip)
+    {
+        std::uint8_t buffer[KAIZEN_EVENT_STREAM_HEADER_SIZE];
+        CHECK_EQUAL(ENOMEM, kaizen_event_stream_header_encode(1000, buffer, sizeof(buffer) - 1));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_stream_header_encode(1000, buffer, sizeof(buffer)));
+
+        std::uint64_t ticks_per_second = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_stream_header_decode(buffer, sizeof(buffer), &ticks_per_second));
+        CHECK_EQUAL(1000u, ticks_per_second);
+
+        buffer[0] = 'X';
+        CHECK_EQUAL(EINVAL, kaizen_event_stream_header_decode(buffer, sizeof(buffer), &ticks_per_second));
+    }
+
+
+
+    TEST(full_block_queue_rejects_push)
+    {
+        static char memory[arena_size];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, arena_size);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_block_queue_t queue;
+        errc = kaizen_block_queue_init_from_arena(&queue, &arena, 2, 64);
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::uint8_t* block = NULL;
+        std::uint32_t first_ticket = 0;
+        std::uint32_t second_ticket = 0;
+        std::uint32_t third_ticket = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_block_queue_try_push_begin(&queue, &block, &first_ticket));
+        block[0] = 1;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_block_queue_try_push_begin(&queue, &block, &second_ticket));
+        block[0] = 2;
+        CHECK_EQUAL(EAGAIN, kaizen_block_queue_try_push_begin(&queue, &block, &third_ticket));
+
+        std::uint8_t const* popped = NULL;
+        std::size_t size = 0;
+        CHECK_EQUAL(EAGAIN, kaizen_block_queue_try_pop_begin(&queue, &popped, &size));
+
+        // Publishing out of order keeps the queue order.
+        kaizen_block_queue_push_end(&queue, second_ticket, 2);
+        CHECK_EQUAL(EAGAIN, kaizen_block_queue_try_pop_begin(&queue, &popped, &size));
+        kaizen_block_queue_push_end(&queue, first_ticket, 1);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_block_queue_try_pop_begin(&queue, &popped, &size));
+        CHECK_EQUAL(1, popped[0]);
+        CHECK_EQUAL(1u, size);
+        kaizen_block_queue_pop_end(&queue);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_block_queue_try_push_begin(&queue, &block, &third_ticket));
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_block_queue_try_pop_begin(&queue, &popped, &size));
+        CHECK_EQUAL(2, popped[0]);
+        CHECK_EQUAL(2u, size);
+        kaizen_block_queue_pop_end(&queue);
+
+        errc = kaizen_block_queue_finalize(&queue);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(submit_without_viewer_discards_events)
+    {
+        static char memory[arena_size];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, arena_size);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_stream_server_t server;
+        errc = kaizen_stream_server_init_tcp(&server, &arena, 0, 4, 1024);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK(0 != kaizen_stream_server_port(&server));
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_stream_server_is_connected(&server));
+
+        kaizen_event_t const event = make_event(10, 1, 1);
+        CHECK_EQUAL(ESRCH, kaizen_stream_server_submit(&server, 0, &event, 1));
+        CHECK_EQUAL(0u, kaizen_stream_server_dropped_event_count(&server));
+
+        errc = kaizen_stream_server_finalize(&server);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+#if defined(KAIZEN_USE_POSIX_THREADS)
+
+    TEST(tcp_viewer_receives_header_and_submitted_events)
+    {
+        static char memory[arena_size];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, arena_size);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_stream_server_t server;
+        errc = kaizen_stream_server_init_tcp(&server, &arena, 0, 4, 1024);
+        assert(KAIZEN_SUCCESS == errc);
+
+        int const viewer = connect_viewer(server);
+
+        kaizen_event_t const events[2] = {make_event(100, 10, 1), make_event(200, 20, 2)};
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_stream_server_submit(&server, 5, events, 2));
+
+        std::vector<std::uint8_t> const received = receive_first_block(viewer);
+
+        std::uint64_t ticks_per_second = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_stream_header_decode(&received[0], received.size(), &ticks_per_second));
+        std::uint64_t expected_ticks_per_second = 0;
+        errc = kaizen_frame_time_query_ticks_per_second(&expected_ticks_per_second);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(expected_ticks_per_second, ticks_per_second);
+
+        kaizen_event_t decoded[2];
+        std::size_t decoded_event_count = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_decode(&received[0] + KAIZEN_EVENT_STREAM_HEADER_SIZE,
+                                                              received.size() - KAIZEN_EVENT_STREAM_HEADER_SIZE,
+                                                              decoded,
+                                                              2,
+                                                              &decoded_event_count));
+        CHECK_EQUAL(2u, decoded_event_count);
+        CHECK_EQUAL(200u, ticks_of(decoded[1].time));
+        CHECK_EQUAL(2u, decoded[1].id);
+
+        close(viewer);
+
+        errc = kaizen_stream_server_finalize(&server);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(compressed_server_sends_compressed_blocks)
+    {
+        static char memory[arena_size];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, arena_size);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_stream_server_t server;
+        errc = kaizen_stream_server_init_tcp(&server, &arena, 0, 4, 1024);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_stream_server_set_compressed(&server, KAIZEN_TRUE));
+
+        int const viewer = connect_viewer(server);
+
+        std::vector<kaizen_event_t> events;
+        for (std::uint32_t i = 0; i < 40; ++i) {
+            events.push_back(make_event(100 + 10 * i, 5, 3));
+        }
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_stream_server_submit(&server, 5, &events[0], events.size()));
+
+        std::vector<std::uint8_t> const received = receive_first_block(viewer);
+        std::uint8_t const* const block = &received[0] + KAIZEN_EVENT_STREAM_HEADER_SIZE;
+        std::size_t const size = received.size() - KAIZEN_EVENT_STREAM_HEADER_SIZE;
+        CHECK_EQUAL('C', static_cast<char>(block[2]));
+
+        // Columns of equal durations, values and ids need no bits.
+        std::size_t block_size = 0;
+        std::uint32_t event_count = 0;
+        std::uint32_t stream_id = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_peek(block, size, &block_size, &event_count, &stream_id));
+        CHECK_EQUAL(40u, event_count);
+        CHECK(block_size < KAIZEN_EVENT_BLOCK_HEADER_SIZE + 4 * events.size());
+
+        kaizen_event_t decoded[40];
+        std::size_t decoded_event_count = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_event_block_decode(block, size, decoded, 40, &decoded_event_count));
+        CHECK_EQUAL(40u, decoded_event_count);
+        CHECK_EQUAL(490u, ticks_of(decoded[39].time));
+        CHECK_EQUAL(3u, decoded[39].id);
+
+        close(viewer);
+
+        errc = kaizen_stream_server_finalize(&server);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+#endif // defined(KAIZEN_USE_POSIX_THREADS)
+
+} // SUITE(kaizen_event_stream_test)
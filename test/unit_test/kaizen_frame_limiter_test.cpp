@@ -0,0 +1,103 @@
+#include <kaizen/kaizen_frame_limiter.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cstdint>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    std::uint64_t ticks(kaizen_raw_frame_time_t const& time)
+    {
+        std::uint64_t result = 0;
+        int const errc = kaizen_frame_time_convert_to_ticks(&time, &result);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        return result;
+    }
+
+
+    kaizen_raw_frame_time_t from_now(std::uint64_t tick_count)
+    {
+        kaizen_raw_frame_time_t now = KAIZEN_RAW_FRAME_TIME_ZERO;
+        int errc = kaizen_frame_time_query(&now);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t offset = KAIZEN_RAW_FRAME_TIME_ZERO;
+        errc = kaizen_frame_time_convert_from_ticks(&offset, tick_count);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t result = KAIZEN_RAW_FRAME_TIME_ZERO;
+        errc = kaizen_frame_time_aggregate(&now, &offset, &result);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        return result;
+    }
+
+} // anonymous namespace
+
+
+
+SUITE(kaizen_frame_limiter_test)
+{
+    TEST(waits_until_deadline)
+    {
+        std::uint64_t ticks_per_second = 0;
+        int errc = kaizen_frame_time_query_ticks_per_second(&ticks_per_second);
+        assert(KAIZEN_SUCCESS == errc);
+        std::uint64_t const millisecond = ticks_per_second / 1000u;
+
+        kaizen_frame_limiter_t limiter;
+        errc = kaizen_frame_limiter_init(&limiter);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t margin = KAIZEN_RAW_FRAME_TIME_ZERO;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_limiter_margin(&limiter, &margin));
+        CHECK(ticks(margin) + 1u >= 2u * millisecond);
+
+        for (int i = 0; i < 20; ++i) {
+            kaizen_raw_frame_time_t const deadline = from_now(5u * millisecond);
+            CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_wait_until(&limiter, &deadline));
+
+            kaizen_raw_frame_time_t now = KAIZEN_RAW_FRAME_TIME_ZERO;
+            errc = kaizen_frame_time_query(&now);
+            assert(KAIZEN_SUCCESS == errc);
+            CHECK_EQUAL(KAIZEN_TRUE, kaizen_frame_time_greater_or_equal(&now, &deadline));
+        }
+
+        // The margin adapted to the oversleep of this machine but never
+        // drops below the minimum.
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_limiter_margin(&limiter, &margin));
+        CHECK(ticks(margin) > 0u);
+        CHECK(kaizen_frame_limiter_overslept_count(&limiter) <= 20u);
+
+        errc = kaizen_frame_limiter_finalize(&limiter);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(passed_deadline_returns_at_once)
+    {
+        kaizen_frame_limiter_t limiter;
+        int errc = kaizen_frame_limiter_init(&limiter);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t deadline = KAIZEN_RAW_FRAME_TIME_ZERO;
+        errc = kaizen_frame_time_query(&deadline);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_wait_until(&limiter, &deadline));
+        CHECK_EQUAL(0u, kaizen_frame_limiter_overslept_count(&limiter));
+
+        errc = kaizen_frame_limiter_finalize(&limiter);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_frame_limiter_test)
@@ -0,0 +1,181 @@
+#include <kaizen/kaizen_frame_stop_watch.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cstdint>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    std::uint64_t ticks(kaizen_raw_frame_time_t const& time)
+    {
+        std::uint64_t result = 0;
+        int const errc = kaizen_frame_time_convert_to_ticks(&time, &result);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        return result;
+    }
+
+
+    // Spins until at least the given number of ticks passed.
+    void spin(std::uint64_t tick_count)
+    {
+        kaizen_raw_frame_time_t start = KAIZEN_RAW_FRAME_TIME_ZERO;
+        int errc = kaizen_frame_time_query(&start);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t now = start;
+        kaizen_raw_frame_time_t passed = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+        do {
+            errc = kaizen_frame_time_query(&now);
+            assert(KAIZEN_SUCCESS == errc);
+            errc = kaizen_frame_time_subtract(&now, &start, &passed);
+            assert(KAIZEN_SUCCESS == errc);
+        } while (ticks(passed) < tick_count);
+    }
+
+
+    std::uint64_t now_ticks()
+    {
+        kaizen_raw_frame_time_t now = KAIZEN_RAW_FRAME_TIME_ZERO;
+        int const errc = kaizen_frame_time_query(&now);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        return ticks(now);
+    }
+
+
+    std::uint64_t ticks_per_millisecond()
+    {
+        std::uint64_t ticks_per_second = 0;
+        int const errc = kaizen_frame_time_query_ticks_per_second(&ticks_per_second);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        return ticks_per_second / 1000u;
+    }
+
+} // anonymous namespace
+
+
+
+SUITE(kaizen_frame_stop_watch_test)
+{
+    TEST(paused_time_is_not_measured)
+    {
+        std::uint64_t const millisecond = ticks_per_millisecond();
+
+        kaizen_frame_stop_watch_t watch;
+        int errc = kaizen_frame_stop_watch_init(&watch);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(kaizen_stopped_frame_stop_watch_state, kaizen_frame_stop_watch_state(&watch));
+
+        std::uint64_t const before_start = now_ticks();
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_start(&watch));
+        CHECK_EQUAL(kaizen_running_frame_stop_watch_state, kaizen_frame_stop_watch_state(&watch));
+        spin(millisecond);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_pause(&watch));
+        CHECK_EQUAL(kaizen_paused_frame_stop_watch_state, kaizen_frame_stop_watch_state(&watch));
+
+        kaizen_raw_frame_time_t paused_elapsed = KAIZEN_RAW_FRAME_TIME_ZERO;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_query_elapsed(&watch, &paused_elapsed));
+        CHECK(ticks(paused_elapsed) >= millisecond);
+
+        std::uint64_t const paused = now_ticks();
+        spin(2u * millisecond);
+
+        kaizen_raw_frame_time_t elapsed = KAIZEN_RAW_FRAME_TIME_ZERO;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_query_elapsed(&watch, &elapsed));
+        CHECK_EQUAL(ticks(paused_elapsed), ticks(elapsed));
+
+        std::uint64_t const before_resume = now_ticks();
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_resume(&watch));
+        spin(millisecond);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_stop(&watch));
+        std::uint64_t const after_stop = now_ticks();
+        CHECK_EQUAL(kaizen_stopped_frame_stop_watch_state, kaizen_frame_stop_watch_state(&watch));
+
+        // Whatever the scheduler does, the span known to be paused is excluded.
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_query_elapsed(&watch, &elapsed));
+        CHECK(ticks(elapsed) >= 2u * millisecond);
+        CHECK(ticks(elapsed) + (before_resume - paused) <= after_stop - before_start);
+
+        // Starting again resets the elapsed time.
+        std::uint64_t const before_restart = now_ticks();
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_start(&watch));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_stop(&watch));
+        std::uint64_t const after_restart = now_ticks();
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_query_elapsed(&watch, &elapsed));
+        CHECK(ticks(elapsed) <= after_restart - before_restart);
+
+        errc = kaizen_frame_stop_watch_finalize(&watch);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(laps)
+    {
+        std::uint64_t const millisecond = ticks_per_millisecond();
+
+        kaizen_frame_stop_watch_t watch;
+        int errc = kaizen_frame_stop_watch_init(&watch);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_frame_lap_statistics_t statistics;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_query_lap_statistics(&watch, &statistics));
+        CHECK_EQUAL(0u, statistics.lap_count);
+        CHECK_EQUAL(0u, ticks(statistics.mean_lap));
+
+        errc = kaizen_frame_stop_watch_start(&watch);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t short_lap = KAIZEN_RAW_FRAME_TIME_ZERO;
+        kaizen_raw_frame_time_t long_lap = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+        spin(millisecond);
+        std::uint64_t const before_short_lap = now_ticks();
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_lap(&watch, &short_lap));
+
+        spin(2u * millisecond);
+        errc = kaizen_frame_stop_watch_pause(&watch);
+        assert(KAIZEN_SUCCESS == errc);
+        std::uint64_t const paused = now_ticks();
+        spin(2u * millisecond);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_lap(&watch, &long_lap));
+
+        errc = kaizen_frame_stop_watch_stop(&watch);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK(ticks(short_lap) >= millisecond);
+        CHECK(ticks(long_lap) >= 2u * millisecond);
+        // The second lap began with the first one and excludes the pause.
+        CHECK(ticks(long_lap) <= paused - before_short_lap);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_query_lap_statistics(&watch, &statistics));
+        CHECK_EQUAL(2u, statistics.lap_count);
+        CHECK_EQUAL(ticks(long_lap), ticks(statistics.last_lap));
+        // Preemption can make the first lap the longer one.
+        std::uint64_t const longest = (ticks(short_lap) > ticks(long_lap)) ? ticks(short_lap) : ticks(long_lap);
+        std::uint64_t const shortest = (ticks(short_lap) > ticks(long_lap)) ? ticks(long_lap) : ticks(short_lap);
+        CHECK_EQUAL(longest, ticks(statistics.longest_lap));
+        CHECK_EQUAL(shortest, ticks(statistics.shortest_lap));
+        CHECK_EQUAL((ticks(short_lap) + ticks(long_lap)) / 2u, ticks(statistics.mean_lap));
+
+        kaizen_raw_frame_time_t elapsed = KAIZEN_RAW_FRAME_TIME_ZERO;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_stop_watch_query_elapsed(&watch, &elapsed));
+        CHECK_EQUAL(ticks(short_lap) + ticks(long_lap), ticks(elapsed));
+
+        errc = kaizen_frame_stop_watch_finalize(&watch);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_frame_stop_watch_test)
@@ -0,0 +1,124 @@
+#include <kaizen/kaizen_frame_time_accumulator.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+
+#include <UnitTest++.h>
+
+
+
+SUITE(kaizen_frame_time_accumulator_test)
+{
+    TEST(sum_carries_beyond_64_bits)
+    {
+        kaizen_frame_time_accumulator_t accumulator;
+        int errc = kaizen_frame_time_accumulator_init(&accumulator);
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::uint64_t const half = static_cast<std::uint64_t>(1) << 63;
+
+        for (int i = 0; i < 5; ++i) {
+            kaizen_frame_time_accumulator_add_ticks(&accumulator, half);
+        }
+
+        std::uint64_t high = 0;
+        std::uint64_t low = 0;
+        kaizen_frame_time_accumulator_ticks(&accumulator, &high, &low);
+        CHECK_EQUAL(2u, high);
+        CHECK_EQUAL(half, low);
+
+        kaizen_frame_time_accumulator_t other;
+        errc = kaizen_frame_time_accumulator_init(&other);
+        assert(KAIZEN_SUCCESS == errc);
+        kaizen_frame_time_accumulator_add_ticks(&other, half);
+        kaizen_frame_time_accumulator_add_ticks(&other, half);
+        kaizen_frame_time_accumulator_add_ticks(&other, half + 7);
+
+        kaizen_frame_time_accumulator_merge(&accumulator, &other);
+        kaizen_frame_time_accumulator_ticks(&accumulator, &high, &low);
+        CHECK_EQUAL(4u, high);
+        CHECK_EQUAL(7u, low);
+
+        errc = kaizen_frame_time_accumulator_finalize(&other);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_frame_time_accumulator_finalize(&accumulator);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(sum_converts_exactly)
+    {
+        kaizen_frame_time_accumulator_t accumulator;
+        int errc = kaizen_frame_time_accumulator_init(&accumulator);
+        assert(KAIZEN_SUCCESS == errc);
+
+        // 2^66 + 2^19 ticks of a 2^20 Hz counter are 2^46 seconds and a half.
+        std::uint64_t const ticks_per_second = static_cast<std::uint64_t>(1) << 20;
+
+        for (int i = 0; i < 8; ++i) {
+            kaizen_frame_time_accumulator_add_ticks(&accumulator, static_cast<std::uint64_t>(1) << 63);
+        }
+        kaizen_frame_time_accumulator_add_ticks(&accumulator, ticks_per_second / 2);
+
+        std::uint64_t seconds = 0;
+        std::uint32_t nanoseconds = 0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_accumulator_convert_to_seconds(&accumulator, ticks_per_second, &seconds, &nanoseconds));
+        CHECK_EQUAL(static_cast<std::uint64_t>(1) << 46, seconds);
+        CHECK_EQUAL(500000000u, nanoseconds);
+
+        CHECK_EQUAL(EINVAL, kaizen_frame_time_accumulator_convert_to_seconds(&accumulator, 0, &seconds, &nanoseconds));
+        CHECK_EQUAL(ERANGE, kaizen_frame_time_accumulator_convert_to_seconds(&accumulator, 1, &seconds, &nanoseconds));
+
+        // A day of 24 MHz ticks summed from one billion durations.
+        errc = kaizen_frame_time_accumulator_init(&accumulator);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t duration;
+        errc = kaizen_frame_time_convert_from_ticks(&duration, 24000000ull * 86400ull / 1000ull);
+        assert(KAIZEN_SUCCESS == errc);
+
+        for (int i = 0; i < 1000; ++i) {
+            CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_accumulator_add(&accumulator, &duration));
+        }
+
+        kaizen_frame_time_accumulator_t day;
+        errc = kaizen_frame_time_accumulator_init(&day);
+        assert(KAIZEN_SUCCESS == errc);
+
+        for (int i = 0; i < 1000000; ++i) {
+            kaizen_frame_time_accumulator_merge(&day, &accumulator);
+        }
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_accumulator_convert_to_seconds(&day, 24000000, &seconds, &nanoseconds));
+        CHECK_EQUAL(86400000000ull, seconds);
+        CHECK_EQUAL(0u, nanoseconds);
+
+        errc = kaizen_frame_time_accumulator_finalize(&day);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_frame_time_accumulator_finalize(&accumulator);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(aggregate_reports_overflow)
+    {
+        kaizen_raw_frame_time_t sum;
+        int errc = kaizen_frame_time_convert_from_ticks(&sum, static_cast<std::uint64_t>(1) << 62);
+        assert(KAIZEN_SUCCESS == errc);
+
+        // Signed tick counters overflow on the first doubling, unsigned ones
+        // on the second.
+        for (int i = 0; (KAIZEN_SUCCESS == errc) && (i < 2); ++i) {
+            kaizen_raw_frame_time_t const previous = sum;
+            errc = kaizen_frame_time_aggregate(&previous, &previous, &sum);
+        }
+
+        CHECK_EQUAL(ERANGE, errc);
+    }
+
+} // SUITE(kaizen_frame_time_accumulator_test)
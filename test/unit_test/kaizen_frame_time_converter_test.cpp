@@ -0,0 +1,161 @@
+#include <kaizen/kaizen_frame_time_converter.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <UnitTest++.h>
+
+
+
+SUITE(kaizen_frame_time_converter_test)
+{
+    TEST(ticks_convert_with_given_frequency)
+    {
+        kaizen_frame_time_converter_t converter;
+        CHECK_EQUAL(EINVAL, kaizen_frame_time_converter_init_with_ticks_per_second(&converter, 0));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_converter_init_with_ticks_per_second(&converter, 4000));
+        CHECK_EQUAL(4000u, kaizen_frame_time_converter_ticks_per_second(&converter));
+
+        CHECK_CLOSE(1.5, kaizen_frame_time_converter_ticks_to_seconds(&converter, 6000), 1.0e-12);
+        CHECK_CLOSE(1500.0, kaizen_frame_time_converter_ticks_to_milliseconds(&converter, 6000), 1.0e-9);
+        CHECK_CLOSE(250.0, kaizen_frame_time_converter_ticks_to_microseconds(&converter, 1), 1.0e-9);
+        CHECK_CLOSE(250000.0, kaizen_frame_time_converter_ticks_to_nanoseconds(&converter, 1), 1.0e-6);
+
+        int const errc = kaizen_frame_time_converter_finalize(&converter);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+    }
+
+
+
+    TEST(frame_times_convert_like_uncached_conversion)
+    {
+        kaizen_frame_time_converter_t converter;
+        int errc = kaizen_frame_time_converter_init(&converter);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t time;
+        errc = kaizen_frame_time_convert_from_ticks(&time, 123456789);
+        assert(KAIZEN_SUCCESS == errc);
+
+        double expected = 0.0;
+        double converted = 0.0;
+        errc = kaizen_frame_time_convert_to_microseconds(&time, &expected);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_converter_convert_to_microseconds(&converter, &time, &converted));
+        CHECK_CLOSE(expected, converted, expected * 1.0e-12);
+
+        errc = kaizen_frame_time_convert_to_seconds(&time, &expected);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_converter_convert_to_seconds(&converter, &time, &converted));
+        CHECK_CLOSE(expected, converted, expected * 1.0e-12);
+
+        errc = kaizen_frame_time_converter_finalize(&converter);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(fixed_point_conversion_matches_exact_conversion)
+    {
+        std::uint64_t const frequencies[] = { 1000, 3579545, 24000000, 1000000000, 3000000000ull };
+        std::uint64_t const values[] = { 0, 1, 999, 16666667, 1000000000, 86400000000000ull, 0xFFFFFFFFFFFFull };
+
+        for (std::size_t i = 0; i < sizeof(frequencies) / sizeof(frequencies[0]); ++i) {
+            kaizen_frame_time_converter_t converter;
+            int const errc = kaizen_frame_time_converter_init_with_ticks_per_second(&converter, frequencies[i]);
+            assert(KAIZEN_SUCCESS == errc);
+            (void)errc;
+
+            for (std::size_t j = 0; j < sizeof(values) / sizeof(values[0]); ++j) {
+                long double const ticks = static_cast<long double>(values[j]) * frequencies[i] / 1.0e9L;
+                long double const nanoseconds = static_cast<long double>(values[j]) * 1.0e9L / frequencies[i];
+
+                CHECK_CLOSE(static_cast<double>(ticks),
+                            static_cast<double>(kaizen_frame_time_converter_nanoseconds_to_ticks(&converter, values[j])),
+                            1.0 + static_cast<double>(ticks) * 1.0e-15);
+
+                if (nanoseconds < 1.8e19L) {
+                    CHECK_CLOSE(static_cast<double>(nanoseconds),
+                                static_cast<double>(kaizen_frame_time_converter_ticks_to_nanoseconds_uint64(&converter, values[j])),
+                                1.0 + static_cast<double>(nanoseconds) * 1.0e-15);
+                }
+            }
+        }
+    }
+
+
+
+    TEST(out_of_range_conversions_saturate_or_are_reported)
+    {
+        std::uint64_t const max_value = 0xFFFFFFFFFFFFFFFFull;
+
+        kaizen_frame_time_converter_t slow_converter;
+        int errc = kaizen_frame_time_converter_init_with_ticks_per_second(&slow_converter, 1000);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(max_value, kaizen_frame_time_converter_ticks_to_nanoseconds_uint64(&slow_converter, max_value / 1000000u + 1u));
+
+        kaizen_frame_time_converter_t fast_converter;
+        errc = kaizen_frame_time_converter_init_with_ticks_per_second(&fast_converter, 3000000000ull);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(max_value, kaizen_frame_time_converter_nanoseconds_to_ticks(&fast_converter, max_value / 3u + 1u));
+
+        kaizen_raw_frame_time_t time;
+        CHECK_EQUAL(ERANGE, kaizen_frame_time_converter_convert_from_nanoseconds(&fast_converter, max_value / 3u + 1u, &time));
+        CHECK_EQUAL(ERANGE, kaizen_frame_time_converter_convert_from_microseconds(&fast_converter, max_value / 1000u + 1u, &time));
+        CHECK_EQUAL(ERANGE, kaizen_frame_time_converter_convert_from_milliseconds(&fast_converter, max_value / 1000000u + 1u, &time));
+        CHECK_EQUAL(ERANGE, kaizen_frame_time_converter_convert_from_seconds(&fast_converter, max_value / 1000000000u + 1u, &time));
+
+        errc = kaizen_frame_time_converter_finalize(&fast_converter);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_frame_time_converter_finalize(&slow_converter);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+    }
+
+
+
+    TEST(frame_times_convert_from_time_spans)
+    {
+        kaizen_frame_time_converter_t converter;
+        int errc = kaizen_frame_time_converter_init(&converter);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t budget;
+        kaizen_raw_frame_time_t expected;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_converter_convert_from_microseconds(&converter, 16667, &budget));
+        errc = kaizen_frame_time_convert_from_microseconds(&expected, 16667.0);
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::uint64_t budget_ticks = 0;
+        std::uint64_t expected_ticks = 0;
+        errc = kaizen_frame_time_convert_to_ticks(&budget, &budget_ticks);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_frame_time_convert_to_ticks(&expected, &expected_ticks);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK(budget_ticks + 1 >= expected_ticks && budget_ticks <= expected_ticks + 1);
+
+        double milliseconds = 0.0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_converter_convert_from_milliseconds(&converter, 250, &budget));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_convert_to_milliseconds(&budget, &milliseconds));
+        CHECK_CLOSE(250.0, milliseconds, 1.0e-3);
+
+        double seconds = 0.0;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_converter_convert_from_seconds(&converter, 3, &budget));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_convert_to_seconds(&budget, &seconds));
+        CHECK_CLOSE(3.0, seconds, 1.0e-6);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_convert_from_seconds(&expected, 0.5));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_time_convert_to_seconds(&expected, &seconds));
+        CHECK_CLOSE(0.5, seconds, 1.0e-6);
+        CHECK_EQUAL(EINVAL, kaizen_frame_time_convert_from_nanoseconds(&expected, -1.0));
+
+        errc = kaizen_frame_time_converter_finalize(&converter);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_frame_time_converter_test)
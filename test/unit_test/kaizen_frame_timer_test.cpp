@@ -0,0 +1,114 @@
+#include <kaizen/kaizen_frame_timer.h>
+#include <kaizen/kaizen_frame_time_accumulator.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    std::uint64_t ticks(kaizen_raw_frame_time_t const& time)
+    {
+        std::uint64_t result = 0;
+        int const errc = kaizen_frame_time_convert_to_ticks(&time, &result);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        return result;
+    }
+
+
+    // Spins until at least the given number of ticks passed.
+    void spin(std::uint64_t tick_count)
+    {
+        kaizen_raw_frame_time_t start = KAIZEN_RAW_FRAME_TIME_ZERO;
+        int errc = kaizen_frame_time_query(&start);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t now = start;
+        kaizen_raw_frame_time_t passed = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+        do {
+            errc = kaizen_frame_time_query(&now);
+            assert(KAIZEN_SUCCESS == errc);
+            errc = kaizen_frame_time_subtract(&now, &start, &passed);
+            assert(KAIZEN_SUCCESS == errc);
+        } while (ticks(passed) < tick_count);
+    }
+
+} // anonymous namespace
+
+
+
+SUITE(kaizen_frame_timer_test)
+{
+    TEST(frame_deltas)
+    {
+        std::uint64_t ticks_per_second = 0;
+        int errc = kaizen_frame_time_query_ticks_per_second(&ticks_per_second);
+        assert(KAIZEN_SUCCESS == errc);
+        std::uint64_t const millisecond = ticks_per_second / 1000u;
+
+        kaizen_frame_timer_t timer;
+        errc = kaizen_frame_timer_init(&timer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t delta = KAIZEN_RAW_FRAME_TIME_ZERO;
+        CHECK_EQUAL(0u, kaizen_frame_timer_frame_count(&timer));
+        CHECK_EQUAL(EINVAL, kaizen_frame_timer_mean_delta(&timer, &delta));
+
+        spin(millisecond);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_timer_advance(&timer, &delta));
+        std::uint64_t const first = ticks(delta);
+        CHECK(first >= millisecond);
+
+        spin(3u * millisecond);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_timer_advance(&timer, &delta));
+        std::uint64_t const second = ticks(delta);
+        CHECK(second >= 3u * millisecond);
+
+        // Time between a restart and the previous frame is not counted.
+        spin(2u * millisecond);
+        kaizen_raw_frame_time_t before_restart = KAIZEN_RAW_FRAME_TIME_ZERO;
+        errc = kaizen_frame_time_query(&before_restart);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_timer_restart(&timer));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_timer_advance(&timer, &delta));
+        kaizen_raw_frame_time_t after_advance = KAIZEN_RAW_FRAME_TIME_ZERO;
+        errc = kaizen_frame_time_query(&after_advance);
+        assert(KAIZEN_SUCCESS == errc);
+        std::uint64_t const third = ticks(delta);
+        CHECK(third <= ticks(after_advance) - ticks(before_restart));
+
+        CHECK_EQUAL(3u, kaizen_frame_timer_frame_count(&timer));
+
+        kaizen_frame_timer_last_delta(&timer, &delta);
+        CHECK_EQUAL(third, ticks(delta));
+        kaizen_frame_timer_shortest_delta(&timer, &delta);
+        CHECK_EQUAL(std::min(first, std::min(second, third)), ticks(delta));
+        kaizen_frame_timer_longest_delta(&timer, &delta);
+        CHECK_EQUAL(std::max(first, std::max(second, third)), ticks(delta));
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_frame_timer_mean_delta(&timer, &delta));
+        CHECK_EQUAL((first + second + third) / 3u, ticks(delta));
+
+        kaizen_frame_time_accumulator_t elapsed;
+        kaizen_frame_timer_elapsed(&timer, &elapsed);
+        std::uint64_t high = 0;
+        std::uint64_t low = 0;
+        kaizen_frame_time_accumulator_ticks(&elapsed, &high, &low);
+        CHECK_EQUAL(0u, high);
+        CHECK_EQUAL(first + second + third, low);
+
+        errc = kaizen_frame_timer_finalize(&timer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_frame_timer_test)
@@ -0,0 +1,165 @@
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_raw_hardware_counters.h>
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_capture_analysis.hpp>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+
+#include <UnitTest++.h>
+
+#include "kaizen_test_events.hpp"
+
+
+
+namespace {
+
+    std::size_t const event_capacity = 64;
+
+    uint32_t const test_zone_id = 11;
+
+    // Keeps the compiler from removing the measured loop.
+    volatile uint64_t work_sink = 0;
+
+    void do_work(int const count)
+    {
+        for (int i = 0; i < count; ++i) {
+            work_sink = work_sink + static_cast<uint64_t>(i);
+        }
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_hardware_counters_test)
+{
+    TEST(counters_count_instructions_or_report_why_not)
+    {
+        kaizen_raw_hardware_counters_t counters;
+        int const errc = kaizen_hardware_counters_init(&counters);
+
+        // Virtual machines and restrictive perf_event_paranoid settings
+        // offer no counters.
+        if (KAIZEN_SUCCESS != errc) {
+            CHECK(0 != errc);
+            return;
+        }
+
+        kaizen_hardware_counter_values_t before;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_hardware_counters_read(&counters, &before));
+        do_work(100000);
+        kaizen_hardware_counter_values_t after;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_hardware_counters_read(&counters, &after));
+
+        if (KAIZEN_TRUE == kaizen_hardware_counters_is_enabled(&counters, kaizen_instructions_hardware_counter)) {
+            CHECK(100000u < after.values[kaizen_instructions_hardware_counter] - before.values[kaizen_instructions_hardware_counter]);
+        }
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_hardware_counters_finalize(&counters));
+    }
+
+
+
+    TEST(attached_counters_are_per_thread)
+    {
+        kaizen_raw_hardware_counters_t counters;
+        int errc = kaizen_hardware_counters_init(&counters);
+
+        if (KAIZEN_SUCCESS != errc) {
+            return;
+        }
+
+        CHECK(NULL == kaizen_hardware_counters_of_current_thread());
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_hardware_counters_attach_to_current_thread(&counters));
+        CHECK(&counters == kaizen_hardware_counters_of_current_thread());
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_hardware_counters_attach_to_current_thread(NULL));
+        CHECK(NULL == kaizen_hardware_counters_of_current_thread());
+
+        errc = kaizen_hardware_counters_finalize(&counters);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(zone_records_counter_deltas_after_its_event)
+    {
+        kaizen_raw_hardware_counters_t counters;
+        int errc = kaizen_hardware_counters_init(&counters);
+
+        if (KAIZEN_SUCCESS != errc) {
+            return;
+        }
+
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_hardware_counters_attach_to_current_thread(&counters);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_zone_t zone = KAIZEN_ZONE_INITIALIZER("zone", test_zone_id);
+        kaizen_zone_scope_t scope;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_begin(&zone, &scope));
+        do_work(10000);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_end(&scope));
+
+        std::size_t enabled_count = 0;
+        for (int i = 0; i < KAIZEN_HARDWARE_COUNTER_COUNT; ++i) {
+            if (KAIZEN_TRUE == kaizen_hardware_counters_is_enabled(&counters, static_cast<kaizen_hardware_counter_t>(i))) {
+                ++enabled_count;
+            }
+        }
+
+        CHECK_EQUAL(1u + enabled_count, kaizen_event_buffer_count(&buffer));
+        CHECK_EQUAL(kaizen_zone_event_type, kaizen_event_buffer_at(&buffer, 0)->type);
+
+        for (std::size_t i = 1; i < kaizen_event_buffer_count(&buffer); ++i) {
+            kaizen_event_t const* event = kaizen_event_buffer_at(&buffer, i);
+            CHECK_EQUAL(kaizen_hardware_counter_event_type, event->type);
+            CHECK_EQUAL(test_zone_id, event->id);
+            CHECK(KAIZEN_HARDWARE_COUNTER_COUNT > event->flags);
+            CHECK_EQUAL(KAIZEN_TRUE, kaizen_hardware_counters_is_enabled(&counters, static_cast<kaizen_hardware_counter_t>(event->flags)));
+        }
+
+        errc = kaizen_hardware_counters_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_hardware_counters_finalize(&counters);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(analysis_sums_counter_deltas_per_zone)
+    {
+        kaizen::capture capture;
+        capture.ticks_per_second = 1000;
+
+        for (uint64_t i = 0; i < 2; ++i) {
+            capture.events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, test_zone_id, 10 * i, 5, 1, 0));
+            capture.events.push_back(kaizen_test::make_capture_event(kaizen_hardware_counter_event_type, test_zone_id, 10 * i, 5, 1000, kaizen_cycles_hardware_counter));
+            capture.events.push_back(kaizen_test::make_capture_event(kaizen_hardware_counter_event_type, test_zone_id, 10 * i, 5, 2000, kaizen_instructions_hardware_counter));
+            capture.events.push_back(kaizen_test::make_capture_event(kaizen_hardware_counter_event_type, test_zone_id, 10 * i, 5, 3, kaizen_cache_misses_hardware_counter));
+        }
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, test_zone_id + 1, 30, 5, 1, 0));
+
+        kaizen::capture_report const report = kaizen::analyze_capture(capture, 2);
+
+        CHECK_EQUAL(2u, report.zones.size());
+        CHECK_EQUAL(2u, report.zones[0].count);
+        CHECK_EQUAL(2u, report.zones[0].hardware_counter_sample_count);
+        CHECK_EQUAL(2000u, report.zones[0].hardware_counter_totals[kaizen_cycles_hardware_counter]);
+        CHECK_EQUAL(4000u, report.zones[0].hardware_counter_totals[kaizen_instructions_hardware_counter]);
+        CHECK_EQUAL(6u, report.zones[0].hardware_counter_totals[kaizen_cache_misses_hardware_counter]);
+        CHECK_EQUAL(0u, report.zones[0].hardware_counter_totals[kaizen_branch_misses_hardware_counter]);
+        CHECK_EQUAL(0u, report.zones[1].hardware_counter_sample_count);
+    }
+
+} // SUITE(kaizen_hardware_counters_test)
@@ -0,0 +1,191 @@
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_lock_profile.h>
+#include <kaizen/kaizen_instrumented_spinlock.h>
+#include <kaizen/kaizen_raw_instrumented_mutex.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_instrumented_lock.hpp>
+
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    std::size_t const event_capacity = 16;
+
+    uint32_t const test_lock_id = 42;
+
+} // anonymous namespace
+
+
+SUITE(kaizen_instrumented_lock_test)
+{
+    TEST(uncontended_mutex_records_nothing)
+    {
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        int errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+        kaizen_raw_instrumented_mutex_t mutex;
+        errc = kaizen_instrumented_mutex_init(&mutex, test_lock_id, &zero);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_instrumented_mutex_lock(&mutex));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_instrumented_mutex_unlock(&mutex));
+
+        CHECK_EQUAL(0u, kaizen_event_buffer_count(&buffer));
+
+        errc = kaizen_instrumented_mutex_finalize(&mutex);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(trylock_of_locked_spinlock_is_busy)
+    {
+        kaizen_raw_frame_time_t const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+        kaizen_instrumented_spinlock_t spinlock;
+        int errc = kaizen_instrumented_spinlock_init(&spinlock, test_lock_id, &zero);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_instrumented_spinlock_trylock(&spinlock));
+        CHECK_EQUAL(EBUSY, kaizen_instrumented_spinlock_trylock(&spinlock));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_instrumented_spinlock_unlock(&spinlock));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_instrumented_spinlock_trylock(&spinlock));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_instrumented_spinlock_unlock(&spinlock));
+
+        errc = kaizen_instrumented_spinlock_finalize(&spinlock);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(contended_acquire_records_wait_and_hold)
+    {
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        int errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t const zero = KAIZEN_RAW_FRAME_TIME_ZERO;
+        kaizen_lock_profile_t profile;
+        errc = kaizen_lock_profile_init(&profile, test_lock_id, &zero);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t wait_start = KAIZEN_RAW_FRAME_TIME_ZERO;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_lock_profile_wait_begin(&profile, &wait_start));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_lock_profile_wait_end(&profile, &wait_start));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_lock_profile_release(&profile));
+
+        CHECK_EQUAL(2u, kaizen_event_buffer_count(&buffer));
+        if (2u == kaizen_event_buffer_count(&buffer)) {
+            kaizen_event_t const* wait = kaizen_event_buffer_at(&buffer, 0);
+            kaizen_event_t const* hold = kaizen_event_buffer_at(&buffer, 1);
+
+            CHECK_EQUAL(kaizen_lock_wait_event_type, wait->type);
+            CHECK_EQUAL(test_lock_id, wait->id);
+            CHECK_EQUAL(kaizen_lock_hold_event_type, hold->type);
+            CHECK_EQUAL(test_lock_id, hold->id);
+            CHECK(kaizen_frame_time_lesser_or_equal(&wait->time, &hold->time));
+        }
+
+        errc = kaizen_lock_profile_finalize(&profile);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(wait_below_threshold_is_not_recorded)
+    {
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        int errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        // A threshold far longer than the (non-existing) wait.
+        kaizen_raw_frame_time_t earlier = KAIZEN_RAW_FRAME_TIME_ZERO;
+        kaizen_raw_frame_time_t later = KAIZEN_RAW_FRAME_TIME_ZERO;
+        errc = kaizen_frame_time_query(&earlier);
+        assert(KAIZEN_SUCCESS == errc);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        errc = kaizen_frame_time_query(&later);
+        assert(KAIZEN_SUCCESS == errc);
+        kaizen_raw_frame_time_t threshold = KAIZEN_RAW_FRAME_TIME_ZERO;
+        errc = kaizen_frame_time_subtract(&later, &earlier, &threshold);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_lock_profile_t profile;
+        errc = kaizen_lock_profile_init(&profile, test_lock_id, &threshold);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t wait_start = KAIZEN_RAW_FRAME_TIME_ZERO;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_lock_profile_wait_begin(&profile, &wait_start));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_lock_profile_wait_end(&profile, &wait_start));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_lock_profile_release(&profile));
+
+        CHECK_EQUAL(0u, kaizen_event_buffer_count(&buffer));
+
+        errc = kaizen_lock_profile_finalize(&profile);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(cpp_mutex_contention_between_threads)
+    {
+        kaizen::instrumented_mutex mutex(test_lock_id);
+        std::size_t waiter_event_count = 0;
+
+        mutex.lock();
+
+        std::thread waiter([&mutex, &waiter_event_count]() {
+            kaizen_event_t storage[event_capacity];
+            kaizen_event_buffer_t buffer;
+            kaizen_event_buffer_init(&buffer, storage, event_capacity);
+            kaizen_event_buffer_attach_to_current_thread(&buffer);
+
+            {
+                std::lock_guard<kaizen::instrumented_mutex> guard(mutex);
+            }
+
+            waiter_event_count = kaizen_event_buffer_count(&buffer);
+            kaizen_event_buffer_attach_to_current_thread(NULL);
+            kaizen_event_buffer_finalize(&buffer);
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        mutex.unlock();
+        waiter.join();
+
+        CHECK_EQUAL(2u, waiter_event_count);
+    }
+
+} // SUITE(kaizen_instrumented_lock_test)
+
@@ -106,6 +106,36 @@ SUITE(kaizen_raw_frame_time_test)
         assert(KAIZEN_SUCCESS == error_code);
     }
     
+    
+    
+    TEST(comparisons)
+    {
+        kaizen_raw_frame_time_t earlier = KAIZEN_RAW_FRAME_TIME_ZERO;
+        kaizen_raw_frame_time_t later = KAIZEN_RAW_FRAME_TIME_ZERO;
+        uint64_t ticks_per_second = 0;
+        int errc = kaizen_frame_time_query_ticks_per_second(&ticks_per_second);
+        assert(KAIZEN_SUCCESS == errc);
+        
+        // Earlier has the greater fraction of a second.
+        errc = kaizen_frame_time_convert_from_ticks(&earlier, ticks_per_second + ticks_per_second / 2);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_frame_time_convert_from_ticks(&later, 2 * ticks_per_second + ticks_per_second / 4);
+        assert(KAIZEN_SUCCESS == errc);
+        
+        CHECK_EQUAL(KAIZEN_TRUE, kaizen_frame_time_lesser(&earlier, &later));
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_frame_time_lesser(&later, &earlier));
+        CHECK_EQUAL(KAIZEN_TRUE, kaizen_frame_time_lesser_or_equal(&earlier, &later));
+        CHECK_EQUAL(KAIZEN_TRUE, kaizen_frame_time_lesser_or_equal(&earlier, &earlier));
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_frame_time_lesser_or_equal(&later, &earlier));
+        CHECK_EQUAL(KAIZEN_TRUE, kaizen_frame_time_greater(&later, &earlier));
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_frame_time_greater(&earlier, &later));
+        CHECK_EQUAL(KAIZEN_TRUE, kaizen_frame_time_greater_or_equal(&later, &later));
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_frame_time_greater_or_equal(&earlier, &later));
+        CHECK_EQUAL(KAIZEN_TRUE, kaizen_frame_time_equal(&earlier, &earlier));
+        CHECK_EQUAL(KAIZEN_TRUE, kaizen_frame_time_unequal(&earlier, &later));
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_frame_time_unequal(&later, &later));
+    }
+    
 } // SUITE(kaizen_test)
 
 
@@ -0,0 +1,167 @@
+#include <kaizen/kaizen_raw_sampler.h>
+#include <kaizen/kaizen_thread_state.h>
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    std::size_t const event_capacity = 2048;
+
+    uint32_t const sample_capacity = 256;
+
+    uint32_t const test_zone_id = 42;
+
+    uint64_t const test_frame_number = 7;
+
+
+    // Keeps the thread busy so its CPU time timer expires.
+    void burn_cpu(std::chrono::milliseconds const duration)
+    {
+        volatile uint64_t sink = 0;
+        std::chrono::steady_clock::time_point const end = std::chrono::steady_clock::now() + duration;
+
+        while (std::chrono::steady_clock::now() < end) {
+            for (uint32_t i = 0; i < 10000; ++i) {
+                sink = sink + i;
+            }
+        }
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_sampler_test)
+{
+    TEST(busy_zone_is_sampled_with_zone_frame_and_stack)
+    {
+        static char memory[sample_capacity * sizeof(kaizen_sample_t) + 4096];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_sampler_t sampler;
+        errc = kaizen_sampler_init_from_arena(&sampler, &arena, sample_capacity);
+
+        if (KAIZEN_SUCCESS != errc) {
+            CHECK_EQUAL(ENOSYS, errc);
+            errc = kaizen_arena_finalize(&arena);
+            assert(KAIZEN_SUCCESS == errc);
+            return;
+        }
+
+        static kaizen_event_t storage[event_capacity];
+        kaizen_thread_state_t state;
+        errc = kaizen_thread_state_init(&state, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_thread_state_attach_to_current_thread(&state);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_sampler_mark_frame(test_frame_number);
+        kaizen_thread_state_push_zone(&state, test_zone_id);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_sampler_start(&sampler, 1000000u));
+        burn_cpu(std::chrono::milliseconds(200));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_sampler_stop(&sampler));
+
+        kaizen_thread_state_pop_zone(&state);
+
+        uint32_t sample_count = 0;
+        kaizen_sample_t sample;
+
+        while (KAIZEN_SUCCESS == kaizen_sampler_read(&sampler, &sample)) {
+            ++sample_count;
+            CHECK_EQUAL(test_zone_id, sample.zone_id);
+            CHECK_EQUAL(test_frame_number, sample.frame_number);
+            CHECK(1u <= sample.stack_depth);
+            CHECK(KAIZEN_SAMPLE_MAX_STACK_DEPTH >= sample.stack_depth);
+            CHECK(0u != sample.stack[0]);
+        }
+
+        CHECK(0u < sample_count);
+        CHECK_EQUAL(EAGAIN, kaizen_sampler_read(&sampler, &sample));
+
+        errc = kaizen_thread_state_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_thread_state_finalize(&state);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_sampler_finalize(&sampler));
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(samples_are_recorded_as_sample_and_stack_frame_events)
+    {
+        static char memory[sample_capacity * sizeof(kaizen_sample_t) + 4096];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_sampler_t sampler;
+        errc = kaizen_sampler_init_from_arena(&sampler, &arena, sample_capacity);
+
+        if (KAIZEN_SUCCESS != errc) {
+            errc = kaizen_arena_finalize(&arena);
+            assert(KAIZEN_SUCCESS == errc);
+            return;
+        }
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_sampler_start(&sampler, 1000000u));
+        burn_cpu(std::chrono::milliseconds(50));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_sampler_stop(&sampler));
+
+        static kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_sampler_record_events(&sampler));
+
+        std::size_t sample_event_count = 0;
+        std::size_t index = 0;
+
+        while (index < kaizen_event_buffer_count(&buffer)) {
+            kaizen_event_t const* const event = kaizen_event_buffer_at(&buffer, index);
+            CHECK_EQUAL(static_cast<uint16_t>(kaizen_sample_event_type), event->type);
+            CHECK_EQUAL(KAIZEN_SAMPLE_NO_ZONE_ID, event->id);
+            ++sample_event_count;
+
+            std::size_t const depth = event->flags;
+            CHECK(1u <= depth);
+
+            for (std::size_t frame = 0; frame < depth; ++frame) {
+                kaizen_event_t const* const frame_event = kaizen_event_buffer_at(&buffer, index + 1 + frame);
+                CHECK_EQUAL(static_cast<uint16_t>(kaizen_stack_frame_event_type), frame_event->type);
+                CHECK_EQUAL(frame, static_cast<std::size_t>(frame_event->flags));
+            }
+
+            index += 1 + depth;
+        }
+
+        CHECK(0u < sample_event_count);
+        CHECK_EQUAL(0u, kaizen_sampler_dropped_count(&sampler));
+
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_sampler_finalize(&sampler));
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_sampler_test)
@@ -0,0 +1,129 @@
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_raw_scheduling_monitor.h>
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_capture_analysis.hpp>
+
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <UnitTest++.h>
+
+#include "kaizen_test_events.hpp"
+
+
+
+namespace {
+
+    std::size_t const event_capacity = 16;
+
+    uint32_t const test_zone_id = 9;
+
+} // anonymous namespace
+
+
+SUITE(kaizen_scheduling_monitor_test)
+{
+    TEST(sleeping_counts_voluntary_context_switches_or_monitor_reports_why_not)
+    {
+        kaizen_raw_scheduling_monitor_t monitor;
+        int const errc = kaizen_scheduling_monitor_init(&monitor);
+
+        if (KAIZEN_SUCCESS != errc) {
+            CHECK(0 != errc);
+            return;
+        }
+
+        kaizen_scheduling_counts_t before;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_scheduling_monitor_read(&monitor, &before));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        kaizen_scheduling_counts_t after;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_scheduling_monitor_read(&monitor, &after));
+
+        CHECK(before.voluntary_context_switch_count < after.voluntary_context_switch_count);
+        CHECK(before.involuntary_context_switch_count <= after.involuntary_context_switch_count);
+        CHECK(before.migration_count <= after.migration_count);
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_scheduling_monitor_finalize(&monitor));
+    }
+
+
+
+    TEST(zone_sleeping_is_flagged_blocked)
+    {
+        kaizen_raw_scheduling_monitor_t monitor;
+        int errc = kaizen_scheduling_monitor_init(&monitor);
+
+        if (KAIZEN_SUCCESS != errc) {
+            return;
+        }
+
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK(NULL == kaizen_scheduling_monitor_of_current_thread());
+        errc = kaizen_scheduling_monitor_attach_to_current_thread(&monitor);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK(&monitor == kaizen_scheduling_monitor_of_current_thread());
+
+        kaizen_zone_t zone = KAIZEN_ZONE_INITIALIZER("zone", test_zone_id);
+        kaizen_zone_scope_t scope;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_begin(&zone, &scope));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_end(&scope));
+
+        CHECK_EQUAL(1u, kaizen_event_buffer_count(&buffer));
+        CHECK(0 != (kaizen_event_buffer_at(&buffer, 0)->flags & KAIZEN_ZONE_EVENT_BLOCKED_FLAG));
+
+        errc = kaizen_scheduling_monitor_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_scheduling_monitor_finalize(&monitor);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(analysis_counts_and_excludes_descheduled_zones)
+    {
+        kaizen::capture capture;
+        capture.ticks_per_second = 1000;
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, test_zone_id, 0, 1, 1, 0));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, test_zone_id, 10, 50, 1, KAIZEN_ZONE_EVENT_DESCHEDULED_FLAG));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_hardware_counter_event_type, test_zone_id, 10, 50, 1, 0));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type,
+                                                                 test_zone_id,
+                                                                 100,
+                                                                 80,
+                                                                 1,
+                                                                 KAIZEN_ZONE_EVENT_DESCHEDULED_FLAG | KAIZEN_ZONE_EVENT_MIGRATED_FLAG));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_zone_event_type, test_zone_id, 200, 2, 1, 0));
+        capture.events.push_back(kaizen_test::make_capture_event(kaizen_hardware_counter_event_type, test_zone_id, 200, 2, 1, 0));
+
+        kaizen::capture_report const report = kaizen::analyze_capture(capture, 1);
+        CHECK_EQUAL(1u, report.zones.size());
+        CHECK_EQUAL(4u, report.zones[0].count);
+        CHECK_EQUAL(2u, report.zones[0].descheduled_count);
+        CHECK_EQUAL(1u, report.zones[0].migrated_count);
+
+        kaizen::capture const undisturbed = kaizen::exclude_descheduled_zones(capture);
+        CHECK_EQUAL(3u, undisturbed.events.size());
+
+        kaizen::capture_report const undisturbed_report = kaizen::analyze_capture(undisturbed, 1);
+        CHECK_EQUAL(2u, undisturbed_report.zones[0].count);
+        CHECK_EQUAL(0u, undisturbed_report.zones[0].descheduled_count);
+        CHECK_EQUAL(1u, undisturbed_report.zones[0].hardware_counter_sample_count);
+        CHECK_CLOSE(0.002, undisturbed_report.zones[0].max_seconds, 1e-9);
+    }
+
+} // SUITE(kaizen_scheduling_monitor_test)
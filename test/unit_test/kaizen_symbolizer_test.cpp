@@ -0,0 +1,73 @@
+#include <kaizen/kaizen_symbolizer.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    // Not inlined so the test binary has a symbol to find.
+#if defined(__GNUC__)
+    __attribute__((noinline))
+#endif
+    int kaizen_symbolizer_test_function(int value)
+    {
+        return value * 3 + 1;
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_symbolizer_test)
+{
+    TEST(unknown_address_is_written_in_hex)
+    {
+        kaizen::elf_symbolizer symbolizer;
+
+        CHECK_EQUAL("0x1234", symbolizer.symbolize(0x1234));
+        CHECK_EQUAL(0u, symbolizer.symbol_count());
+    }
+
+
+
+    TEST(missing_binary_throws_enoent)
+    {
+        kaizen::elf_symbolizer symbolizer;
+        int error_code = 0;
+
+        try {
+            symbolizer.add_module("/kaizen/no/such/binary", 0);
+        } catch (std::system_error const& e) {
+            error_code = e.code().value();
+        }
+
+        CHECK_EQUAL(ENOENT, error_code);
+    }
+
+
+
+#if defined(__linux__)
+    TEST(mapped_test_binary_symbolizes_own_function)
+    {
+        CHECK_EQUAL(7, kaizen_symbolizer_test_function(2));
+
+        kaizen::elf_symbolizer symbolizer;
+        std::ifstream maps("/proc/self/maps");
+        CHECK(0u < symbolizer.add_mapped_modules(maps));
+        CHECK(0u < symbolizer.symbol_count());
+
+        std::uint64_t const address = reinterpret_cast<std::uintptr_t>(&kaizen_symbolizer_test_function);
+        std::string const name = symbolizer.symbolize(address + 1);
+
+        CHECK(std::string::npos != name.find("kaizen_symbolizer_test_function"));
+        CHECK_EQUAL(name, symbolizer.symbolize(address + 1));
+    }
+#endif
+
+} // SUITE(kaizen_symbolizer_test)
@@ -0,0 +1,73 @@
+/**
+ * @file
+ *
+ * Event fixtures shared by the unit tests.
+ */
+
+#ifndef KAIZEN_kaizen_test_events_HPP
+#define KAIZEN_kaizen_test_events_HPP
+
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_capture_analysis.hpp>
+
+#include <cassert>
+#include <cstdint>
+
+
+
+namespace kaizen_test {
+
+    /**
+     * Returns a recorded event of @a type starting at @a time_ticks and
+     * lasting @a duration_ticks.
+     */
+    inline kaizen_event_t make_event(kaizen_event_type_t const type,
+                                     std::uint32_t const id,
+                                     std::uint64_t const time_ticks,
+                                     std::uint64_t const duration_ticks,
+                                     std::uint64_t const value = 1,
+                                     std::uint16_t const flags = 0)
+    {
+        kaizen_event_t event;
+        int errc = kaizen_frame_time_convert_from_ticks(&event.time, time_ticks);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_frame_time_convert_from_ticks(&event.duration, duration_ticks);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+        event.value = value;
+        event.id = id;
+        event.type = static_cast<std::uint16_t>(type);
+        event.flags = flags;
+
+        return event;
+    }
+
+
+    /**
+     * Returns a decoded capture event of stream 0, times are in ticks.
+     */
+    inline kaizen::capture_event make_capture_event(std::uint16_t const type,
+                                                    std::uint32_t const id,
+                                                    std::uint64_t const time,
+                                                    std::uint64_t const duration,
+                                                    std::uint64_t const value = 1,
+                                                    std::uint16_t const flags = 0)
+    {
+        kaizen::capture_event event;
+        event.time = time;
+        event.duration = duration;
+        event.value = value;
+        event.id = id;
+        event.stream_id = 0;
+        event.type = type;
+        event.flags = flags;
+
+        return event;
+    }
+
+} // namespace kaizen_test
+
+
+#endif /* KAIZEN_kaizen_test_events_HPP */
@@ -0,0 +1,104 @@
+#include <kaizen/kaizen_thread_state.h>
+#include <kaizen/kaizen_arena.h>
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cstddef>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    std::size_t const event_capacity = 16;
+
+} // anonymous namespace
+
+
+SUITE(kaizen_thread_state_test)
+{
+    TEST(blocks_do_not_share_cache_lines)
+    {
+        CHECK_EQUAL(0u, sizeof(kaizen_thread_state_t) % KAIZEN_CACHE_LINE_SIZE);
+        CHECK_EQUAL(0u, offsetof(kaizen_thread_state_t, depth_stack) % KAIZEN_CACHE_LINE_SIZE);
+        CHECK_EQUAL(0u, offsetof(kaizen_thread_state_t, stats) % KAIZEN_CACHE_LINE_SIZE);
+
+        kaizen_thread_state_t states[2];
+        CHECK_EQUAL(0u, reinterpret_cast<std::size_t>(&states[1]) % KAIZEN_CACHE_LINE_SIZE);
+    }
+
+
+
+    TEST(attach_exposes_state_and_event_buffer)
+    {
+        kaizen_event_t storage[event_capacity];
+        kaizen_thread_state_t state;
+        int errc = kaizen_thread_state_init(&state, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK(NULL == kaizen_thread_state_of_current_thread());
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_thread_state_attach_to_current_thread(&state));
+        CHECK(&state == kaizen_thread_state_of_current_thread());
+        CHECK(kaizen_thread_state_event_buffer(&state) == kaizen_event_buffer_of_current_thread());
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_thread_state_attach_to_current_thread(NULL));
+        CHECK(NULL == kaizen_thread_state_of_current_thread());
+        CHECK(NULL == kaizen_event_buffer_of_current_thread());
+
+        errc = kaizen_thread_state_finalize(&state);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(nested_zones_track_depth)
+    {
+        static char memory[4096];
+        kaizen_arena_t arena;
+        int errc = kaizen_arena_init(&arena, memory, sizeof(memory));
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_thread_state_t* state = NULL;
+        errc = kaizen_thread_state_allocate_from_arena(&arena, event_capacity, &state);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(0u, reinterpret_cast<std::size_t>(state) % KAIZEN_CACHE_LINE_SIZE);
+        errc = kaizen_thread_state_attach_to_current_thread(state);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_zone_t outer_zone = KAIZEN_ZONE_INITIALIZER("outer", 1);
+        kaizen_zone_t inner_zone = KAIZEN_ZONE_INITIALIZER("inner", 2);
+
+        kaizen_zone_scope_t outer_scope;
+        kaizen_zone_scope_t inner_scope;
+        (void)kaizen_zone_begin(&outer_zone, &outer_scope);
+        (void)kaizen_zone_begin(&inner_zone, &inner_scope);
+
+        CHECK_EQUAL(2u, kaizen_thread_state_depth(state));
+        CHECK_EQUAL(2u, kaizen_thread_state_top_zone_id(state));
+
+        (void)kaizen_zone_end(&inner_scope);
+        CHECK_EQUAL(1u, kaizen_thread_state_top_zone_id(state));
+        (void)kaizen_zone_end(&outer_scope);
+
+        CHECK_EQUAL(0u, kaizen_thread_state_depth(state));
+        CHECK_EQUAL(2u, kaizen_thread_state_max_depth(state));
+        CHECK_EQUAL(2u, kaizen_thread_state_zone_count(state));
+        CHECK_EQUAL(2u, kaizen_event_buffer_count(kaizen_thread_state_event_buffer(state)));
+
+        // Only the outer zone ends with no zone of the state open.
+        kaizen_event_buffer_t* const buffer = kaizen_thread_state_event_buffer(state);
+        CHECK_EQUAL(0u, kaizen_event_buffer_at(buffer, 0)->flags & KAIZEN_ZONE_EVENT_OUTERMOST_FLAG);
+        CHECK_EQUAL(KAIZEN_ZONE_EVENT_OUTERMOST_FLAG, kaizen_event_buffer_at(buffer, 1)->flags & KAIZEN_ZONE_EVENT_OUTERMOST_FLAG);
+
+        errc = kaizen_thread_state_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_thread_state_finalize(state);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_arena_finalize(&arena);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_thread_state_test)
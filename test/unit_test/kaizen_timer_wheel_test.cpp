@@ -0,0 +1,280 @@
+#include <kaizen/kaizen_timer_wheel.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    kaizen_raw_frame_time_t frame_time(std::uint64_t ticks)
+    {
+        kaizen_raw_frame_time_t result = KAIZEN_RAW_FRAME_TIME_ZERO;
+        int const errc = kaizen_frame_time_convert_from_ticks(&result, ticks);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+
+        return result;
+    }
+
+
+    struct recorded_call {
+        std::uint64_t now_ticks;
+        std::uint64_t call_ticks;
+        std::uint64_t call_count;
+    };
+
+
+    void record_call(kaizen_timer_t* timer, void* context)
+    {
+        assert(NULL != timer);
+        (void)timer;
+
+        recorded_call* const call = static_cast<recorded_call*>(context);
+        call->call_ticks = call->now_ticks;
+        ++(call->call_count);
+    }
+
+
+    struct periodic_context {
+        kaizen_timer_wheel_t* wheel;
+        std::uint64_t deadline_ticks;
+        std::uint64_t period_ticks;
+        std::uint64_t call_count;
+    };
+
+
+    void reschedule(kaizen_timer_t* timer, void* context)
+    {
+        periodic_context* const periodic = static_cast<periodic_context*>(context);
+        ++(periodic->call_count);
+        periodic->deadline_ticks += periodic->period_ticks;
+
+        kaizen_raw_frame_time_t const deadline = frame_time(periodic->deadline_ticks);
+        int const errc = kaizen_timer_wheel_schedule(periodic->wheel, timer, &deadline);
+        assert(KAIZEN_SUCCESS == errc);
+        (void)errc;
+    }
+
+
+    std::uint64_t const granularity_ticks = 1000;
+
+} // anonymous namespace
+
+
+
+SUITE(kaizen_timer_wheel_test)
+{
+    TEST(zero_granularity_is_invalid)
+    {
+        kaizen_timer_wheel_t wheel;
+        kaizen_raw_frame_time_t const now = frame_time(0);
+        kaizen_raw_frame_time_t const granularity = frame_time(0);
+
+        CHECK_EQUAL(EINVAL, kaizen_timer_wheel_init(&wheel, &now, &granularity));
+    }
+
+
+
+    TEST(calls_timer_once_deadline_passed)
+    {
+        kaizen_timer_wheel_t wheel;
+        kaizen_raw_frame_time_t now = frame_time(5 * granularity_ticks + 17);
+        kaizen_raw_frame_time_t const granularity = frame_time(granularity_ticks);
+        int errc = kaizen_timer_wheel_init(&wheel, &now, &granularity);
+        assert(KAIZEN_SUCCESS == errc);
+
+        recorded_call call = {0, 0, 0};
+        kaizen_timer_t timer;
+        errc = kaizen_timer_init(&timer, record_call, &call);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t const deadline = frame_time(9 * granularity_ticks + 1);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_timer_wheel_schedule(&wheel, &timer, &deadline));
+        CHECK_EQUAL(KAIZEN_TRUE, kaizen_timer_is_scheduled(&timer));
+        CHECK_EQUAL(1u, kaizen_timer_wheel_timer_count(&wheel));
+
+        // Not called before the deadline even within its granule.
+        now = frame_time(9 * granularity_ticks + 1 - 1);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_timer_wheel_advance(&wheel, &now));
+        CHECK_EQUAL(0u, call.call_count);
+
+        call.now_ticks = 10 * granularity_ticks;
+        now = frame_time(call.now_ticks);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_timer_wheel_advance(&wheel, &now));
+        CHECK_EQUAL(1u, call.call_count);
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_timer_is_scheduled(&timer));
+        CHECK_EQUAL(0u, kaizen_timer_wheel_timer_count(&wheel));
+
+        // Passed deadlines are called by the next advance.
+        kaizen_raw_frame_time_t const passed = frame_time(0);
+        errc = kaizen_timer_wheel_schedule(&wheel, &timer, &passed);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_timer_wheel_advance(&wheel, &now));
+        CHECK_EQUAL(1u, call.call_count);
+        call.now_ticks = 11 * granularity_ticks;
+        now = frame_time(call.now_ticks);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_timer_wheel_advance(&wheel, &now));
+        CHECK_EQUAL(2u, call.call_count);
+
+        errc = kaizen_timer_finalize(&timer);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_timer_wheel_finalize(&wheel);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(cancel_and_reschedule)
+    {
+        kaizen_timer_wheel_t wheel;
+        kaizen_raw_frame_time_t now = frame_time(0);
+        kaizen_raw_frame_time_t const granularity = frame_time(granularity_ticks);
+        int errc = kaizen_timer_wheel_init(&wheel, &now, &granularity);
+        assert(KAIZEN_SUCCESS == errc);
+
+        recorded_call call = {0, 0, 0};
+        kaizen_timer_t timer;
+        errc = kaizen_timer_init(&timer, record_call, &call);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t const early = frame_time(100 * granularity_ticks);
+        kaizen_raw_frame_time_t const late = frame_time(5000 * granularity_ticks);
+
+        errc = kaizen_timer_wheel_schedule(&wheel, &timer, &early);
+        assert(KAIZEN_SUCCESS == errc);
+        kaizen_timer_wheel_cancel(&wheel, &timer);
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_timer_is_scheduled(&timer));
+        CHECK_EQUAL(0u, kaizen_timer_wheel_timer_count(&wheel));
+
+        // Cancelling twice is harmless.
+        kaizen_timer_wheel_cancel(&wheel, &timer);
+
+        errc = kaizen_timer_wheel_schedule(&wheel, &timer, &early);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_timer_wheel_schedule(&wheel, &timer, &late));
+        CHECK_EQUAL(1u, kaizen_timer_wheel_timer_count(&wheel));
+
+        for (std::uint64_t granule = 1; granule <= 5000; ++granule) {
+            call.now_ticks = granule * granularity_ticks;
+            now = frame_time(call.now_ticks);
+            errc = kaizen_timer_wheel_advance(&wheel, &now);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        CHECK_EQUAL(1u, call.call_count);
+        CHECK_EQUAL(5000 * granularity_ticks, call.call_ticks);
+
+        errc = kaizen_timer_finalize(&timer);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_timer_wheel_finalize(&wheel);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(many_timers_across_levels)
+    {
+        kaizen_timer_wheel_t wheel;
+        std::uint64_t const start_ticks = 123456789;
+        kaizen_raw_frame_time_t now = frame_time(start_ticks);
+        kaizen_raw_frame_time_t const granularity = frame_time(granularity_ticks);
+        int errc = kaizen_timer_wheel_init(&wheel, &now, &granularity);
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::size_t const timer_count = 4000;
+        std::vector<kaizen_timer_t> timers(timer_count);
+        std::vector<recorded_call> calls(timer_count);
+        std::vector<std::uint64_t> deadlines(timer_count);
+
+        // Deadlines spread over three levels of the wheel.
+        std::uint64_t random = 12345;
+
+        for (std::size_t i = 0; i < timer_count; ++i) {
+            random = random * 6364136223846793005ull + 1442695040888963407ull;
+            deadlines[i] = start_ticks + (random >> 33) % (300000 * granularity_ticks);
+
+            calls[i].now_ticks = 0;
+            calls[i].call_ticks = 0;
+            calls[i].call_count = 0;
+
+            errc = kaizen_timer_init(&timers[i], record_call, &calls[i]);
+            assert(KAIZEN_SUCCESS == errc);
+
+            kaizen_raw_frame_time_t const deadline = frame_time(deadlines[i]);
+            errc = kaizen_timer_wheel_schedule(&wheel, &timers[i], &deadline);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        CHECK_EQUAL(timer_count, kaizen_timer_wheel_timer_count(&wheel));
+
+        // Advance by uneven steps like frames of varying length.
+        std::uint64_t const step_ticks = 16667;
+        std::uint64_t now_ticks = start_ticks;
+
+        while (0 != kaizen_timer_wheel_timer_count(&wheel)) {
+            now_ticks += step_ticks;
+
+            for (std::size_t i = 0; i < timer_count; ++i) {
+                calls[i].now_ticks = now_ticks;
+            }
+
+            now = frame_time(now_ticks);
+            errc = kaizen_timer_wheel_advance(&wheel, &now);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        for (std::size_t i = 0; i < timer_count; ++i) {
+            CHECK_EQUAL(1u, calls[i].call_count);
+            // Called by the first advance reaching the deadline.
+            CHECK(calls[i].call_ticks >= deadlines[i]);
+            CHECK(calls[i].call_ticks < deadlines[i] + step_ticks + granularity_ticks);
+
+            errc = kaizen_timer_finalize(&timers[i]);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        errc = kaizen_timer_wheel_finalize(&wheel);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(periodic_timer_reschedules_from_callback)
+    {
+        kaizen_timer_wheel_t wheel;
+        kaizen_raw_frame_time_t now = frame_time(0);
+        kaizen_raw_frame_time_t const granularity = frame_time(granularity_ticks);
+        int errc = kaizen_timer_wheel_init(&wheel, &now, &granularity);
+        assert(KAIZEN_SUCCESS == errc);
+
+        periodic_context periodic = {&wheel, 3 * granularity_ticks, 3 * granularity_ticks, 0};
+        kaizen_timer_t timer;
+        errc = kaizen_timer_init(&timer, reschedule, &periodic);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_raw_frame_time_t const deadline = frame_time(periodic.deadline_ticks);
+        errc = kaizen_timer_wheel_schedule(&wheel, &timer, &deadline);
+        assert(KAIZEN_SUCCESS == errc);
+
+        // One long frame catches up with all periods it spans.
+        now = frame_time(30 * granularity_ticks);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_timer_wheel_advance(&wheel, &now));
+        CHECK_EQUAL(10u, periodic.call_count);
+        CHECK_EQUAL(KAIZEN_TRUE, kaizen_timer_is_scheduled(&timer));
+
+        errc = kaizen_timer_wheel_finalize(&wheel);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_timer_is_scheduled(&timer));
+        errc = kaizen_timer_finalize(&timer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_timer_wheel_test)
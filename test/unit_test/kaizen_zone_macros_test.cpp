@@ -0,0 +1,101 @@
+// Compile FINE zones and strip VERBOSE zones in this translation unit.
+// Differs from the other test files, which is only safe because all zones
+// here have internal linkage (see kaizen_zone.hpp).
+#define KAIZEN_ZONE_LEVEL 2
+
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_zone_macros.h>
+#include <kaizen/kaizen_stddef.h>
+#include <kaizen/kaizen_zone.hpp>
+
+#include <cassert>
+#include <type_traits>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    std::size_t const event_capacity = 16;
+
+    KAIZEN_ZONE_DEFINE(FINE, fine_macro_zone, "fine_macro", 11);
+    KAIZEN_ZONE_DEFINE(VERBOSE, verbose_macro_zone, "verbose_macro", 12);
+
+} // anonymous namespace
+
+
+namespace kaizen_zone_macros_test_descriptors {
+
+    constexpr kaizen::zone_descriptor fine_zone = {"fine", 21, kaizen::zone_level::fine};
+    constexpr kaizen::zone_descriptor verbose_zone = {"verbose", 22, kaizen::zone_level::verbose};
+
+    static_assert(kaizen::zone_is_enabled(fine_zone), "FINE zones are compiled");
+    static_assert(!kaizen::zone_is_enabled(verbose_zone), "VERBOSE zones are stripped");
+
+    static_assert(std::is_empty<kaizen::scoped_zone<verbose_zone> >::value,
+                  "Stripped zones have no state");
+    static_assert(std::is_trivially_destructible<kaizen::scoped_zone<verbose_zone> >::value,
+                  "Stripped zones run no code on scope exit");
+
+} // namespace kaizen_zone_macros_test_descriptors
+
+
+SUITE(kaizen_zone_macros_test)
+{
+    TEST(c_macros_record_enabled_and_strip_disabled_levels)
+    {
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        int errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        {
+            KAIZEN_ZONE_BEGIN(FINE, fine_macro_zone);
+            KAIZEN_ZONE_BEGIN(VERBOSE, verbose_macro_zone);
+            KAIZEN_ZONE_END(VERBOSE, verbose_macro_zone);
+            KAIZEN_ZONE_END(FINE, fine_macro_zone);
+        }
+
+        CHECK_EQUAL(1u, kaizen_event_buffer_count(&buffer));
+        CHECK_EQUAL(11u, kaizen_event_buffer_at(&buffer, 0)->id);
+
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(cpp_scoped_zones_record_enabled_and_strip_disabled_levels)
+    {
+        using namespace kaizen_zone_macros_test_descriptors;
+
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        int errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        {
+            kaizen::scoped_zone<fine_zone> fine;
+            kaizen::scoped_zone<verbose_zone> verbose;
+        }
+
+        CHECK_EQUAL(1u, kaizen_event_buffer_count(&buffer));
+        CHECK_EQUAL(21u, kaizen_event_buffer_at(&buffer, 0)->id);
+        CHECK_EQUAL(kaizen_zone_event_type, kaizen_event_buffer_at(&buffer, 0)->type);
+        CHECK_EQUAL(21u, kaizen_zone_id(kaizen::scoped_zone<fine_zone>::native_handle()));
+
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_zone_macros_test)
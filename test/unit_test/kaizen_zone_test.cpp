@@ -0,0 +1,425 @@
+#include <kaizen/kaizen_event.h>
+#include <kaizen/kaizen_zone.h>
+#include <kaizen/kaizen_zone_sampler.h>
+#include <kaizen/kaizen_thread_state.h>
+#include <kaizen/kaizen_raw_frame_time.h>
+#include <kaizen/kaizen_stddef.h>
+
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include <UnitTest++.h>
+
+
+
+namespace {
+
+    std::size_t const event_capacity = 64;
+
+    uint32_t const test_zone_id = 7;
+
+    void execute_zone(kaizen_zone_t* zone, int const count)
+    {
+        for (int i = 0; i < count; ++i) {
+            kaizen_zone_scope_t scope;
+            (void)kaizen_zone_begin(zone, &scope);
+            (void)kaizen_zone_end(&scope);
+        }
+    }
+
+} // anonymous namespace
+
+
+SUITE(kaizen_zone_test)
+{
+    TEST(zone_records_every_execution_by_default)
+    {
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        int errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_zone_t zone = KAIZEN_ZONE_INITIALIZER("zone", test_zone_id);
+        CHECK_EQUAL(1u, kaizen_zone_sample_interval(&zone));
+
+        kaizen_zone_scope_t scope;
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_begin(&zone, &scope));
+        CHECK_EQUAL(KAIZEN_TRUE, kaizen_zone_scope_is_sampled(&scope));
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_end(&scope));
+
+        CHECK_EQUAL(1u, kaizen_event_buffer_count(&buffer));
+        kaizen_event_t const* event = kaizen_event_buffer_at(&buffer, 0);
+        CHECK_EQUAL(kaizen_zone_event_type, event->type);
+        CHECK_EQUAL(test_zone_id, event->id);
+        CHECK_EQUAL(1u, event->value);
+        CHECK_EQUAL(1u, kaizen_zone_exchange_sample_count(&zone));
+        CHECK_EQUAL(0u, kaizen_zone_exchange_sample_count(&zone));
+
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(zero_sample_interval_is_invalid)
+    {
+        kaizen_zone_t zone;
+        int errc = kaizen_zone_init(&zone, "zone", test_zone_id);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK_EQUAL(EINVAL, kaizen_zone_set_sample_interval(&zone, 0));
+        CHECK_EQUAL(1u, kaizen_zone_sample_interval(&zone));
+
+        errc = kaizen_zone_finalize(&zone);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(zone_records_one_in_n_executions)
+    {
+        kaizen_zone_t zone;
+        int errc = kaizen_zone_init(&zone, "zone", test_zone_id);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_zone_set_sample_interval(&zone, 8);
+        assert(KAIZEN_SUCCESS == errc);
+
+        execute_zone(&zone, 80000);
+
+        uint32_t const samples = kaizen_zone_exchange_sample_count(&zone);
+        CHECK(8500u < samples);
+        CHECK(11500u > samples);
+
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+
+        execute_zone(&zone, 800);
+
+        CHECK(0u < kaizen_event_buffer_count(&buffer));
+        CHECK_EQUAL(8u, kaizen_event_buffer_at(&buffer, 0)->value);
+
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_zone_finalize(&zone);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(unsampled_execution_is_tracked_by_thread_state)
+    {
+        kaizen_event_t storage[event_capacity];
+        kaizen_thread_state_t state;
+        int errc = kaizen_thread_state_init(&state, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_thread_state_attach_to_current_thread(&state);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_zone_t outer_zone = KAIZEN_ZONE_INITIALIZER("outer", test_zone_id);
+        kaizen_zone_t rare_zone = KAIZEN_ZONE_INITIALIZER("rare", test_zone_id + 1u);
+        errc = kaizen_zone_set_sample_interval(&rare_zone, 1000000u);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_zone_scope_t outer_scope;
+        kaizen_zone_scope_t scope;
+        errc = kaizen_zone_begin(&outer_zone, &outer_scope);
+        assert(KAIZEN_SUCCESS == errc);
+
+        do {
+            errc = kaizen_zone_begin(&rare_zone, &scope);
+            assert(KAIZEN_SUCCESS == errc);
+
+            if (KAIZEN_TRUE == kaizen_zone_scope_is_sampled(&scope)) {
+                errc = kaizen_zone_end(&scope);
+                assert(KAIZEN_SUCCESS == errc);
+            }
+        } while (KAIZEN_TRUE == kaizen_zone_scope_is_sampled(&scope));
+
+        CHECK_EQUAL(2u, kaizen_thread_state_depth(&state));
+        CHECK_EQUAL(test_zone_id + 1u, kaizen_thread_state_top_zone_id(&state));
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_end(&scope));
+        CHECK_EQUAL(1u, kaizen_thread_state_depth(&state));
+        CHECK_EQUAL(test_zone_id, kaizen_thread_state_top_zone_id(&state));
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_end(&outer_scope));
+        CHECK_EQUAL(0u, kaizen_thread_state_depth(&state));
+
+        errc = kaizen_thread_state_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_thread_state_finalize(&state);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(sampler_rate_limits_hot_zone_and_keeps_rare_zone)
+    {
+        kaizen_zone_t hot_zone = KAIZEN_ZONE_INITIALIZER("hot", 1);
+        kaizen_zone_t rare_zone = KAIZEN_ZONE_INITIALIZER("rare", 2);
+
+        kaizen_zone_t* zone_storage[2];
+        double estimate_storage[2];
+        kaizen_zone_sampler_t sampler;
+        int errc = kaizen_zone_sampler_init(&sampler,
+                                            zone_storage,
+                                            estimate_storage,
+                                            2,
+                                            0.01);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK(0.0 < kaizen_zone_sampler_sample_cost(&sampler));
+
+        errc = kaizen_zone_sampler_set_sample_cost(&sampler, 100.0);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_zone_sampler_add(&sampler, &hot_zone);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_zone_sampler_add(&sampler, &rare_zone);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(ENOMEM, kaizen_zone_sampler_add(&sampler, &rare_zone));
+
+        // A 10ms frame with a 1% budget at 100ns per sample allows about
+        // 1000 samples, so 100000 hot executions settle near 1 in 100.
+        for (int frame = 0; frame < 6; ++frame) {
+            kaizen_raw_frame_time_t frame_start = KAIZEN_RAW_FRAME_TIME_ZERO;
+            errc = kaizen_frame_time_query(&frame_start);
+            assert(KAIZEN_SUCCESS == errc);
+
+            execute_zone(&hot_zone, 100000);
+            execute_zone(&rare_zone, 10);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+            kaizen_raw_frame_time_t frame_end = KAIZEN_RAW_FRAME_TIME_ZERO;
+            errc = kaizen_frame_time_query(&frame_end);
+            assert(KAIZEN_SUCCESS == errc);
+            kaizen_raw_frame_time_t frame_duration = KAIZEN_RAW_FRAME_TIME_ZERO;
+            errc = kaizen_frame_time_subtract(&frame_end, &frame_start, &frame_duration);
+            assert(KAIZEN_SUCCESS == errc);
+
+            CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_sampler_adapt(&sampler, &frame_duration));
+        }
+
+        CHECK(10u < kaizen_zone_sample_interval(&hot_zone));
+        CHECK(200u > kaizen_zone_sample_interval(&hot_zone));
+        CHECK_EQUAL(1u, kaizen_zone_sample_interval(&rare_zone));
+
+        errc = kaizen_zone_sampler_finalize(&sampler);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+
+    TEST(sampler_collects_samples_counted_by_thread_states)
+    {
+        kaizen_zone_t zone = KAIZEN_ZONE_INITIALIZER("hot", 1);
+
+        kaizen_zone_t* zone_storage[1];
+        double estimate_storage[1];
+        kaizen_zone_sampler_t sampler;
+        int errc = kaizen_zone_sampler_init(&sampler,
+                                            zone_storage,
+                                            estimate_storage,
+                                            1,
+                                            0.01);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_zone_sampler_set_sample_cost(&sampler, 100.0);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_zone_sampler_add(&sampler, &zone);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(0u, kaizen_zone_sampler_slot(&zone));
+
+        std::size_t const thread_count = 2;
+        kaizen_event_t storage[thread_count][event_capacity];
+        kaizen_thread_state_t states[thread_count];
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            errc = kaizen_thread_state_init(&states[t], storage[t], event_capacity);
+            assert(KAIZEN_SUCCESS == errc);
+            errc = kaizen_zone_sampler_add_thread_state(&sampler, &states[t]);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+
+        // Both threads record every execution, the full event buffers only
+        // drop the events, not the counts.
+        std::thread threads[thread_count];
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads[t] = std::thread([&states, &zone, t]() {
+                int thread_errc = kaizen_thread_state_attach_to_current_thread(&states[t]);
+                assert(KAIZEN_SUCCESS == thread_errc);
+                execute_zone(&zone, 50000);
+                thread_errc = kaizen_thread_state_attach_to_current_thread(NULL);
+                assert(KAIZEN_SUCCESS == thread_errc);
+                (void)thread_errc;
+            });
+        }
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            threads[t].join();
+        }
+
+        CHECK_EQUAL(0u, kaizen_zone_exchange_sample_count(&zone));
+        CHECK_EQUAL(50000u, kaizen_thread_state_exchange_sample_count(&states[0], 0u));
+        CHECK_EQUAL(0u, kaizen_thread_state_exchange_sample_count(&states[0], 0u));
+
+        // 40000 counted executions in a 10ms frame exceed the budget of
+        // about 1000 samples.
+        for (int i = 0; i < 40000; ++i) {
+            CHECK_EQUAL(KAIZEN_TRUE, kaizen_thread_state_count_sample(&states[1], 0u));
+        }
+
+        kaizen_raw_frame_time_t frame_duration = KAIZEN_RAW_FRAME_TIME_ZERO;
+        errc = kaizen_frame_time_convert_from_milliseconds(&frame_duration, 10.0);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_sampler_adapt(&sampler, &frame_duration));
+        CHECK(1u < kaizen_zone_sample_interval(&zone));
+        CHECK_EQUAL(0u, kaizen_thread_state_exchange_sample_count(&states[1], 0u));
+
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_sampler_remove_thread_state(&sampler, &states[0]));
+        CHECK_EQUAL(ESRCH, kaizen_zone_sampler_remove_thread_state(&sampler, &states[0]));
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_thread_state_count_sample(&states[0], 0u));
+
+        errc = kaizen_zone_sampler_finalize(&sampler);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_ZONE_NO_SAMPLER_SLOT, kaizen_zone_sampler_slot(&zone));
+        CHECK_EQUAL(KAIZEN_FALSE, kaizen_thread_state_count_sample(&states[1], 0u));
+
+        for (std::size_t t = 0; t < thread_count; ++t) {
+            errc = kaizen_thread_state_finalize(&states[t]);
+            assert(KAIZEN_SUCCESS == errc);
+        }
+    }
+
+
+
+    TEST(fiber_zone_excludes_suspended_time_across_threads)
+    {
+        kaizen_event_t thread_storage[event_capacity];
+        kaizen_thread_state_t thread_state;
+        int errc = kaizen_thread_state_init(&thread_state, thread_storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_thread_state_attach_to_current_thread(&thread_state);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_event_t fiber_storage[event_capacity];
+        kaizen_thread_state_t fiber_state;
+        errc = kaizen_thread_state_init(&fiber_state, fiber_storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_zone_t zone = KAIZEN_ZONE_INITIALIZER("fiber zone", test_zone_id);
+        kaizen_zone_scope_t scope;
+        kaizen_raw_frame_time_t now = KAIZEN_RAW_FRAME_TIME_ZERO;
+
+        // The fiber begins the zone on this thread and suspends.
+        errc = kaizen_frame_time_query(&now);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_thread_state_switch_in(&fiber_state, &now));
+        CHECK_EQUAL(&fiber_state, kaizen_thread_state_of_current_thread());
+
+        errc = kaizen_zone_begin(&zone, &scope);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(1u, kaizen_thread_state_depth(&fiber_state));
+
+        errc = kaizen_frame_time_query(&now);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_thread_state_switch_out(&fiber_state, &now));
+        CHECK_EQUAL(&thread_state, kaizen_thread_state_of_current_thread());
+        CHECK_EQUAL(kaizen_thread_state_event_buffer(&thread_state), kaizen_event_buffer_of_current_thread());
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        // The fiber resumes and ends the zone on another thread.
+        std::thread worker([&fiber_state, &scope]() {
+            kaizen_raw_frame_time_t resume = KAIZEN_RAW_FRAME_TIME_ZERO;
+            int worker_errc = kaizen_frame_time_query(&resume);
+            assert(KAIZEN_SUCCESS == worker_errc);
+            worker_errc = kaizen_thread_state_switch_in(&fiber_state, &resume);
+            assert(KAIZEN_SUCCESS == worker_errc);
+
+            worker_errc = kaizen_zone_end(&scope);
+            assert(KAIZEN_SUCCESS == worker_errc);
+
+            worker_errc = kaizen_frame_time_query(&resume);
+            assert(KAIZEN_SUCCESS == worker_errc);
+            worker_errc = kaizen_thread_state_switch_out(&fiber_state, &resume);
+            assert(KAIZEN_SUCCESS == worker_errc);
+            assert(NULL == kaizen_thread_state_of_current_thread());
+            (void)worker_errc;
+        });
+        worker.join();
+
+        CHECK_EQUAL(0u, kaizen_thread_state_depth(&fiber_state));
+        CHECK_EQUAL(2u, kaizen_thread_state_switch_count(&fiber_state));
+        CHECK_EQUAL(0u, kaizen_event_buffer_count(kaizen_thread_state_event_buffer(&thread_state)));
+
+        kaizen_event_buffer_t const* fiber_buffer = kaizen_thread_state_event_buffer(&fiber_state);
+        CHECK_EQUAL(1u, kaizen_event_buffer_count(fiber_buffer));
+
+        std::uint64_t suspended_ticks = kaizen_thread_state_suspended_ticks(&fiber_state);
+        std::uint64_t duration_ticks = 0;
+        errc = kaizen_frame_time_convert_to_ticks(&(kaizen_event_buffer_at(fiber_buffer, 0)->duration), &duration_ticks);
+        assert(KAIZEN_SUCCESS == errc);
+
+        std::uint64_t ticks_per_second = 0;
+        errc = kaizen_frame_time_query_ticks_per_second(&ticks_per_second);
+        assert(KAIZEN_SUCCESS == errc);
+
+        CHECK(suspended_ticks >= ticks_per_second / 20u);
+        CHECK(duration_ticks < ticks_per_second / 20u);
+
+        errc = kaizen_thread_state_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_thread_state_finalize(&fiber_state);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_thread_state_finalize(&thread_state);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+
+    TEST(zone_name_is_recorded_in_eight_byte_chunks)
+    {
+        kaizen_event_t storage[event_capacity];
+        kaizen_event_buffer_t buffer;
+        int errc = kaizen_event_buffer_init(&buffer, storage, event_capacity);
+        assert(KAIZEN_SUCCESS == errc);
+
+        kaizen_zone_t zone = KAIZEN_ZONE_INITIALIZER("physics_step", test_zone_id);
+        CHECK_EQUAL(ESRCH, kaizen_zone_record_name(&zone));
+
+        errc = kaizen_event_buffer_attach_to_current_thread(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+        CHECK_EQUAL(KAIZEN_SUCCESS, kaizen_zone_record_name(&zone));
+
+        std::string name;
+        CHECK_EQUAL(2u, kaizen_event_buffer_count(&buffer));
+        for (std::size_t i = 0; i < kaizen_event_buffer_count(&buffer); ++i) {
+            kaizen_event_t const* event = kaizen_event_buffer_at(&buffer, i);
+            CHECK_EQUAL(kaizen_zone_name_event_type, event->type);
+            CHECK_EQUAL(test_zone_id, event->id);
+            CHECK_EQUAL(i, static_cast<std::size_t>(event->flags));
+
+            for (unsigned b = 0; b < 8 && 0 != ((event->value >> (8 * b)) & 0xff); ++b) {
+                name.push_back(static_cast<char>((event->value >> (8 * b)) & 0xff));
+            }
+        }
+        CHECK_EQUAL("physics_step", name);
+
+        errc = kaizen_event_buffer_attach_to_current_thread(NULL);
+        assert(KAIZEN_SUCCESS == errc);
+        errc = kaizen_event_buffer_finalize(&buffer);
+        assert(KAIZEN_SUCCESS == errc);
+    }
+
+} // SUITE(kaizen_zone_test)
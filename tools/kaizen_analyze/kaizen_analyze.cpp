@@ -0,0 +1,545 @@
+/*
+ * Copyright (c) 2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * kaizen_analyze - prints per-zone statistics and the worst frames of a
+ * capture, or compares the zones of two captures.
+ *
+ * Usage:
+ *     kaizen_analyze [--threads N] [--exclude-descheduled] [--worst N] capture
+ *     kaizen_analyze [--threads N] [--exclude-descheduled]
+ *                    --diff baseline_capture current_capture
+ *     kaizen_analyze [--threads N] [--exclude-descheduled] [--significance P]
+ *                    [--min-change F] --compare baseline_capture current_capture
+ *     kaizen_analyze --chrome-trace trace.json capture
+ *     kaizen_analyze --perfetto-trace trace.pftrace capture
+ *     kaizen_analyze [--maps maps] [--symbols binary] [--frames first:last]
+ *                    --folded-samples stacks.folded capture
+ *     kaizen_analyze [--frames first:last] --folded-zones stacks.folded capture
+ *     kaizen_analyze [--maps maps] [--symbols binary] [--frames first:last]
+ *                    --folded-callstacks stacks.folded capture
+ *     kaizen_analyze --compress compressed_capture capture
+ *
+ * Zones are listed by the names recorded with kaizen_zone_record_name (see
+ * kaizen_zone.h), or by id. The report, --diff and --compare analyze
+ * captures block by block with constant memory (see
+ * kaizen::analyze_capture_file).
+ *
+ * desched counts the recorded zone executions the scheduler preempted or
+ * migrated (see kaizen_raw_scheduling_monitor.h), --exclude-descheduled
+ * analyzes without them. Executions that blocked, e.g. on a lock, are kept.
+ *
+ * --compare flags zones whose per-frame times changed significantly (see
+ * kaizen::compare_reports) and exits with 2 if any zone regressed, e.g. to
+ * fail nightly performance tests.
+ *
+ * Captures recorded with hardware counters (see
+ * kaizen_raw_hardware_counters.h) additionally list instructions per
+ * cycle and cache and branch misses per measured zone execution, captures
+ * recorded with allocation tracking (see kaizen_allocation.h) the
+ * allocations and deallocations made directly in each zone.
+ *
+ * --chrome-trace and --perfetto-trace stream the capture into a trace file
+ * for chrome://tracing or https://ui.perfetto.dev (see
+ * kaizen_capture_export.hpp).
+ *
+ * --folded-samples, --folded-zones and --folded-callstacks write the
+ * sampled call stacks (see kaizen_raw_sampler.h), the zone hierarchies or
+ * the call stacks recorded with zones (see kaizen_callstack.h) of the
+ * frames first to last as folded stacks for flame graph tools. Stack addresses are
+ * symbolized offline from the binaries listed in --maps, a copy of
+ * /proc/<pid>/maps of the profiled process, and the --symbols binaries
+ * linked without -pie (see kaizen_symbolizer.hpp).
+ *
+ * --compress rewrites a capture with compressed blocks (see
+ * kaizen_event_encoding.h), about half the size of uncompressed captures.
+ * All modes read both.
+ *
+ * Build with the kaizen C sources of the platform and src/c plus src/cpp
+ * in the include path, e.g.:
+ *     c++ -std=c++11 -DKAIZEN_USE_... -Isrc/c -Isrc/cpp
+ *         tools/kaizen_analyze/kaizen_analyze.cpp kaizen_objects -lpthread
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <kaizen/kaizen_capture_analysis.hpp>
+#include <kaizen/kaizen_capture_export.hpp>
+#include <kaizen/kaizen_symbolizer.hpp>
+
+
+
+namespace {
+
+    double const milliseconds_per_second = 1000.0;
+    double const bytes_per_kibibyte = 1024.0;
+
+    // Distinguishes regressions from errors (EXIT_FAILURE).
+    int const regression_exit_code = 2;
+
+
+    int print_usage()
+    {
+        std::fprintf(stderr,
+                     "usage: kaizen_analyze [--threads N] [--exclude-descheduled] [--worst N] capture\n"
+                     "       kaizen_analyze [--threads N] [--exclude-descheduled]\n"
+                     "                      --diff baseline_capture current_capture\n"
+                     "       kaizen_analyze [--threads N] [--exclude-descheduled] [--significance P]\n"
+                     "                      [--min-change F] --compare baseline_capture current_capture\n"
+                     "       kaizen_analyze --chrome-trace trace.json capture\n"
+                     "       kaizen_analyze --perfetto-trace trace.pftrace capture\n"
+                     "       kaizen_analyze [--maps maps] [--symbols binary] [--frames first:last]\n"
+                     "                      --folded-samples stacks.folded capture\n"
+                     "       kaizen_analyze [--frames first:last] --folded-zones stacks.folded capture\n"
+                     "       kaizen_analyze [--maps maps] [--symbols binary] [--frames first:last]\n"
+                     "                      --folded-callstacks stacks.folded capture\n"
+                     "       kaizen_analyze --compress compressed_capture capture\n");
+
+        return EXIT_FAILURE;
+    }
+
+
+    // Zones the capture does not name print their id.
+    std::string zone_label(std::uint32_t const zone_id, std::string const& name)
+    {
+        return name.empty() ? std::to_string(zone_id) : name;
+    }
+
+
+    void print_zones(kaizen::capture_report const& report)
+    {
+        std::printf("%-24s %12s %12s %12s %10s %10s %10s %10s %10s\n",
+                    "zone", "count", "total ms", "self ms", "p50 ms", "p95 ms", "p99 ms", "max ms", "desched");
+
+        for (std::size_t i = 0; i < report.zones.size(); ++i) {
+            kaizen::zone_report const& zone = report.zones[i];
+            std::printf("%-24s %12llu %12.3f %12.3f %10.4f %10.4f %10.4f %10.4f %10llu\n",
+                        zone_label(zone.zone_id, zone.name).c_str(),
+                        static_cast<unsigned long long>(zone.count),
+                        zone.total_seconds * milliseconds_per_second,
+                        zone.self_seconds * milliseconds_per_second,
+                        zone.p50_seconds * milliseconds_per_second,
+                        zone.p95_seconds * milliseconds_per_second,
+                        zone.p99_seconds * milliseconds_per_second,
+                        zone.max_seconds * milliseconds_per_second,
+                        static_cast<unsigned long long>(zone.descheduled_count));
+        }
+    }
+
+
+    double per_execution(std::uint64_t const total, std::uint64_t const executions)
+    {
+        return (0 == executions) ? 0.0 : static_cast<double>(total) / static_cast<double>(executions);
+    }
+
+
+    // Only printed for captures recorded with hardware counters attached.
+    void print_hardware_counters(kaizen::capture_report const& report)
+    {
+        bool has_counters = false;
+        for (std::size_t i = 0; i < report.zones.size(); ++i) {
+            has_counters = has_counters || (0 < report.zones[i].hardware_counter_sample_count);
+        }
+
+        if (!has_counters) {
+            return;
+        }
+
+        std::printf("\n%-24s %12s %8s %14s %14s %14s\n",
+                    "zone", "measured", "IPC", "cycles/exec", "cache miss/ex", "branch miss/ex");
+
+        for (std::size_t i = 0; i < report.zones.size(); ++i) {
+            kaizen::zone_report const& zone = report.zones[i];
+            std::uint64_t const executions = zone.hardware_counter_sample_count;
+            std::uint64_t const cycles = zone.hardware_counter_totals[kaizen_cycles_hardware_counter];
+
+            if (0 == executions) {
+                continue;
+            }
+
+            std::printf("%-24s %12llu %8.3f %14.1f %14.2f %14.2f\n",
+                        zone_label(zone.zone_id, zone.name).c_str(),
+                        static_cast<unsigned long long>(executions),
+                        per_execution(zone.hardware_counter_totals[kaizen_instructions_hardware_counter], cycles),
+                        per_execution(cycles, executions),
+                        per_execution(zone.hardware_counter_totals[kaizen_cache_misses_hardware_counter], executions),
+                        per_execution(zone.hardware_counter_totals[kaizen_branch_misses_hardware_counter], executions));
+        }
+    }
+
+
+    // Only printed for captures recorded with allocation tracking.
+    void print_allocations(kaizen::capture_report const& report)
+    {
+        bool has_allocations = false;
+        for (std::size_t i = 0; i < report.zones.size(); ++i) {
+            has_allocations = has_allocations
+                              || (0 < report.zones[i].allocation_count)
+                              || (0 < report.zones[i].deallocation_count);
+        }
+
+        if (!has_allocations) {
+            return;
+        }
+
+        std::printf("\n%-24s %12s %14s %12s %14s %12s\n",
+                    "zone", "allocations", "allocated KiB", "frees", "freed KiB", "allocs/exec");
+
+        for (std::size_t i = 0; i < report.zones.size(); ++i) {
+            kaizen::zone_report const& zone = report.zones[i];
+
+            if (0 == zone.allocation_count && 0 == zone.deallocation_count) {
+                continue;
+            }
+
+            std::printf("%-24s %12llu %14.1f %12llu %14.1f %12.2f\n",
+                        zone_label(zone.zone_id, zone.name).c_str(),
+                        static_cast<unsigned long long>(zone.allocation_count),
+                        static_cast<double>(zone.allocated_bytes) / bytes_per_kibibyte,
+                        static_cast<unsigned long long>(zone.deallocation_count),
+                        static_cast<double>(zone.deallocated_bytes) / bytes_per_kibibyte,
+                        per_execution(zone.allocation_count, zone.count));
+        }
+    }
+
+
+    void print_worst_frames(kaizen::capture_report const& report, std::size_t const count)
+    {
+        std::vector<kaizen::frame_report> const frames = kaizen::worst_frames(report, count);
+
+        std::printf("\n%12s %14s %12s\n", "frame", "begin s", "duration ms");
+
+        for (std::size_t i = 0; i < frames.size(); ++i) {
+            std::printf("%12llu %14.6f %12.3f\n",
+                        static_cast<unsigned long long>(frames[i].frame_number),
+                        frames[i].begin_seconds,
+                        frames[i].duration_seconds * milliseconds_per_second);
+        }
+    }
+
+
+    double percent_change(double const baseline, double const current)
+    {
+        return (0.0 == baseline) ? 0.0 : 100.0 * (current - baseline) / baseline;
+    }
+
+
+    void print_diff(kaizen::capture_report const& baseline,
+                    kaizen::capture_report const& current)
+    {
+        std::vector<kaizen::zone_difference> const differences = kaizen::diff_reports(baseline, current);
+
+        std::printf("%-24s %12s %12s %8s %10s %10s %8s %10s %10s %8s\n",
+                    "zone",
+                    "base total", "total ms", "change",
+                    "base p50", "p50 ms", "change",
+                    "base p95", "p95 ms", "change");
+
+        for (std::size_t i = 0; i < differences.size(); ++i) {
+            kaizen::zone_report const& before = differences[i].baseline;
+            kaizen::zone_report const& after = differences[i].current;
+            std::printf("%-24s %12.3f %12.3f %7.1f%% %10.4f %10.4f %7.1f%% %10.4f %10.4f %7.1f%%\n",
+                        zone_label(differences[i].zone_id, after.name.empty() ? before.name : after.name).c_str(),
+                        before.total_seconds * milliseconds_per_second,
+                        after.total_seconds * milliseconds_per_second,
+                        percent_change(before.total_seconds, after.total_seconds),
+                        before.p50_seconds * milliseconds_per_second,
+                        after.p50_seconds * milliseconds_per_second,
+                        percent_change(before.p50_seconds, after.p50_seconds),
+                        before.p95_seconds * milliseconds_per_second,
+                        after.p95_seconds * milliseconds_per_second,
+                        percent_change(before.p95_seconds, after.p95_seconds));
+        }
+    }
+
+
+
+    char const* change_name(kaizen::zone_change const change)
+    {
+        switch (change) {
+            case kaizen::zone_change::regression:
+                return "REGRESSION";
+            case kaizen::zone_change::improvement:
+                return "improvement";
+            default:
+                return "-";
+        }
+    }
+
+
+    /**
+     * Returns the number of regressed zones.
+     */
+    std::size_t print_comparison(kaizen::capture_report const& baseline,
+                                 kaizen::capture_report const& current,
+                                 double const significance,
+                                 double const min_relative_change,
+                                 unsigned const thread_count)
+    {
+        std::vector<kaizen::zone_comparison> const comparisons = kaizen::compare_reports(baseline,
+                                                                                         current,
+                                                                                         significance,
+                                                                                         min_relative_change,
+                                                                                         thread_count);
+        std::size_t regression_count = 0;
+
+        std::printf("%-24s %8s %8s %12s %12s %8s %8s %10s %12s %8s %s\n",
+                    "zone", "frames", "frames", "base p50 ms", "p50 ms", "change",
+                    "z", "p", "confidence", "P(slower)", "result");
+
+        for (std::size_t i = 0; i < comparisons.size(); ++i) {
+            kaizen::zone_comparison const& comparison = comparisons[i];
+            std::printf("%-24s %8lu %8lu %12.4f %12.4f %7.1f%% %8.2f %10.2e %11.4f%% %8.3f %s\n",
+                        zone_label(comparison.zone_id, comparison.name).c_str(),
+                        static_cast<unsigned long>(comparison.baseline_frame_count),
+                        static_cast<unsigned long>(comparison.current_frame_count),
+                        comparison.baseline_median_seconds * milliseconds_per_second,
+                        comparison.current_median_seconds * milliseconds_per_second,
+                        percent_change(comparison.baseline_median_seconds, comparison.current_median_seconds),
+                        comparison.z_score,
+                        comparison.p_value,
+                        comparison.confidence * 100.0,
+                        comparison.probability_slower,
+                        change_name(comparison.change));
+
+            if (kaizen::zone_change::regression == comparison.change) {
+                ++regression_count;
+            }
+        }
+
+        return regression_count;
+    }
+
+} // anonymous namespace
+
+
+
+int main(int argc, char* argv[])
+{
+    unsigned thread_count = kaizen::detail::default_thread_count();
+    std::size_t worst_frame_count = 10;
+    bool diff = false;
+    bool compare = false;
+    bool exclude_descheduled = false;
+    double significance = 0.01;
+    double min_relative_change = 0.0;
+    std::string chrome_trace_path;
+    std::string perfetto_trace_path;
+    std::string compressed_path;
+    std::string folded_samples_path;
+    std::string folded_zones_path;
+    std::string folded_callstacks_path;
+    std::string maps_path;
+    std::vector<std::string> symbol_paths;
+    std::uint64_t first_frame = 0;
+    std::uint64_t last_frame = ~std::uint64_t(0);
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        if (0 == std::strcmp("--threads", argv[i]) && i + 1 < argc) {
+            thread_count = static_cast<unsigned>(std::strtoul(argv[++i], NULL, 10));
+        } else if (0 == std::strcmp("--worst", argv[i]) && i + 1 < argc) {
+            worst_frame_count = static_cast<std::size_t>(std::strtoul(argv[++i], NULL, 10));
+        } else if (0 == std::strcmp("--significance", argv[i]) && i + 1 < argc) {
+            significance = std::strtod(argv[++i], NULL);
+        } else if (0 == std::strcmp("--min-change", argv[i]) && i + 1 < argc) {
+            min_relative_change = std::strtod(argv[++i], NULL);
+        } else if (0 == std::strcmp("--chrome-trace", argv[i]) && i + 1 < argc) {
+            chrome_trace_path = argv[++i];
+        } else if (0 == std::strcmp("--perfetto-trace", argv[i]) && i + 1 < argc) {
+            perfetto_trace_path = argv[++i];
+        } else if (0 == std::strcmp("--compress", argv[i]) && i + 1 < argc) {
+            compressed_path = argv[++i];
+        } else if (0 == std::strcmp("--folded-samples", argv[i]) && i + 1 < argc) {
+            folded_samples_path = argv[++i];
+        } else if (0 == std::strcmp("--folded-zones", argv[i]) && i + 1 < argc) {
+            folded_zones_path = argv[++i];
+        } else if (0 == std::strcmp("--folded-callstacks", argv[i]) && i + 1 < argc) {
+            folded_callstacks_path = argv[++i];
+        } else if (0 == std::strcmp("--maps", argv[i]) && i + 1 < argc) {
+            maps_path = argv[++i];
+        } else if (0 == std::strcmp("--symbols", argv[i]) && i + 1 < argc) {
+            symbol_paths.push_back(argv[++i]);
+        } else if (0 == std::strcmp("--frames", argv[i]) && i + 1 < argc) {
+            char* separator = NULL;
+            first_frame = std::strtoull(argv[++i], &separator, 10);
+            last_frame = (':' == *separator) ? std::strtoull(separator + 1, NULL, 10) : first_frame;
+        } else if (0 == std::strcmp("--diff", argv[i])) {
+            diff = true;
+        } else if (0 == std::strcmp("--compare", argv[i])) {
+            compare = true;
+        } else if (0 == std::strcmp("--exclude-descheduled", argv[i])) {
+            exclude_descheduled = true;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    bool const is_export = !chrome_trace_path.empty() || !perfetto_trace_path.empty();
+    std::string const folded_path = folded_samples_path + folded_zones_path + folded_callstacks_path;
+    bool const is_folded = !folded_path.empty();
+    int const mode_count = (diff ? 1 : 0) + (compare ? 1 : 0) + (chrome_trace_path.empty() ? 0 : 1) + (perfetto_trace_path.empty() ? 0 : 1)
+                           + (folded_samples_path.empty() ? 0 : 1) + (folded_zones_path.empty() ? 0 : 1)
+                           + (folded_callstacks_path.empty() ? 0 : 1) + (compressed_path.empty() ? 0 : 1);
+
+    if (0 == thread_count || 1 < mode_count || paths.size() != ((diff || compare) ? 2u : 1u) || first_frame > last_frame) {
+        return print_usage();
+    }
+
+    try {
+        if (is_folded) {
+            kaizen::capture const capture = kaizen::read_capture_file(paths[0], thread_count);
+            std::ofstream folded(folded_path.c_str(), std::ios::out | std::ios::binary);
+
+            if (!folded) {
+                std::fprintf(stderr, "kaizen_analyze: cannot open stacks\n");
+
+                return EXIT_FAILURE;
+            }
+
+            if (!folded_zones_path.empty()) {
+                kaizen::export_zone_folded_stacks(capture, folded, first_frame, last_frame);
+
+                return EXIT_SUCCESS;
+            }
+
+            kaizen::elf_symbolizer symbolizer;
+
+            if (!maps_path.empty()) {
+                std::ifstream maps(maps_path.c_str());
+
+                if (!maps) {
+                    std::fprintf(stderr, "kaizen_analyze: cannot open %s\n", maps_path.c_str());
+
+                    return EXIT_FAILURE;
+                }
+
+                symbolizer.add_mapped_modules(maps);
+            }
+
+            for (std::size_t i = 0; i < symbol_paths.size(); ++i) {
+                symbolizer.add_module(symbol_paths[i], 0);
+            }
+
+            std::function<std::string(std::uint64_t)> const symbolize = [&symbolizer](std::uint64_t const address) {
+                return symbolizer.symbolize(address);
+            };
+
+            if (!folded_callstacks_path.empty()) {
+                kaizen::export_zone_callstack_folded_stacks(capture, folded, symbolize, first_frame, last_frame);
+            } else {
+                kaizen::export_sample_folded_stacks(capture, folded, symbolize, first_frame, last_frame);
+            }
+
+            return EXIT_SUCCESS;
+        }
+
+        if (!compressed_path.empty()) {
+            std::ifstream capture(paths[0].c_str(), std::ios::in | std::ios::binary);
+            std::ofstream compressed(compressed_path.c_str(), std::ios::out | std::ios::binary);
+
+            if (!capture || !compressed) {
+                std::fprintf(stderr, "kaizen_analyze: cannot open %s\n", !capture ? paths[0].c_str() : compressed_path.c_str());
+
+                return EXIT_FAILURE;
+            }
+
+            kaizen::compress_capture(capture, compressed);
+
+            return EXIT_SUCCESS;
+        }
+
+        if (is_export) {
+            std::ifstream capture(paths[0].c_str(), std::ios::in | std::ios::binary);
+            std::ofstream trace(chrome_trace_path.empty() ? perfetto_trace_path.c_str() : chrome_trace_path.c_str(),
+                                std::ios::out | std::ios::binary);
+
+            if (!capture || !trace) {
+                std::fprintf(stderr, "kaizen_analyze: cannot open %s\n", !capture ? paths[0].c_str() : "trace");
+
+                return EXIT_FAILURE;
+            }
+
+            if (chrome_trace_path.empty()) {
+                kaizen::export_perfetto_trace(capture, trace);
+            } else {
+                kaizen::export_chrome_trace(capture, trace);
+            }
+
+            return EXIT_SUCCESS;
+        }
+
+        std::vector<kaizen::capture_report> reports;
+
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            reports.push_back(kaizen::analyze_capture_file(paths[i], thread_count, exclude_descheduled));
+        }
+
+        if (compare) {
+            std::size_t const regression_count = print_comparison(reports[0],
+                                                                  reports[1],
+                                                                  significance,
+                                                                  min_relative_change,
+                                                                  thread_count);
+            if (0 < regression_count) {
+                std::fprintf(stderr, "kaizen_analyze: %lu zone(s) regressed\n", static_cast<unsigned long>(regression_count));
+
+                return regression_exit_code;
+            }
+        } else if (diff) {
+            print_diff(reports[0], reports[1]);
+        } else {
+            print_zones(reports[0]);
+            print_hardware_counters(reports[0]);
+            print_allocations(reports[0]);
+            print_worst_frames(reports[0], worst_frame_count);
+        }
+
+    } catch (std::exception const& e) {
+        std::fprintf(stderr, "kaizen_analyze: %s\n", e.what());
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}